@@ -14,19 +14,21 @@ array = np.array(list(map(lambda t: [round(t[i]*((2**bit_mode[i]-1)/255)) for i
 bin_array = list(map(lambda t: ''.join([(('0'*(bit_mode[i] - len(bin(t[i])[2:]))) + bin(t[i])[2:])[:bit_mode[i]] for i in range(len(t))]), array))
 hex_array = list(map(lambda t: hex(int(t,2)), bin_array))
 
-array_type = "uint8_t" if sum(bit_mode) <= 8 else ("uint16_t" if sum(bit_mode) <= 16 else "uint8_t[3]")
+array_type = "uint8_t" if sum(bit_mode) <= 8 else ("uint16_t" if sum(bit_mode) <= 16 else "uint32_t")
 
 output_header = f"""//Generated with the "color_modes.py" script
-#ifndef {sys.argv[1]}_PALETTE_H
-#define {sys.argv[1]}_PALETTE_H
+#ifndef PALETTE_{sys.argv[1]}_H
+#define PALETTE_{sys.argv[1]}_H
 
 #include <stdint.h>
 
-{array_type}[256] *palette = 0x20041000; // Start of SRAM 5
+typedef {array_type} palette_t;
+
 //Conversion (or not) of the original Quake palette to the indicated color bit mode
-palette* = [""" + ', '.join(hex_array) + """"];
+static const palette_t palette[256] = {{""" + ', '.join(hex_array) + """};
 
-#endif"""
+#endif
+"""
 
 header = open(f"{sys.argv[1]}_palette.h", "w")
 header.write(output_header)
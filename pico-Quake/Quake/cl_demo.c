@@ -40,6 +40,8 @@ read from the demo file.
 static byte		*demo_head;
 static int		*demo_head_sizes;
 
+static qboolean	demo_deferred;		// the message from CL_GetMessage is written after it's parsed
+
 /*
 ==============
 CL_ClearSignons
@@ -74,6 +76,64 @@ void CL_StopPlayback (void)
 		CL_FinishTimeDemo ();
 }
 
+/*
+====================
+CL_DemoMessage
+
+The message as a demo has to have it. A local server may have left the
+entities in sv_snapshot, and they are only written out now, in place of
+the svc_localsnapshot. An svc_deltaentities is only good to a client that
+has the snapshots before it, so it's replaced by the entities it was built
+into, all fields of each. Either way the message is rebuilt in msg, from the
+message buffer pool, and the caller gives it back.
+====================
+*/
+#define	DEMO_MAXUPDATE	40		// the most MSG_WriteEntityUpdate writes
+
+static sizebuf_t *CL_DemoMessage (sizebuf_t *msg)
+{
+	entityspan_t	span;
+	entityupdate_t	u;
+	byte	*p;
+	int		i, rest;
+
+	span = cl_entityspan;
+	if (!span.length)
+	{	// not parsed yet
+		span.offset = sv_snapshot.offset;
+		span.length = 5;
+		if (!sv_snapshot.pending || span.offset + 5 > net_message.cursize)
+			return &net_message;
+		p = net_message.data + span.offset;
+		if (p[0] != svc_localsnapshot || (p[1] | (p[2] << 8) | (p[3] << 16) | (p[4] << 24)) != sv_snapshot.sequence)
+			return &net_message;
+		span.numupdates = sv_snapshot.numupdates;
+		span.updates = sv_snapshot.updates;
+		span.built = false;
+	}
+
+	rest = net_message.cursize - (span.offset + span.length);
+	memset (msg, 0, sizeof(*msg));
+	msg->maxsize = q_min (span.offset + span.numupdates * DEMO_MAXUPDATE + rest, MAX_MSGLEN);
+	msg->data = MSG_AllocBuffer (msg->maxsize);
+
+	SZ_Write (msg, net_message.data, span.offset);
+	for (i = 0; i < span.numupdates && msg->cursize + DEMO_MAXUPDATE + rest <= msg->maxsize; i++)
+	{
+		u = span.updates[i];
+		if (span.built)
+		{
+			u.bits |= U_MOREBITS | U_EXTEND1;
+			if (u.num >= 256)
+				u.bits |= U_LONGENTITY;
+		}
+		MSG_WriteEntityUpdate (msg, &u, cl.protocolflags);
+	}
+	SZ_Write (msg, net_message.data + span.offset + span.length, rest);
+
+	return msg;
+}
+
 /*
 ====================
 CL_WriteDemoMessage
@@ -86,16 +146,21 @@ static void CL_WriteDemoMessage (void)
 	int	len;
 	int	i;
 	float	f;
+	sizebuf_t	demomsg, *msg;
 
-	len = LittleLong (net_message.cursize);
+	msg = CL_DemoMessage (&demomsg);
+	len = LittleLong (msg->cursize);
 	fwrite (&len, 4, 1, cls.demofile);
 	for (i = 0; i < 3; i++)
 	{
 		f = LittleFloat (cl.viewangles[i]);
 		fwrite (&f, 4, 1, cls.demofile);
 	}
-	fwrite (net_message.data, net_message.cursize, 1, cls.demofile);
+	fwrite (msg->data, msg->cursize, 1, cls.demofile);
 	fflush (cls.demofile);
+
+	if (msg == &demomsg)
+		MSG_FreeBuffer (demomsg.data, demomsg.maxsize);
 }
 
 static int CL_GetDemoMessage (void)
@@ -176,8 +241,14 @@ int CL_GetMessage (void)
 			break;
 	}
 
+	// snapshots sent as changes can only be written out once they're read
 	if (cls.demorecording)
-		CL_WriteDemoMessage ();
+	{
+		if (cl.protocolflags & PRFL_DELTAENTS)
+			demo_deferred = true;
+		else
+			CL_WriteDemoMessage ();
+	}
 
 	if (cls.signon < 2)
 	{
@@ -191,6 +262,21 @@ int CL_GetMessage (void)
 }
 
 
+/*
+====================
+CL_FinishDemoMessage
+
+writes the message CL_GetMessage held back, now that it has been parsed
+====================
+*/
+void CL_FinishDemoMessage (void)
+{
+	if (demo_deferred && cls.demorecording)
+		CL_WriteDemoMessage ();
+	demo_deferred = false;
+	cl_entityspan.length = 0;	// nothing else written has it
+}
+
 /*
 ====================
 CL_Stop_f
@@ -342,14 +342,22 @@ void CL_SendMove (const usercmd_t *cmd)
 	int		i;
 	int		bits;
 	sizebuf_t	buf;
-	byte	data[128];
+	byte	data[NET_HEADERSIZE + 128];
 
 	buf.maxsize = 128;
 	buf.cursize = 0;
-	buf.data = data;
+	buf.data = data + NET_HEADERSIZE;
+	buf.headroom = NET_HEADERSIZE;
 
 	cl.cmd = *cmd;
 
+// tell the server which snapshot the next one can be sent as changes from
+	if (cl.protocolflags & PRFL_DELTAENTS)
+	{
+		MSG_WriteByte (&buf, clc_deltaack);
+		MSG_WriteLong (&buf, cl.deltaack);
+	}
+
 //
 // send the movement message
 //
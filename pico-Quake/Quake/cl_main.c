@@ -285,6 +285,7 @@ CL_AllocDlight
 dlight_t *CL_AllocDlight (int key)
 {
 	int		i;
+	qboolean	persist;
 	dlight_t	*dl;
 
 // first look for an exact key match
@@ -295,8 +296,12 @@ dlight_t *CL_AllocDlight (int key)
 		{
 			if (dl->key == key)
 			{
+				// the key carried a live light over from the last frame
+				persist = (dl->die >= cl.oldtime && dl->radius);
 				memset (dl, 0, sizeof(*dl));
 				dl->key = key;
+				dl->lit = cl.time;
+				dl->persist = persist;
 				dl->color[0] = dl->color[1] = dl->color[2] = 1; //johnfitz -- lit support via lordhavoc
 				return dl;
 			}
@@ -311,6 +316,7 @@ dlight_t *CL_AllocDlight (int key)
 		{
 			memset (dl, 0, sizeof(*dl));
 			dl->key = key;
+			dl->lit = cl.time;
 			dl->color[0] = dl->color[1] = dl->color[2] = 1; //johnfitz -- lit support via lordhavoc
 			return dl;
 		}
@@ -319,6 +325,7 @@ dlight_t *CL_AllocDlight (int key)
 	dl = &cl_dlights[0];
 	memset (dl, 0, sizeof(*dl));
 	dl->key = key;
+	dl->lit = cl.time;
 	dl->color[0] = dl->color[1] = dl->color[2] = 1; //johnfitz -- lit support via lordhavoc
 	return dl;
 }
@@ -637,6 +644,7 @@ int CL_ReadFromServer (void)
 
 		cl.last_received_message = realtime;
 		CL_ParseServerMessage ();
+		CL_FinishDemoMessage ();
 	} while (ret && cls.state == ca_connected);
 
 	if (cl_shownet.value)
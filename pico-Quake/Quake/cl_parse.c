@@ -312,7 +312,7 @@ void CL_ParseServerInfo (void)
 
 	if (cl.protocol == PROTOCOL_RMQ)
 	{
-		const unsigned int supportedflags = (PRFL_SHORTANGLE | PRFL_FLOATANGLE | PRFL_24BITCOORD | PRFL_FLOATCOORD | PRFL_EDICTSCALE | PRFL_INT32COORD);
+		const unsigned int supportedflags = (PRFL_SHORTANGLE | PRFL_FLOATANGLE | PRFL_24BITCOORD | PRFL_FLOATCOORD | PRFL_EDICTSCALE | PRFL_INT32COORD | PRFL_DELTAENTS);
 		
 		// mh - read protocol flags from server so that we know what protocol features to expect
 		cl.protocolflags = (unsigned int) MSG_ReadLong ();
@@ -324,6 +324,8 @@ void CL_ParseServerInfo (void)
 	}
 	else cl.protocolflags = 0;
 
+	CL_ClearDeltaFrames ();	// cl.deltaack was cleared with the rest
+
 // parse maxclients
 	cl.maxclients = MSG_ReadByte ();
 	if (cl.maxclients < 1 || cl.maxclients > MAX_SCOREBOARD)
@@ -434,19 +436,20 @@ void CL_ParseServerInfo (void)
 //johnfitz -- reset developer stats
 	memset(&dev_stats, 0, sizeof(dev_stats));
 	memset(&dev_peakstats, 0, sizeof(dev_peakstats));
+	memset(&sv_devstats, 0, sizeof(sv_devstats));
+	memset(&sv_devpeakstats, 0, sizeof(sv_devpeakstats));
 	memset(&dev_overflows, 0, sizeof(dev_overflows));
 }
 
 /*
 ==================
-CL_ParseUpdate
+CL_ApplyUpdate
 
-Parse an entity update message from the server
 If an entities model or origin changes from frame to frame, it must be
 relinked.  Other attributes can change without relinking.
 ==================
 */
-void CL_ParseUpdate (int bits)
+static void CL_ApplyUpdate (entityupdate_t *u)
 {
 	int		i;
 	qmodel_t	*model;
@@ -455,6 +458,7 @@ void CL_ParseUpdate (int bits)
 	entity_t	*ent;
 	int		num;
 	int		skin;
+	int		bits;
 
 	if (cls.signon == SIGNONS - 1)
 	{	// first update is the final signon stage
@@ -462,27 +466,8 @@ void CL_ParseUpdate (int bits)
 		CL_SignonReply ();
 	}
 
-	if (bits & U_MOREBITS)
-	{
-		i = MSG_ReadByte ();
-		bits |= (i<<8);
-	}
-
-	//johnfitz -- PROTOCOL_FITZQUAKE
-	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
-	{
-		if (bits & U_EXTEND1)
-			bits |= MSG_ReadByte() << 16;
-		if (bits & U_EXTEND2)
-			bits |= MSG_ReadByte() << 24;
-	}
-	//johnfitz
-
-	if (bits & U_LONGENTITY)
-		num = MSG_ReadShort ();
-	else
-		num = MSG_ReadByte ();
-
+	bits = u->bits;
+	num = u->num;
 	ent = CL_EntityNum (num);
 
 	if (ent->msgtime != cl.mtime[1])
@@ -498,21 +483,17 @@ void CL_ParseUpdate (int bits)
 	ent->msgtime = cl.mtime[0];
 
 	if (bits & U_MODEL)
-	{
-		modnum = MSG_ReadByte ();
-		if (modnum >= MAX_MODELS)
-			Host_Error ("CL_ParseModel: bad modnum");
-	}
+		modnum = u->modelindex & 0xFF;
 	else
 		modnum = ent->baseline.modelindex;
 
 	if (bits & U_FRAME)
-		ent->frame = MSG_ReadByte ();
+		ent->frame = u->frame & 0xFF;
 	else
 		ent->frame = ent->baseline.frame;
 
 	if (bits & U_COLORMAP)
-		i = MSG_ReadByte();
+		i = u->colormap;
 	else
 		i = ent->baseline.colormap;
 	if (!i)
@@ -524,7 +505,7 @@ void CL_ParseUpdate (int bits)
 		ent->colormap = cl.scores[i-1].translations;
 	}
 	if (bits & U_SKIN)
-		skin = MSG_ReadByte();
+		skin = u->skin;
 	else
 		skin = ent->baseline.skin;
 	if (skin != ent->skinnum)
@@ -534,7 +515,7 @@ void CL_ParseUpdate (int bits)
 			R_TranslateNewPlayerSkin (num - 1); //johnfitz -- was R_TranslatePlayerSkin
 	}
 	if (bits & U_EFFECTS)
-		ent->effects = MSG_ReadByte();
+		ent->effects = u->effects;
 	else
 		ent->effects = ent->baseline.effects;
 
@@ -542,30 +523,23 @@ void CL_ParseUpdate (int bits)
 	VectorCopy (ent->msg_origins[0], ent->msg_origins[1]);
 	VectorCopy (ent->msg_angles[0], ent->msg_angles[1]);
 
-	if (bits & U_ORIGIN1)
-		ent->msg_origins[0][0] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][0] = ent->baseline.origin[0];
+	for (i=0 ; i<3 ; i++)
+	{
+		if (bits & (U_ORIGIN1<<i))
+			ent->msg_origins[0][i] = u->origin[i];
+		else
+			ent->msg_origins[0][i] = ent->baseline.origin[i];
+	}
 	if (bits & U_ANGLE1)
-		ent->msg_angles[0][0] = MSG_ReadAngle(cl.protocolflags);
+		ent->msg_angles[0][0] = u->angles[0];
 	else
 		ent->msg_angles[0][0] = ent->baseline.angles[0];
-
-	if (bits & U_ORIGIN2)
-		ent->msg_origins[0][1] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][1] = ent->baseline.origin[1];
 	if (bits & U_ANGLE2)
-		ent->msg_angles[0][1] = MSG_ReadAngle(cl.protocolflags);
+		ent->msg_angles[0][1] = u->angles[1];
 	else
 		ent->msg_angles[0][1] = ent->baseline.angles[1];
-
-	if (bits & U_ORIGIN3)
-		ent->msg_origins[0][2] = MSG_ReadCoord (cl.protocolflags);
-	else
-		ent->msg_origins[0][2] = ent->baseline.origin[2];
 	if (bits & U_ANGLE3)
-		ent->msg_angles[0][2] = MSG_ReadAngle(cl.protocolflags);
+		ent->msg_angles[0][2] = u->angles[2];
 	else
 		ent->msg_angles[0][2] = ent->baseline.angles[2];
 
@@ -583,20 +557,20 @@ void CL_ParseUpdate (int bits)
 	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
 	{
 		if (bits & U_ALPHA)
-			ent->alpha = MSG_ReadByte();
+			ent->alpha = u->alpha;
 		else
 			ent->alpha = ent->baseline.alpha;
 		if (bits & U_SCALE)
-			ent->scale = MSG_ReadByte();
+			ent->scale = u->scale;
 		else
 			ent->scale = ent->baseline.scale;
 		if (bits & U_FRAME2)
-			ent->frame = (ent->frame & 0x00FF) | (MSG_ReadByte() << 8);
+			ent->frame = (ent->frame & 0x00FF) | (u->frame & 0xFF00);
 		if (bits & U_MODEL2)
-			modnum = (modnum & 0x00FF) | (MSG_ReadByte() << 8);
+			modnum = (modnum & 0x00FF) | (u->modelindex & 0xFF00);
 		if (bits & U_LERPFINISH)
 		{
-			ent->lerpfinish = ent->msgtime + ((float)(MSG_ReadByte()) / 255);
+			ent->lerpfinish = ent->msgtime + ((float)(u->lerpfinish) / 255);
 			ent->lerpflags |= LERP_FINISH;
 		}
 		else
@@ -606,27 +580,16 @@ void CL_ParseUpdate (int bits)
 	{
 		//HACK: if this bit is set, assume this is PROTOCOL_NEHAHRA
 		if (bits & U_TRANS)
-		{
-			float a, b;
-
-			if (warn_about_nehahra_protocol)
-			{
-				Con_Warning ("nonstandard update bit, assuming Nehahra protocol\n");
-				warn_about_nehahra_protocol = false;
-			}
-
-			a = MSG_ReadFloat();
-			b = MSG_ReadFloat(); //alpha
-			if (a == 2)
-				MSG_ReadFloat(); //fullbright (not using this yet)
-			ent->alpha = ENTALPHA_ENCODE(b);
-		}
+			ent->alpha = u->alpha;
 		else
 			ent->alpha = ent->baseline.alpha;
 		ent->scale = ent->baseline.scale;
 	}
 	//johnfitz
 
+	if (modnum >= MAX_MODELS)
+		Host_Error ("CL_ParseModel: bad modnum");
+
 	//johnfitz -- moved here from above
 	model = cl.model_precache[modnum];
 	if (model != ent->model)
@@ -660,6 +623,307 @@ void CL_ParseUpdate (int bits)
 	}
 }
 
+/*
+==================
+CL_ReadUpdateBits
+
+the rest of the bits of an entity update, after the first byte
+==================
+*/
+static int CL_ReadUpdateBits (int bits)
+{
+	if (bits & U_MOREBITS)
+		bits |= MSG_ReadByte () << 8;
+
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
+	{
+		if (bits & U_EXTEND1)
+			bits |= MSG_ReadByte() << 16;
+		if (bits & U_EXTEND2)
+			bits |= MSG_ReadByte() << 24;
+	}
+	//johnfitz
+
+	return bits;
+}
+
+/*
+==================
+CL_ReadUpdateFields
+
+reads the fields the bits say are there over the ones in u
+==================
+*/
+static void CL_ReadUpdateFields (entityupdate_t *u, int bits)
+{
+	float		a, b;
+
+	if (bits & U_MODEL)
+		u->modelindex = MSG_ReadByte ();
+	if (bits & U_FRAME)
+		u->frame = MSG_ReadByte ();
+	if (bits & U_COLORMAP)
+		u->colormap = MSG_ReadByte ();
+	if (bits & U_SKIN)
+		u->skin = MSG_ReadByte ();
+	if (bits & U_EFFECTS)
+		u->effects = MSG_ReadByte ();
+	if (bits & U_ORIGIN1)
+		u->origin[0] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE1)
+		u->angles[0] = MSG_ReadAngle (cl.protocolflags);
+	if (bits & U_ORIGIN2)
+		u->origin[1] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE2)
+		u->angles[1] = MSG_ReadAngle (cl.protocolflags);
+	if (bits & U_ORIGIN3)
+		u->origin[2] = MSG_ReadCoord (cl.protocolflags);
+	if (bits & U_ANGLE3)
+		u->angles[2] = MSG_ReadAngle (cl.protocolflags);
+
+	//johnfitz -- PROTOCOL_FITZQUAKE and PROTOCOL_NEHAHRA
+	if (cl.protocol == PROTOCOL_FITZQUAKE || cl.protocol == PROTOCOL_RMQ)
+	{
+		if (bits & U_ALPHA)
+			u->alpha = MSG_ReadByte ();
+		if (bits & U_SCALE)
+			u->scale = MSG_ReadByte ();
+		if (bits & U_FRAME2)
+			u->frame |= MSG_ReadByte () << 8;
+		if (bits & U_MODEL2)
+			u->modelindex |= MSG_ReadByte () << 8;
+		if (bits & U_LERPFINISH)
+			u->lerpfinish = MSG_ReadByte ();
+	}
+	else if (cl.protocol == PROTOCOL_NETQUAKE)
+	{
+		//HACK: if this bit is set, assume this is PROTOCOL_NEHAHRA
+		if (bits & U_TRANS)
+		{
+			if (warn_about_nehahra_protocol)
+			{
+				Con_Warning ("nonstandard update bit, assuming Nehahra protocol\n");
+				warn_about_nehahra_protocol = false;
+			}
+
+			a = MSG_ReadFloat();
+			b = MSG_ReadFloat(); //alpha
+			if (a == 2)
+				MSG_ReadFloat(); //fullbright (not using this yet)
+			u->alpha = ENTALPHA_ENCODE(b);
+		}
+	}
+	//johnfitz
+}
+
+/*
+==================
+CL_ParseUpdate
+
+Parse an entity update message from the server
+==================
+*/
+void CL_ParseUpdate (int bits)
+{
+	entityupdate_t	u;
+
+	Q_memset (&u, 0, sizeof(u));
+
+	bits = CL_ReadUpdateBits (bits);
+	u.bits = bits;
+	if (bits & U_LONGENTITY)
+		u.num = MSG_ReadShort ();
+	else
+		u.num = MSG_ReadByte ();
+	CL_ReadUpdateFields (&u, bits);
+
+	CL_ApplyUpdate (&u);
+}
+
+/*
+==================
+CL_ParseLocalSnapshot
+
+the entities a local server left in sv_snapshot for this message
+==================
+*/
+static void CL_ParseLocalSnapshot (void)
+{
+	int		i, sequence;
+
+	sequence = MSG_ReadLong ();
+	if (!sv_snapshot.pending || sequence != sv_snapshot.sequence)
+		return;		// sent before a level change, they're gone now
+
+	cl_entityspan.offset = msg_readcount - 5;
+	cl_entityspan.length = 5;
+	cl_entityspan.numupdates = sv_snapshot.numupdates;
+	cl_entityspan.updates = sv_snapshot.updates;
+	cl_entityspan.built = false;
+
+	for (i=0 ; i<sv_snapshot.numupdates ; i++)
+		CL_ApplyUpdate (&sv_snapshot.updates[i]);
+	sv_snapshot.pending = false;
+}
+
+/*
+==================
+CL_DeltaFromBaseline
+
+an entity that wasn't in the base snapshot starts from its baseline
+==================
+*/
+static void CL_DeltaFromBaseline (entityupdate_t *u, int num)
+{
+	entity_state_t	*baseline;
+
+	baseline = &CL_EntityNum (num)->baseline;
+	Q_memset (u, 0, sizeof(*u));
+	u->num = num;
+	u->modelindex = baseline->modelindex;
+	u->frame = baseline->frame;
+	u->colormap = baseline->colormap;
+	u->skin = baseline->skin;
+	u->effects = baseline->effects;
+	u->alpha = baseline->alpha;
+	u->scale = baseline->scale;
+	VectorCopy (baseline->origin, u->origin);
+	VectorCopy (baseline->angles, u->angles);
+}
+
+// the snapshots kept for svc_deltaentities to be built from, by sequence
+static deltaframe_t	cl_deltaframes[DELTA_BACKUP];
+static deltaframe_t	cl_deltascratch;		// for one whose base is gone
+static int			*cl_deltaremoved;
+static int			cl_maxdeltaremoved;
+
+entityspan_t		cl_entityspan;
+
+#define	U_DELTAFULL	(U_ORIGIN1|U_ORIGIN2|U_ORIGIN3|U_ANGLE1|U_ANGLE2|U_ANGLE3|U_MODEL|U_MODEL2| \
+					 U_FRAME|U_FRAME2|U_COLORMAP|U_SKIN|U_EFFECTS|U_ALPHA|U_SCALE)
+
+/*
+==================
+CL_ClearDeltaFrames
+
+the last level's snapshots, when a new one starts
+==================
+*/
+void CL_ClearDeltaFrames (void)
+{
+	int		i;
+
+	for (i=0 ; i<DELTA_BACKUP ; i++)
+		cl_deltaframes[i].sequence = 0;
+}
+
+/*
+==================
+CL_ParseDeltaEntities
+
+Builds the snapshot from the base one and the changes, keeps it for later
+ones to be built from, and applies every entity in it. The entities in a
+snapshot have all their fields, so they are applied with every field bit
+set and only the lerp bits as the server sent them.
+==================
+*/
+static void CL_ParseDeltaEntities (int offset)
+{
+	deltaframe_t	*frame, *base;
+	entityupdate_t	*u, *from;
+	int		i, j, k, sequence, basesequence, numremoved, bits, num;
+
+	sequence = MSG_ReadLong ();
+	basesequence = MSG_ReadLong ();
+
+	base = NULL;
+	frame = &cl_deltaframes[sequence & (DELTA_BACKUP-1)];
+	if (basesequence)
+	{
+		base = &cl_deltaframes[basesequence & (DELTA_BACKUP-1)];
+		if (base->sequence != basesequence || base == frame)
+		{
+			Con_DPrintf ("CL_ParseDeltaEntities: no snapshot %i to build %i from\n", basesequence, sequence);
+			base = NULL;
+			frame = &cl_deltascratch;	// read, but not kept or applied
+		}
+	}
+	frame->sequence = 0;
+	frame->numupdates = 0;
+
+	numremoved = 0;
+	while ((num = MSG_ReadShort ()) > 0)
+	{
+		if (numremoved == cl_maxdeltaremoved)
+		{
+			cl_maxdeltaremoved = q_max (64, cl_maxdeltaremoved * 2);
+			cl_deltaremoved = (int *) realloc (cl_deltaremoved, cl_maxdeltaremoved * sizeof(int));
+			if (!cl_deltaremoved)
+				Sys_Error ("CL_ParseDeltaEntities: out of memory");
+		}
+		cl_deltaremoved[numremoved++] = num;
+	}
+
+// merge the updates into what's left of the base, both by entity number
+	i = j = 0;
+	while (1)
+	{
+		bits = MSG_ReadByte ();
+		if (bits <= 0)
+			num = cl_max_edicts;	// the end, copy the rest of the base
+		else
+		{
+			bits = CL_ReadUpdateBits (bits);
+			num = (bits & U_LONGENTITY) ? MSG_ReadShort () : MSG_ReadByte ();
+		}
+
+		for ( ; base && i<base->numupdates && base->updates[i].num < num ; i++)
+		{
+			while (j < numremoved && cl_deltaremoved[j] < base->updates[i].num)
+				j++;
+			if (j < numremoved && cl_deltaremoved[j] == base->updates[i].num)
+				continue;
+			SV_GrowDeltaFrame (frame, frame->numupdates + 1);
+			frame->updates[frame->numupdates++] = base->updates[i];
+		}
+		if (bits <= 0)
+			break;
+
+		from = NULL;
+		if (base && i < base->numupdates && base->updates[i].num == num)
+			from = &base->updates[i++];
+
+		SV_GrowDeltaFrame (frame, frame->numupdates + 1);
+		u = &frame->updates[frame->numupdates++];
+		if (from)
+			*u = *from;
+		else
+			CL_DeltaFromBaseline (u, num);
+		CL_ReadUpdateFields (u, bits);
+		u->bits = U_DELTAFULL | (bits & (U_STEP|U_LERPFINISH));
+
+		if (msg_badread)
+			Host_Error ("CL_ParseDeltaEntities: bad update");
+	}
+
+	cl_entityspan.offset = offset;
+	cl_entityspan.length = msg_readcount - offset;
+	cl_entityspan.numupdates = 0;
+	cl_entityspan.built = true;
+	if (frame == &cl_deltascratch)
+		return;
+
+	frame->sequence = sequence;
+	if (sequence > cl.deltaack)
+		cl.deltaack = sequence;
+	cl_entityspan.numupdates = frame->numupdates;
+	cl_entityspan.updates = frame->updates;
+
+	for (k=0 ; k<frame->numupdates ; k++)
+		CL_ApplyUpdate (&frame->updates[k]);
+}
+
 /*
 ==================
 CL_ParseBaseline
@@ -742,12 +1006,14 @@ void CL_ParseClientdata (void)
 	}
 	//johnfitz
 
+// the status bar compares each element against the stats it was last drawn
+// from, so stat changes no longer need to force a full Sbar_Changed redraw
+
 // [always sent]	if (bits & SU_ITEMS)
 		i = MSG_ReadLong ();
 
 	if (cl.items != i)
 	{	// set flash times
-		Sbar_Changed ();
 		for (j = 0; j < 32; j++)
 			if ( (i & (1<<j)) && !(cl.items & (1<<j)))
 				cl.item_gettime[j] = cl.time;
@@ -766,64 +1032,32 @@ void CL_ParseClientdata (void)
 		i = MSG_ReadByte ();
 	else
 		i = 0;
-	if (cl.stats[STAT_ARMOR] != i)
-	{
-		cl.stats[STAT_ARMOR] = i;
-		Sbar_Changed ();
-	}
+	cl.stats[STAT_ARMOR] = i;
 
 	if (bits & SU_WEAPON)
 		i = MSG_ReadByte ();
 	else
 		i = 0;
-	if (cl.stats[STAT_WEAPON] != i)
-	{
-		cl.stats[STAT_WEAPON] = i;
-		Sbar_Changed ();
-	}
+	cl.stats[STAT_WEAPON] = i;
 
 	i = MSG_ReadShort ();
-	if (cl.stats[STAT_HEALTH] != i)
-	{
-		cl.stats[STAT_HEALTH] = i;
-		Sbar_Changed ();
-	}
+	cl.stats[STAT_HEALTH] = i;
 
 	i = MSG_ReadByte ();
-	if (cl.stats[STAT_AMMO] != i)
-	{
-		cl.stats[STAT_AMMO] = i;
-		Sbar_Changed ();
-	}
+	cl.stats[STAT_AMMO] = i;
 
 	for (i = 0; i < 4; i++)
 	{
 		j = MSG_ReadByte ();
-		if (cl.stats[STAT_SHELLS+i] != j)
-		{
-			cl.stats[STAT_SHELLS+i] = j;
-			Sbar_Changed ();
-		}
+		cl.stats[STAT_SHELLS+i] = j;
 	}
 
 	i = MSG_ReadByte ();
 
 	if (standard_quake)
-	{
-		if (cl.stats[STAT_ACTIVEWEAPON] != i)
-		{
-			cl.stats[STAT_ACTIVEWEAPON] = i;
-			Sbar_Changed ();
-		}
-	}
+		cl.stats[STAT_ACTIVEWEAPON] = i;
 	else
-	{
-		if (cl.stats[STAT_ACTIVEWEAPON] != (1<<i))
-		{
-			cl.stats[STAT_ACTIVEWEAPON] = (1<<i);
-			Sbar_Changed ();
-		}
-	}
+		cl.stats[STAT_ACTIVEWEAPON] = (1<<i);
 
 	//johnfitz -- PROTOCOL_FITZQUAKE
 	if (bits & SU_WEAPON2)
@@ -1022,6 +1256,7 @@ void CL_ParseServerMessage (void)
 // parse the message
 //
 	MSG_BeginReading ();
+	cl_entityspan.length = 0;
 
 	lastcmd = 0;
 	while (1)
@@ -1066,6 +1301,14 @@ void CL_ParseServerMessage (void)
 			cl.mtime[0] = MSG_ReadFloat ();
 			break;
 
+		case svc_localsnapshot:
+			CL_ParseLocalSnapshot ();
+			break;
+
+		case svc_deltaentities:
+			CL_ParseDeltaEntities (msg_readcount - 1);
+			break;
+
 		case svc_clientdata:
 			CL_ParseClientdata (); //johnfitz -- removed bits parameter, we will read this inside CL_ParseClientdata()
 			break;
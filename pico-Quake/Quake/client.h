@@ -69,6 +69,8 @@ typedef struct
 	vec3_t	origin;
 	float	radius;
 	float	die;				// stop lighting after this time
+	float	lit;				// the time it was allocated, so die - lit is how long it lives
+	qboolean	persist;		// renewed under the same key, so not a flash
 	float	decay;				// drop this each second
 	float	minlight;			// don't add when contributing less
 	int		key;
@@ -224,8 +226,20 @@ typedef struct
 
 	unsigned	protocol; //johnfitz
 	unsigned	protocolflags;
+
+	int			deltaack;		// the last svc_deltaentities read, acked with every move
 } client_state_t;
 
+// where the entities of the message being read were found when they weren't
+// sent as updates, so a demo can have them written out as updates instead
+typedef struct
+{
+	int				offset, length;		// length is 0 when there were none
+	int				numupdates;
+	entityupdate_t	*updates;
+	qboolean		built;				// from a snapshot, with only the bits CL_ApplyUpdate needs
+} entityspan_t;
+
 
 //
 // cvars
@@ -334,6 +348,7 @@ void CL_ClearState (void);
 //
 void CL_StopPlayback (void);
 int CL_GetMessage (void);
+void CL_FinishDemoMessage (void);
 void CL_ClearSignons (void);
 
 void CL_Stop_f (void);
@@ -346,6 +361,9 @@ void CL_TimeDemo_f (void);
 //
 void CL_ParseServerMessage (void);
 void CL_NewTranslation (int slot);
+void CL_ClearDeltaFrames (void);
+
+extern	entityspan_t	cl_entityspan;
 
 //
 // view
@@ -103,6 +103,12 @@ void Cbuf_AddText (const char *text)
 {
 	int	l;
 
+	if (Host_PipelineThread ())
+	{
+		Host_PipelineCommand (text);	// the buffer belongs to the main thread
+		return;
+	}
+
 	l = Q_strlen (text);
 
 	if (cmd_text.cursize + l >= cmd_text.maxsize)
@@ -129,6 +135,13 @@ void Cbuf_InsertText (const char *text)
 	char	*temp;
 	int		templen;
 
+	if (Host_PipelineThread ())
+	{
+		Host_PipelineCommand (text);	// after whatever is left, when joined
+		Host_PipelineCommand ("\n");
+		return;
+	}
+
 // copy off any commands still remaining in the exec buffer
 	templen = cmd_text.cursize;
 	if (templen)
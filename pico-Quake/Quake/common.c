@@ -767,6 +767,72 @@ void MSG_WriteAngle16 (sizebuf_t *sb, float f, unsigned int flags)
 }
 //johnfitz
 
+/*
+=============
+MSG_WriteEntityUpdate
+
+an entity update as the server sends it, also used by the client to put the
+updates of a local snapshot into a demo
+=============
+*/
+void MSG_WriteEntityUpdate (sizebuf_t *msg, const entityupdate_t *u, unsigned int protocolflags)
+{
+	int		bits = u->bits;
+
+	MSG_WriteByte (msg, bits | U_SIGNAL);
+
+	if (bits & U_MOREBITS)
+		MSG_WriteByte (msg, bits>>8);
+
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	if (bits & U_EXTEND1)
+		MSG_WriteByte(msg, bits>>16);
+	if (bits & U_EXTEND2)
+		MSG_WriteByte(msg, bits>>24);
+	//johnfitz
+
+	if (bits & U_LONGENTITY)
+		MSG_WriteShort (msg,u->num);
+	else
+		MSG_WriteByte (msg,u->num);
+
+	if (bits & U_MODEL)
+		MSG_WriteByte (msg,	u->modelindex);
+	if (bits & U_FRAME)
+		MSG_WriteByte (msg, u->frame);
+	if (bits & U_COLORMAP)
+		MSG_WriteByte (msg, u->colormap);
+	if (bits & U_SKIN)
+		MSG_WriteByte (msg, u->skin);
+	if (bits & U_EFFECTS)
+		MSG_WriteByte (msg, u->effects);
+	if (bits & U_ORIGIN1)
+		MSG_WriteCoord (msg, u->origin[0], protocolflags);
+	if (bits & U_ANGLE1)
+		MSG_WriteAngle(msg, u->angles[0], protocolflags);
+	if (bits & U_ORIGIN2)
+		MSG_WriteCoord (msg, u->origin[1], protocolflags);
+	if (bits & U_ANGLE2)
+		MSG_WriteAngle(msg, u->angles[1], protocolflags);
+	if (bits & U_ORIGIN3)
+		MSG_WriteCoord (msg, u->origin[2], protocolflags);
+	if (bits & U_ANGLE3)
+		MSG_WriteAngle(msg, u->angles[2], protocolflags);
+
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	if (bits & U_ALPHA)
+		MSG_WriteByte(msg, u->alpha);
+	if (bits & U_SCALE)
+		MSG_WriteByte(msg, u->scale);
+	if (bits & U_FRAME2)
+		MSG_WriteByte(msg, u->frame >> 8);
+	if (bits & U_MODEL2)
+		MSG_WriteByte(msg, u->modelindex >> 8);
+	if (bits & U_LERPFINISH)
+		MSG_WriteByte(msg, u->lerpfinish);
+	//johnfitz
+}
+
 //
 // reading functions
 //
@@ -947,6 +1013,7 @@ void SZ_Alloc (sizebuf_t *buf, int startsize)
 	buf->data = (byte *) Hunk_AllocName (startsize, "sizebuf");
 	buf->maxsize = startsize;
 	buf->cursize = 0;
+	buf->headroom = 0;
 }
 
 
@@ -963,6 +1030,102 @@ void SZ_Clear (sizebuf_t *buf)
 	buf->cursize = 0;
 }
 
+/*
+==============================================================================
+
+POOLED MESSAGE BUFFERS
+
+Message buffers are made of whole fragments, and the ones given back go on
+a list for their number of fragments, so sockets and clients that come and
+go reuse each other's instead of going back to the heap.
+
+==============================================================================
+*/
+
+#define	MSG_FRAGMENT			1024
+#define	MSG_FRAGMENTS(size)		(((size) + MSG_FRAGMENT - 1) / MSG_FRAGMENT)
+#define	MSG_POOLCLASSES			64		// enough for MAX_MSGLEN
+
+typedef struct msgblock_s
+{
+	struct msgblock_s	*next;
+} msgblock_t;
+
+static msgblock_t	*msg_pool[MSG_POOLCLASSES + 1];
+
+byte *MSG_AllocBuffer (int size)
+{
+	msgblock_t	*block;
+	int			n;
+
+	n = q_max (MSG_FRAGMENTS (size), 1);
+	if (n <= MSG_POOLCLASSES && msg_pool[n])
+	{
+		block = msg_pool[n];
+		msg_pool[n] = block->next;
+		return (byte *) block;
+	}
+
+	block = (msgblock_t *) malloc (n * MSG_FRAGMENT);
+	if (!block)
+		Sys_Error ("MSG_AllocBuffer: couldn't allocate %i bytes", n * MSG_FRAGMENT);
+	return (byte *) block;
+}
+
+void MSG_FreeBuffer (byte *data, int size)
+{
+	msgblock_t	*block = (msgblock_t *) data;
+	int			n;
+
+	if (!data)
+		return;
+
+	n = q_max (MSG_FRAGMENTS (size), 1);
+	if (n > MSG_POOLCLASSES)
+	{
+		free (data);
+		return;
+	}
+	block->next = msg_pool[n];
+	msg_pool[n] = block;
+}
+
+/*
+================
+MSG_ResizeBuffer
+
+a buffer of newsize from the pool, with the first keep bytes of data, which
+is given back
+================
+*/
+byte *MSG_ResizeBuffer (byte *data, int oldsize, int newsize, int keep)
+{
+	byte	*newdata;
+
+	if (data && MSG_FRAGMENTS (oldsize) == MSG_FRAGMENTS (newsize))
+		return data;
+
+	newdata = MSG_AllocBuffer (newsize);
+	if (data && keep)
+		memcpy (newdata, data, keep);
+	MSG_FreeBuffer (data, oldsize);
+	return newdata;
+}
+
+/*
+================
+SZ_Resize
+
+for sizebufs from the pool, keeping what has been written so far
+================
+*/
+void SZ_Resize (sizebuf_t *buf, int size)
+{
+	size = q_max (size, buf->cursize);
+	buf->data = MSG_ResizeBuffer (buf->data, buf->maxsize, size, buf->cursize);
+	buf->maxsize = size;
+}
+
 void *SZ_GetSpace (sizebuf_t *buf, int length)
 {
 	void	*data;
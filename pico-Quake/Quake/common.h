@@ -118,6 +118,7 @@ typedef struct sizebuf_s
 	byte		*data;
 	int		maxsize;
 	int		cursize;
+	int		headroom;		// bytes free before data, for the net layer's header
 } sizebuf_t;
 
 void SZ_Alloc (sizebuf_t *buf, int startsize);
@@ -126,6 +127,11 @@ void SZ_Clear (sizebuf_t *buf);
 void *SZ_GetSpace (sizebuf_t *buf, int length);
 void SZ_Write (sizebuf_t *buf, const void *data, int length);
 void SZ_Print (sizebuf_t *buf, const char *data);	// strcats onto the sizebuf
+void SZ_Resize (sizebuf_t *buf, int size);	// only for sizebufs from the pool
+
+byte *MSG_AllocBuffer (int size);
+void MSG_FreeBuffer (byte *data, int size);
+byte *MSG_ResizeBuffer (byte *data, int oldsize, int newsize, int keep);
 
 //============================================================================
 
@@ -186,6 +192,8 @@ void MSG_WriteString (sizebuf_t *sb, const char *s);
 void MSG_WriteCoord (sizebuf_t *sb, float f, unsigned int flags);
 void MSG_WriteAngle (sizebuf_t *sb, float f, unsigned int flags);
 void MSG_WriteAngle16 (sizebuf_t *sb, float f, unsigned int flags); //johnfitz
+struct entityupdate_s;
+void MSG_WriteEntityUpdate (sizebuf_t *msg, const struct entityupdate_s *u, unsigned int protocolflags);
 
 extern	int			msg_readcount;
 extern	qboolean	msg_badread;		// set if a read goes beyond end of message
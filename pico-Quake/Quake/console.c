@@ -48,6 +48,7 @@ int		con_backscroll;		// lines up from bottom to display
 int		con_current;		// where next message will be printed
 int		con_x;				// offset in current line for next print
 char		*con_text = NULL;
+static int	con_changes;		// bumped whenever the text buffer is modified
 
 cvar_t		con_notifytime = {"con_notifytime","3",CVAR_NONE};	//seconds
 cvar_t		con_logcenterprint = {"con_logcenterprint", "1", CVAR_NONE}; //johnfitz
@@ -142,6 +143,7 @@ static void Con_Clear_f (void)
 	if (con_text)
 		Q_memset (con_text, ' ', con_buffersize); //johnfitz -- con_buffersize replaces CON_TEXTSIZE
 	con_backscroll = 0; //johnfitz -- if console is empty, being scrolled up is confusing
+	con_changes++;
 }
 
 /*
@@ -294,6 +296,7 @@ void Con_CheckResize (void)
 
 	con_backscroll = 0;
 	con_current = con_totallines - 1;
+	con_changes++;
 }
 
 
@@ -378,6 +381,8 @@ static void Con_Print (const char *txt)
 	int		mask;
 	qboolean	boundary;
 
+	con_changes++;
+
 	//con_backscroll = 0; //johnfitz -- better console scrolling
 
 	if (txt[0] == 1)
@@ -498,6 +503,12 @@ void Con_Printf (const char *fmt, ...)
 	q_vsnprintf (msg, sizeof(msg), fmt, argptr);
 	va_end (argptr);
 
+	if (Host_PipelineThread ())
+	{
+		Host_PipelinePrint (msg);	// the console belongs to the main thread
+		return;
+	}
+
 // also echo to debugging console
 	Sys_Printf ("%s", msg);
 
@@ -632,6 +643,12 @@ void Con_SafePrintf (const char *fmt, ...)
 	q_vsnprintf (msg, sizeof(msg), fmt, argptr);
 	va_end (argptr);
 
+	if (Host_PipelineThread ())
+	{
+		Host_PipelinePrint (msg);
+		return;
+	}
+
 	temp = scr_disabled_for_loading;
 	scr_disabled_for_loading = true;
 	Con_Printf ("%s", msg);
@@ -1241,6 +1258,30 @@ void Con_DrawConsole (int lines, qboolean drawinput)
 }
 
 
+/*
+================
+Con_Signature
+
+hashes everything Con_DrawConsole draws from, so the screen can tell when a
+full screen console has to be redrawn
+================
+*/
+unsigned int Con_Signature (void)
+{
+	unsigned int	signature;
+	const char	*text;
+
+	signature = SCR_HudHash (con_changes, con_backscroll);
+	signature = SCR_HudHash (signature, edit_line);
+	signature = SCR_HudHash (signature, key_linepos);
+	signature = SCR_HudHash (signature, key_insert);
+	signature = SCR_HudHash (signature, (int)((realtime-key_blinktime)*con_cursorspeed) & 1);
+	for (text = key_lines[edit_line]; *text; text++)
+		signature = SCR_HudHash (signature, *text);
+
+	return signature;
+}
+
 /*
 ==================
 Con_NotifyBox
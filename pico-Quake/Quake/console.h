@@ -39,6 +39,7 @@ void Con_DrawCharacter (int cx, int line, int num);
 void Con_CheckResize (void);
 void Con_Init (void);
 void Con_DrawConsole (int lines, qboolean drawinput);
+unsigned int Con_Signature (void);
 void Con_Printf (const char *fmt, ...) FUNC_PRINTF(1,2);
 void Con_DWarning (const char *fmt, ...) FUNC_PRINTF(1,2); //ericw
 void Con_Warning (const char *fmt, ...) FUNC_PRINTF(1,2); //johnfitz
@@ -368,12 +368,7 @@ Cvar_VariableValue
 */
 float	Cvar_VariableValue (const char *var_name)
 {
-	cvar_t	*var;
-
-	var = Cvar_FindVar (var_name);
-	if (!var)
-		return 0;
-	return Q_atof (var->string);
+	return Q_atof (Cvar_VariableString (var_name));
 }
 
 
@@ -385,10 +380,13 @@ Cvar_VariableString
 const char *Cvar_VariableString (const char *var_name)
 {
 	cvar_t *var;
+	const char *pending;
 
 	var = Cvar_FindVar (var_name);
 	if (!var)
 		return "";
+	if (Host_PipelineThread () && (pending = Host_PipelineCvar (var)) != NULL)
+		return pending;	// set by this server frame, not made yet
 	return var->string;
 }
 
@@ -445,6 +443,12 @@ void Cvar_SetQuick (cvar_t *var, const char *value)
 	if (!(var->flags & CVAR_REGISTERED))
 		return;
 
+	if (Host_PipelineThread ())
+	{
+		Host_PipelineSetCvar (var, value);	// cvars belong to the main thread
+		return;
+	}
+
 	if (!var->string)
 		var->string = Z_Strdup (value);
 	else
@@ -64,6 +64,7 @@ cvar_t	host_timescale = {"host_timescale", "0", CVAR_NONE}; //johnfitz
 cvar_t	max_edicts = {"max_edicts", "8192", CVAR_NONE}; //johnfitz //ericw -- changed from 2048 to 8192, removed CVAR_ARCHIVE
 
 cvar_t	sys_ticrate = {"sys_ticrate","0.05",CVAR_NONE}; // dedicated server
+cvar_t	sys_mintic = {"sys_mintic","0.013",CVAR_NONE}; // dedicated server, soonest a client's packet starts a frame
 cvar_t	serverprofile = {"serverprofile","0",CVAR_NONE};
 
 cvar_t	fraglimit = {"fraglimit","0",CVAR_NOTIFY|CVAR_SERVERINFO};
@@ -88,6 +89,7 @@ cvar_t	horde = {"horde","0",CVAR_NONE}; // for the 2021 rerelease
 cvar_t	sv_cheats = {"sv_cheats","0",CVAR_NONE}; // for the 2021 rerelease
 
 devstats_t dev_stats, dev_peakstats;
+devstats_t sv_devstats, sv_devpeakstats;
 overflowtimes_t dev_overflows; //this stores the last time overflow messages were displayed, not the last time overflows occured
 
 /*
@@ -123,6 +125,8 @@ void Host_EndGame (const char *message, ...)
 	va_list		argptr;
 	char		string[1024];
 
+	Host_FinishServerFrame ();
+
 	va_start (argptr,message);
 	q_vsnprintf (string, sizeof(string), message, argptr);
 	va_end (argptr);
@@ -155,15 +159,20 @@ void Host_Error (const char *error, ...)
 	char		string[1024];
 	static	qboolean inerror = false;
 
+	va_start (argptr,error);
+	q_vsnprintf (string, sizeof(string), error, argptr);
+	va_end (argptr);
+
+	if (Host_PipelineThread ())
+		Host_PipelineError (string);	// raised again on the main thread
+	Host_FinishServerFrame ();
+
 	if (inerror)
 		Sys_Error ("Host_Error: recursively entered");
 	inerror = true;
 
 	SCR_EndLoadingPlaque ();		// reenable screen updates
 
-	va_start (argptr,error);
-	q_vsnprintf (string, sizeof(string), error, argptr);
-	va_end (argptr);
 	Con_Printf ("Host_Error: %s\n",string);
 
 	if (sv.active)
@@ -246,6 +255,43 @@ void Host_Callback_Notify (cvar_t *var)
 		SV_BroadcastPrintf ("\"%s\" changed to \"%s\"\n", var->name, var->string);
 }
 
+/*
+=======================
+Host_TickStats_f
+
+how late the dedicated server's ticks have started since the last time
+=======================
+*/
+#define	TICK_BUCKETS	8
+
+static const double	tick_bucketlimits[TICK_BUCKETS] = {0.0001, 0.00025, 0.0005, 0.001, 0.002, 0.005, 0.01, 1e30};
+static int		tick_late[TICK_BUCKETS];	// ticks started by the clock, by lateness
+static int		tick_woken;					// frames started early by a client's packet
+static double	tick_worst;
+
+static void Host_TickStats_f (void)
+{
+	int		i, total;
+	double	lo;
+
+	for (i = total = 0; i < TICK_BUCKETS; i++)
+		total += tick_late[i];
+
+	Con_Printf ("%i ticks on time, %i frames started by packets\n", total, tick_woken);
+	for (i = 0, lo = 0; i < TICK_BUCKETS; lo = tick_bucketlimits[i++])
+	{
+		if (i < TICK_BUCKETS - 1)
+			Con_Printf ("  %6.2f - %6.2f ms late: %i\n", lo * 1000, tick_bucketlimits[i] * 1000, tick_late[i]);
+		else
+			Con_Printf ("  %6.2f ms or later:  %i\n", lo * 1000, tick_late[i]);
+	}
+	Con_Printf ("  worst %.2f ms\n", tick_worst * 1000);
+
+	memset (tick_late, 0, sizeof(tick_late));
+	tick_woken = 0;
+	tick_worst = 0;
+}
+
 /*
 =======================
 Host_InitLocal
@@ -268,8 +314,11 @@ void Host_InitLocal (void)
 	Cvar_RegisterVariable (&devstats); //johnfitz
 
 	Cvar_RegisterVariable (&sys_ticrate);
+	Cvar_RegisterVariable (&sys_mintic);
+	Cmd_AddCommand ("tickstats", Host_TickStats_f);
 	Cvar_RegisterVariable (&sys_throttle);
 	Cvar_RegisterVariable (&serverprofile);
+	Host_InitPipeline ();
 
 	Cvar_RegisterVariable (&fraglimit);
 	Cvar_RegisterVariable (&timelimit);
@@ -546,6 +595,8 @@ not reinitialize anything.
 */
 void Host_ClearMemory (void)
 {
+	int		i;
+
 	Con_DPrintf ("Clearing memory\n");
 	D_FlushCaches ();
 	Mod_ClearAll ();
@@ -554,6 +605,17 @@ void Host_ClearMemory (void)
 	Hunk_FreeToLowMark (host_hunklevel);
 	cls.signon = 0; // not CL_ClearSignons()
 	free(sv.edicts); // ericw -- sv.edicts switched to use malloc()
+	free(sv.edictleafs);
+	free(sv.baselines);
+	free(sv.physwake);
+	free(sv.netedicts);
+	free(sv.baselineedicts);
+	free(sv.edictthink);
+	for (i = 0; i < sv.num_signon_buffers; i++)
+		free(sv.signon_buffers[i]);
+	MSG_FreeBuffer (sv.datagram.data, sv.datagram.maxsize);
+	MSG_FreeBuffer (sv.reliable_datagram.data, sv.reliable_datagram.maxsize);
+	MSG_FreeBuffer (sv.clientdatagram.data, sv.clientdatagram.maxsize);
 	memset (&sv, 0, sizeof(sv));
 	memset (&cl, 0, sizeof(cl));
 }
@@ -639,6 +701,7 @@ void Host_ServerFrame (void)
 	SV_ClearDatagram ();
 
 // check for new clients
+	NET_BeginBatch ();
 	SV_CheckForNewClients ();
 
 // read client messages
@@ -649,24 +712,86 @@ void Host_ServerFrame (void)
 	if (!sv.paused && (svs.maxclients > 1 || key_dest == key_game) )
 		SV_Physics ();
 
+// give back the strings of removed edicts
+	PR_ReclaimStrings ();
+
 //johnfitz -- devstats
 	if (cls.signon == SIGNONS)
 	{
 		for (i=0, active=0; i<sv.num_edicts; i++)
 		{
 			ent = EDICT_NUM(i);
-			if (!ent->free)
+			if (!ent->hot->free)
 				active++;
 		}
-		if (active > 600 && dev_peakstats.edicts <= 600)
+		if (active > 600 && sv_devpeakstats.edicts <= 600)
 			Con_DWarning ("%i edicts exceeds standard limit of 600 (max = %d).\n", active, sv.max_edicts);
-		dev_stats.edicts = active;
-		dev_peakstats.edicts = q_max(active, dev_peakstats.edicts);
+		sv_devstats.edicts = active;
+		sv_devpeakstats.edicts = q_max(active, sv_devpeakstats.edicts);
 	}
 //johnfitz
 
 // send all messages to the clients
 	SV_SendClientMessages ();
+	NET_EndBatch ();
+}
+
+/*
+==================
+Host_WaitForTick
+
+Sleeps a dedicated server until its next frame is due, and returns the time
+it starts. The ticks are sys_ticrate apart, kept to the clock rather than to
+when the last frame happened to start. A client's packet starts the frame
+early, but not before sys_mintic has passed since the last one, so that
+moves are answered as they come in without a frame for every packet. The
+next tick is then sys_ticrate after that frame.
+==================
+*/
+double Host_WaitForTick (double lasttime)
+{
+	static double	nexttick;
+	double	ticrate, mintic, newtime, late;
+	int		i;
+
+	ticrate = q_max (sys_ticrate.value, 0.001);
+	mintic = q_max (sys_mintic.value, 1.0 / CLAMP (10.f, host_maxfps.value, 1000.f));	// Host_FilterTime's limit
+	mintic = q_min (mintic, ticrate);
+
+	newtime = Sys_DoubleTime ();
+	if (nexttick < lasttime || nexttick - newtime > ticrate)
+		nexttick = lasttime + ticrate;	// the first, or the clock or sys_ticrate changed
+
+	// nothing wakes us before sys_mintic
+	if (newtime < lasttime + mintic)
+	{
+		NET_Wait (lasttime + mintic - newtime, false);
+		newtime = Sys_DoubleTime ();
+	}
+
+	if (newtime < nexttick && NET_Wait (nexttick - newtime, true))
+	{
+		newtime = Sys_DoubleTime ();
+		if (newtime < nexttick)
+		{	// this frame is the tick
+			tick_woken++;
+			nexttick = newtime + ticrate;
+			return newtime;
+		}
+	}
+	newtime = Sys_DoubleTime ();
+
+	late = newtime - nexttick;
+	for (i = 0; late >= tick_bucketlimits[i]; i++)
+		;
+	tick_late[i]++;
+	tick_worst = q_max (tick_worst, late);
+
+	// skip ticks that were missed outright rather than run them back to back
+	nexttick += ticrate;
+	if (nexttick < newtime)
+		nexttick = newtime + ticrate;
+	return newtime;
 }
 
 /*
@@ -681,7 +806,8 @@ void _Host_Frame (float time)
 	static double		time1 = 0;
 	static double		time2 = 0;
 	static double		time3 = 0;
-	int			pass1, pass2, pass3;
+	int			pass1, pass2, pass3, sim, stall;
+	qboolean	pipelined;
 
 	if (setjmp (host_abortserver) )
 		return;			// something bad happened, or the server disconnected
@@ -719,7 +845,8 @@ void _Host_Frame (float time)
 // check for commands typed to the host
 	Host_GetConsoleCommands ();
 
-	if (sv.active)
+	pipelined = Host_PipelineFrame ();
+	if (sv.active && !pipelined)
 		Host_ServerFrame ();
 
 //-------------------
@@ -737,6 +864,11 @@ void _Host_Frame (float time)
 	if (cls.state == ca_connected)
 		CL_ReadFromServer ();
 
+// the client has read everything the server sent last frame, so the server
+// can run this one on the other thread while the client renders
+	if (pipelined)
+		Host_StartServerFrame ();
+
 // update video
 	if (host_speeds.value)
 		time1 = Sys_DoubleTime ();
@@ -760,14 +892,29 @@ void _Host_Frame (float time)
 
 	CDAudio_Update();
 
+	Host_FinishServerFrame ();
+
+// the server's devstats, now that it's not running
+	dev_stats.edicts = sv_devstats.edicts;
+	dev_stats.packetsize = sv_devstats.packetsize;
+	dev_peakstats.edicts = sv_devpeakstats.edicts;
+	dev_peakstats.packetsize = sv_devpeakstats.packetsize;
+
 	if (host_speeds.value)
 	{
 		pass1 = (time1 - time3)*1000;
 		time3 = Sys_DoubleTime ();
 		pass2 = (time2 - time1)*1000;
 		pass3 = (time3 - time2)*1000;
-		Con_Printf ("%3i tot %3i server %3i gfx %3i snd\n",
-					pass1+pass2+pass3, pass1, pass2, pass3);
+		if (pipelined)
+		{
+			Host_PipelineSpeeds (&sim, &stall);
+			Con_Printf ("%3i tot %3i client %3i gfx %3i snd %3i sim %3i stall\n",
+						pass1+pass2+pass3, pass1, pass2, pass3, sim, stall);
+		}
+		else
+			Con_Printf ("%3i tot %3i server %3i gfx %3i snd\n",
+						pass1+pass2+pass3, pass1, pass2, pass3);
 	}
 
 	host_framecount++;
@@ -926,6 +1073,9 @@ void Host_Shutdown(void)
 // keep Con_Printf from trying to update the screen
 	scr_disabled_for_loading = true;
 
+	Host_ShutdownPipeline ();
+	SV_ShutdownWorkers ();
+
 	Host_WriteConfiguration ();
 
 	NET_Shutdown ();
@@ -487,8 +487,8 @@ static void Host_God_f (void)
 	switch (Cmd_Argc())
 	{
 	case 1:
-		sv_player->v.flags = (int)sv_player->v.flags ^ FL_GODMODE;
-		if (!((int)sv_player->v.flags & FL_GODMODE) )
+		sv_player->hot->flags = (int)sv_player->hot->flags ^ FL_GODMODE;
+		if (!((int)sv_player->hot->flags & FL_GODMODE) )
 			SV_ClientPrintf ("godmode OFF\n");
 		else
 			SV_ClientPrintf ("godmode ON\n");
@@ -496,12 +496,12 @@ static void Host_God_f (void)
 	case 2:
 		if (Q_atof(Cmd_Argv(1)))
 		{
-			sv_player->v.flags = (int)sv_player->v.flags | FL_GODMODE;
+			sv_player->hot->flags = (int)sv_player->hot->flags | FL_GODMODE;
 			SV_ClientPrintf ("godmode ON\n");
 		}
 		else
 		{
-			sv_player->v.flags = (int)sv_player->v.flags & ~FL_GODMODE;
+			sv_player->hot->flags = (int)sv_player->hot->flags & ~FL_GODMODE;
 			SV_ClientPrintf ("godmode OFF\n");
 		}
 		break;
@@ -532,8 +532,8 @@ static void Host_Notarget_f (void)
 	switch (Cmd_Argc())
 	{
 	case 1:
-		sv_player->v.flags = (int)sv_player->v.flags ^ FL_NOTARGET;
-		if (!((int)sv_player->v.flags & FL_NOTARGET) )
+		sv_player->hot->flags = (int)sv_player->hot->flags ^ FL_NOTARGET;
+		if (!((int)sv_player->hot->flags & FL_NOTARGET) )
 			SV_ClientPrintf ("notarget OFF\n");
 		else
 			SV_ClientPrintf ("notarget ON\n");
@@ -541,12 +541,12 @@ static void Host_Notarget_f (void)
 	case 2:
 		if (Q_atof(Cmd_Argv(1)))
 		{
-			sv_player->v.flags = (int)sv_player->v.flags | FL_NOTARGET;
+			sv_player->hot->flags = (int)sv_player->hot->flags | FL_NOTARGET;
 			SV_ClientPrintf ("notarget ON\n");
 		}
 		else
 		{
-			sv_player->v.flags = (int)sv_player->v.flags & ~FL_NOTARGET;
+			sv_player->hot->flags = (int)sv_player->hot->flags & ~FL_NOTARGET;
 			SV_ClientPrintf ("notarget OFF\n");
 		}
 		break;
@@ -579,16 +579,16 @@ static void Host_Noclip_f (void)
 	switch (Cmd_Argc())
 	{
 	case 1:
-		if (sv_player->v.movetype != MOVETYPE_NOCLIP)
+		if (sv_player->hot->movetype != MOVETYPE_NOCLIP)
 		{
 			noclip_anglehack = true;
-			sv_player->v.movetype = MOVETYPE_NOCLIP;
+			sv_player->hot->movetype = MOVETYPE_NOCLIP;
 			SV_ClientPrintf ("noclip ON\n");
 		}
 		else
 		{
 			noclip_anglehack = false;
-			sv_player->v.movetype = MOVETYPE_WALK;
+			sv_player->hot->movetype = MOVETYPE_WALK;
 			SV_ClientPrintf ("noclip OFF\n");
 		}
 		break;
@@ -596,13 +596,13 @@ static void Host_Noclip_f (void)
 		if (Q_atof(Cmd_Argv(1)))
 		{
 			noclip_anglehack = true;
-			sv_player->v.movetype = MOVETYPE_NOCLIP;
+			sv_player->hot->movetype = MOVETYPE_NOCLIP;
 			SV_ClientPrintf ("noclip ON\n");
 		}
 		else
 		{
 			noclip_anglehack = false;
-			sv_player->v.movetype = MOVETYPE_WALK;
+			sv_player->hot->movetype = MOVETYPE_WALK;
 			SV_ClientPrintf ("noclip OFF\n");
 		}
 		break;
@@ -638,30 +638,30 @@ static void Host_SetPos_f(void)
 		SV_ClientPrintf("   setpos <x> <y> <z> <pitch> <yaw> <roll>\n");
 		SV_ClientPrintf("current values:\n");
 		SV_ClientPrintf("   %i %i %i %i %i %i\n",
-			(int)sv_player->v.origin[0],
-			(int)sv_player->v.origin[1],
-			(int)sv_player->v.origin[2],
+			(int)sv_player->hot->origin[0],
+			(int)sv_player->hot->origin[1],
+			(int)sv_player->hot->origin[2],
 			(int)sv_player->v.v_angle[0],
 			(int)sv_player->v.v_angle[1],
 			(int)sv_player->v.v_angle[2]);
 		return;
 	}
 
-	if (sv_player->v.movetype != MOVETYPE_NOCLIP)
+	if (sv_player->hot->movetype != MOVETYPE_NOCLIP)
 	{
 		noclip_anglehack = true;
-		sv_player->v.movetype = MOVETYPE_NOCLIP;
+		sv_player->hot->movetype = MOVETYPE_NOCLIP;
 		SV_ClientPrintf ("noclip ON\n");
 	}
 
 	//make sure they're not going to whizz away from it
-	sv_player->v.velocity[0] = 0;
-	sv_player->v.velocity[1] = 0;
-	sv_player->v.velocity[2] = 0;
+	sv_player->hot->velocity[0] = 0;
+	sv_player->hot->velocity[1] = 0;
+	sv_player->hot->velocity[2] = 0;
 	
-	sv_player->v.origin[0] = atof(Cmd_Argv(1));
-	sv_player->v.origin[1] = atof(Cmd_Argv(2));
-	sv_player->v.origin[2] = atof(Cmd_Argv(3));
+	sv_player->hot->origin[0] = atof(Cmd_Argv(1));
+	sv_player->hot->origin[1] = atof(Cmd_Argv(2));
+	sv_player->hot->origin[2] = atof(Cmd_Argv(3));
 	
 	if (Cmd_Argc() == 7)
 	{
@@ -696,26 +696,26 @@ static void Host_Fly_f (void)
 	switch (Cmd_Argc())
 	{
 	case 1:
-		if (sv_player->v.movetype != MOVETYPE_FLY)
+		if (sv_player->hot->movetype != MOVETYPE_FLY)
 		{
-			sv_player->v.movetype = MOVETYPE_FLY;
+			sv_player->hot->movetype = MOVETYPE_FLY;
 			SV_ClientPrintf ("flymode ON\n");
 		}
 		else
 		{
-			sv_player->v.movetype = MOVETYPE_WALK;
+			sv_player->hot->movetype = MOVETYPE_WALK;
 			SV_ClientPrintf ("flymode OFF\n");
 		}
 		break;
 	case 2:
 		if (Q_atof(Cmd_Argv(1)))
 		{
-			sv_player->v.movetype = MOVETYPE_FLY;
+			sv_player->hot->movetype = MOVETYPE_FLY;
 			SV_ClientPrintf ("flymode ON\n");
 		}
 		else
 		{
-			sv_player->v.movetype = MOVETYPE_WALK;
+			sv_player->hot->movetype = MOVETYPE_WALK;
 			SV_ClientPrintf ("flymode OFF\n");
 		}
 		break;
@@ -1234,17 +1234,18 @@ static void Host_Loadgame_f (void)
 		{	// parse an edict
 			ent = EDICT_NUM(entnum);
 			if (entnum < sv.num_edicts) {
-				ent->free = false;
-				memset (&ent->v, 0, progs->entityfields * 4);
+				ent->hot->free = false;
+				ED_ClearFields (ent);
 			}
 			else {
-				memset (ent, 0, pr_edict_size);
-				ent->baseline.scale = ENTSCALE_DEFAULT;
+				ED_ZeroEdict (entnum);
+				memset (&sv.baselines[entnum], 0, sizeof(entity_state_t));
+				sv.baselines[entnum].scale = ENTSCALE_DEFAULT;
 			}
 			data = ED_ParseEdict (data, ent);
 
 		// link it into the bsp tree
-			if (!ent->free)
+			if (!ent->hot->free)
 				SV_LinkEdict (ent, false);
 		}
 
@@ -1646,7 +1647,7 @@ static void Host_Spawn_f (void)
 		// set up the edict
 		ent = host_client->edict;
 
-		memset (&ent->v, 0, progs->entityfields * 4);
+		ED_ClearFields (ent);
 		ent->v.colormap = NUM_FOR_EDICT(ent);
 		ent->v.team = (host_client->colors & 15) + 1;
 		ent->v.netname = PR_SetEngineString(host_client->name);
@@ -2082,7 +2083,10 @@ static edict_t	*FindViewthing (void)
 	{
 		e = EDICT_NUM(i);
 		if ( !strcmp (PR_GetString(e->v.classname), "viewthing") )
+		{
+			SV_WakeEdict (i);	// the callers change its frame
 			return e;
+		}
 	}
 	Con_Printf ("No viewthing on map\n");
 	return NULL;
@@ -0,0 +1,404 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// host_pipe.c -- runs the local server's frame on a second core
+
+#include "quakedef.h"
+#include <setjmp.h>
+
+/*
+
+With host_pipeline set, a frame is split into two stages. The simulation
+stage (the local server's physics and QuakeC) runs on the second thread,
+while this thread reads the messages the server sent last frame and renders
+them. Everything the two stages share goes through the loopback messages,
+which the client has finished reading before the server frame is started,
+so the only handoff needed is a frame number each way:
+
+	main:	input, commands, CL_ReadFromServer | render, sound | wait
+	sim:	                                   | Host_ServerFrame   |
+
+A frame then costs about the slower of the two stages instead of their sum,
+at the price of the client seeing the server one frame later.
+
+What else the server frame would touch that belongs to the main thread is
+held until the join: console output, cvar changes and command text. QuakeC
+reading a cvar it has just set sees the new value. The server's devstats
+are kept apart (sv_devstats) and copied over by the main thread, and its
+temporary lists come from malloc, as the hunk and the cache are the main
+thread's. Rendering that reads the server's edicts, r_showbboxes, turns the
+pipeline off.
+
+*/
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PIPE_THREADS	1
+#include <pthread.h>
+#else
+#define PIPE_THREADS	0	// no second thread, the frame always runs serially
+#endif
+
+cvar_t	host_pipeline = {"host_pipeline", "0", CVAR_ARCHIVE};
+
+static qboolean	pipe_busy;			// a server frame has been handed over and not joined
+static double	pipe_simtime;		// how long the last server frame took
+static double	pipe_stalltime;		// how long the main thread waited for it
+
+// things the server frame can't do from its own thread are held until the join
+#define	PIPE_MAXCVARS	64
+
+static char		pipe_print[4096];
+static int		pipe_printlen;
+static char		pipe_commands[4096];
+static int		pipe_commandslen;
+static cvar_t	*pipe_cvars[PIPE_MAXCVARS];
+static char		*pipe_cvarvalues[PIPE_MAXCVARS];	// in pipe_cvartext
+static int		pipe_numcvars;
+static char		pipe_cvartext[4096];
+static int		pipe_cvartextlen;
+static int		pipe_dropped;		// held back things that didn't fit
+static char		pipe_error[1024];
+static jmp_buf	pipe_abort;
+
+#if PIPE_THREADS
+static pthread_t		pipe_thread;
+static pthread_mutex_t	pipe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	pipe_wake = PTHREAD_COND_INITIALIZER;		// a frame was posted
+static pthread_cond_t	pipe_finished = PTHREAD_COND_INITIALIZER;	// a frame was done
+static qboolean			pipe_started;
+static qboolean			pipe_quit;
+
+// only the main thread writes pipe_posted and only the sim thread writes
+// pipe_done, both under the lock, and each side sleeps on its condition
+// until the other has moved its number on
+static int				pipe_posted, pipe_done;
+#endif
+
+/*
+==================
+Host_RunServerFrame
+==================
+*/
+static void Host_RunServerFrame (void)
+{
+	double	time1;
+
+	time1 = Sys_DoubleTime ();
+	if (!setjmp (pipe_abort))
+		Host_ServerFrame ();
+	pipe_simtime = Sys_DoubleTime () - time1;
+}
+
+#if PIPE_THREADS
+/*
+==================
+Host_PipelineMain
+==================
+*/
+static void *Host_PipelineMain (void *arg)
+{
+	int		frame;
+
+	for (;;)
+	{
+		pthread_mutex_lock (&pipe_lock);
+		while (!pipe_quit && pipe_posted == pipe_done)
+			pthread_cond_wait (&pipe_wake, &pipe_lock);
+		frame = pipe_posted;
+		pthread_mutex_unlock (&pipe_lock);
+
+		if (pipe_quit)
+			break;
+
+		Host_RunServerFrame ();
+
+		pthread_mutex_lock (&pipe_lock);
+		pipe_done = frame;
+		pthread_cond_signal (&pipe_finished);
+		pthread_mutex_unlock (&pipe_lock);
+	}
+
+	return NULL;
+}
+#endif
+
+/*
+==================
+Host_PipelineThread
+
+true when called from the simulation thread
+==================
+*/
+qboolean Host_PipelineThread (void)
+{
+#if PIPE_THREADS
+	return pipe_started && pthread_equal (pthread_self (), pipe_thread);
+#else
+	return false;
+#endif
+}
+
+/*
+==================
+Host_PipelinePrint
+
+console output from the server frame, printed when the frame is joined
+==================
+*/
+void Host_PipelinePrint (const char *msg)
+{
+	q_strlcpy (pipe_print + pipe_printlen, msg, sizeof(pipe_print) - pipe_printlen);
+	pipe_printlen = strlen (pipe_print);
+}
+
+/*
+==================
+Host_PipelineCommand
+
+command text from the server frame, added to the buffer when it is joined
+==================
+*/
+void Host_PipelineCommand (const char *text)
+{
+	int		len = strlen (text);
+
+	if (pipe_commandslen + len >= (int)sizeof(pipe_commands))
+	{
+		pipe_dropped++;
+		return;
+	}
+	memcpy (pipe_commands + pipe_commandslen, text, len + 1);
+	pipe_commandslen += len;
+}
+
+/*
+==================
+Host_PipelineSetCvar
+
+a cvar change from the server frame, made when it is joined
+==================
+*/
+void Host_PipelineSetCvar (cvar_t *var, const char *value)
+{
+	int		len = strlen (value);
+
+	if (pipe_numcvars == PIPE_MAXCVARS || pipe_cvartextlen + len >= (int)sizeof(pipe_cvartext))
+	{
+		pipe_dropped++;
+		return;
+	}
+	pipe_cvars[pipe_numcvars] = var;
+	pipe_cvarvalues[pipe_numcvars] = pipe_cvartext + pipe_cvartextlen;
+	memcpy (pipe_cvartext + pipe_cvartextlen, value, len + 1);
+	pipe_cvartextlen += len + 1;
+	pipe_numcvars++;
+}
+
+/*
+==================
+Host_PipelineCvar
+
+the value the server frame last gave var, or NULL if it hasn't
+==================
+*/
+const char *Host_PipelineCvar (cvar_t *var)
+{
+	int		i;
+
+	for (i = pipe_numcvars - 1; i >= 0; i--)
+	{
+		if (pipe_cvars[i] == var)
+			return pipe_cvarvalues[i];
+	}
+	return NULL;
+}
+
+/*
+==================
+Host_PipelineError
+
+a Host_Error in the server frame. the frame is abandoned and the error is
+raised again on the main thread when it is joined.
+==================
+*/
+void Host_PipelineError (const char *error)
+{
+	q_strlcpy (pipe_error, error, sizeof(pipe_error));
+	longjmp (pipe_abort, 1);
+}
+
+/*
+==================
+Host_PipelineFrame
+
+decides whether the server frame can run alongside this frame's rendering
+==================
+*/
+qboolean Host_PipelineFrame (void)
+{
+#if PIPE_THREADS
+	extern	cvar_t	r_showbboxes;
+
+	if (!host_pipeline.value || !sv.active || cls.state != ca_connected || cls.signon != SIGNONS)
+		return false;
+	if (r_showbboxes.value)
+		return false;	// draws the server's edicts
+
+	if (!pipe_started)
+	{
+		pipe_started = true;
+		if (pthread_create (&pipe_thread, NULL, Host_PipelineMain, NULL) != 0)
+		{
+			pipe_started = false;
+			Con_Warning ("couldn't start the simulation thread\n");
+			Cvar_SetQuick (&host_pipeline, "0");
+			return false;
+		}
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+==================
+Host_StartServerFrame
+
+the client must have finished reading the server's messages for this frame
+==================
+*/
+void Host_StartServerFrame (void)
+{
+#if PIPE_THREADS
+	pipe_busy = true;
+	pthread_mutex_lock (&pipe_lock);
+	pipe_posted++;
+	pthread_cond_signal (&pipe_wake);
+	pthread_mutex_unlock (&pipe_lock);
+#else
+	Host_RunServerFrame ();
+#endif
+}
+
+/*
+==================
+Host_FinishServerFrame
+
+waits for the server frame handed over by Host_StartServerFrame, if any
+==================
+*/
+void Host_FinishServerFrame (void)
+{
+	double	time1;
+	char	error[sizeof(pipe_error)];
+	int		i;
+
+	if (!pipe_busy)
+		return;
+	pipe_busy = false;
+
+	time1 = Sys_DoubleTime ();
+#if PIPE_THREADS
+	pthread_mutex_lock (&pipe_lock);
+	while (pipe_done != pipe_posted)
+		pthread_cond_wait (&pipe_finished, &pipe_lock);
+	pthread_mutex_unlock (&pipe_lock);
+#endif
+	pipe_stalltime = Sys_DoubleTime () - time1;
+
+	if (pipe_printlen)
+	{
+		Con_Printf ("%s", pipe_print);
+		pipe_printlen = 0;
+	}
+
+	for (i = 0; i < pipe_numcvars; i++)
+		Cvar_SetQuick (pipe_cvars[i], pipe_cvarvalues[i]);
+	pipe_numcvars = 0;
+	pipe_cvartextlen = 0;
+
+	if (pipe_commandslen)
+	{
+		Cbuf_AddText (pipe_commands);
+		pipe_commandslen = 0;
+	}
+
+	if (pipe_dropped)
+	{
+		Con_Warning ("%i cvar changes or commands from the server frame didn't fit\n", pipe_dropped);
+		pipe_dropped = 0;
+	}
+
+	if (pipe_error[0])
+	{
+		q_strlcpy (error, pipe_error, sizeof(error));
+		pipe_error[0] = 0;
+		Host_Error ("%s", error);
+	}
+}
+
+/*
+==================
+Host_PipelineSpeeds
+
+for host_speeds, in milliseconds
+==================
+*/
+void Host_PipelineSpeeds (int *sim, int *stall)
+{
+	*sim = pipe_simtime * 1000;
+	*stall = pipe_stalltime * 1000;
+}
+
+/*
+==================
+Host_InitPipeline
+==================
+*/
+void Host_InitPipeline (void)
+{
+	Cvar_RegisterVariable (&host_pipeline);
+}
+
+/*
+==================
+Host_ShutdownPipeline
+==================
+*/
+void Host_ShutdownPipeline (void)
+{
+	Host_FinishServerFrame ();
+
+#if PIPE_THREADS
+	if (!pipe_started)
+		return;
+
+	pthread_mutex_lock (&pipe_lock);
+	pipe_quit = true;
+	pthread_cond_signal (&pipe_wake);
+	pthread_mutex_unlock (&pipe_lock);
+
+	pthread_join (pipe_thread, NULL);
+	pipe_started = false;
+#endif
+}
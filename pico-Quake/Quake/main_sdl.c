@@ -95,16 +95,9 @@ int main(int argc, char *argv[])
 	{
 		while (1)
 		{
-			newtime = Sys_DoubleTime ();
+			newtime = Host_WaitForTick (oldtime);
 			time = newtime - oldtime;
 
-			while (time < sys_ticrate.value )
-			{
-				SDL_Delay(1);
-				newtime = Sys_DoubleTime ();
-				time = newtime - oldtime;
-			}
-
 			Host_Frame (time);
 			oldtime = newtime;
 		}
@@ -36,6 +36,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define NET_MAXMESSAGE		64000	/* ericw -- was 32000 */
 
+// what a connection's buffers need for protocol p: the loopback queues a
+// datagram behind a reliable message. PROTOCOL_NETQUAKE is kept to the
+// original sizes, the others can send anything up to NET_MAXMESSAGE.
+#define	NET_MESSAGESIZE(p)	((p) == PROTOCOL_NETQUAKE ? NETQUAKE_MSGLEN + NETQUAKE_DATAGRAM + 16 : NET_MAXMESSAGE)
+
 extern int		DEFAULTnet_hostport;
 extern int		net_hostport;
 
@@ -57,6 +62,7 @@ struct qsocket_s	*NET_Connect (const char *host);
 
 double NET_QSocketGetTime (const struct qsocket_s *sock);
 const char *NET_QSocketGetAddressString (const struct qsocket_s *sock);
+void NET_SetMessageSize (struct qsocket_s *sock, int size);
 
 qboolean NET_CanSendMessage (struct qsocket_s *sock);
 // Returns true or false if the given qsocket can currently accept a
@@ -75,6 +81,10 @@ int	NET_SendUnreliableMessage (struct qsocket_s *sock, sizebuf_t *data);
 //		is still considered valid
 // returns 1 if the message was sent properly
 // returns -1 if the connection died
+// an unreliable message with NET_HEADERSIZE bytes of headroom is sent from
+// where it was built, without being copied
+
+#define NET_HEADERSIZE		(2 * sizeof(unsigned int))	// a datagram's header
 
 int	NET_SendToAll(sizebuf_t *data, double blocktime);
 // This is a reliable *blocking* send to all attached clients.
@@ -90,6 +100,13 @@ void	NET_Close (struct qsocket_s *sock);
 
 void	NET_Poll (void);
 
+qboolean NET_Wait (double timeout, qboolean wake);
+
+// a dedicated server's frame is put between these, so the landrivers can
+// read and write its datagrams many to a call
+void	NET_BeginBatch (void);
+void	NET_EndBatch (void);
+
 
 // Server list related globals:
 extern	qboolean	slistInProgress;
@@ -35,7 +35,6 @@ struct qsockaddr
 	unsigned char qsa_data[14];
 };
 
-#define NET_HEADERSIZE		(2 * sizeof(unsigned int))
 #define NET_DATAGRAMSIZE	(MAX_DATAGRAM + NET_HEADERSIZE)
 
 // NetHeader flags
@@ -146,17 +145,25 @@ typedef struct qsocket_s
 	unsigned int	ackSequence;
 	unsigned int	sendSequence;
 	unsigned int	unreliableSendSequence;
-	int		sendMessageLength;
-	byte		sendMessage [NET_MAXMESSAGE];
+	int		sendMessageOffset;	// of the part not yet acked
+	int		sendMessageLength;	// from sendMessageOffset
+	byte		*sendMessage;		// [NET_HEADERSIZE + maxmessage], the loopback doesn't use it
 
 	unsigned int	receiveSequence;
 	unsigned int	unreliableReceiveSequence;
 	int		receiveMessageLength;
-	byte		receiveMessage [NET_MAXMESSAGE];
+	byte		*receiveMessage;	// [maxmessage]
+
+	int		maxmessage;			// see NET_SetMessageSize
 
 	struct qsockaddr	addr;
 	char		address[NET_NAMELEN];
 
+	// a server's connections share the landriver's accept socket
+	qboolean	shared;
+	struct qsocket_s	*sharednext;	// in the hash of them by address
+	struct netpacket_s	*pending, *pendingtail;	// read off it for this one
+
 } qsocket_t;
 
 extern qsocket_t	*net_activeSockets;
@@ -186,12 +193,17 @@ typedef struct
 	int		(*AddrCompare) (struct qsockaddr *addr1, struct qsockaddr *addr2);
 	int		(*GetSocketPort) (struct qsockaddr *addr);
 	int		(*SetSocketPort) (struct qsockaddr *addr, int port);
+	void		(*Flush) (void);	// sends writes held back while batching, may be NULL
+	int		(*Sockets) (sys_socket_t *sockets, int max);	// for NET_Wait, may be NULL
+	int		(*WriteNow) (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr);	// never held back, may be NULL
 } net_landriver_t;
 
 #define	MAX_NET_DRIVERS		8
 extern net_landriver_t	net_landrivers[];
 extern const int	net_numlandrivers;
 
+extern qboolean	net_batching;	// landrivers may hold writes back until Flush
+
 typedef struct
 {
 	const char	*name;
@@ -223,7 +235,7 @@ extern int		messagesReceived;
 extern int		unreliableMessagesSent;
 extern int		unreliableMessagesReceived;
 
-qsocket_t *NET_NewQSocket (void);
+qsocket_t *NET_NewQSocket (int messagesize);
 void NET_FreeQSocket(qsocket_t *);
 double SetNetTime(void);
 
@@ -129,56 +129,212 @@ static void NET_Ban_f (void)
 #endif	// BAN_TEST
 
 
-int Datagram_SendMessage (qsocket_t *sock, sizebuf_t *data)
+/*
+=============================================================================
+
+SHARED SOCKETS
+
+The connections a server accepts don't get sockets of their own, they all
+use the landriver's accept socket, and their datagrams are told apart by
+where they come from. Whatever a read finds there goes on the list of the
+connection it's from, or on the control list for the connection requests,
+so the landriver can take a frame's datagrams for every client at once.
+
+=============================================================================
+*/
+
+typedef struct netpacket_s
 {
-	unsigned int	packetLen;
-	unsigned int	dataLen;
-	unsigned int	eom;
+	struct netpacket_s	*next;
+	int					length;
+	struct qsockaddr	addr;
+} netpacket_t;	// followed by the datagram
 
-#ifdef DEBUG
-	if (data->cursize == 0)
-		Sys_Error("Datagram_SendMessage: zero length message");
+#define	DEMUX_HASH		64		// power of two
+#define	DEMUX_PENDING	256		// read and not yet handled, over all the lists
 
-	if (data->cursize > NET_MAXMESSAGE)
-		Sys_Error("Datagram_SendMessage: message too big: %u", data->cursize);
+static qsocket_t	*demux_hash[DEMUX_HASH];
+static netpacket_t	*demux_control[MAX_NET_DRIVERS], *demux_controltail[MAX_NET_DRIVERS];
+static sys_socket_t	demux_socket[MAX_NET_DRIVERS];	// the accept socket last read
+static int			demux_pending;
+static qboolean		demux_listening[MAX_NET_DRIVERS];	// answering connection requests
+static int			demux_connections[MAX_NET_DRIVERS];	// keeping the accept socket open
 
-	if (sock->canSend == false)
-		Sys_Error("SendMessage: called with canSend == false");
-#endif
+#define	DEMUX_BUCKET(landriver,addr)	(net_landrivers[landriver].GetSocketPort (addr) & (DEMUX_HASH - 1))
 
-	Q_memcpy(sock->sendMessage, data->data, data->cursize);
-	sock->sendMessageLength = data->cursize;
+static qsocket_t *Demux_Find (int landriver, struct qsockaddr *addr)
+{
+	qsocket_t	*s;
 
-	if (data->cursize <= MAX_DATAGRAM)
+	for (s = demux_hash[DEMUX_BUCKET (landriver, addr)]; s; s = s->sharednext)
 	{
-		dataLen = data->cursize;
-		eom = NETFLAG_EOM;
+		if (s->landriver == landriver && net_landrivers[landriver].AddrCompare (addr, &s->addr) == 0)
+			return s;
 	}
-	else
+	return NULL;
+}
+
+static void Demux_Add (qsocket_t *sock)
+{
+	int		bucket = DEMUX_BUCKET (sock->landriver, &sock->addr);
+
+	sock->shared = true;
+	sock->sharednext = demux_hash[bucket];
+	demux_hash[bucket] = sock;
+	demux_connections[sock->landriver]++;
+}
+
+static void Demux_FreeList (netpacket_t *p)
+{
+	netpacket_t	*next;
+
+	for ( ; p; p = next)
 	{
-		dataLen = MAX_DATAGRAM;
-		eom = 0;
+		next = p->next;
+		MSG_FreeBuffer ((byte *) p, sizeof(netpacket_t) + p->length);
+		demux_pending--;
 	}
-	packetLen = NET_HEADERSIZE + dataLen;
+}
 
-	packetBuffer.length = BigLong(packetLen | (NETFLAG_DATA | eom));
-	packetBuffer.sequence = BigLong(sock->sendSequence++);
-	Q_memcpy (packetBuffer.data, sock->sendMessage, dataLen);
+static void Demux_Remove (qsocket_t *sock)
+{
+	qsocket_t	**link;
 
-	sock->canSend = false;
+	for (link = &demux_hash[DEMUX_BUCKET (sock->landriver, &sock->addr)]; *link; link = &(*link)->sharednext)
+	{
+		if (*link == sock)
+		{
+			*link = sock->sharednext;
+			break;
+		}
+	}
+	Demux_FreeList (sock->pending);
+	sock->pending = sock->pendingtail = NULL;
+	sock->shared = false;
+	demux_connections[sock->landriver]--;
+}
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
-		return -1;
+/*
+==================
+Demux_Read
+
+Reads everything waiting on an accept socket onto the lists. Datagrams
+that aren't control requests and aren't from a connection are dropped, and
+so are control requests once the driver has stopped listening. With too
+many not handled yet, the rest are left on the socket.
+==================
+*/
+static void Demux_Read (int landriver, sys_socket_t socketid)
+{
+	struct qsockaddr	readaddr;
+	netpacket_t	*p, **head, **tail;
+	qsocket_t	*s;
+	int			len;
 
-	sock->lastSendTime = net_time;
-	packetsSent++;
-	return 1;
+	demux_socket[landriver] = socketid;
+
+	while (demux_pending < DEMUX_PENDING)
+	{
+		len = net_landrivers[landriver].Read (socketid, (byte *)&packetBuffer, NET_DATAGRAMSIZE, &readaddr);
+		if (len <= 0)
+			break;
+		if (len < (int) NET_HEADERSIZE)
+		{
+			shortPacketCount++;
+			continue;
+		}
+
+		if (BigLong (packetBuffer.length) & NETFLAG_CTL)
+		{
+			if (!demux_listening[landriver])
+				continue;
+			head = &demux_control[landriver];
+			tail = &demux_controltail[landriver];
+		}
+		else if ((s = Demux_Find (landriver, &readaddr)) != NULL)
+		{
+			head = &s->pending;
+			tail = &s->pendingtail;
+		}
+		else
+			continue;
+
+		p = (netpacket_t *) MSG_AllocBuffer (sizeof(netpacket_t) + len);
+		p->next = NULL;
+		p->length = len;
+		p->addr = readaddr;
+		memcpy (p + 1, &packetBuffer, len);
+		if (*head)
+			(*tail)->next = p;
+		else
+			*head = p;
+		*tail = p;
+		demux_pending++;
+	}
 }
 
+/*
+==================
+Demux_Get
 
-static int SendMessageNext (qsocket_t *sock)
+Takes the first datagram off a list, reading the socket first if it's
+empty, and returns its length.
+==================
+*/
+static int Demux_Get (int landriver, sys_socket_t socketid, netpacket_t **head, byte *buf, int len, struct qsockaddr *addr)
+{
+	netpacket_t	*p;
+
+	if (!*head)
+		Demux_Read (landriver, socketid);
+	if (!(p = *head))
+		return 0;
+	*head = p->next;
+
+	len = q_min (len, p->length);
+	memcpy (buf, p + 1, len);
+	*addr = p->addr;
+	MSG_FreeBuffer ((byte *) p, sizeof(netpacket_t) + p->length);
+	demux_pending--;
+	return len;
+}
+
+
+/*
+==================
+WritePacket
+
+Puts the header in the NET_HEADERSIZE bytes before data and sends them
+together, so nothing is copied on the way to the landriver. Reliable
+fragments are sent from sendMessage, where they're kept until acked, so
+they go with WriteNow where there is one, rather than be copied into a
+batch.
+==================
+*/
+static int WritePacket (qsocket_t *sock, byte *data, int dataLen, unsigned int flags, unsigned int sequence)
+{
+	unsigned int	header[2];
+
+	header[0] = BigLong((NET_HEADERSIZE + dataLen) | flags);
+	header[1] = BigLong(sequence);
+	memcpy (data - NET_HEADERSIZE, header, NET_HEADERSIZE);	// may not be aligned
+
+	if ((flags & NETFLAG_DATA) && sfunc.WriteNow)
+		return sfunc.WriteNow (sock->socket, data - NET_HEADERSIZE, NET_HEADERSIZE + dataLen, &sock->addr);
+	return sfunc.Write (sock->socket, data - NET_HEADERSIZE, NET_HEADERSIZE + dataLen, &sock->addr);
+}
+
+/*
+==================
+SendFragment
+
+Sends the first part of sendMessage that hasn't been acked from where it
+is. Its header goes over the end of the part before it, which has been, or
+into the room left in front of the message.
+==================
+*/
+static int SendFragment (qsocket_t *sock, unsigned int sequence)
 {
-	unsigned int	packetLen;
 	unsigned int	dataLen;
 	unsigned int	eom;
 
@@ -192,15 +348,35 @@ static int SendMessageNext (qsocket_t *sock)
 		dataLen = MAX_DATAGRAM;
 		eom = 0;
 	}
-	packetLen = NET_HEADERSIZE + dataLen;
 
-	packetBuffer.length = BigLong(packetLen | (NETFLAG_DATA | eom));
-	packetBuffer.sequence = BigLong(sock->sendSequence++);
-	Q_memcpy (packetBuffer.data, sock->sendMessage, dataLen);
+	return WritePacket (sock, sock->sendMessage + sock->sendMessageOffset, dataLen, NETFLAG_DATA | eom, sequence);
+}
 
-	sock->sendNext = false;
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
+int Datagram_SendMessage (qsocket_t *sock, sizebuf_t *data)
+{
+	if (data->cursize > sock->maxmessage)
+	{
+		Con_Printf ("Datagram_SendMessage: %i byte message too big for %s\n", data->cursize, sock->address);
+		return -1;
+	}
+
+#ifdef DEBUG
+	if (data->cursize == 0)
+		Sys_Error("Datagram_SendMessage: zero length message");
+
+	if (sock->canSend == false)
+		Sys_Error("SendMessage: called with canSend == false");
+#endif
+
+	// the only copy, as it has to be kept until it's acked
+	sock->sendMessageOffset = NET_HEADERSIZE;
+	Q_memcpy(sock->sendMessage + NET_HEADERSIZE, data->data, data->cursize);
+	sock->sendMessageLength = data->cursize;
+
+	sock->canSend = false;
+
+	if (SendFragment (sock, sock->sendSequence++) == -1)
 		return -1;
 
 	sock->lastSendTime = net_time;
@@ -209,31 +385,24 @@ static int SendMessageNext (qsocket_t *sock)
 }
 
 
-static int ReSendMessage (qsocket_t *sock)
+static int SendMessageNext (qsocket_t *sock)
 {
-	unsigned int	packetLen;
-	unsigned int	dataLen;
-	unsigned int	eom;
+	sock->sendNext = false;
 
-	if (sock->sendMessageLength <= MAX_DATAGRAM)
-	{
-		dataLen = sock->sendMessageLength;
-		eom = NETFLAG_EOM;
-	}
-	else
-	{
-		dataLen = MAX_DATAGRAM;
-		eom = 0;
-	}
-	packetLen = NET_HEADERSIZE + dataLen;
+	if (SendFragment (sock, sock->sendSequence++) == -1)
+		return -1;
+
+	sock->lastSendTime = net_time;
+	packetsSent++;
+	return 1;
+}
 
-	packetBuffer.length = BigLong(packetLen | (NETFLAG_DATA | eom));
-	packetBuffer.sequence = BigLong(sock->sendSequence - 1);
-	Q_memcpy (packetBuffer.data, sock->sendMessage, dataLen);
 
+static int ReSendMessage (qsocket_t *sock)
+{
 	sock->sendNext = false;
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
+	if (SendFragment (sock, sock->sendSequence - 1) == -1)
 		return -1;
 
 	sock->lastSendTime = net_time;
@@ -259,7 +428,7 @@ qboolean Datagram_CanSendUnreliableMessage (qsocket_t *sock)
 
 int Datagram_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 {
-	int	packetLen;
+	byte	*packet;
 
 #ifdef DEBUG
 	if (data->cursize == 0)
@@ -269,13 +438,16 @@ int Datagram_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 		Sys_Error("Datagram_SendUnreliableMessage: message too big: %u", data->cursize);
 #endif
 
-	packetLen = NET_HEADERSIZE + data->cursize;
-
-	packetBuffer.length = BigLong(packetLen | NETFLAG_UNRELIABLE);
-	packetBuffer.sequence = BigLong(sock->unreliableSendSequence++);
-	Q_memcpy (packetBuffer.data, data->data, data->cursize);
+	// sent from where it was built if the header fits in front
+	if (data->headroom >= (int)NET_HEADERSIZE)
+		packet = data->data;
+	else
+	{
+		packet = packetBuffer.data;
+		Q_memcpy (packet, data->data, data->cursize);
+	}
 
-	if (sfunc.Write (sock->socket, (byte *)&packetBuffer, packetLen, &sock->addr) == -1)
+	if (WritePacket (sock, packet, data->cursize, NETFLAG_UNRELIABLE, sock->unreliableSendSequence++) == -1)
 		return -1;
 
 	packetsSent++;
@@ -298,7 +470,11 @@ int	Datagram_GetMessage (qsocket_t *sock)
 
 	while (1)
 	{
-		length = (unsigned int) sfunc.Read(sock->socket, (byte *)&packetBuffer,
+		if (sock->shared)
+			length = (unsigned int) Demux_Get(sock->landriver, sock->socket, &sock->pending,
+							(byte *)&packetBuffer, NET_DATAGRAMSIZE, &readaddr);
+		else
+			length = (unsigned int) sfunc.Read(sock->socket, (byte *)&packetBuffer,
 							NET_DATAGRAMSIZE, &readaddr);
 
 	//	if ((rand() & 255) > 220)
@@ -383,11 +559,12 @@ int	Datagram_GetMessage (qsocket_t *sock)
 			sock->sendMessageLength -= MAX_DATAGRAM;
 			if (sock->sendMessageLength > 0)
 			{
-				memmove (sock->sendMessage, sock->sendMessage + MAX_DATAGRAM, sock->sendMessageLength);
+				sock->sendMessageOffset += MAX_DATAGRAM;
 				sock->sendNext = true;
 			}
 			else
 			{
+				sock->sendMessageOffset = NET_HEADERSIZE;
 				sock->sendMessageLength = 0;
 				sock->canSend = true;
 			}
@@ -420,6 +597,13 @@ int	Datagram_GetMessage (qsocket_t *sock)
 				break;
 			}
 
+			if (sock->receiveMessageLength + length > sock->maxmessage)
+			{
+				Con_Printf ("Datagram_GetMessage: message from %s too big\n", sock->address);
+				ret = -1;
+				break;
+			}
+
 			Q_memcpy(sock->receiveMessage + sock->receiveMessageLength, packetBuffer.data, length);
 			sock->receiveMessageLength += length;
 			continue;
@@ -839,16 +1023,39 @@ void Datagram_Shutdown (void)
 
 void Datagram_Close (qsocket_t *sock)
 {
-	sfunc.Close_Socket(sock->socket);
+	if (sock->shared)
+	{
+		Demux_Remove (sock);
+		if (!demux_connections[sock->landriver] && !demux_listening[sock->landriver])
+			sfunc.Listen (false);	// was kept open for this one
+	}
+	else
+		sfunc.Close_Socket(sock->socket);
 }
 
 
+/*
+==================
+Datagram_Listen
+
+Turning listening off only stops new connections. The ones made are on the
+accept socket, so it's closed when the last of them is.
+==================
+*/
 void Datagram_Listen (qboolean state)
 {
 	int i;
 
 	for (i = 0; i < net_numlandrivers; i++)
 	{
+		demux_listening[i] = state;
+		if (!state)
+		{
+			Demux_FreeList (demux_control[i]);
+			demux_control[i] = demux_controltail[i] = NULL;
+			if (demux_connections[i])
+				continue;
+		}
 		if (net_landrivers[i].initialized)
 			net_landrivers[i].Listen (state);
 	}
@@ -859,7 +1066,6 @@ static qsocket_t *_Datagram_CheckNewConnections (void)
 {
 	struct qsockaddr clientaddr;
 	struct qsockaddr newaddr;
-	sys_socket_t		newsock;
 	sys_socket_t		acceptsock;
 	qsocket_t	*sock;
 	qsocket_t	*s;
@@ -868,13 +1074,18 @@ static qsocket_t *_Datagram_CheckNewConnections (void)
 	int			control;
 	int			ret;
 
-	acceptsock = dfunc.CheckNewConnections();
-	if (acceptsock == INVALID_SOCKET)
-		return NULL;
+	if (!demux_control[net_landriverlevel])
+	{
+		acceptsock = dfunc.CheckNewConnections();
+		if (acceptsock == INVALID_SOCKET)
+			return NULL;
+	}
+	else
+		acceptsock = demux_socket[net_landriverlevel];
 
 	SZ_Clear(&net_message);
 
-	len = dfunc.Read (acceptsock, net_message.data, net_message.maxsize, &clientaddr);
+	len = Demux_Get (net_landriverlevel, acceptsock, &demux_control[net_landriverlevel], net_message.data, net_message.maxsize, &clientaddr);
 	if (len < (int) sizeof(int))
 		return NULL;
 	net_message.cursize = len;
@@ -1049,7 +1260,7 @@ static qsocket_t *_Datagram_CheckNewConnections (void)
 	}
 
 	// allocate a QSocket
-	sock = NET_NewQSocket ();
+	sock = NET_NewQSocket (NET_MESSAGESIZE (sv.protocol));
 	if (sock == NULL)	// no room; try to let him know
 	{
 		SZ_Clear(&net_message);
@@ -1063,34 +1274,19 @@ static qsocket_t *_Datagram_CheckNewConnections (void)
 		return NULL;
 	}
 
-	// allocate a network socket
-	newsock = dfunc.Open_Socket(0);
-	if (newsock == INVALID_SOCKET)
-	{
-		NET_FreeQSocket(sock);
-		return NULL;
-	}
-
-	// connect to the client
-	if (dfunc.Connect (newsock, &clientaddr) == -1)
-	{
-		dfunc.Close_Socket(newsock);
-		NET_FreeQSocket(sock);
-		return NULL;
-	}
-
 	// everything is allocated, just fill in the details
-	sock->socket = newsock;
+	sock->socket = acceptsock;
 	sock->landriver = net_landriverlevel;
 	sock->addr = clientaddr;
 	Q_strcpy(sock->address, dfunc.AddrToString(&clientaddr));
+	Demux_Add (sock);
 
 	// send him back the info about the server connection he has been allocated
 	SZ_Clear(&net_message);
 	// save space for the header, filled in later
 	MSG_WriteLong(&net_message, 0);
 	MSG_WriteByte(&net_message, CCREP_ACCEPT);
-	dfunc.GetSocketAddr(newsock, &newaddr);
+	dfunc.GetSocketAddr(acceptsock, &newaddr);
 	MSG_WriteLong(&net_message, dfunc.GetSocketPort(&newaddr));
 //	MSG_WriteString(&net_message, dfunc.AddrToString(&newaddr));
 	*((int *)net_message.data) = BigLong(NETFLAG_CTL | (net_message.cursize & NETFLAG_LENGTH_MASK));
@@ -1108,8 +1304,12 @@ qsocket_t *Datagram_CheckNewConnections (void)
 	{
 		if (net_landrivers[net_landriverlevel].initialized)
 		{
-			if ((ret = _Datagram_CheckNewConnections ()) != NULL)
-				break;
+			// every request read off the accept socket is answered
+			do
+			{
+				if ((ret = _Datagram_CheckNewConnections ()) != NULL)
+					return ret;
+			} while (demux_control[net_landriverlevel]);
 		}
 	}
 	return ret;
@@ -1253,7 +1453,7 @@ static qsocket_t *_Datagram_Connect (const char *host)
 	if (newsock == INVALID_SOCKET)
 		return NULL;
 
-	sock = NET_NewQSocket ();
+	sock = NET_NewQSocket (NET_MAXMESSAGE);	// whatever the server speaks
 	if (sock == NULL)
 		goto ErrorReturn2;
 	sock->socket = newsock;
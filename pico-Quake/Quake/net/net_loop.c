@@ -75,7 +75,7 @@ qsocket_t *Loop_Connect (const char *host)
 
 	if (!loop_client)
 	{
-		if ((loop_client = NET_NewQSocket ()) == NULL)
+		if ((loop_client = NET_NewQSocket (NET_MESSAGESIZE (sv.protocol))) == NULL)
 		{
 			Con_Printf("Loop_Connect: no qsocket available\n");
 			return NULL;
@@ -88,7 +88,7 @@ qsocket_t *Loop_Connect (const char *host)
 
 	if (!loop_server)
 	{
-		if ((loop_server = NET_NewQSocket ()) == NULL)
+		if ((loop_server = NET_NewQSocket (NET_MESSAGESIZE (sv.protocol))) == NULL)
 		{
 			Con_Printf("Loop_Connect: no qsocket available\n");
 			return NULL;
@@ -165,7 +165,7 @@ int Loop_SendMessage (qsocket_t *sock, sizebuf_t *data)
 
 	bufferLength = &((qsocket_t *)sock->driverdata)->receiveMessageLength;
 
-	if ((*bufferLength + data->cursize + 4) > NET_MAXMESSAGE)
+	if (IntAlign(*bufferLength + data->cursize + 4) > ((qsocket_t *)sock->driverdata)->maxmessage)
 		Sys_Error("Loop_SendMessage: overflow");
 
 	buffer = ((qsocket_t *)sock->driverdata)->receiveMessage + *bufferLength;
@@ -199,7 +199,7 @@ int Loop_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 
 	bufferLength = &((qsocket_t *)sock->driverdata)->receiveMessageLength;
 
-	if ((*bufferLength + data->cursize + sizeof(byte) + sizeof(short)) > NET_MAXMESSAGE)
+	if (IntAlign(*bufferLength + data->cursize + 4) > ((qsocket_t *)sock->driverdata)->maxmessage)
 		return 0;
 
 	buffer = ((qsocket_t *)sock->driverdata)->receiveMessage + *bufferLength;
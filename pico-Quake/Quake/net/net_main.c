@@ -19,12 +19,23 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define	_GNU_SOURCE		/* ppoll */
+#endif
+
 #include "q_stdinc.h"
 #include "arch_def.h"
 #include "net_sys.h"
 #include "quakedef.h"
 #include "net_defs.h"
 
+#if defined(PLATFORM_UNIX)
+#include <poll.h>
+#define	NET_POLL	1
+#else
+#define	NET_POLL	0	// NET_Wait only sleeps
+#endif
+
 qsocket_t	*net_activeSockets = NULL;
 qsocket_t	*net_freeSockets = NULL;
 int		net_numsockets = 0;
@@ -86,7 +97,7 @@ Called by drivers when a new communications endpoint is required
 The sequence and buffer fields will be filled in properly
 ===================
 */
-qsocket_t *NET_NewQSocket (void)
+qsocket_t *NET_NewQSocket (int messagesize)
 {
 	qsocket_t	*sock;
 
@@ -116,10 +127,14 @@ qsocket_t *NET_NewQSocket (void)
 	sock->ackSequence = 0;
 	sock->sendSequence = 0;
 	sock->unreliableSendSequence = 0;
+	sock->sendMessageOffset = NET_HEADERSIZE;
 	sock->sendMessageLength = 0;
 	sock->receiveSequence = 0;
 	sock->unreliableReceiveSequence = 0;
 	sock->receiveMessageLength = 0;
+	sock->shared = false;
+	sock->pending = sock->pendingtail = NULL;
+	NET_SetMessageSize (sock, messagesize);
 
 	return sock;
 }
@@ -151,6 +166,43 @@ void NET_FreeQSocket(qsocket_t *sock)
 	sock->next = net_freeSockets;
 	net_freeSockets = sock;
 	sock->disconnected = true;
+
+	// and its buffers to the pool
+	MSG_FreeBuffer (sock->sendMessage, NET_HEADERSIZE + sock->maxmessage);
+	MSG_FreeBuffer (sock->receiveMessage, sock->maxmessage);
+	sock->sendMessage = sock->receiveMessage = NULL;
+	sock->maxmessage = 0;
+}
+
+
+/*
+===================
+NET_SetMessageSize
+
+Sizes the socket's buffers for the biggest message its connection will
+carry, keeping what is in them. Both ends of the loopback are sized
+together, as each writes into the other's. The send buffer has room for a
+header in front, so that the datagram driver can send from it in place.
+===================
+*/
+void NET_SetMessageSize (qsocket_t *sock, int size)
+{
+	qsocket_t	*peer;
+	int			sent;
+
+	sent = sock->sendMessageOffset + sock->sendMessageLength;
+	size = q_max (size, q_max (sent - (int)NET_HEADERSIZE, sock->receiveMessageLength));
+	if (size != sock->maxmessage)
+	{
+		sock->receiveMessage = MSG_ResizeBuffer (sock->receiveMessage, sock->maxmessage, size, sock->receiveMessageLength);
+		if (!IS_LOOP_DRIVER (sock->driver))
+			sock->sendMessage = MSG_ResizeBuffer (sock->sendMessage, NET_HEADERSIZE + sock->maxmessage, NET_HEADERSIZE + size, sent);
+		sock->maxmessage = size;
+	}
+
+	peer = (qsocket_t *) sock->driverdata;
+	if (IS_LOOP_DRIVER (sock->driver) && peer && peer->maxmessage != sock->maxmessage)
+		NET_SetMessageSize (peer, sock->maxmessage);
 }
 
 
@@ -680,6 +732,8 @@ int NET_SendToAll (sizebuf_t *data, double blocktime)
 	qboolean	msg_init[MAX_SCOREBOARD];	/* did we write the message to the client's connection	*/
 	qboolean	msg_sent[MAX_SCOREBOARD];	/* did the msg arrive its destination (canSend state).	*/
 
+	NET_EndBatch ();	// it waits on the replies, so can't be in a batch
+
 	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
 	{
 		/*
@@ -863,6 +917,94 @@ void NET_Shutdown (void)
 }
 
 
+/*
+====================
+NET_BeginBatch
+
+only for a dedicated server. a listen server's frame may run on the
+pipeline thread, alongside the client's own network calls.
+====================
+*/
+qboolean	net_batching = false;
+
+void NET_BeginBatch (void)
+{
+	if (cls.state != ca_dedicated)
+		return;
+	NET_EndBatch ();	// anything left from outside a batch
+	net_batching = true;
+}
+
+/*
+====================
+NET_EndBatch
+====================
+*/
+void NET_EndBatch (void)
+{
+	int		i;
+
+	net_batching = false;
+	for (i = 0; i < net_numlandrivers; i++)
+	{
+		if (net_landrivers[i].initialized && net_landrivers[i].Flush)
+			net_landrivers[i].Flush ();
+	}
+}
+
+/*
+====================
+NET_Wait
+
+Sleeps for up to timeout seconds. With wake set, a datagram arriving on
+any of the landrivers' sockets ends it early, and true is returned.
+====================
+*/
+#define	NET_WAITSOCKETS	MAX_NET_DRIVERS
+
+qboolean NET_Wait (double timeout, qboolean wake)
+{
+#if NET_POLL
+	struct pollfd	fds[NET_WAITSOCKETS];
+	sys_socket_t	sockets[NET_WAITSOCKETS];
+	int		i, j, n, ret;
+#if defined(__linux__)
+	struct timespec	ts;
+#endif
+
+	if (timeout < 0)
+		timeout = 0;
+
+	n = 0;
+	for (i = 0; wake && i < net_numlandrivers; i++)
+	{
+		if (!net_landrivers[i].initialized || !net_landrivers[i].Sockets)
+			continue;
+		n += net_landrivers[i].Sockets (sockets + n, NET_WAITSOCKETS - n);
+	}
+	for (j = 0; j < n; j++)
+	{
+		fds[j].fd = sockets[j];
+		fds[j].events = POLLIN;
+		fds[j].revents = 0;
+	}
+
+#if defined(__linux__)
+	// to the microsecond, not rounded to the millisecond as poll would
+	ts.tv_sec = (time_t)timeout;
+	ts.tv_nsec = (long)((timeout - ts.tv_sec) * 1e9);
+	ret = ppoll (fds, n, &ts, NULL);
+#else
+	ret = poll (fds, n, (int)(timeout * 1000.0 + 0.999));
+#endif
+	return ret > 0;
+#else
+	Sys_Sleep ((unsigned long)(timeout * 1000.0));
+	return false;
+#endif
+}
+
+
 static PollProcedure *pollProcedureList = NULL;
 
 void NET_Poll(void)
@@ -20,6 +20,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define	_GNU_SOURCE		/* recvmmsg and sendmmsg */
+#endif
+
 #include "q_stdinc.h"
 #include "arch_def.h"
 #include "net_sys.h"
@@ -35,6 +39,186 @@ static in_addr_t	myAddr;
 
 #include "net_udp.h"
 
+/*
+=============================================================================
+
+BATCHED DATAGRAMS
+
+A server's connections all use the accept socket, see net_dgrm.c. While
+net_batching is set, which is only around a dedicated server's frame, a
+read of it that finds nothing left over takes everything waiting with one
+recvmmsg, and the reads after it are served from that. Writes to it are
+held back and sent with one sendmmsg by UDP_Flush. That's a call or two a
+frame for all the clients, rather than one for each datagram and one more
+to find there are no more.
+
+Only datagrams up to UDP_BATCHPACKET are batched. Clients never send
+bigger ones, and a bigger one from the server is sent straight away.
+
+=============================================================================
+*/
+
+#if defined(__linux__)
+#define	UDP_BATCHING	1
+#else
+#define	UDP_BATCHING	0	// no recvmmsg and sendmmsg
+#endif
+
+#define	UDP_BATCH		32		// datagrams to a recvmmsg or sendmmsg
+#define	UDP_BATCHPACKET	(NET_HEADERSIZE + DATAGRAM_MTU)
+
+#if UDP_BATCHING
+typedef struct
+{
+	sys_socket_t		socketid;
+
+	// read ahead, for UDP_Read to hand out
+	int					numread, nextread;
+	qboolean			drained;		// the last recvmmsg emptied the socket
+	int					readlen[UDP_BATCH];
+	struct qsockaddr	readaddr[UDP_BATCH];
+	byte				readbuf[UDP_BATCH][UDP_BATCHPACKET];
+
+	// held back for UDP_Flush
+	int					numwrite;
+	int					writelen[UDP_BATCH];
+	struct qsockaddr	writeaddr[UDP_BATCH];
+	byte				writebuf[UDP_BATCH][UDP_BATCHPACKET];
+} udpbatch_t;
+
+static udpbatch_t	*udp_batch;		// for the accept socket
+
+#define	UDP_Batch(socketid)		((udp_batch && udp_batch->socketid == (socketid)) ? udp_batch : NULL)
+
+static udpbatch_t *UDP_NewBatch (sys_socket_t socketid)
+{
+	udpbatch_t	*b;
+
+	b = (udpbatch_t *) calloc (1, sizeof(udpbatch_t));
+	if (!b)
+		Sys_Error ("UDP_NewBatch: out of memory");
+	b->socketid = socketid;
+	return b;
+}
+#endif	/* UDP_BATCHING */
+
+static void UDP_LoadTest_f (void);
+
+#if UDP_BATCHING
+/*
+============
+UDP_FillBatch
+
+reads everything waiting on the socket, up to UDP_BATCH datagrams, and
+returns how many there were
+============
+*/
+static int UDP_FillBatch (udpbatch_t *b)
+{
+	struct mmsghdr	msgs[UDP_BATCH];
+	struct iovec	iovs[UDP_BATCH];
+	int		i, j, ret, err;
+
+	memset (msgs, 0, sizeof(msgs));
+	for (i = 0; i < UDP_BATCH; i++)
+	{
+		iovs[i].iov_base = b->readbuf[i];
+		iovs[i].iov_len = UDP_BATCHPACKET;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &b->readaddr[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct qsockaddr);
+	}
+
+	b->numread = b->nextread = 0;
+	ret = recvmmsg (b->socketid, msgs, UDP_BATCH, 0, NULL);
+	if (ret == SOCKET_ERROR)
+	{
+		err = SOCKETERRNO;
+		if (err != NET_EWOULDBLOCK && err != NET_ECONNREFUSED)
+			Con_SafePrintf ("UDP_Read, recvmmsg: %s\n", socketerror(err));
+		b->drained = true;
+		return 0;
+	}
+
+	// empty ones are dropped, as they'd read as nothing waiting
+	for (i = j = 0; i < ret; i++)
+	{
+		if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+		{
+			Con_DPrintf ("UDP_Read: dropped a datagram over %i bytes\n", (int) UDP_BATCHPACKET);
+			continue;
+		}
+		if (!msgs[i].msg_len)
+			continue;
+		if (i != j)
+		{
+			memcpy (b->readbuf[j], b->readbuf[i], msgs[i].msg_len);
+			b->readaddr[j] = b->readaddr[i];
+		}
+		b->readlen[j++] = msgs[i].msg_len;
+	}
+	b->numread = j;
+	b->drained = (ret < UDP_BATCH);
+
+	return j;
+}
+
+/*
+============
+UDP_FlushBatch
+============
+*/
+static void UDP_FlushBatch (udpbatch_t *b)
+{
+	struct mmsghdr	msgs[UDP_BATCH];
+	struct iovec	iovs[UDP_BATCH];
+	int		i, sent, ret, err;
+
+	memset (msgs, 0, sizeof(msgs));
+	for (i = 0; i < b->numwrite; i++)
+	{
+		iovs[i].iov_base = b->writebuf[i];
+		iovs[i].iov_len = b->writelen[i];
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &b->writeaddr[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct qsockaddr);
+	}
+
+	for (sent = 0; sent < b->numwrite; sent += ret)
+	{
+		ret = sendmmsg (b->socketid, msgs + sent, b->numwrite - sent, 0);
+		if (ret == SOCKET_ERROR)
+		{	// the rest are lost, as sendto would have lost them
+			err = SOCKETERRNO;
+			if (err != NET_EWOULDBLOCK)
+				Con_SafePrintf ("UDP_Flush, sendmmsg: %s\n", socketerror(err));
+			break;
+		}
+	}
+	b->numwrite = 0;
+}
+#endif	/* UDP_BATCHING */
+
+/*
+============
+UDP_Flush
+
+sends what UDP_Write held back, at the end of a batch
+============
+*/
+void UDP_Flush (void)
+{
+#if UDP_BATCHING
+	if (!udp_batch)
+		return;
+	if (udp_batch->numwrite)
+		UDP_FlushBatch (udp_batch);
+	udp_batch->drained = false;	// the next batch looks again
+#endif
+}
+
 //=============================================================================
 
 sys_socket_t UDP_Init (void)
@@ -118,6 +302,8 @@ sys_socket_t UDP_Init (void)
 	tst = strrchr(my_tcpip_address, ':');
 	if (tst) *tst = 0;
 
+	Cmd_AddCommand ("udp_loadtest", UDP_LoadTest_f);
+
 	Con_SafePrintf("UDP Initialized\n");
 	tcpipAvailable = true;
 
@@ -143,6 +329,9 @@ void UDP_Listen (qboolean state)
 			return;
 		if ((net_acceptsocket = UDP_OpenSocket (net_hostport)) == INVALID_SOCKET)
 			Sys_Error ("UDP_Listen: Unable to open accept socket");
+#if UDP_BATCHING
+		udp_batch = UDP_NewBatch (net_acceptsocket);
+#endif
 		return;
 	}
 
@@ -192,11 +381,38 @@ int UDP_CloseSocket (sys_socket_t socketid)
 {
 	if (socketid == net_broadcastsocket)
 		net_broadcastsocket = 0;
+#if UDP_BATCHING
+	if (UDP_Batch (socketid))
+	{	// anything still held for it goes with it
+		free (udp_batch);
+		udp_batch = NULL;
+	}
+#endif
 	return closesocket (socketid);
 }
 
 //=============================================================================
 
+/*
+============
+UDP_Sockets
+
+the sockets a running server reads: only the accept socket, which all
+its connections share. The control socket is the client's, and until a
+server is running nothing reads the accept socket, so what waits there
+would end every wait straight away.
+============
+*/
+int UDP_Sockets (sys_socket_t *sockets, int max)
+{
+	if (!sv.active || net_acceptsocket == INVALID_SOCKET || max < 1)
+		return 0;
+	sockets[0] = net_acceptsocket;
+	return 1;
+}
+
+//=============================================================================
+
 /*
 ============
 PartialIPAddress
@@ -270,6 +486,15 @@ sys_socket_t UDP_CheckNewConnections (void)
 	if (net_acceptsocket == INVALID_SOCKET)
 		return INVALID_SOCKET;
 
+#if UDP_BATCHING
+	if (udp_batch && (net_batching || udp_batch->nextread < udp_batch->numread))
+	{	// the read ahead replaces the FIONREAD, and absorbs empty packets
+		if (udp_batch->nextread < udp_batch->numread || (!udp_batch->drained && UDP_FillBatch (udp_batch)))
+			return net_acceptsocket;
+		return INVALID_SOCKET;
+	}
+#endif
+
 	if (ioctl (net_acceptsocket, FIONREAD, &available) == -1)
 	{
 		int err = SOCKETERRNO;
@@ -288,6 +513,25 @@ int UDP_Read (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr)
 {
 	socklen_t addrlen = sizeof(struct qsockaddr);
 	int ret;
+#if UDP_BATCHING
+	udpbatch_t	*b;
+
+	b = UDP_Batch (socketid);
+	if (b && b->nextread == b->numread && net_batching)
+	{
+		if (b->drained)
+			return 0;	// nothing more until the next batch
+		UDP_FillBatch (b);
+	}
+	if (b && b->nextread < b->numread)
+	{
+		ret = q_min (len, b->readlen[b->nextread]);
+		memcpy (buf, b->readbuf[b->nextread], ret);
+		*addr = b->readaddr[b->nextread];
+		b->nextread++;
+		return ret;
+	}
+#endif
 
 	ret = recvfrom (socketid, buf, len, 0, (struct sockaddr *)addr, &addrlen);
 	if (ret == SOCKET_ERROR)
@@ -343,6 +587,37 @@ int UDP_Broadcast (sys_socket_t socketid, byte *buf, int len)
 //=============================================================================
 
 int UDP_Write (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr)
+{
+#if UDP_BATCHING
+	udpbatch_t	*b;
+
+	b = UDP_Batch (socketid);
+	if (b && net_batching && len <= UDP_BATCHPACKET)
+	{
+		if (b->numwrite == UDP_BATCH)
+			UDP_FlushBatch (b);
+		memcpy (b->writebuf[b->numwrite], buf, len);
+		b->writeaddr[b->numwrite] = *addr;
+		b->writelen[b->numwrite] = len;
+		b->numwrite++;
+		return len;
+	}
+#endif
+
+	return UDP_WriteNow (socketid, buf, len, addr);
+}
+
+//=============================================================================
+
+/*
+============
+UDP_WriteNow
+
+sends it straight away, leaving anything held back for the batch where it
+is, for a caller that would have it copied for nothing
+============
+*/
+int UDP_WriteNow (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr)
 {
 	int	ret;
 
@@ -478,3 +753,115 @@ int UDP_SetSocketPort (struct qsockaddr *addr, int port)
 
 //=============================================================================
 
+
+/*
+============
+UDP_LoadTest_f
+
+udp_loadtest [clients] [frames]: clients on the loopback each send the
+server socket a small datagram a frame, which it reads and answers as a
+server's frame would, a datagram at a time and then batched, and prints
+how many datagrams a second each way the server managed
+============
+*/
+#define	UDP_LOADCLIENTS		256
+
+static double UDP_LoadTestRun (sys_socket_t server, sys_socket_t *clients, int numclients, struct qsockaddr *serveraddr, int frames, qboolean batched, int *received)
+{
+	struct qsockaddr	addr;
+	byte	buf[64];
+	double	time1, total;
+	int		i, frame;
+
+	memset (buf, 0, sizeof(buf));
+	*received = 0;
+	total = 0;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		for (i = 0; i < numclients; i++)
+			UDP_Write (clients[i], buf, sizeof(buf), serveraddr);
+
+		// only the server's side is timed
+		time1 = Sys_DoubleTime ();
+		net_batching = batched;
+		while (UDP_Read (server, buf, sizeof(buf), &addr) > 0)
+		{
+			UDP_Write (server, buf, sizeof(buf), &addr);
+			(*received)++;
+		}
+		net_batching = false;
+		UDP_Flush ();
+		total += Sys_DoubleTime () - time1;
+
+		for (i = 0; i < numclients; i++)
+		{
+			while (UDP_Read (clients[i], buf, sizeof(buf), &addr) > 0)
+				;
+		}
+	}
+
+	return total;
+}
+
+static void UDP_LoadTest_f (void)
+{
+	struct qsockaddr	serveraddr;
+	sys_socket_t	server, clients[UDP_LOADCLIENTS];
+	qboolean	batching;
+	double		t;
+	int			i, numclients, frames, count, received;
+#if UDP_BATCHING
+	udpbatch_t	*batch;
+#endif
+
+	numclients = (Cmd_Argc () > 1) ? atoi (Cmd_Argv (1)) : MAX_SCOREBOARD;
+	frames = (Cmd_Argc () > 2) ? atoi (Cmd_Argv (2)) : 10000;
+	if (numclients <= 0 || numclients > UDP_LOADCLIENTS || frames <= 0)
+	{
+		Con_Printf ("udp_loadtest [clients (1 to %i)] [frames]\n", UDP_LOADCLIENTS);
+		return;
+	}
+
+	server = UDP_OpenSocket (0);
+	for (i = 0; i < numclients && server != INVALID_SOCKET; i++)
+	{
+		if ((clients[i] = UDP_OpenSocket (0)) == INVALID_SOCKET)
+			break;
+	}
+	if (server == INVALID_SOCKET || i < numclients)
+	{
+		while (i-- > 0)
+			UDP_CloseSocket (clients[i]);
+		if (server != INVALID_SOCKET)
+			UDP_CloseSocket (server);
+		return;
+	}
+
+	UDP_GetSocketAddr (server, &serveraddr);
+	((struct sockaddr_in *)&serveraddr)->sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+	count = numclients * frames;
+
+	batching = net_batching;
+	net_batching = false;
+	UDP_Flush ();
+
+	t = UDP_LoadTestRun (server, clients, numclients, &serveraddr, frames, false, &received);
+	Con_Printf ("unbatched: %i of %i received, %.0f datagrams/sec\n", received, count, t ? received / t : 0);
+#if UDP_BATCHING
+	// the server socket stands in for the accept socket
+	batch = udp_batch;
+	udp_batch = UDP_NewBatch (server);
+	t = UDP_LoadTestRun (server, clients, numclients, &serveraddr, frames, true, &received);
+	Con_Printf ("batched:   %i of %i received, %.0f datagrams/sec\n", received, count, t ? received / t : 0);
+	free (udp_batch);
+	udp_batch = batch;
+#else
+	Con_Printf ("no batching on this platform\n");
+#endif
+
+	net_batching = batching;
+	for (i = 0; i < numclients; i++)
+		UDP_CloseSocket (clients[i]);
+	UDP_CloseSocket (server);
+}
@@ -40,6 +40,9 @@ int  UDP_GetAddrFromName (const char *name, struct qsockaddr *addr);
 int  UDP_AddrCompare (struct qsockaddr *addr1, struct qsockaddr *addr2);
 int  UDP_GetSocketPort (struct qsockaddr *addr);
 int  UDP_SetSocketPort (struct qsockaddr *addr, int port);
+void UDP_Flush (void);
+int  UDP_Sockets (sys_socket_t *sockets, int max);
+int  UDP_WriteNow (sys_socket_t socketid, byte *buf, int len, struct qsockaddr *addr);
 
 #endif	/* __net_udp_h */
 
@@ -185,7 +185,7 @@ static void PF_setorigin (void)
 
 	e = G_EDICT(OFS_PARM0);
 	org = G_VECTOR(OFS_PARM1);
-	VectorCopy (org, e->v.origin);
+	VectorCopy (org, e->hot->origin);
 	SV_LinkEdict (e, false);
 }
 
@@ -753,7 +753,6 @@ static int	checkpvs_capacity;
 static int PF_newcheckclient (int check)
 {
 	int		i;
-	byte	*pvs;
 	edict_t	*ent;
 	mleaf_t	*leaf;
 	vec3_t	org;
@@ -781,11 +780,11 @@ static int PF_newcheckclient (int check)
 		if (i == check)
 			break;	// didn't find anything else
 
-		if (ent->free)
+		if (ent->hot->free)
 			continue;
 		if (ent->v.health <= 0)
 			continue;
-		if ((int)ent->v.flags & FL_NOTARGET)
+		if ((int)ent->hot->flags & FL_NOTARGET)
 			continue;
 
 	// anything that is a client, or has a client as an enemy
@@ -793,9 +792,8 @@ static int PF_newcheckclient (int check)
 	}
 
 // get the PVS for the entity
-	VectorAdd (ent->v.origin, ent->v.view_ofs, org);
+	VectorAdd (ent->hot->origin, ent->v.view_ofs, org);
 	leaf = Mod_PointInLeaf (org, sv.worldmodel);
-	pvs = Mod_LeafPVS (leaf, sv.worldmodel);
 	
 	pvsbytes = (sv.worldmodel->numleafs+7)>>3;
 	if (checkpvs == NULL || pvsbytes > checkpvs_capacity)
@@ -805,7 +803,7 @@ static int PF_newcheckclient (int check)
 		if (!checkpvs)
 			Sys_Error ("PF_newcheckclient: realloc() failed on %d bytes", checkpvs_capacity);
 	}
-	memcpy (checkpvs, pvs, pvsbytes);
+	Mod_LeafPVS (leaf, sv.worldmodel, checkpvs);
 
 	return i;
 }
@@ -843,7 +841,7 @@ static void PF_checkclient (void)
 
 // return check if it might be visible
 	ent = EDICT_NUM(sv.lastcheck);
-	if (ent->free || ent->v.health <= 0)
+	if (ent->hot->free || ent->v.health <= 0)
 	{
 		RETURN_EDICT(sv.edicts);
 		return;
@@ -851,7 +849,7 @@ static void PF_checkclient (void)
 
 // if current entity can't possibly see the check entity, return 0
 	self = PROG_TO_EDICT(pr_global_struct->self);
-	VectorAdd (self->v.origin, self->v.view_ofs, view);
+	VectorAdd (self->hot->origin, self->v.view_ofs, view);
 	leaf = Mod_PointInLeaf (view, sv.worldmodel);
 	l = (leaf - sv.worldmodel->leafs) - 1;
 	if ( (l < 0) || !(checkpvs[l>>3] & (1 << (l & 7))) )
@@ -971,20 +969,20 @@ static void PF_findradius (void)
 	for (i = 1; i < sv.num_edicts; i++, ent = NEXT_EDICT(ent))
 	{
 		float d, lensq;
-		if (ent->free)
+		if (ent->hot->free)
 			continue;
-		if (ent->v.solid == SOLID_NOT)
+		if (ent->hot->solid == SOLID_NOT)
 			continue;
 
-		d = org[0] - (ent->v.origin[0] + (ent->v.mins[0] + ent->v.maxs[0]) * 0.5);
+		d = org[0] - (ent->hot->origin[0] + (ent->v.mins[0] + ent->v.maxs[0]) * 0.5);
 		lensq = d * d;
 		if (lensq > rad)
 			continue;
-		d = org[1] - (ent->v.origin[1] + (ent->v.mins[1] + ent->v.maxs[1]) * 0.5);
+		d = org[1] - (ent->hot->origin[1] + (ent->v.mins[1] + ent->v.maxs[1]) * 0.5);
 		lensq += d * d;
 		if (lensq > rad)
 			continue;
-		d = org[2] - (ent->v.origin[2] + (ent->v.mins[2] + ent->v.maxs[2]) * 0.5);
+		d = org[2] - (ent->hot->origin[2] + (ent->v.mins[2] + ent->v.maxs[2]) * 0.5);
 		lensq += d * d;
 		if (lensq > rad)
 			continue;
@@ -1071,7 +1069,7 @@ static void PF_Find (void)
 	for (e++ ; e < sv.num_edicts ; e++)
 	{
 		ed = EDICT_NUM(e);
-		if (ed->free)
+		if (ed->hot->free)
 			continue;
 		t = E_STRING(ed,f);
 		if (!t)
@@ -1188,7 +1186,7 @@ static void PF_walkmove (void)
 	yaw = G_FLOAT(OFS_PARM0);
 	dist = G_FLOAT(OFS_PARM1);
 
-	if ( !( (int)ent->v.flags & (FL_ONGROUND|FL_FLY|FL_SWIM) ) )
+	if ( !( (int)ent->hot->flags & (FL_ONGROUND|FL_FLY|FL_SWIM) ) )
 	{
 		G_FLOAT(OFS_RETURN) = 0;
 		return;
@@ -1227,18 +1225,18 @@ static void PF_droptofloor (void)
 
 	ent = PROG_TO_EDICT(pr_global_struct->self);
 
-	VectorCopy (ent->v.origin, end);
+	VectorCopy (ent->hot->origin, end);
 	end[2] -= 256;
 
-	trace = SV_Move (ent->v.origin, ent->v.mins, ent->v.maxs, end, false, ent);
+	trace = SV_Move (ent->hot->origin, ent->v.mins, ent->v.maxs, end, false, ent);
 
 	if (trace.fraction == 1 || trace.allsolid)
 		G_FLOAT(OFS_RETURN) = 0;
 	else
 	{
-		VectorCopy (trace.endpos, ent->v.origin);
+		VectorCopy (trace.endpos, ent->hot->origin);
 		SV_LinkEdict (ent, false);
-		ent->v.flags = (int)ent->v.flags | FL_ONGROUND;
+		ent->hot->flags = (int)ent->hot->flags | FL_ONGROUND;
 		ent->v.groundentity = EDICT_TO_PROG(trace.ent);
 		G_FLOAT(OFS_RETURN) = 1;
 	}
@@ -1357,7 +1355,7 @@ static void PF_nextent (void)
 			return;
 		}
 		ent = EDICT_NUM(i);
-		if (!ent->free)
+		if (!ent->hot->free)
 		{
 			RETURN_EDICT(ent);
 			return;
@@ -1387,7 +1385,7 @@ static void PF_aim (void)
 	speed = G_FLOAT(OFS_PARM1);
 	(void) speed; /* variable set but not used */
 
-	VectorCopy (ent->v.origin, start);
+	VectorCopy (ent->hot->origin, start);
 	start[2] += 20;
 
 // try sending a trace straight
@@ -1416,7 +1414,7 @@ static void PF_aim (void)
 		if (teamplay.value && ent->v.team > 0 && ent->v.team == check->v.team)
 			continue;	// don't aim at teammate
 		for (j = 0; j < 3; j++)
-			end[j] = check->v.origin[j] + 0.5 * (check->v.mins[j] + check->v.maxs[j]);
+			end[j] = check->hot->origin[j] + 0.5 * (check->v.mins[j] + check->v.maxs[j]);
 		VectorSubtract (end, start, dir);
 		VectorNormalize (dir);
 		dist = DotProduct (dir, pr_global_struct->v_forward);
@@ -1432,7 +1430,7 @@ static void PF_aim (void)
 
 	if (bestent)
 	{
-		VectorSubtract (bestent->v.origin, ent->v.origin, dir);
+		VectorSubtract (bestent->hot->origin, ent->hot->origin, dir);
 		dist = DotProduct (dir, pr_global_struct->v_forward);
 		VectorScale (pr_global_struct->v_forward, dist, end);
 		end[2] = dir[2];
@@ -1608,7 +1606,7 @@ static void PF_makestatic (void)
 		if (sv.protocol == PROTOCOL_RMQ)
 		{
 			eval_t* val;
-			val = GetEdictFieldValue(ent, "scale");
+			val = GetEdictFieldOfs(ent, pr_extfields.scale);
 			if (val)
 				ent->scale = ENTSCALE_ENCODE(val->_float);
 			else
@@ -1644,7 +1642,7 @@ static void PF_makestatic (void)
 	MSG_WriteByte (sv.signon, ent->v.skin);
 	for (i = 0; i < 3; i++)
 	{
-		MSG_WriteCoord(sv.signon, ent->v.origin[i], sv.protocolflags);
+		MSG_WriteCoord(sv.signon, ent->hot->origin[i], sv.protocolflags);
 		MSG_WriteAngle(sv.signon, ent->v.angles[i], sv.protocolflags);
 	}
 
@@ -28,9 +28,26 @@ dfunction_t		*pr_functions;
 
 static	char		*pr_strings;
 static	int		pr_stringssize;
-static	const char	**pr_knownstrings;
+
+// strings outside pr_strings, string_t -1 - index
+typedef struct
+{
+	const char	*s;		// NULL while the slot is free
+	int		size;		// of the block PR_AllocString gave it, 0 for engine strings
+	int		next;		// next in the same hash chain, or on the free list
+	int		flags;
+} prknownstring_t;
+
+#define	KS_CANDIDATE	1	// held by an edict that was freed
+#define	KS_REACHED	2	// still referenced, found by PR_ReclaimStrings
+
+static	prknownstring_t	*pr_knownstrings;
 static	int		pr_maxknownstrings;
 static	int		pr_numknownstrings;
+static	int		pr_freeknownstring = -1;	// head of the free slots
+static	int		*pr_stringhash;		// pointer -> first slot, chained through next
+static	int		pr_numcandidates;	// KS_CANDIDATE slots
+static	int		pr_reclaimat;		// PR_ReclaimStrings runs once there are this many
 static	ddef_t		*pr_fielddefs;
 static	ddef_t		*pr_globaldefs;
 
@@ -42,6 +59,8 @@ globalvars_t	*pr_global_struct;
 float		*pr_globals;		// same as pr_global_struct
 int		pr_edict_size;		// in bytes
 
+signed char	pr_hotfields[ENTVARS_INTS];
+
 unsigned short	pr_crc;
 
 int		type_size[8] = {
@@ -58,21 +77,20 @@ int		type_size[8] = {
 #define NUM_TYPE_SIZES (int)Q_COUNTOF(type_size)
 
 static ddef_t	*ED_FieldAtOfs (int ofs);
-static qboolean	ED_ParseEpair (void *base, ddef_t *key, const char *s);
+static void	PR_FreeEdictStrings (edict_t *ed);
+static void	PR_ClearStrings (void);
+static qboolean	ED_ParseEpair (void *d, ddef_t *key, const char *s);
 
-#define	MAX_FIELD_LEN	64
-#define	GEFV_CACHESIZE	2
+// name lookups into the defs and functions, built by PR_LoadProgs
+typedef struct
+{
+	int		*indices;	// index + 1, 0 = empty
+	int		numindices;
+} prhash_t;
 
-typedef struct {
-	ddef_t	*pcache;
-	char	field[MAX_FIELD_LEN];
-} gefv_cache;
+static prhash_t	pr_fieldhash, pr_globalhash, pr_functionhash;
 
-static gefv_cache	gefvCache[GEFV_CACHESIZE] =
-{
-		{ NULL,	"" },
-		{ NULL,	"" }
-};
+prfields_t	pr_extfields;
 
 cvar_t	nomonsters = {"nomonsters", "0", CVAR_NONE};
 cvar_t	gamecfg = {"gamecfg", "0", CVAR_NONE};
@@ -94,9 +112,39 @@ Sets everything to NULL
 =================
 */
 void ED_ClearEdict (edict_t *e)
+{
+	ED_ClearFields (e);
+	e->hot->free = false;
+}
+
+/*
+=================
+ED_ClearFields
+
+Sets the QuakeC fields to NULL, wherever they are kept
+=================
+*/
+void ED_ClearFields (edict_t *e)
 {
 	memset (&e->v, 0, progs->entityfields * 4);
-	e->free = false;
+	memset (e->hot, 0, offsetof(edicthot_t, free));
+}
+
+/*
+=================
+ED_ZeroEdict
+
+Zeroes all of an edict, which was left uninitialized by malloc(), but for
+where its hot fields are
+=================
+*/
+void ED_ZeroEdict (int num)
+{
+	edict_t	*e = EDICT_NUM(num);
+
+	memset (e, 0, pr_edict_size);
+	e->hot = &sv.edicthot[num];
+	memset (e->hot, 0, sizeof(edicthot_t));
 }
 
 /*
@@ -120,7 +168,7 @@ edict_t *ED_Alloc (void)
 		e = EDICT_NUM(i);
 		// the first couple seconds of server time can involve a lot of
 		// freeing and allocating, so relax the replacement policy
-		if (e->free && ( e->freetime < 2 || sv.time - e->freetime > 0.5 ) )
+		if (e->hot->free && ( e->freetime < 2 || sv.time - e->freetime > 0.5 ) )
 		{
 			ED_ClearEdict (e);
 			return e;
@@ -131,9 +179,11 @@ edict_t *ED_Alloc (void)
 		Host_Error ("ED_Alloc: no free edicts (max_edicts is %i)", sv.max_edicts);
 
 	sv.num_edicts++;
+	ED_ZeroEdict (i); // ericw -- switched sv.edicts to malloc(), so we are accessing uninitialized memory and must fully zero it, not just ED_ClearEdict
 	e = EDICT_NUM(i);
-	memset(e, 0, pr_edict_size); // ericw -- switched sv.edicts to malloc(), so we are accessing uninitialized memory and must fully zero it, not just ED_ClearEdict
-	e->baseline.scale = ENTSCALE_DEFAULT;
+	memset(&sv.baselines[i], 0, sizeof(entity_state_t));
+	sv.baselines[i].scale = ENTSCALE_DEFAULT;
+	SV_WakeEdict (i);
 
 	return e;
 }
@@ -149,18 +199,20 @@ FIXME: walk all entities and NULL out references to this entity
 void ED_Free (edict_t *ed)
 {
 	SV_UnlinkEdict (ed);		// unlink from world bsp
+	SV_ClearNetEdict (NUM_FOR_EDICT(ed));
+	PR_FreeEdictStrings (ed);
 
-	ed->free = true;
+	ed->hot->free = true;
 	ed->v.model = 0;
 	ed->v.takedamage = 0;
 	ed->v.modelindex = 0;
 	ed->v.colormap = 0;
 	ed->v.skin = 0;
 	ed->v.frame = 0;
-	VectorCopy (vec3_origin, ed->v.origin);
+	VectorCopy (vec3_origin, ed->hot->origin);
 	VectorCopy (vec3_origin, ed->v.angles);
-	ed->v.nextthink = -1;
-	ed->v.solid = 0;
+	ed->hot->nextthink = -1;
+	ed->hot->solid = 0;
 	ed->alpha = ENTALPHA_DEFAULT; //johnfitz -- reset alpha for next entity
 	ed->scale = ENTSCALE_DEFAULT;
 
@@ -207,23 +259,97 @@ static ddef_t *ED_FieldAtOfs (int ofs)
 	return NULL;
 }
 
+// names for the hash tables
+static const char *ED_FieldName (int i)
+{
+	return PR_GetString (pr_fielddefs[i].s_name);
+}
+
+static const char *ED_GlobalName (int i)
+{
+	return PR_GetString (pr_globaldefs[i].s_name);
+}
+
+static const char *ED_FunctionName (int i)
+{
+	return PR_GetString (pr_functions[i].s_name);
+}
+
 /*
 ============
-ED_FindField
+PR_HashFind
+
+Returns the index of the entry called key, or -1
 ============
 */
-static ddef_t *ED_FindField (const char *name)
+static int PR_HashFind (prhash_t *hash, const char *(*name) (int i), const char *key)
 {
-	ddef_t		*def;
-	int			i;
+	int		pos, end, idx;
 
-	for (i = 0; i < progs->numfielddefs; i++)
+	if (!hash->numindices)
+		return -1;
+
+	pos = COM_HashString (key) % hash->numindices;
+	end = pos;
+
+	do
 	{
-		def = &pr_fielddefs[i];
-		if ( !strcmp(PR_GetString(def->s_name), name) )
-			return def;
+		idx = hash->indices[pos];
+		if (!idx)
+			return -1;
+		if (!strcmp (name (idx - 1), key))
+			return idx - 1;
+
+		++pos;
+		if (pos == hash->numindices)
+			pos = 0;
+	} while (pos != end);
+
+	return -1;
+}
+
+/*
+============
+PR_BuildHash
+
+Only the first of several entries with the same name goes in, since that is
+the one a search from the start of the list would have found.
+============
+*/
+static void PR_BuildHash (prhash_t *hash, int count, const char *(*name) (int i))
+{
+	int		i, pos;
+
+	hash->numindices = count * 2;	// 50% load factor
+	hash->indices = (int *) Hunk_AllocName (hash->numindices * sizeof(int), "prhash");
+
+	for (i = 0; i < count; i++)
+	{
+		if (PR_HashFind (hash, name, name (i)) >= 0)
+			continue;
+
+		pos = COM_HashString (name (i)) % hash->numindices;
+		while (hash->indices[pos])
+		{
+			++pos;
+			if (pos == hash->numindices)
+				pos = 0;
+		}
+		hash->indices[pos] = i + 1;
 	}
-	return NULL;
+}
+
+/*
+============
+ED_FindField
+============
+*/
+static ddef_t *ED_FindField (const char *name)
+{
+	int		i;
+
+	i = PR_HashFind (&pr_fieldhash, ED_FieldName, name);
+	return (i < 0) ? NULL : &pr_fielddefs[i];
 }
 
 
@@ -234,16 +360,10 @@ ED_FindGlobal
 */
 static ddef_t *ED_FindGlobal (const char *name)
 {
-	ddef_t		*def;
-	int			i;
+	int		i;
 
-	for (i = 0; i < progs->numglobaldefs; i++)
-	{
-		def = &pr_globaldefs[i];
-		if ( !strcmp(PR_GetString(def->s_name), name) )
-			return def;
-	}
-	return NULL;
+	i = PR_HashFind (&pr_globalhash, ED_GlobalName, name);
+	return (i < 0) ? NULL : &pr_globaldefs[i];
 }
 
 
@@ -254,52 +374,36 @@ ED_FindFunction
 */
 static dfunction_t *ED_FindFunction (const char *fn_name)
 {
-	dfunction_t		*func;
-	int				i;
+	int		i;
 
-	for (i = 0; i < progs->numfunctions; i++)
-	{
-		func = &pr_functions[i];
-		if ( !strcmp(PR_GetString(func->s_name), fn_name) )
-			return func;
-	}
-	return NULL;
+	i = PR_HashFind (&pr_functionhash, ED_FunctionName, fn_name);
+	return (i < 0) ? NULL : &pr_functions[i];
 }
 
 /*
 ============
-GetEdictFieldValue
+ED_FindFieldOffset
+
+A handle for GetEdictFieldOfs, -1 if the progs have no such field. Engine
+code that reads a field every frame looks it up once per progs.
 ============
 */
-eval_t *GetEdictFieldValue(edict_t *ed, const char *field)
+int ED_FindFieldOffset (const char *field)
 {
-	ddef_t			*def = NULL;
-	int				i;
-	static int		rep = 0;
-
-	for (i = 0; i < GEFV_CACHESIZE; i++)
-	{
-		if (!strcmp(field, gefvCache[i].field))
-		{
-			def = gefvCache[i].pcache;
-			goto Done;
-		}
-	}
+	ddef_t	*def;
 
 	def = ED_FindField (field);
+	return def ? def->ofs : -1;
+}
 
-	if (strlen(field) < MAX_FIELD_LEN)
-	{
-		gefvCache[rep].pcache = def;
-		strcpy (gefvCache[rep].field, field);
-		rep ^= 1;
-	}
-
-Done:
-	if (!def)
-		return NULL;
-
-	return (eval_t *)((char *)&ed->v + def->ofs*4);
+/*
+============
+GetEdictFieldValue
+============
+*/
+eval_t *GetEdictFieldValue(edict_t *ed, const char *field)
+{
+	return GetEdictFieldOfs (ed, ED_FindFieldOffset (field));
 }
 
 
@@ -485,7 +589,7 @@ void ED_Print (edict_t *ed)
 	const char	*name;
 	int		type;
 
-	if (ed->free)
+	if (ed->hot->free)
 	{
 		Con_Printf ("FREE\n");
 		return;
@@ -500,7 +604,7 @@ void ED_Print (edict_t *ed)
 		if (l > 1 && name[l - 2] == '_')
 			continue;	// skip _x, _y, _z vars
 
-		v = (int *)((char *)&ed->v + d->ofs*4);
+		v = ED_Field (ed, d->ofs);
 
 	// if the value is still all 0, skip the field
 		type = d->type & ~DEF_SAVEGLOBAL;
@@ -541,7 +645,7 @@ void ED_Write (FILE *f, edict_t *ed)
 
 	fprintf (f, "{\n");
 
-	if (ed->free)
+	if (ed->hot->free)
 	{
 		fprintf (f, "}\n");
 		return;
@@ -555,7 +659,7 @@ void ED_Write (FILE *f, edict_t *ed)
 		if (j > 1 && name[j - 2] == '_')
 			continue;	// skip _x, _y, _z vars
 
-		v = (int *)((char *)&ed->v + d->ofs*4);
+		v = ED_Field (ed, d->ofs);
 
 	// if the value is still all 0, skip the field
 		type = d->type & ~DEF_SAVEGLOBAL;
@@ -649,14 +753,14 @@ static void ED_Count (void)
 	for (i = 0; i < sv.num_edicts; i++)
 	{
 		ent = EDICT_NUM(i);
-		if (ent->free)
+		if (ent->hot->free)
 			continue;
 		active++;
-		if (ent->v.solid)
+		if (ent->hot->solid)
 			solid++;
 		if (ent->v.model)
 			models++;
-		if (ent->v.movetype == MOVETYPE_STEP)
+		if (ent->hot->movetype == MOVETYPE_STEP)
 			step++;
 	}
 
@@ -744,7 +848,7 @@ const char *ED_ParseGlobals (const char *data)
 			continue;
 		}
 
-		if (!ED_ParseEpair ((void *)pr_globals, key, com_token))
+		if (!ED_ParseEpair ((void *)((int *)pr_globals + key->ofs), key, com_token))
 			Host_Error ("ED_ParseGlobals: parse error");
 	}
 	return data;
@@ -789,22 +893,19 @@ static string_t ED_NewString (const char *string)
 =============
 ED_ParseEval
 
-Can parse either fields or globals
+Can parse either fields or globals, into d
 returns false if error
 =============
 */
-static qboolean ED_ParseEpair (void *base, ddef_t *key, const char *s)
+static qboolean ED_ParseEpair (void *d, ddef_t *key, const char *s)
 {
 	int		i;
 	char	string[128];
 	ddef_t	*def;
 	char	*v, *w;
 	char	*end;
-	void	*d;
 	dfunction_t	*func;
 
-	d = (void *)((int *)base + key->ofs);
-
 	switch (key->type & ~DEF_SAVEGLOBAL)
 	{
 	case ev_string:
@@ -892,7 +993,7 @@ const char *ED_ParseEdict (const char *data, edict_t *ent)
 
 	// clear it
 	if (ent != sv.edicts)	// hack
-		memset (&ent->v, 0, progs->entityfields * 4);
+		ED_ClearFields (ent);
 
 	// go through all the dictionary pairs
 	while (1)
@@ -967,12 +1068,12 @@ const char *ED_ParseEdict (const char *data, edict_t *ent)
 			sprintf (com_token, "0 %s 0", temp);
 		}
 
-		if (!ED_ParseEpair ((void *)&ent->v, key, com_token))
+		if (!ED_ParseEpair ((void *)ED_Field (ent, key->ofs), key, com_token))
 			Host_Error ("ED_ParseEdict: parse error");
 	}
 
 	if (!init)
-		ent->free = true;
+		ent->hot->free = true;
 
 	return data;
 }
@@ -1164,10 +1265,6 @@ void PR_LoadProgs (void)
 {
 	int			i;
 
-	// flush the non-C variable lookup cache
-	for (i = 0; i < GEFV_CACHESIZE; i++)
-		gefvCache[i].field[0] = 0;
-
 	CRC_Init (&pr_crc);
 
 	progs = (dprograms_t *)COM_LoadHunkFile ("progs.dat", NULL);
@@ -1193,12 +1290,8 @@ void PR_LoadProgs (void)
 		Host_Error ("progs.dat strings go past end of file\n");
 
 	// initialize the strings
-	pr_numknownstrings = 0;
-	pr_maxknownstrings = 0;
 	pr_stringssize = progs->numstrings;
-	if (pr_knownstrings)
-		Z_Free ((void *)pr_knownstrings);
-	pr_knownstrings = NULL;
+	PR_ClearStrings ();
 	PR_SetEngineString("");
 
 	pr_globaldefs = (ddef_t *)((byte *)progs + progs->ofs_globaldefs);
@@ -1260,8 +1353,20 @@ void PR_LoadProgs (void)
 	pr_edict_size += sizeof(void *) - 1;
 	pr_edict_size &= ~(sizeof(void *) - 1);
 
+	PR_BuildHash (&pr_fieldhash, progs->numfielddefs, ED_FieldName);
+	PR_BuildHash (&pr_globalhash, progs->numglobaldefs, ED_GlobalName);
+	PR_BuildHash (&pr_functionhash, progs->numfunctions, ED_FunctionName);
+
+	pr_extfields.alpha = ED_FindFieldOffset ("alpha");
+	pr_extfields.scale = ED_FindFieldOffset ("scale");
+	pr_extfields.items2 = ED_FindFieldOffset ("items2");
+	pr_extfields.gravity = ED_FindFieldOffset ("gravity");
+
 	PR_PatchRereleaseBuiltins ();
 	pr_effects_mask = PR_FindSupportedEffects ();
+
+	PR_DecodeProgs ();
+	PR_LinkNativeProgs ();
 }
 
 
@@ -1270,13 +1375,39 @@ void PR_LoadProgs (void)
 PR_Init
 ===============
 */
+/*
+===============
+PR_InitHotFields
+===============
+*/
+static void PR_InitHotFields (void)
+{
+	int		i;
+
+	memset (pr_hotfields, -1, sizeof(pr_hotfields));
+#define	HOTFIELD(f,n)	for (i = 0; i < n; i++) \
+		pr_hotfields[offsetof(entvars_t, f) / 4 + i] = offsetof(edicthot_t, f) / 4 + i
+	HOTFIELD (movetype, 1);
+	HOTFIELD (solid, 1);
+	HOTFIELD (flags, 1);
+	HOTFIELD (nextthink, 1);
+	HOTFIELD (origin, 3);
+	HOTFIELD (velocity, 3);
+#undef	HOTFIELD
+}
+
 void PR_Init (void)
 {
+	PR_InitHotFields ();
 	Cmd_AddCommand ("edict", ED_PrintEdict_f);
 	Cmd_AddCommand ("edicts", ED_PrintEdicts);
 	Cmd_AddCommand ("edictcount", ED_Count);
 	Cmd_AddCommand ("profile", PR_Profile_f);
+	Cmd_AddCommand ("pr_bench", PR_Bench_f);
+	Cmd_AddCommand ("pr_fuse", PR_Fuse_f);
 	Cvar_RegisterVariable (&nomonsters);
+	Cvar_RegisterVariable (&pr_profile);
+	Cvar_RegisterVariable (&pr_nativecode);
 	Cvar_RegisterVariable (&gamecfg);
 	Cvar_RegisterVariable (&scratch1);
 	Cvar_RegisterVariable (&scratch2);
@@ -1313,12 +1444,178 @@ int NUM_FOR_EDICT(edict_t *e)
 
 
 #define	PR_STRING_ALLOCSLOTS	256
+#define	PR_RECLAIM_BATCH	64		// candidates to collect before looking for references
+
+// blocks given back by PR_ReclaimStrings, by size in 16 byte steps, the last
+// list holding everything bigger
+#define	PR_STRING_BLOCKCLASSES	16
 
+typedef struct prfreeblock_s
+{
+	struct prfreeblock_s	*next;
+	int			size;
+} prfreeblock_t;
+
+static prfreeblock_t	*pr_freeblocks[PR_STRING_BLOCKCLASSES];
+
+static unsigned int PR_StringHash (const char *s)
+{
+	return ((unsigned int)(uintptr_t)s >> 2) * 2654435761u;
+}
+
+/*
+===============
+PR_AllocStringSlots
+
+grows the slots and rebuilds the hash over them
+===============
+*/
 static void PR_AllocStringSlots (void)
 {
+	int		i, h;
+
 	pr_maxknownstrings += PR_STRING_ALLOCSLOTS;
 	Con_DPrintf2("PR_AllocStringSlots: realloc'ing for %d slots\n", pr_maxknownstrings);
-	pr_knownstrings = (const char **) Z_Realloc ((void *)pr_knownstrings, pr_maxknownstrings * sizeof(char *));
+	pr_knownstrings = (prknownstring_t *) realloc (pr_knownstrings, pr_maxknownstrings * sizeof(prknownstring_t));
+	pr_stringhash = (int *) realloc (pr_stringhash, pr_maxknownstrings * sizeof(int));
+	if (!pr_knownstrings || !pr_stringhash)
+		Sys_Error ("PR_AllocStringSlots: out of memory");
+
+	for (i = 0; i < pr_maxknownstrings; i++)
+		pr_stringhash[i] = -1;
+	for (i = 0; i < pr_numknownstrings; i++)
+	{
+		if (!pr_knownstrings[i].s)
+			continue;
+		h = PR_StringHash (pr_knownstrings[i].s) % pr_maxknownstrings;
+		pr_knownstrings[i].next = pr_stringhash[h];
+		pr_stringhash[h] = i;
+	}
+}
+
+/*
+===============
+PR_NewStringSlot
+
+a slot for s, off the free list if there is one, and hashed
+===============
+*/
+static int PR_NewStringSlot (const char *s, int size)
+{
+	int		i, h;
+
+	if (pr_freeknownstring >= 0)
+	{
+		i = pr_freeknownstring;
+		pr_freeknownstring = pr_knownstrings[i].next;
+	}
+	else
+	{
+		if (pr_numknownstrings >= pr_maxknownstrings)
+			PR_AllocStringSlots();
+		i = pr_numknownstrings++;
+	}
+
+	pr_knownstrings[i].s = s;
+	pr_knownstrings[i].size = size;
+	pr_knownstrings[i].flags = 0;
+
+	h = PR_StringHash (s) % pr_maxknownstrings;
+	pr_knownstrings[i].next = pr_stringhash[h];
+	pr_stringhash[h] = i;
+
+	return i;
+}
+
+/*
+===============
+PR_FindStringSlot
+===============
+*/
+static int PR_FindStringSlot (const char *s)
+{
+	int		i;
+
+	if (!pr_maxknownstrings)
+		return -1;
+
+	for (i = pr_stringhash[PR_StringHash (s) % pr_maxknownstrings]; i >= 0; i = pr_knownstrings[i].next)
+	{
+		if (pr_knownstrings[i].s == s)
+			return i;
+	}
+	return -1;
+}
+
+/*
+===============
+PR_FreeStringSlot
+
+unhashes the slot and puts it and its block on the free lists
+===============
+*/
+static void PR_FreeStringSlot (int i)
+{
+	prknownstring_t	*ks = &pr_knownstrings[i];
+	prfreeblock_t	*block;
+	int		*link, c;
+
+	for (link = &pr_stringhash[PR_StringHash (ks->s) % pr_maxknownstrings]; *link != i; link = &pr_knownstrings[*link].next)
+		;
+	*link = ks->next;
+
+	if (ks->size)
+	{
+		c = q_min (ks->size / 16, PR_STRING_BLOCKCLASSES) - 1;
+		block = (prfreeblock_t *)ks->s;
+		block->size = ks->size;
+		block->next = pr_freeblocks[c];
+		pr_freeblocks[c] = block;
+	}
+
+	ks->s = NULL;
+	ks->size = 0;
+	ks->flags = 0;
+	ks->next = pr_freeknownstring;
+	pr_freeknownstring = i;
+}
+
+/*
+===============
+PR_ClearStrings
+
+forgets every string outside pr_strings, when new progs are loaded
+===============
+*/
+static void PR_ClearStrings (void)
+{
+	prfreeblock_t	*block, *next;
+	int		i;
+
+	for (i = 0; i < pr_numknownstrings; i++)
+	{
+		if (pr_knownstrings[i].size)
+			free ((void *)pr_knownstrings[i].s);
+	}
+	for (i = 0; i < PR_STRING_BLOCKCLASSES; i++)
+	{
+		for (block = pr_freeblocks[i]; block; block = next)
+		{
+			next = block->next;
+			free (block);
+		}
+	}
+	memset (pr_freeblocks, 0, sizeof(pr_freeblocks));
+
+	free (pr_knownstrings);
+	free (pr_stringhash);
+	pr_knownstrings = NULL;
+	pr_stringhash = NULL;
+	pr_numknownstrings = 0;
+	pr_maxknownstrings = 0;
+	pr_freeknownstring = -1;
+	pr_numcandidates = 0;
+	pr_reclaimat = PR_RECLAIM_BATCH;
 }
 
 const char *PR_GetString (int num)
@@ -1327,12 +1624,12 @@ const char *PR_GetString (int num)
 		return pr_strings + num;
 	else if (num < 0 && num >= -pr_numknownstrings)
 	{
-		if (!pr_knownstrings[-1 - num])
+		if (!pr_knownstrings[-1 - num].s)
 		{
 			Host_Error ("PR_GetString: attempt to get a non-existant string %d\n", num);
 			return "";
 		}
-		return pr_knownstrings[-1 - num];
+		return pr_knownstrings[-1 - num].s;
 	}
 	else
 	{
@@ -1354,50 +1651,156 @@ int PR_SetEngineString (const char *s)
 	if (s >= pr_strings && s <= pr_strings + pr_stringssize - 2)
 		return (int)(s - pr_strings);
 #endif
-	for (i = 0; i < pr_numknownstrings; i++)
+	i = PR_FindStringSlot (s);
+	if (i < 0)
+		i = PR_NewStringSlot (s, 0);	// new unknown engine string
+	return -1 - i;
+}
+
+int PR_AllocString (int size, char **ptr)
+{
+	prfreeblock_t	**link;
+	char		*block;
+	int		c;
+
+	if (!size)
+		return 0;
+
+	size = (size + 15) & ~15;
+
+	// any block in a bigger list fits, the last one has to be searched
+	block = NULL;
+	for (c = q_min (size / 16, PR_STRING_BLOCKCLASSES) - 1; c < PR_STRING_BLOCKCLASSES && !block; c++)
 	{
-		if (pr_knownstrings[i] == s)
-			return -1 - i;
+		for (link = &pr_freeblocks[c]; *link; link = &(*link)->next)
+		{
+			if ((*link)->size >= size)
+			{
+				size = (*link)->size;
+				block = (char *)*link;
+				*link = (*link)->next;
+				memset (block, 0, size);
+				break;
+			}
+		}
 	}
-	// new unknown engine string
-	//Con_DPrintf ("PR_SetEngineString: new engine string %p\n", s);
-#if 0
-	for (i = 0; i < pr_numknownstrings; i++)
+	if (!block)
 	{
-		if (!pr_knownstrings[i])
-			break;
+		// not on the hunk, which is the main thread's while the server frame
+		// is pipelined. PR_ClearStrings gives them all back.
+		block = (char *) calloc (1, size);
+		if (!block)
+			Sys_Error ("PR_AllocString: couldn't allocate %i bytes", size);
 	}
-#endif
-//	if (i >= pr_numknownstrings)
-//	{
-		if (i >= pr_maxknownstrings)
-			PR_AllocStringSlots();
-		pr_numknownstrings++;
-//	}
-	pr_knownstrings[i] = s;
-	return -1 - i;
+
+	if (ptr)
+		*ptr = block;
+	return -1 - PR_NewStringSlot (block, size);
 }
 
-int PR_AllocString (int size, char **ptr)
+/*
+===============
+PR_FreeEdictStrings
+
+marks the allocated strings ed's fields hold, for PR_ReclaimStrings to give
+back once nothing else refers to them
+===============
+*/
+static void PR_FreeEdictStrings (edict_t *ed)
+{
+	ddef_t	*def;
+	int		i, num;
+
+	for (i = 0, def = pr_fielddefs; i < progs->numfielddefs; i++, def++)
+	{
+		if ((def->type & ~DEF_SAVEGLOBAL) != ev_string)
+			continue;
+		num = -1 - ((int *)&ed->v)[def->ofs];
+		if (num < 0 || num >= pr_numknownstrings)
+			continue;
+		if (pr_knownstrings[num].size && !(pr_knownstrings[num].flags & KS_CANDIDATE))
+		{
+			pr_knownstrings[num].flags |= KS_CANDIDATE;
+			pr_numcandidates++;
+		}
+	}
+}
+
+/*
+===============
+PR_ReachString
+
+marks what a string_t or a pointer the server kept refers to
+===============
+*/
+static void PR_ReachString (int value)
+{
+	int		num = -1 - value;
+
+	if (num >= 0 && num < pr_numknownstrings)
+		pr_knownstrings[num].flags |= KS_REACHED;
+}
+
+static void PR_ReachPointer (const char *s)
 {
 	int		i;
 
-	if (!size)
-		return 0;
+	if (s && (i = PR_FindStringSlot (s)) >= 0)
+		pr_knownstrings[i].flags |= KS_REACHED;
+}
+
+/*
+===============
+PR_ReclaimStrings
+
+Gives back the strings of removed edicts that nothing refers to any more.
+Anything that looks like a reference counts: the globals, every edict still
+in use or freed too recently to be reused, and the pointers the server
+keeps. Runs between server frames, when no QuakeC locals are saved anywhere
+else.
+===============
+*/
+void PR_ReclaimStrings (void)
+{
+	edict_t	*ed;
+	int		i, j, freed;
+
+	if (!sv.active || pr_numcandidates < pr_reclaimat)
+		return;
+
+	for (i = 0; i < progs->numglobals; i++)
+		PR_ReachString (((int *)pr_globals)[i]);
+
+	for (i = 0; i < sv.num_edicts; i++)
+	{
+		ed = EDICT_NUM(i);
+		if (ed->hot->free && (ed->freetime < 2 || sv.time - ed->freetime > 0.5))
+			continue;	// what ED_Alloc would reuse
+		for (j = 0; j < progs->entityfields; j++)
+			PR_ReachString (((int *)&ed->v)[j]);
+	}
+
+	for (i = 0; i < MAX_MODELS && sv.model_precache[i]; i++)
+		PR_ReachPointer (sv.model_precache[i]);
+	for (i = 0; i < MAX_SOUNDS && sv.sound_precache[i]; i++)
+		PR_ReachPointer (sv.sound_precache[i]);
+	for (i = 0; i < MAX_LIGHTSTYLES; i++)
+		PR_ReachPointer (sv.lightstyles[i]);
+
+	freed = 0;
 	for (i = 0; i < pr_numknownstrings; i++)
 	{
-		if (!pr_knownstrings[i])
-			break;
+		if ((pr_knownstrings[i].flags & (KS_CANDIDATE|KS_REACHED)) == KS_CANDIDATE)
+		{
+			PR_FreeStringSlot (i);
+			freed++;
+		}
+		else
+			pr_knownstrings[i].flags &= ~KS_REACHED;
 	}
-//	if (i >= pr_numknownstrings)
-//	{
-		if (i >= pr_maxknownstrings)
-			PR_AllocStringSlots();
-		pr_numknownstrings++;
-//	}
-	pr_knownstrings[i] = (char *)Hunk_AllocName(size, "string");
-	if (ptr)
-		*ptr = (char *) pr_knownstrings[i];
-	return -1 - i;
+
+	pr_numcandidates -= freed;
+	pr_reclaimat = pr_numcandidates + PR_RECLAIM_BATCH;
+	Con_DPrintf2 ("PR_ReclaimStrings: %i strings given back, %i still held\n", freed, pr_numcandidates);
 }
 
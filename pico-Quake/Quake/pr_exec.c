@@ -40,6 +40,92 @@ dfunction_t	*pr_xfunction;
 int		pr_xstatement;
 int		pr_argc;
 
+cvar_t	pr_profile = {"pr_profile", "0", CVAR_NONE};	// count the superinstructions for pr_fuse
+cvar_t	pr_nativecode = {"pr_nativecode", "1", CVAR_NONE};	// use the built in translation of progs.dat, from the next map
+
+// the statements as the fast loop runs them, decoded once at load time
+typedef struct
+{
+	int		op;
+	eval_t		*a, *b, *c;	// operands resolved to their globals
+	int		jump;		// branch offset of IF, IFNOT and GOTO
+} prstatement_t;
+
+enum
+{
+	OP_BADOP = OP_BITOR + 1,	// anything out of range, so the fast loop needs no bounds check
+
+	// superinstructions, a statement and the one after it in one dispatch
+	OP_LOAD_STORE,		// LOAD_F/S/ENT/FLD/FNC, STORE of the result
+	OP_LOAD_STORE_V,
+	OP_ADDRESS_STOREP,	// ADDRESS, STOREP_F/S/ENT/FLD/FNC through it
+	OP_ADDRESS_STOREP_V,
+	OP_LT_IFNOT,		// comparison, IFNOT on the result
+	OP_GT_IFNOT,
+	OP_LE_IFNOT,
+	OP_GE_IFNOT,
+	OP_EQ_F_IFNOT,
+	OP_NE_F_IFNOT,
+	OP_EQ_E_IFNOT,
+	OP_NE_E_IFNOT,
+	OP_STORE_CALL,		// STORE_F/S/ENT/FLD/FNC to a parm, CALL
+	OP_STORE_V_CALL,
+
+	OP_NUMDECODED
+};
+
+#define	OP_FIRSTFUSED		OP_LOAD_STORE
+#define	NUM_FUSED		(OP_NUMDECODED - OP_FIRSTFUSED)
+
+static const char *pr_fusenames[NUM_FUSED] =
+{
+	"LOAD STORE",
+	"LOAD_V STORE_V",
+	"ADDRESS STOREP",
+	"ADDRESS STOREP_V",
+	"LT IFNOT",
+	"GT IFNOT",
+	"LE IFNOT",
+	"GE IFNOT",
+	"EQ_F IFNOT",
+	"NE_F IFNOT",
+	"EQ_E IFNOT",
+	"NE_E IFNOT",
+	"STORE CALL",
+	"STORE_V CALL"
+};
+
+static prstatement_t	*pr_code;	// parallel to pr_statements
+
+// which functions PR_FuseProgs fuses
+typedef enum {FUSE_OFF, FUSE_ALL, FUSE_HOT} prfusemode_t;
+
+static prfusemode_t	pr_fusemode = FUSE_HOT;
+static double		pr_fusetime;	// when to fuse from this map's counts, 0 before the first program, -1 once done
+static int		*pr_fuseprofile;	// the profile counts the hot functions were picked from, kept across maps
+static int		pr_fuseprofilecount;	// numfunctions they are for
+static unsigned short	pr_fuseprofilecrc;
+static int		pr_fusefunctions;	// how many functions were fused
+static int		pr_fusesites[NUM_FUSED];
+static int		pr_fusecount[NUM_FUSED];	// times each fused op ran, with pr_profile 1
+static int		pr_fuseframe;	// host_framecount when pr_fusecount was cleared
+
+#define	PR_FUSEDELAY		10	// seconds of play the hot functions are picked from
+
+#define	PR_RUNAWAY		0x1000000	/* was 100000 */
+
+static qboolean	pr_benchslow;	// pr_bench's first pass
+
+// functions of the loaded progs that were translated to C by qc2c.py
+static const prnative_t	*pr_native;
+
+#ifdef USE_NATIVE_PROGS
+extern const prnativeprogs_t	pr_nativeprogs;
+#endif
+
+// tracing is only done by the slow loop
+#define	PR_SLOWPATH		(pr_trace || pr_benchslow)
+
 static const char *pr_opnames[] =
 {
 	"DONE",
@@ -344,46 +430,864 @@ static int PR_LeaveFunction (void)
 
 /*
 ====================
-PR_ExecuteProgram
+PR_FuseKind
 
-The interpretation main loop
+The superinstruction that statement st and the one after it can be run as,
+or 0. The second statement has to use what the first one produced.
 ====================
 */
-#define OPA ((eval_t *)&pr_globals[(unsigned short)st->a])
-#define OPB ((eval_t *)&pr_globals[(unsigned short)st->b])
-#define OPC ((eval_t *)&pr_globals[(unsigned short)st->c])
+static int PR_FuseKind (const dstatement_t *st)
+{
+	const dstatement_t	*next = st + 1;
 
-void PR_ExecuteProgram (func_t fnum)
+	switch (st->op)
+	{
+	case OP_LOAD_F:
+	case OP_LOAD_S:
+	case OP_LOAD_ENT:
+	case OP_LOAD_FLD:
+	case OP_LOAD_FNC:
+		if ((unsigned int)(next->op - OP_STORE_F) < 6 && next->op != OP_STORE_V && next->a == st->c)
+			return OP_LOAD_STORE;
+		break;
+	case OP_LOAD_V:
+		if (next->op == OP_STORE_V && next->a == st->c)
+			return OP_LOAD_STORE_V;
+		break;
+
+	case OP_ADDRESS:
+		if ((unsigned int)(next->op - OP_STOREP_F) < 6 && next->b == st->c)
+			return (next->op == OP_STOREP_V) ? OP_ADDRESS_STOREP_V : OP_ADDRESS_STOREP;
+		break;
+
+	case OP_LT:
+	case OP_GT:
+	case OP_LE:
+	case OP_GE:
+	case OP_EQ_F:
+	case OP_NE_F:
+	case OP_EQ_E:
+	case OP_NE_E:
+		if (next->op != OP_IFNOT || next->a != st->c)
+			break;
+		switch (st->op)
+		{
+		case OP_LT:	return OP_LT_IFNOT;
+		case OP_GT:	return OP_GT_IFNOT;
+		case OP_LE:	return OP_LE_IFNOT;
+		case OP_GE:	return OP_GE_IFNOT;
+		case OP_EQ_F:	return OP_EQ_F_IFNOT;
+		case OP_NE_F:	return OP_NE_F_IFNOT;
+		case OP_EQ_E:	return OP_EQ_E_IFNOT;
+		default:	return OP_NE_E_IFNOT;
+		}
+
+	case OP_STORE_F:
+	case OP_STORE_V:
+	case OP_STORE_S:
+	case OP_STORE_ENT:
+	case OP_STORE_FLD:
+	case OP_STORE_FNC:
+		if ((unsigned int)(next->op - OP_CALL0) < 9 &&
+			(unsigned int)((unsigned short)st->b - OFS_PARM0) < MAX_PARMS*3)
+			return (st->op == OP_STORE_V) ? OP_STORE_V_CALL : OP_STORE_CALL;
+		break;
+	}
+
+	return 0;
+}
+
+/*
+====================
+PR_CompareCounts
+====================
+*/
+static int PR_CompareCounts (const void *a, const void *b)
+{
+	return *(const int *)b - *(const int *)a;	// busiest first
+}
+
+/*
+====================
+PR_FuseProgs
+
+Rewrites pr_code so that pairs of statements PR_FuseKind knows run in one
+dispatch. Only the first statement of a pair changes, the second is still
+there for anything that branches to it. With FUSE_HOT, only the functions
+that make up most of the kept profile counts are fused, and until there are
+counts for these progs everything is, so the first map isn't any slower.
+====================
+*/
+static void PR_FuseProgs (void)
+{
+	dfunction_t	*f;
+	byte		*flags;
+	int		*profile, *sorted;
+	int		i, s, kind, cutoff;
+	double		total, sum;
+
+	for (s = 0; s < progs->numstatements; s++)
+		pr_code[s].op = (pr_statements[s].op < OP_BADOP) ? pr_statements[s].op : OP_BADOP;
+	memset (pr_fusesites, 0, sizeof(pr_fusesites));
+	pr_fusefunctions = 0;
+
+	pr_fusetime = -1;
+	if (pr_fusemode == FUSE_OFF)
+		return;
+
+	profile = NULL;
+	if (pr_fusemode == FUSE_HOT)
+	{
+		if (pr_fuseprofile && pr_fuseprofilecrc == pr_crc && pr_fuseprofilecount == progs->numfunctions)
+			profile = pr_fuseprofile;
+		else
+			pr_fusetime = 0;	// PR_FuseCheck picks them once the counts are in
+	}
+
+	// 1 = a function starts here, 2 = part of a function that gets fused
+	flags = (byte *) calloc (progs->numstatements, 1);
+	if (!flags)
+		Sys_Error ("PR_FuseProgs: couldn't allocate %i bytes", progs->numstatements);
+
+	for (i = 0, f = pr_functions; i < progs->numfunctions; i++, f++)
+	{
+		if (f->first_statement > 0 && f->first_statement < progs->numstatements)
+			flags[f->first_statement] = 1;
+	}
+
+	// the hot functions are the busiest ones that add up to 95% of the counts
+	cutoff = 0;
+	if (profile)
+	{
+		sorted = (int *) malloc (progs->numfunctions * sizeof(int));
+		if (!sorted)
+			Sys_Error ("PR_FuseProgs: couldn't allocate %i bytes", progs->numfunctions * (int)sizeof(int));
+		memcpy (sorted, profile, progs->numfunctions * sizeof(int));
+		qsort (sorted, progs->numfunctions, sizeof(int), PR_CompareCounts);
+
+		for (i = 0, total = 0; i < progs->numfunctions; i++)
+			total += sorted[i];
+		for (i = 0, sum = 0; i < progs->numfunctions && sorted[i]; i++)
+		{
+			cutoff = sorted[i];
+			sum += sorted[i];
+			if (sum >= total - total / 20)
+				break;
+		}
+		free (sorted);
+	}
+
+	for (i = 0, f = pr_functions; i < progs->numfunctions; i++, f++)
+	{
+		if (f->first_statement <= 0 || (profile && (!profile[i] || profile[i] < cutoff)))
+			continue;
+		pr_fusefunctions++;
+		s = f->first_statement;
+		do
+			flags[s++] |= 2;
+		while (s < progs->numstatements && !(flags[s] & 1));
+	}
+
+	for (s = 0; s < progs->numstatements - 1; s++)
+	{
+		if (!(flags[s] & 2) || (flags[s + 1] & 1))
+			continue;
+		kind = PR_FuseKind (&pr_statements[s]);
+		if (kind)
+		{
+			pr_code[s].op = kind;
+			pr_fusesites[kind - OP_FIRSTFUSED]++;
+		}
+	}
+
+	free (flags);
+}
+
+/*
+====================
+PR_KeepFuseProfile
+
+Takes the profile counts the hot functions are picked from, and keeps them
+so the same progs are fused the same way on later maps
+====================
+*/
+static void PR_KeepFuseProfile (void)
+{
+	int		i;
+
+	free (pr_fuseprofile);
+	pr_fuseprofile = (int *) malloc (progs->numfunctions * sizeof(int));
+	if (!pr_fuseprofile)
+		Sys_Error ("PR_KeepFuseProfile: couldn't allocate %i bytes", progs->numfunctions * (int)sizeof(int));
+	for (i = 0; i < progs->numfunctions; i++)
+		pr_fuseprofile[i] = pr_functions[i].profile;
+	pr_fuseprofilecount = progs->numfunctions;
+	pr_fuseprofilecrc = pr_crc;
+}
+
+/*
+====================
+PR_FuseCheck
+
+Called before a program runs with nothing else running, while the hot
+functions still have to be picked. The profile counts of the first
+PR_FUSEDELAY seconds of play decide them.
+====================
+*/
+static void PR_FuseCheck (void)
+{
+	if (!pr_fusetime)
+	{
+		pr_fusetime = sv.time + PR_FUSEDELAY;
+		return;
+	}
+	if (sv.time < pr_fusetime)
+		return;
+
+	PR_KeepFuseProfile ();
+	PR_FuseProgs ();
+	Con_DPrintf ("%i of %i functions fused\n", pr_fusefunctions, progs->numfunctions);
+}
+
+/*
+============
+PR_Fuse_f
+
+pr_fuse [off | all | hot]: changes which functions are fused, then reports
+how many of each superinstruction there are and, with pr_profile 1, how
+often they ran, which is the number of dispatches they saved
+============
+*/
+void PR_Fuse_f (void)
 {
+	const char	*arg;
+	int		i, sites, frames;
+	double		saved;
+
+	if (!sv.active)
+	{
+		Con_Printf ("pr_fuse: no map running\n");
+		return;
+	}
+
+	if (Cmd_Argc () > 1)
+	{
+		arg = Cmd_Argv (1);
+		if (!q_strcasecmp (arg, "off"))
+			pr_fusemode = FUSE_OFF;
+		else if (!q_strcasecmp (arg, "all"))
+			pr_fusemode = FUSE_ALL;
+		else if (!q_strcasecmp (arg, "hot"))
+		{
+			for (i = 0; i < progs->numfunctions; i++)
+			{
+				if (pr_functions[i].profile)
+					break;
+			}
+			if (i == progs->numfunctions)
+			{
+				Con_Printf ("no profile counts, play for a while first\n");
+				return;
+			}
+
+			PR_KeepFuseProfile ();
+			pr_fusemode = FUSE_HOT;
+		}
+		else
+		{
+			Con_Printf ("usage: pr_fuse [off | all | hot]\n");
+			return;
+		}
+
+		PR_FuseProgs ();
+		memset (pr_fusecount, 0, sizeof(pr_fusecount));
+		pr_fuseframe = host_framecount;
+	}
+
+	frames = q_max (1, host_framecount - pr_fuseframe);
+
+	Con_Printf ("%i of %i functions fused%s\n", pr_fusefunctions, progs->numfunctions,
+				(pr_fusetime >= 0) ? ", hot ones not picked yet" : "");
+	Con_Printf ("superinstruction   sites  per frame\n");
+	sites = 0;
+	saved = 0;
+	for (i = 0; i < NUM_FUSED; i++)
+	{
+		if (!pr_fusesites[i])
+			continue;
+		Con_Printf ("%-16s %7i %10.1f\n", pr_fusenames[i], pr_fusesites[i], (double)pr_fusecount[i] / frames);
+		sites += pr_fusesites[i];
+		saved += pr_fusecount[i];
+	}
+	if (pr_profile.value)
+		Con_Printf ("%i sites, %.1f dispatches saved per frame over %i frames\n", sites, saved / frames, frames);
+	else
+		Con_Printf ("%i sites, set pr_profile 1 to count how often they run\n", sites);
+
+	memset (pr_fusecount, 0, sizeof(pr_fusecount));
+	pr_fuseframe = host_framecount;
+}
+
+/*
+====================
+PR_DecodeProgs
+
+Builds pr_code from pr_statements once the progs are loaded, so the fast
+loop finds its operands and branch targets without any arithmetic.
+====================
+*/
+void PR_DecodeProgs (void)
+{
+	dstatement_t	*in;
+	prstatement_t	*out;
+	int		i;
+
+	pr_code = (prstatement_t *) Hunk_AllocName (progs->numstatements * sizeof(prstatement_t), "progcode");
+
+	for (i = 0, in = pr_statements, out = pr_code; i < progs->numstatements; i++, in++, out++)
+	{
+		out->a = (eval_t *)&pr_globals[(unsigned short)in->a];
+		out->b = (eval_t *)&pr_globals[(unsigned short)in->b];
+		out->c = (eval_t *)&pr_globals[(unsigned short)in->c];
+
+		if (in->op == OP_IF || in->op == OP_IFNOT)
+			out->jump = in->b;
+		else if (in->op == OP_GOTO)
+			out->jump = in->a;
+		else
+			out->jump = 0;
+	}
+
+	PR_FuseProgs ();
+	memset (pr_fusecount, 0, sizeof(pr_fusecount));
+	pr_fuseframe = host_framecount;
+}
+
+
+/*
+====================
+PR_ExecuteFast
+
+The interpretation main loop, on the decoded statements. There is no trace
+here, but statements are counted for the profile and the runaway check just
+as in the slow loop. Returns the statement to carry on from if a builtin switched on the slow
+path, or -1 once the function has returned to exitdepth.
+====================
+*/
+#define OPA (st->a)
+#define OPB (st->b)
+#define OPC (st->c)
+
+#if defined(__GNUC__)
+#define PR_COMPUTED_GOTO
+#endif
+
+#ifdef PR_COMPUTED_GOTO
+#define CASE(op)	L_##op
+#define DISPATCH					\
+	do {						\
+		if (++profile > PR_RUNAWAY)		\
+			goto runaway;			\
+		goto *dispatch[(++st)->op];		\
+	} while (0)
+#else
+#define CASE(op)	case op
+#define DISPATCH	goto next
+#endif
+
+// a superinstruction is two statements as far as the counts go
+#define FUSED(op)						\
+	do {							\
+		profile++;					\
+		if (fusecount)					\
+			fusecount[(op) - OP_FIRSTFUSED]++;	\
+	} while (0)
+
+#define JUMP(ofs)	(st += (ofs) - 1)	/* -1 to offset the st++ */
+
+static int PR_ExecuteFast (int s, int exitdepth)
+{
+	prstatement_t	*st;
 	eval_t		*ptr;
-	dstatement_t	*st;
-	dfunction_t	*f, *newf;
-	int profile, startprofile;
+	dfunction_t	*newf;
 	edict_t		*ed;
-	int		exitdepth;
+	int		i, profile, startprofile;
+	int		*fusecount;
+#ifdef PR_COMPUTED_GOTO
+	static const void *const dispatch[OP_NUMDECODED] =
+	{
+		&&L_OP_DONE,
+		&&L_OP_MUL_F, &&L_OP_MUL_V, &&L_OP_MUL_FV, &&L_OP_MUL_VF,
+		&&L_OP_DIV_F,
+		&&L_OP_ADD_F, &&L_OP_ADD_V,
+		&&L_OP_SUB_F, &&L_OP_SUB_V,
+		&&L_OP_EQ_F, &&L_OP_EQ_V, &&L_OP_EQ_S, &&L_OP_EQ_E, &&L_OP_EQ_FNC,
+		&&L_OP_NE_F, &&L_OP_NE_V, &&L_OP_NE_S, &&L_OP_NE_E, &&L_OP_NE_FNC,
+		&&L_OP_LE, &&L_OP_GE, &&L_OP_LT, &&L_OP_GT,
+		&&L_OP_LOAD_F, &&L_OP_LOAD_V, &&L_OP_LOAD_S, &&L_OP_LOAD_ENT, &&L_OP_LOAD_FLD, &&L_OP_LOAD_FNC,
+		&&L_OP_ADDRESS,
+		&&L_OP_STORE_F, &&L_OP_STORE_V, &&L_OP_STORE_S, &&L_OP_STORE_ENT, &&L_OP_STORE_FLD, &&L_OP_STORE_FNC,
+		&&L_OP_STOREP_F, &&L_OP_STOREP_V, &&L_OP_STOREP_S, &&L_OP_STOREP_ENT, &&L_OP_STOREP_FLD, &&L_OP_STOREP_FNC,
+		&&L_OP_RETURN,
+		&&L_OP_NOT_F, &&L_OP_NOT_V, &&L_OP_NOT_S, &&L_OP_NOT_ENT, &&L_OP_NOT_FNC,
+		&&L_OP_IF, &&L_OP_IFNOT,
+		&&L_OP_CALL0, &&L_OP_CALL1, &&L_OP_CALL2, &&L_OP_CALL3, &&L_OP_CALL4,
+		&&L_OP_CALL5, &&L_OP_CALL6, &&L_OP_CALL7, &&L_OP_CALL8,
+		&&L_OP_STATE,
+		&&L_OP_GOTO,
+		&&L_OP_AND, &&L_OP_OR,
+		&&L_OP_BITAND, &&L_OP_BITOR,
+		&&L_OP_BADOP,
+		&&L_OP_LOAD_STORE, &&L_OP_LOAD_STORE_V,
+		&&L_OP_ADDRESS_STOREP, &&L_OP_ADDRESS_STOREP_V,
+		&&L_OP_LT_IFNOT, &&L_OP_GT_IFNOT, &&L_OP_LE_IFNOT, &&L_OP_GE_IFNOT,
+		&&L_OP_EQ_F_IFNOT, &&L_OP_NE_F_IFNOT, &&L_OP_EQ_E_IFNOT, &&L_OP_NE_E_IFNOT,
+		&&L_OP_STORE_CALL, &&L_OP_STORE_V_CALL
+	};
+#endif
+
+	st = &pr_code[s];
+	startprofile = profile = 0;
+	fusecount = pr_profile.value ? pr_fusecount : NULL;	// off the hot path unless asked for
 
-	if (!fnum || fnum >= progs->numfunctions)
+#ifdef PR_COMPUTED_GOTO
+	DISPATCH;
 	{
-		if (pr_global_struct->self)
-			ED_Print (PROG_TO_EDICT(pr_global_struct->self));
-		Host_Error ("PR_ExecuteProgram: NULL function");
+#else
+next:
+	if (++profile > PR_RUNAWAY)
+		goto runaway;
+	st++;	/* next statement */
+	switch (st->op)
+	{
+#endif
+	CASE(OP_ADD_F):
+		OPC->_float = OPA->_float + OPB->_float;
+		DISPATCH;
+	CASE(OP_ADD_V):
+		OPC->vector[0] = OPA->vector[0] + OPB->vector[0];
+		OPC->vector[1] = OPA->vector[1] + OPB->vector[1];
+		OPC->vector[2] = OPA->vector[2] + OPB->vector[2];
+		DISPATCH;
+
+	CASE(OP_SUB_F):
+		OPC->_float = OPA->_float - OPB->_float;
+		DISPATCH;
+	CASE(OP_SUB_V):
+		OPC->vector[0] = OPA->vector[0] - OPB->vector[0];
+		OPC->vector[1] = OPA->vector[1] - OPB->vector[1];
+		OPC->vector[2] = OPA->vector[2] - OPB->vector[2];
+		DISPATCH;
+
+	CASE(OP_MUL_F):
+		OPC->_float = OPA->_float * OPB->_float;
+		DISPATCH;
+	CASE(OP_MUL_V):
+		OPC->_float = OPA->vector[0] * OPB->vector[0] +
+			      OPA->vector[1] * OPB->vector[1] +
+			      OPA->vector[2] * OPB->vector[2];
+		DISPATCH;
+	CASE(OP_MUL_FV):
+		OPC->vector[0] = OPA->_float * OPB->vector[0];
+		OPC->vector[1] = OPA->_float * OPB->vector[1];
+		OPC->vector[2] = OPA->_float * OPB->vector[2];
+		DISPATCH;
+	CASE(OP_MUL_VF):
+		OPC->vector[0] = OPB->_float * OPA->vector[0];
+		OPC->vector[1] = OPB->_float * OPA->vector[1];
+		OPC->vector[2] = OPB->_float * OPA->vector[2];
+		DISPATCH;
+
+	CASE(OP_DIV_F):
+		OPC->_float = OPA->_float / OPB->_float;
+		DISPATCH;
+
+	CASE(OP_BITAND):
+		OPC->_float = (int)OPA->_float & (int)OPB->_float;
+		DISPATCH;
+
+	CASE(OP_BITOR):
+		OPC->_float = (int)OPA->_float | (int)OPB->_float;
+		DISPATCH;
+
+	CASE(OP_GE):
+		OPC->_float = OPA->_float >= OPB->_float;
+		DISPATCH;
+	CASE(OP_LE):
+		OPC->_float = OPA->_float <= OPB->_float;
+		DISPATCH;
+	CASE(OP_GT):
+		OPC->_float = OPA->_float > OPB->_float;
+		DISPATCH;
+	CASE(OP_LT):
+		OPC->_float = OPA->_float < OPB->_float;
+		DISPATCH;
+	CASE(OP_AND):
+		OPC->_float = OPA->_float && OPB->_float;
+		DISPATCH;
+	CASE(OP_OR):
+		OPC->_float = OPA->_float || OPB->_float;
+		DISPATCH;
+
+	CASE(OP_NOT_F):
+		OPC->_float = !OPA->_float;
+		DISPATCH;
+	CASE(OP_NOT_V):
+		OPC->_float = !OPA->vector[0] && !OPA->vector[1] && !OPA->vector[2];
+		DISPATCH;
+	CASE(OP_NOT_S):
+		OPC->_float = !OPA->string || !*PR_GetString(OPA->string);
+		DISPATCH;
+	CASE(OP_NOT_FNC):
+		OPC->_float = !OPA->function;
+		DISPATCH;
+	CASE(OP_NOT_ENT):
+		OPC->_float = (PROG_TO_EDICT(OPA->edict) == sv.edicts);
+		DISPATCH;
+
+	CASE(OP_EQ_F):
+		OPC->_float = OPA->_float == OPB->_float;
+		DISPATCH;
+	CASE(OP_EQ_V):
+		OPC->_float = (OPA->vector[0] == OPB->vector[0]) &&
+			      (OPA->vector[1] == OPB->vector[1]) &&
+			      (OPA->vector[2] == OPB->vector[2]);
+		DISPATCH;
+	CASE(OP_EQ_S):
+		OPC->_float = !strcmp(PR_GetString(OPA->string), PR_GetString(OPB->string));
+		DISPATCH;
+	CASE(OP_EQ_E):
+		OPC->_float = OPA->_int == OPB->_int;
+		DISPATCH;
+	CASE(OP_EQ_FNC):
+		OPC->_float = OPA->function == OPB->function;
+		DISPATCH;
+
+	CASE(OP_NE_F):
+		OPC->_float = OPA->_float != OPB->_float;
+		DISPATCH;
+	CASE(OP_NE_V):
+		OPC->_float = (OPA->vector[0] != OPB->vector[0]) ||
+			      (OPA->vector[1] != OPB->vector[1]) ||
+			      (OPA->vector[2] != OPB->vector[2]);
+		DISPATCH;
+	CASE(OP_NE_S):
+		OPC->_float = strcmp(PR_GetString(OPA->string), PR_GetString(OPB->string));
+		DISPATCH;
+	CASE(OP_NE_E):
+		OPC->_float = OPA->_int != OPB->_int;
+		DISPATCH;
+	CASE(OP_NE_FNC):
+		OPC->_float = OPA->function != OPB->function;
+		DISPATCH;
+
+	CASE(OP_STORE_F):
+	CASE(OP_STORE_ENT):
+	CASE(OP_STORE_FLD):	// integers
+	CASE(OP_STORE_S):
+	CASE(OP_STORE_FNC):	// pointers
+		OPB->_int = OPA->_int;
+		DISPATCH;
+	CASE(OP_STORE_V):
+		OPB->vector[0] = OPA->vector[0];
+		OPB->vector[1] = OPA->vector[1];
+		OPB->vector[2] = OPA->vector[2];
+		DISPATCH;
+
+	CASE(OP_STOREP_F):
+	CASE(OP_STOREP_ENT):
+	CASE(OP_STOREP_FLD):	// integers
+	CASE(OP_STOREP_S):
+	CASE(OP_STOREP_FNC):	// pointers
+		ptr = (eval_t *)((byte *)sv.edicts + OPB->_int);
+		ptr->_int = OPA->_int;
+		DISPATCH;
+	CASE(OP_STOREP_V):
+		ptr = (eval_t *)((byte *)sv.edicts + OPB->_int);
+		ptr->vector[0] = OPA->vector[0];
+		ptr->vector[1] = OPA->vector[1];
+		ptr->vector[2] = OPA->vector[2];
+		DISPATCH;
+
+	CASE(OP_ADDRESS):
+		ed = PROG_TO_EDICT(OPA->edict);
+		if (ed == (edict_t *)sv.edicts && sv.state == ss_active)
+		{
+			pr_xstatement = st - pr_code;
+			PR_RunError("assignment to world entity");
+		}
+		SV_WakeEdict (OPA->edict / pr_edict_size);
+		OPC->_int = (byte *)ED_Field (ed, OPB->_int) - (byte *)sv.edicts;
+		DISPATCH;
+
+	CASE(OP_LOAD_F):
+	CASE(OP_LOAD_FLD):
+	CASE(OP_LOAD_ENT):
+	CASE(OP_LOAD_S):
+	CASE(OP_LOAD_FNC):
+		ed = PROG_TO_EDICT(OPA->edict);
+		OPC->_int = ((eval_t *)ED_Field (ed, OPB->_int))->_int;
+		DISPATCH;
+
+	CASE(OP_LOAD_V):
+		ed = PROG_TO_EDICT(OPA->edict);
+		ptr = (eval_t *)ED_Field (ed, OPB->_int);
+		OPC->vector[0] = ptr->vector[0];
+		OPC->vector[1] = ptr->vector[1];
+		OPC->vector[2] = ptr->vector[2];
+		DISPATCH;
+
+	CASE(OP_IFNOT):
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+
+	CASE(OP_IF):
+		if (OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+
+	CASE(OP_GOTO):
+		JUMP(st->jump);
+		DISPATCH;
+
+	CASE(OP_CALL0):
+	CASE(OP_CALL1):
+	CASE(OP_CALL2):
+	CASE(OP_CALL3):
+	CASE(OP_CALL4):
+	CASE(OP_CALL5):
+	CASE(OP_CALL6):
+	CASE(OP_CALL7):
+	CASE(OP_CALL8):
+	call:
+		pr_xfunction->profile += profile - startprofile;
+		startprofile = profile;
+		pr_xstatement = st - pr_code;
+		pr_argc = st->op - OP_CALL0;
+		if (!OPA->function)
+			PR_RunError("NULL function");
+		newf = &pr_functions[OPA->function];
+		if (newf->first_statement < 0)
+		{ // Built-in function
+			i = -newf->first_statement;
+			if (i >= pr_numbuiltins)
+				PR_RunError("Bad builtin call number %d", i);
+			pr_builtins[i]();
+			if (PR_SLOWPATH)	// traceon
+				return st - pr_code;
+			DISPATCH;
+		}
+		if (pr_native && pr_native[OPA->function])
+		{ // Translated function
+			i = OPA->function;
+			PR_EnterFunction(newf);
+			pr_native[i]();
+			PR_LeaveFunction();
+			if (PR_SLOWPATH)
+				return st - pr_code;
+			DISPATCH;
+		}
+		// Normal function
+		st = &pr_code[PR_EnterFunction(newf)];
+		DISPATCH;
+
+	CASE(OP_DONE):
+	CASE(OP_RETURN):
+		pr_xfunction->profile += profile - startprofile;
+		startprofile = profile;
+		pr_xstatement = st - pr_code;
+		((int *)pr_globals)[OFS_RETURN] = OPA[0]._int;
+		((int *)pr_globals)[OFS_RETURN + 1] = OPA[1]._int;
+		((int *)pr_globals)[OFS_RETURN + 2] = OPA[2]._int;
+		st = &pr_code[PR_LeaveFunction()];
+		if (pr_depth == exitdepth)
+		{ // Done
+			return -1;
+		}
+		DISPATCH;
+
+	CASE(OP_STATE):
+		ed = PROG_TO_EDICT(pr_global_struct->self);
+		SV_WakeEdict (pr_global_struct->self / pr_edict_size);
+		ed->hot->nextthink = pr_global_struct->time + 0.1;
+		ed->v.frame = OPA->_float;
+		ed->v.think = OPB->function;
+		DISPATCH;
+
+	// superinstructions. each does the first statement, steps onto the
+	// second and does that with what the first one left behind
+	CASE(OP_LOAD_STORE):
+		FUSED(OP_LOAD_STORE);
+		ed = PROG_TO_EDICT(OPA->edict);
+		OPC->_int = ((eval_t *)ED_Field (ed, OPB->_int))->_int;
+		st++;
+		OPB->_int = OPA->_int;
+		DISPATCH;
+	CASE(OP_LOAD_STORE_V):
+		FUSED(OP_LOAD_STORE_V);
+		ed = PROG_TO_EDICT(OPA->edict);
+		ptr = (eval_t *)ED_Field (ed, OPB->_int);
+		OPC->vector[0] = ptr->vector[0];
+		OPC->vector[1] = ptr->vector[1];
+		OPC->vector[2] = ptr->vector[2];
+		st++;
+		OPB->vector[0] = OPA->vector[0];
+		OPB->vector[1] = OPA->vector[1];
+		OPB->vector[2] = OPA->vector[2];
+		DISPATCH;
+
+	CASE(OP_ADDRESS_STOREP):
+		FUSED(OP_ADDRESS_STOREP);
+		ed = PROG_TO_EDICT(OPA->edict);
+		if (ed == (edict_t *)sv.edicts && sv.state == ss_active)
+		{
+			pr_xstatement = st - pr_code;
+			PR_RunError("assignment to world entity");
+		}
+		SV_WakeEdict (OPA->edict / pr_edict_size);
+		OPC->_int = (byte *)ED_Field (ed, OPB->_int) - (byte *)sv.edicts;
+		st++;
+		ptr = (eval_t *)((byte *)sv.edicts + OPB->_int);
+		ptr->_int = OPA->_int;
+		DISPATCH;
+	CASE(OP_ADDRESS_STOREP_V):
+		FUSED(OP_ADDRESS_STOREP_V);
+		ed = PROG_TO_EDICT(OPA->edict);
+		if (ed == (edict_t *)sv.edicts && sv.state == ss_active)
+		{
+			pr_xstatement = st - pr_code;
+			PR_RunError("assignment to world entity");
+		}
+		SV_WakeEdict (OPA->edict / pr_edict_size);
+		OPC->_int = (byte *)ED_Field (ed, OPB->_int) - (byte *)sv.edicts;
+		st++;
+		ptr = (eval_t *)((byte *)sv.edicts + OPB->_int);
+		ptr->vector[0] = OPA->vector[0];
+		ptr->vector[1] = OPA->vector[1];
+		ptr->vector[2] = OPA->vector[2];
+		DISPATCH;
+
+	CASE(OP_LT_IFNOT):
+		FUSED(OP_LT_IFNOT);
+		OPC->_float = OPA->_float < OPB->_float;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+	CASE(OP_GT_IFNOT):
+		FUSED(OP_GT_IFNOT);
+		OPC->_float = OPA->_float > OPB->_float;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+	CASE(OP_LE_IFNOT):
+		FUSED(OP_LE_IFNOT);
+		OPC->_float = OPA->_float <= OPB->_float;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+	CASE(OP_GE_IFNOT):
+		FUSED(OP_GE_IFNOT);
+		OPC->_float = OPA->_float >= OPB->_float;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+	CASE(OP_EQ_F_IFNOT):
+		FUSED(OP_EQ_F_IFNOT);
+		OPC->_float = OPA->_float == OPB->_float;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+	CASE(OP_NE_F_IFNOT):
+		FUSED(OP_NE_F_IFNOT);
+		OPC->_float = OPA->_float != OPB->_float;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+	CASE(OP_EQ_E_IFNOT):
+		FUSED(OP_EQ_E_IFNOT);
+		OPC->_float = OPA->_int == OPB->_int;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+	CASE(OP_NE_E_IFNOT):
+		FUSED(OP_NE_E_IFNOT);
+		OPC->_float = OPA->_int != OPB->_int;
+		st++;
+		if (!OPA->_int)
+			JUMP(st->jump);
+		DISPATCH;
+
+	CASE(OP_STORE_CALL):
+		FUSED(OP_STORE_CALL);
+		OPB->_int = OPA->_int;
+		st++;
+		goto call;
+	CASE(OP_STORE_V_CALL):
+		FUSED(OP_STORE_V_CALL);
+		OPB->vector[0] = OPA->vector[0];
+		OPB->vector[1] = OPA->vector[1];
+		OPB->vector[2] = OPA->vector[2];
+		st++;
+		goto call;
+
+	CASE(OP_BADOP):
+#ifndef PR_COMPUTED_GOTO
+	default:
+#endif
+		pr_xstatement = st - pr_code;
+		PR_RunError("Bad opcode %i", pr_statements[pr_xstatement].op);
 	}
 
-	f = &pr_functions[fnum];
+runaway:
+	pr_xstatement = st + 1 - pr_code;
+	PR_RunError("runaway loop error");
+	return -1;	// not reached
+}
+#undef JUMP
+#undef FUSED
+#undef DISPATCH
+#undef CASE
+#undef OPA
+#undef OPB
+#undef OPC
 
-	pr_trace = false;
 
-// make a stack frame
-	exitdepth = pr_depth;
+/*
+====================
+PR_ExecuteSlow
 
-	st = &pr_statements[PR_EnterFunction(f)];
+The original loop over pr_statements, used while tracing and by pr_bench.
+Returns like PR_ExecuteFast, once neither wants it any more.
+====================
+*/
+#define OPA ((eval_t *)&pr_globals[(unsigned short)st->a])
+#define OPB ((eval_t *)&pr_globals[(unsigned short)st->b])
+#define OPC ((eval_t *)&pr_globals[(unsigned short)st->c])
+
+static int PR_ExecuteSlow (int s, int exitdepth)
+{
+	eval_t		*ptr;
+	dstatement_t	*st;
+	dfunction_t	*newf;
+	int profile, startprofile;
+	edict_t		*ed;
+
+	st = &pr_statements[s];
 	startprofile = profile = 0;
 
     while (1)
     {
 	st++;	/* next statement */
 
-	if (++profile > 0x1000000) /* was 100000 */
+	if (++profile > PR_RUNAWAY)
 	{
 		pr_xstatement = st - pr_statements;
 		PR_RunError("runaway loop error");
@@ -549,7 +1453,8 @@ void PR_ExecuteProgram (func_t fnum)
 			pr_xstatement = st - pr_statements;
 			PR_RunError("assignment to world entity");
 		}
-		OPC->_int = (byte *)((int *)&ed->v + OPB->_int) - (byte *)sv.edicts;
+		SV_WakeEdict (OPA->edict / pr_edict_size);
+		OPC->_int = (byte *)ED_Field (ed, OPB->_int) - (byte *)sv.edicts;
 		break;
 
 	case OP_LOAD_F:
@@ -558,12 +1463,12 @@ void PR_ExecuteProgram (func_t fnum)
 	case OP_LOAD_S:
 	case OP_LOAD_FNC:
 		ed = PROG_TO_EDICT(OPA->edict);
-		OPC->_int = ((eval_t *)((int *)&ed->v + OPB->_int))->_int;
+		OPC->_int = ((eval_t *)ED_Field (ed, OPB->_int))->_int;
 		break;
 
 	case OP_LOAD_V:
 		ed = PROG_TO_EDICT(OPA->edict);
-		ptr = (eval_t *)((int *)&ed->v + OPB->_int);
+		ptr = (eval_t *)ED_Field (ed, OPB->_int);
 		OPC->vector[0] = ptr->vector[0];
 		OPC->vector[1] = ptr->vector[1];
 		OPC->vector[2] = ptr->vector[2];
@@ -605,6 +1510,8 @@ void PR_ExecuteProgram (func_t fnum)
 			if (i >= pr_numbuiltins)
 				PR_RunError("Bad builtin call number %d", i);
 			pr_builtins[i]();
+			if (!PR_SLOWPATH)	// traceoff
+				return st - pr_statements;
 			break;
 		}
 		// Normal function
@@ -622,13 +1529,14 @@ void PR_ExecuteProgram (func_t fnum)
 		st = &pr_statements[PR_LeaveFunction()];
 		if (pr_depth == exitdepth)
 		{ // Done
-			return;
+			return -1;
 		}
 		break;
 
 	case OP_STATE:
 		ed = PROG_TO_EDICT(pr_global_struct->self);
-		ed->v.nextthink = pr_global_struct->time + 0.1;
+		SV_WakeEdict (pr_global_struct->self / pr_edict_size);
+		ed->hot->nextthink = pr_global_struct->time + 0.1;
 		ed->v.frame = OPA->_float;
 		ed->v.think = OPB->function;
 		break;
@@ -642,3 +1550,320 @@ void PR_ExecuteProgram (func_t fnum)
 #undef OPA
 #undef OPB
 #undef OPC
+
+
+/*
+====================
+PR_ExecuteProgram
+====================
+*/
+void PR_ExecuteProgram (func_t fnum)
+{
+	dfunction_t	*f;
+	int		s, exitdepth;
+
+	if (!fnum || fnum >= progs->numfunctions)
+	{
+		if (pr_global_struct->self)
+			ED_Print (PROG_TO_EDICT(pr_global_struct->self));
+		Host_Error ("PR_ExecuteProgram: NULL function");
+	}
+
+	f = &pr_functions[fnum];
+
+	pr_trace = false;
+
+	if (pr_fusetime >= 0 && !pr_depth)
+		PR_FuseCheck ();
+
+// make a stack frame
+	exitdepth = pr_depth;
+
+	s = PR_EnterFunction(f);
+	if (pr_native && pr_native[fnum] && !PR_SLOWPATH)
+	{
+		pr_native[fnum]();
+		PR_LeaveFunction();
+		return;
+	}
+	do
+	{
+		if (PR_SLOWPATH)
+			s = PR_ExecuteSlow (s, exitdepth);
+		else
+			s = PR_ExecuteFast (s, exitdepth);
+	} while (s >= 0);
+}
+
+
+/*
+====================
+PR_LinkNativeProgs
+
+Picks up the translation of progs.dat built into the engine, if it was made
+from exactly the progs.dat that was just loaded.
+====================
+*/
+void PR_LinkNativeProgs (void)
+{
+#ifdef USE_NATIVE_PROGS
+	int		i, count;
+#endif
+
+	pr_native = NULL;
+
+#ifdef USE_NATIVE_PROGS
+	if (!pr_nativecode.value)
+		return;
+
+	if (pr_nativeprogs.crc != pr_crc ||
+		pr_nativeprogs.numstatements != progs->numstatements ||
+		pr_nativeprogs.numfunctions != progs->numfunctions)
+	{
+		Con_DPrintf ("progs.dat doesn't match the built in native code\n");
+		return;
+	}
+
+	pr_native = pr_nativeprogs.functions;
+
+	for (i = count = 0; i < progs->numfunctions; i++)
+	{
+		if (pr_native[i])
+			count++;
+	}
+	Con_DPrintf ("%i of %i functions run as native code.\n", count, progs->numfunctions);
+#endif
+}
+
+/*
+====================
+PR_NativeCall
+
+OP_CALL for translated functions. The callee is run by whichever of the
+translation, a builtin or the interpreter has it.
+====================
+*/
+void PR_NativeCall (int statement, int argc, func_t fnum)
+{
+	dfunction_t	*newf;
+	int		i, s, exitdepth;
+
+	pr_xstatement = statement;
+	pr_argc = argc;
+	if (!fnum)
+		PR_RunError("NULL function");
+	newf = &pr_functions[fnum];
+	if (newf->first_statement < 0)
+	{ // Built-in function
+		i = -newf->first_statement;
+		if (i >= pr_numbuiltins)
+			PR_RunError("Bad builtin call number %d", i);
+		pr_builtins[i]();
+		return;
+	}
+
+	exitdepth = pr_depth;
+	s = PR_EnterFunction(newf);
+	if (pr_native && pr_native[fnum] && !PR_SLOWPATH)
+	{
+		pr_native[fnum]();
+		PR_LeaveFunction();
+		return;
+	}
+	do
+	{
+		if (PR_SLOWPATH)
+			s = PR_ExecuteSlow (s, exitdepth);
+		else
+			s = PR_ExecuteFast (s, exitdepth);
+	} while (s >= 0);
+}
+
+/*
+====================
+PR_NativeAddress
+
+OP_ADDRESS for translated functions
+====================
+*/
+int PR_NativeAddress (int statement, int edict, int ofs)
+{
+	edict_t		*ed;
+
+	ed = PROG_TO_EDICT(edict);
+	if (ed == (edict_t *)sv.edicts && sv.state == ss_active)
+	{
+		pr_xstatement = statement;
+		PR_RunError("assignment to world entity");
+	}
+	SV_WakeEdict (edict / pr_edict_size);
+	return (byte *)ED_Field (ed, ofs) - (byte *)sv.edicts;
+}
+
+/*
+====================
+PR_NativeRunaway
+====================
+*/
+void PR_NativeRunaway (int statement)
+{
+	pr_xstatement = statement;
+	PR_RunError("runaway loop error");
+}
+
+
+/*
+============
+PR_Bench_f
+
+Runs the think function of every monster on the level a number of times,
+first through the slow loop, then through the fast one and then as native
+code if there is any, putting the edicts, globals and server messages back
+the way they were after each pass. That can't undo everything the thinks do
+(strings they allocate, the random numbers they take), so it is a developer
+tool for a local single player game, not something to run on a real server.
+============
+*/
+void PR_Bench_f (void)
+{
+	edict_t		*ent;
+	byte		*edicts;
+	edicthot_t	*edicthot;
+	int		*globals, *messages;
+	sizebuf_t	*signon;
+	const prnative_t	*native;
+	int		num_edicts, num_signon, signonsize, datagramsize, reliablesize;
+	int		lastcheck;
+	double		lastchecktime;
+	int		passes, pass, mode, modes, i, statements, monsters;
+	double		time1, elapsed[3];
+	static const char *modenames[3] = {"slow loop", "fast loop", "native code"};
+
+	if (!sv.active || sv.state != ss_active)
+	{
+		Con_Printf ("pr_bench: no map running\n");
+		return;
+	}
+
+	if (!developer.value || svs.maxclients > 1)
+	{
+		Con_Printf ("pr_bench: only for single player with developer 1, it disturbs the game\n");
+		return;
+	}
+
+	passes = (Cmd_Argc () > 1) ? q_max (1, atoi (Cmd_Argv (1))) : 10;
+
+	num_edicts = sv.num_edicts;
+	num_signon = sv.num_signon_buffers;
+	signon = sv.signon;
+	signonsize = signon->cursize;
+	datagramsize = sv.datagram.cursize;
+	reliablesize = sv.reliable_datagram.cursize;
+	lastcheck = sv.lastcheck;
+	lastchecktime = sv.lastchecktime;
+
+	edicts = (byte *) malloc (num_edicts * pr_edict_size);
+	edicthot = (edicthot_t *) malloc (num_edicts * sizeof(edicthot_t));
+	globals = (int *) malloc (progs->numglobals * sizeof(int));
+	messages = (int *) malloc (svs.maxclients * sizeof(int));
+	if (!edicts || !edicthot || !globals || !messages)
+		Sys_Error ("PR_Bench_f: out of memory");
+
+	memcpy (edicts, sv.edicts, num_edicts * pr_edict_size);
+	memcpy (edicthot, sv.edicthot, num_edicts * sizeof(edicthot_t));
+	memcpy (globals, pr_globals, progs->numglobals * sizeof(int));
+	for (i = 0; i < svs.maxclients; i++)
+		messages[i] = svs.clients[i].message.cursize;
+
+	statements = 0;
+	for (i = 0; i < progs->numfunctions; i++)
+		statements -= pr_functions[i].profile;
+
+	native = pr_native;
+	modes = native ? 3 : 2;
+
+	monsters = 0;
+	for (mode = 0; mode < modes; mode++)
+	{
+		pr_benchslow = (mode == 0);	// native code doesn't count statements
+		pr_native = (mode == 2) ? native : NULL;
+
+		time1 = Sys_DoubleTime ();
+		for (pass = 0; pass < passes; pass++)
+		{
+			srand (0x5eed);	// same random numbers every pass
+
+			monsters = 0;
+			for (i = 1; i < num_edicts; i++)
+			{
+				ent = EDICT_NUM(i);
+				if (ent->hot->free || !((int)ent->hot->flags & FL_MONSTER) || !ent->v.think)
+					continue;
+
+				pr_global_struct->time = sv.time;
+				pr_global_struct->self = EDICT_TO_PROG(ent);
+				pr_global_struct->other = EDICT_TO_PROG(sv.edicts);
+				PR_ExecuteProgram (ent->v.think);
+				monsters++;
+			}
+
+			// put the level back for the next pass
+			memcpy (sv.edicts, edicts, num_edicts * pr_edict_size);
+			memcpy (sv.edicthot, edicthot, num_edicts * sizeof(edicthot_t));
+			memcpy (pr_globals, globals, progs->numglobals * sizeof(int));
+			sv.num_edicts = num_edicts;
+			while (sv.num_signon_buffers > num_signon)
+				free (sv.signon_buffers[--sv.num_signon_buffers]);
+			sv.signon = signon;
+			sv.signon->cursize = signonsize;
+			sv.datagram.cursize = datagramsize;
+			sv.reliable_datagram.cursize = reliablesize;
+			sv.lastcheck = lastcheck;
+			sv.lastchecktime = lastchecktime;
+			for (i = 0; i < svs.maxclients; i++)
+				svs.clients[i].message.cursize = messages[i];
+
+			// the saved links point into the old tree, so build it again
+			for (i = 0; i < sv.max_edicts; i++)
+			{
+				ent = EDICT_NUM(i);
+				ent->area.prev = ent->area.next = NULL;
+			}
+			SV_ClearWorld ();
+			for (i = 1; i < num_edicts; i++)
+			{
+				ent = EDICT_NUM(i);
+				if (!ent->hot->free)
+					SV_LinkEdict (ent, false);
+			}
+		}
+		elapsed[mode] = Sys_DoubleTime () - time1;
+
+		if (mode == 0)
+		{
+			for (i = 0; i < progs->numfunctions; i++)
+				statements += pr_functions[i].profile;
+		}
+	}
+	pr_benchslow = false;
+	pr_native = native;
+
+	// let physics look at everything again rather than trust the wake bits
+	SV_WakeAllEdicts ();
+
+	free (messages);
+	free (globals);
+	free (edicthot);
+	free (edicts);
+
+	if (!monsters)
+	{
+		Con_Printf ("pr_bench: no monsters on this level\n");
+		return;
+	}
+
+	Con_Printf ("%i monster thinks x %i passes, %i statements\n", monsters, passes, statements);
+	for (mode = 0; mode < modes; mode++)
+		Con_Printf ("%s: %.3f ms, %.1f M statements/sec\n", modenames[mode], elapsed[mode] * 1000.0,
+					statements / q_max (elapsed[mode], 1e-6) / 1e6);
+}
@@ -37,15 +37,46 @@ typedef union eval_s
 } eval_t;
 
 #define	MAX_ENT_LEAFS	32
-typedef struct edict_s
+/* the bsp leafs and the baseline are kept in sv.edictleafs and sv.baselines,
+   indexed by edict number, so the edicts themselves stay small. */
+typedef struct
 {
-	qboolean	free;
-	link_t		area;			/* linked to a division node or leaf */
+	int		ofs;			/* byte offset of four bytes of the pvs row */
+	unsigned int	mask;			/* the leafs' bits in them */
+} pvsword_t;
 
+typedef struct
+{
 	int		num_leafs;
-	int		leafnums[MAX_ENT_LEAFS];
+	int		num_pvswords;		/* when set, the leafs are kept as words of the pvs */
+	union
+	{
+		int		leafnums[MAX_ENT_LEAFS];
+		pvsword_t	pvswords[MAX_ENT_LEAFS/2];
+	} u;
+} edictleafs_t;
+
+/* the fields SV_Physics and the visibility sweep read of every edict are kept
+   in sv.edicthot, indexed by edict number, so walking them is cache-linear.
+   all but free are QuakeC fields: their slots in entvars_t go unused, and
+   progs reach them here through ED_Field. */
+typedef struct
+{
+	float		movetype;
+	float		solid;
+	float		flags;
+	float		nextthink;
+	vec3_t		origin;
+	vec3_t		velocity;
+	qboolean	free;			/* after the QuakeC fields, see ED_ClearFields */
+} edicthot_t;
+
+typedef struct edict_s
+{
+	edicthot_t	*hot;			/* sv.edicthot[NUM_FOR_EDICT(this)] */
+	link_t		area;			/* linked to a division node or leaf */
+	struct areanode_s	*areanode;	/* the node area is linked into */
 
-	entity_state_t	baseline;
 	unsigned char	alpha;			/* johnfitz -- hack to support alpha since it's not part of entvars_t */
 	unsigned char	scale;			/* Quakespasm: added for model scale support. */
 	qboolean	sendinterval;		/* johnfitz -- send time until nextthink to client for better lerp timing */
@@ -75,14 +106,36 @@ void PR_Init (void);
 
 void PR_ExecuteProgram (func_t fnum);
 void PR_LoadProgs (void);
+void PR_DecodeProgs (void);
+
+// progs.dat translated to C by qc2c.py, see PR_LinkNativeProgs
+typedef void (*prnative_t) (void);
+
+typedef struct
+{
+	unsigned short	crc;		// of the whole file, as pr_crc
+	int		numstatements;
+	int		numfunctions;
+	const prnative_t	*functions;	// NULL for builtins and anything left to the interpreter
+} prnativeprogs_t;
+
+void PR_LinkNativeProgs (void);
+void PR_NativeCall (int statement, int argc, func_t fnum);
+int PR_NativeAddress (int statement, int edict, int ofs);
+FUNC_NORETURN void PR_NativeRunaway (int statement);
 
 const char *PR_GetString (int num);
 int PR_SetEngineString (const char *s);
 int PR_AllocString (int bufferlength, char **ptr);
+void PR_ReclaimStrings (void);
 
 void PR_Profile_f (void);
+void PR_Bench_f (void);
+void PR_Fuse_f (void);
 
 edict_t *ED_Alloc (void);
+void ED_ZeroEdict (int num);
+void ED_ClearFields (edict_t *e);
 void ED_Free (edict_t *ed);
 
 void ED_Print (edict_t *ed);
@@ -114,10 +167,22 @@ int NUM_FOR_EDICT(edict_t*);
 #define	G_STRING(o)		(PR_GetString(*(string_t *)&pr_globals[o]))
 #define	G_FUNCTION(o)		(*(func_t *)&pr_globals[o])
 
-#define	E_FLOAT(e,o)		(((float*)&e->v)[o])
-#define	E_INT(e,o)		(*(int *)&((float*)&e->v)[o])
-#define	E_VECTOR(e,o)		(&((float*)&e->v)[o])
-#define	E_STRING(e,o)		(PR_GetString(*(string_t *)&((float*)&e->v)[o]))
+/* each int of entvars_t's int in edicthot_t, or -1 if it's kept in the edict */
+#define	ENTVARS_INTS		((int)(sizeof(entvars_t) / 4))
+extern	signed char	pr_hotfields[ENTVARS_INTS];
+
+/* where the field at offset ofs of an edict is kept */
+static inline int *ED_Field (edict_t *ed, int ofs)
+{
+	if ((unsigned int)ofs < ENTVARS_INTS && pr_hotfields[ofs] >= 0)
+		return (int *)ed->hot + pr_hotfields[ofs];
+	return (int *)&ed->v + ofs;
+}
+
+#define	E_FLOAT(e,o)		(*(float *)ED_Field(e,o))
+#define	E_INT(e,o)		(*ED_Field(e,o))
+#define	E_VECTOR(e,o)		((float *)ED_Field(e,o))
+#define	E_STRING(e,o)		(PR_GetString(*(string_t *)ED_Field(e,o)))
 
 extern	int		type_size[8];
 
@@ -135,6 +200,8 @@ typedef struct {
 extern	int		pr_argc;
 
 extern	qboolean	pr_trace;
+extern	cvar_t		pr_profile;
+extern	cvar_t		pr_nativecode;
 extern	dfunction_t	*pr_xfunction;
 extern	int		pr_xstatement;
 
@@ -149,5 +216,20 @@ void ED_PrintEdicts (void);
 void ED_PrintNum (int ent);
 
 eval_t *GetEdictFieldValue(edict_t *ed, const char *field);
+int ED_FindFieldOffset (const char *field);
+
+// the value of a field from ED_FindFieldOffset, NULL if there is no such field
+#define	GetEdictFieldOfs(ed,ofs)	((ofs) < 0 ? NULL : (eval_t *)ED_Field(ed,ofs))
+
+// optional fields the engine reads, looked up when the progs are loaded
+typedef struct
+{
+	int		alpha;
+	int		scale;
+	int		items2;
+	int		gravity;
+} prfields_t;
+
+extern	prfields_t	pr_extfields;
 
 #endif	/* QUAKE_PROGS_H */
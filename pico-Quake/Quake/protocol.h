@@ -29,6 +29,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define PROTOCOL_FITZQUAKE	666 //johnfitz -- added new protocol for fitzquake 0.85
 #define PROTOCOL_RMQ		999
 
+// the biggest messages a PROTOCOL_NETQUAKE server sends, which are what the
+// original engine could take. the others go up to MAX_MSGLEN and MAX_DATAGRAM.
+#define	NETQUAKE_MSGLEN		8000
+#define	NETQUAKE_DATAGRAM	1024
+#define	PROTOCOL_MSGLEN(p)		((p) == PROTOCOL_NETQUAKE ? NETQUAKE_MSGLEN : MAX_MSGLEN)
+#define	PROTOCOL_DATAGRAM(p)	((p) == PROTOCOL_NETQUAKE ? NETQUAKE_DATAGRAM : MAX_DATAGRAM)
+
 // PROTOCOL_RMQ protocol flags
 #define PRFL_SHORTANGLE		(1 << 1)
 #define PRFL_FLOATANGLE		(1 << 2)
@@ -37,6 +44,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define PRFL_EDICTSCALE		(1 << 5)
 #define PRFL_ALPHASANITY	(1 << 6)	// cleanup insanity with alpha
 #define PRFL_INT32COORD		(1 << 7)
+#define PRFL_DELTAENTS		(1 << 8)	// clients that ack them get svc_deltaentities
 #define PRFL_MOREFLAGS		(1 << 31)	// not supported
 
 // if the high bit of the servercmd is set, the low bits are fast update flags:
@@ -62,7 +70,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define U_ALPHA			(1<<16) // 1 byte, uses ENTALPHA_ENCODE, not sent if equal to baseline
 #define U_FRAME2		(1<<17) // 1 byte, this is .frame & 0xFF00 (second byte)
 #define U_MODEL2		(1<<18) // 1 byte, this is .modelindex & 0xFF00 (second byte)
-#define U_LERPFINISH	(1<<19) // 1 byte, 0.0-1.0 maps to 0-255, not sent if exactly 0.1, this is ent->v.nextthink - sv.time, used for lerping
+#define U_LERPFINISH	(1<<19) // 1 byte, 0.0-1.0 maps to 0-255, not sent if exactly 0.1, this is ent->hot->nextthink - sv.time, used for lerping
 #define U_SCALE			(1<<20) // 1 byte, for PROTOCOL_RMQ PRFL_EDICTSCALE
 #define U_UNUSED21		(1<<21)
 #define U_UNUSED22		(1<<22)
@@ -223,6 +231,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define svc_backtolobby		55
 #define svc_localsound		56
 
+// never goes over a network or into a demo, see localsnapshot_t
+#define	svc_localsnapshot	100	// [long] sequence
+
+// PRFL_DELTAENTS -- the entities as changed since a snapshot the client acked
+#define	svc_deltaentities	101	// [long] sequence [long] base sequence, 0 for none
+								// [short] removed entity... [short] 0
+								// [entity update from the base or baseline]... [byte] 0
+
 //
 // client to server
 //
@@ -231,6 +247,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define	clc_disconnect	2
 #define	clc_move		3		// [usercmd_t]
 #define	clc_stringcmd	4		// [string] message
+#define	clc_deltaack	5		// [long] the last svc_deltaentities sequence received
 
 //
 // temp entity events
@@ -266,6 +283,16 @@ typedef struct
 	int		effects;
 } entity_state_t;
 
+// one entity in a datagram, as the U_ bits would send it
+typedef struct entityupdate_s
+{
+	int			num;
+	int			bits;
+	int			modelindex, frame;
+	byte		colormap, skin, effects, alpha, scale, lerpfinish;
+	vec3_t		origin, angles;
+} entityupdate_t;
+
 typedef struct
 {
 	vec3_t	viewangles;
@@ -249,6 +249,7 @@ typedef struct
 #include "menu.h"
 #include "cdaudio.h"
 #include "glquake.h"
+#include "framebuffer.h"
 
 
 //=============================================================================
@@ -296,12 +297,28 @@ void Host_Callback_Notify (cvar_t *var);	/* callback function for CVAR_NOTIFY */
 FUNC_NORETURN void Host_Error (const char *error, ...) FUNC_PRINTF(1,2);
 FUNC_NORETURN void Host_EndGame (const char *message, ...) FUNC_PRINTF(1,2);
 void Host_Frame (float time);
+double Host_WaitForTick (double lasttime);
 void Host_Quit_f (void);
 void Host_ClientCommands (const char *fmt, ...) FUNC_PRINTF(1,2);
 void Host_ShutdownServer (qboolean crash);
 void Host_WriteConfiguration (void);
 void Host_Resetdemos (void);
 
+// host_pipe.c
+extern	cvar_t		host_pipeline;
+void Host_InitPipeline (void);
+void Host_ShutdownPipeline (void);
+qboolean Host_PipelineFrame (void);
+qboolean Host_PipelineThread (void);
+void Host_StartServerFrame (void);
+void Host_FinishServerFrame (void);
+void Host_PipelinePrint (const char *msg);
+void Host_PipelineCommand (const char *text);
+void Host_PipelineSetCvar (cvar_t *var, const char *value);
+const char *Host_PipelineCvar (cvar_t *var);
+FUNC_NORETURN void Host_PipelineError (const char *error);
+void Host_PipelineSpeeds (int *sim, int *stall);
+
 void ExtraMaps_Init (void);
 void Modlist_Init (void);
 void DemoList_Init (void);
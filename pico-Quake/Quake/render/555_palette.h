@@ -1,11 +1,12 @@
 //Generated with the "color_modes.py" script
-#ifndef 555_PALETTE_H
-#define 555_PALETTE_H
+#ifndef PALETTE_555_H
+#define PALETTE_555_H
 
 #include <stdint.h>
 
-uint16_t[256] *palette = 0x20041000; // Start of SRAM 5
+typedef uint16_t palette_t;
+
 //Conversion (or not) of the original Quake palette to the indicated color bit mode
-palette* = [0x0, 0x842, 0x1084, 0x18c6, 0x2108, 0x2529, 0x2d6b, 0x35ad, 0x3def, 0x4631, 0x4e73, 0x56b5, 0x5ef7, 0x6739, 0x6f7b, 0x77bd, 0x821, 0xc41, 0x1061, 0x1462, 0x1882, 0x1ca3, 0x20c3, 0x24e3, 0x28e3, 0x2d04, 0x3124, 0x3544, 0x3964, 0x3d84, 0x41a4, 0x45a4, 0x422, 0x843, 0xc65, 0x14a6, 0x18c8, 0x1ce9, 0x210b, 0x252d, 0x294e, 0x2d6f, 0x3191, 0x35b2, 0x39d4, 0x3df5, 0x4217, 0x4639, 0x0, 0x420, 0x420, 0x840, 0xc60, 0x1080, 0x14a1, 0x18c1, 0x1ce1, 0x2101, 0x2521, 0x2521, 0x2941, 0x2d61, 0x3181, 0x35a2, 0x400, 0x800, 0xc00, 0x1000, 0x1400, 0x1800, 0x1c00, 0x2000, 0x2400, 0x2800, 0x2c00, 0x3000, 0x3400, 0x3400, 0x3800, 0x3c00, 0x840, 0xc60, 0x1080, 0x18a0, 0x1cc0, 0x20e0, 0x24e1, 0x2d01, 0x3121, 0x3521, 0x3942, 0x4162, 0x4562, 0x4983, 0x5184, 0x55a4, 0x1041, 0x1861, 0x1c82, 0x2482, 0x2ca3, 0x30c4, 0x38e4, 0x3ce5, 0x4506, 0x4d46, 0x5586, 0x5dc6, 0x6625, 0x6ea5, 0x7724, 0x7fc3, 0x420, 0xc40, 0x1482, 0x1ca2, 0x24c3, 0x28e4, 0x3105, 0x3526, 0x3d48, 0x4589, 0x4daa, 0x51ec, 0x5a0d, 0x624f, 0x6a91, 0x72d2, 0x5634, 0x4df2, 0x49d0, 0x45af, 0x3d6d, 0x394c, 0x352b, 0x3109, 0x2ce8, 0x24c7, 0x20a6, 0x1c84, 0x1463, 0x1042, 0xc21, 0x821, 0x5dd3, 0x55b1, 0x5190, 0x496e, 0x454d, 0x3d2c, 0x390a, 0x34e9, 0x30c8, 0x28a7, 0x2485, 0x1c84, 0x1863, 0x1042, 0xc21, 0x821, 0x6f17, 0x66d4, 0x5e93, 0x5651, 0x520f, 0x49ed, 0x41ac, 0x3d8a, 0x3569, 0x3127, 0x2906, 0x20c5, 0x1ca4, 0x1483, 0xc42, 0x821, 0x360f, 0x35ed, 0x31cd, 0x2dac, 0x298b, 0x256a, 0x2149, 0x1d28, 0x1907, 0x14e6, 0x10c5, 0x10a4, 0xc83, 0x862, 0x441, 0x421, 0x7fc3, 0x7763, 0x6f22, 0x66c2, 0x5e82, 0x5641, 0x4e01, 0x45c1, 0x3d81, 0x3540, 0x2d20, 0x24e0, 0x1ca0, 0x1480, 0xc40, 0x420, 0x1f, 0x43d, 0x85b, 0xc79, 0x1097, 0x14b5, 0x18d3, 0x18d1, 0x18cf, 0x18cd, 0x18cc, 0x14aa, 0x1088, 0xc66, 0x844, 0x422, 0x1400, 0x1c00, 0x2420, 0x3020, 0x3440, 0x3c61, 0x4881, 0x50a1, 0x58c2, 0x6123, 0x6585, 0x6de7, 0x724a, 0x72ac, 0x76ee, 0x7b51, 0x51e7, 0x5a67, 0x6307, 0x738b, 0x3eff, 0x579f, 0x6bff, 0x3400, 0x4400, 0x5800, 0x6800, 0x7c00, 0x7fd2, 0x7fd8, 0x7fff, 0x4d6a"];
+static const palette_t palette[256] = {0x0, 0x842, 0x1084, 0x18c6, 0x2108, 0x2529, 0x2d6b, 0x35ad, 0x3def, 0x4631, 0x4e73, 0x56b5, 0x5ef7, 0x6739, 0x6f7b, 0x77bd, 0x821, 0xc41, 0x1061, 0x1462, 0x1882, 0x1ca3, 0x20c3, 0x24e3, 0x28e3, 0x2d04, 0x3124, 0x3544, 0x3964, 0x3d84, 0x41a4, 0x45a4, 0x422, 0x843, 0xc65, 0x14a6, 0x18c8, 0x1ce9, 0x210b, 0x252d, 0x294e, 0x2d6f, 0x3191, 0x35b2, 0x39d4, 0x3df5, 0x4217, 0x4639, 0x0, 0x420, 0x420, 0x840, 0xc60, 0x1080, 0x14a1, 0x18c1, 0x1ce1, 0x2101, 0x2521, 0x2521, 0x2941, 0x2d61, 0x3181, 0x35a2, 0x400, 0x800, 0xc00, 0x1000, 0x1400, 0x1800, 0x1c00, 0x2000, 0x2400, 0x2800, 0x2c00, 0x3000, 0x3400, 0x3400, 0x3800, 0x3c00, 0x840, 0xc60, 0x1080, 0x18a0, 0x1cc0, 0x20e0, 0x24e1, 0x2d01, 0x3121, 0x3521, 0x3942, 0x4162, 0x4562, 0x4983, 0x5184, 0x55a4, 0x1041, 0x1861, 0x1c82, 0x2482, 0x2ca3, 0x30c4, 0x38e4, 0x3ce5, 0x4506, 0x4d46, 0x5586, 0x5dc6, 0x6625, 0x6ea5, 0x7724, 0x7fc3, 0x420, 0xc40, 0x1482, 0x1ca2, 0x24c3, 0x28e4, 0x3105, 0x3526, 0x3d48, 0x4589, 0x4daa, 0x51ec, 0x5a0d, 0x624f, 0x6a91, 0x72d2, 0x5634, 0x4df2, 0x49d0, 0x45af, 0x3d6d, 0x394c, 0x352b, 0x3109, 0x2ce8, 0x24c7, 0x20a6, 0x1c84, 0x1463, 0x1042, 0xc21, 0x821, 0x5dd3, 0x55b1, 0x5190, 0x496e, 0x454d, 0x3d2c, 0x390a, 0x34e9, 0x30c8, 0x28a7, 0x2485, 0x1c84, 0x1863, 0x1042, 0xc21, 0x821, 0x6f17, 0x66d4, 0x5e93, 0x5651, 0x520f, 0x49ed, 0x41ac, 0x3d8a, 0x3569, 0x3127, 0x2906, 0x20c5, 0x1ca4, 0x1483, 0xc42, 0x821, 0x360f, 0x35ed, 0x31cd, 0x2dac, 0x298b, 0x256a, 0x2149, 0x1d28, 0x1907, 0x14e6, 0x10c5, 0x10a4, 0xc83, 0x862, 0x441, 0x421, 0x7fc3, 0x7763, 0x6f22, 0x66c2, 0x5e82, 0x5641, 0x4e01, 0x45c1, 0x3d81, 0x3540, 0x2d20, 0x24e0, 0x1ca0, 0x1480, 0xc40, 0x420, 0x1f, 0x43d, 0x85b, 0xc79, 0x1097, 0x14b5, 0x18d3, 0x18d1, 0x18cf, 0x18cd, 0x18cc, 0x14aa, 0x1088, 0xc66, 0x844, 0x422, 0x1400, 0x1c00, 0x2420, 0x3020, 0x3440, 0x3c61, 0x4881, 0x50a1, 0x58c2, 0x6123, 0x6585, 0x6de7, 0x724a, 0x72ac, 0x76ee, 0x7b51, 0x51e7, 0x5a67, 0x6307, 0x738b, 0x3eff, 0x579f, 0x6bff, 0x3400, 0x4400, 0x5800, 0x6800, 0x7c00, 0x7fd2, 0x7fd8, 0x7fff, 0x4d6a};
 
-#endif
\ No newline at end of file
+#endif
@@ -1,11 +1,12 @@
 //Generated with the "color_modes.py" script
-#ifndef 565_PALETTE_H
-#define 565_PALETTE_H
+#ifndef PALETTE_565_H
+#define PALETTE_565_H
 
 #include <stdint.h>
 
-uint16_t[256] *palette = 0x20041000; // Start of SRAM 5
+typedef uint16_t palette_t;
+
 //Conversion (or not) of the original Quake palette to the indicated color bit mode
-palette* = [0x0, 0x1082, 0x2104, 0x3186, 0x4208, 0x4a69, 0x5acb, 0x6b4d, 0x7bcf, 0x8c51, 0x9cd3, 0xad55, 0xbdd7, 0xce59, 0xdedb, 0xef5d, 0x1061, 0x1881, 0x20c1, 0x28e2, 0x3122, 0x3963, 0x4183, 0x49c3, 0x51e3, 0x5a24, 0x6264, 0x6aa4, 0x72a4, 0x7ae4, 0x8324, 0x8b64, 0x862, 0x10a3, 0x18e5, 0x2946, 0x3188, 0x39c9, 0x420b, 0x4a4d, 0x528e, 0x5acf, 0x6311, 0x6b52, 0x7394, 0x7bd5, 0x8417, 0x8c59, 0x0, 0x840, 0x860, 0x10a0, 0x18e0, 0x2120, 0x2961, 0x3181, 0x39c1, 0x4201, 0x4a41, 0x4a61, 0x52a1, 0x5ac1, 0x6301, 0x6b42, 0x800, 0x1000, 0x1800, 0x2000, 0x2800, 0x3000, 0x3800, 0x4000, 0x4800, 0x5000, 0x5800, 0x6000, 0x6800, 0x6800, 0x7000, 0x7800, 0x10a0, 0x18e0, 0x2120, 0x3160, 0x3980, 0x41c0, 0x49e1, 0x5a21, 0x6241, 0x6a61, 0x72a2, 0x82a2, 0x8ac2, 0x92e3, 0xa304, 0xab24, 0x20a1, 0x30c1, 0x3902, 0x4922, 0x5963, 0x6184, 0x71c4, 0x79e5, 0x8a26, 0x9a86, 0xab06, 0xbba6, 0xcc65, 0xdd45, 0xee44, 0xff83, 0x840, 0x18a0, 0x2922, 0x3962, 0x49a3, 0x51c4, 0x6205, 0x6a46, 0x7aa8, 0x8ae9, 0x9b4a, 0xa3cc, 0xb42d, 0xc48f, 0xd511, 0xe592, 0xac54, 0x9bf2, 0x9390, 0x8b2f, 0x7acd, 0x72ac, 0x6a6b, 0x6209, 0x59c8, 0x4987, 0x4146, 0x3904, 0x28c3, 0x20a2, 0x1861, 0x1041, 0xbb93, 0xab51, 0xa2f0, 0x92ae, 0x8a8d, 0x7a6c, 0x722a, 0x69e9, 0x61a8, 0x5167, 0x4925, 0x3904, 0x30c3, 0x20a2, 0x1861, 0x1041, 0xde17, 0xcd94, 0xbd13, 0xacb1, 0xa42f, 0x93cd, 0x836c, 0x7b0a, 0x6aa9, 0x6267, 0x5206, 0x41a5, 0x3964, 0x2903, 0x18a2, 0x1061, 0x6c0f, 0x6bcd, 0x638d, 0x5b4c, 0x530b, 0x4aca, 0x42a9, 0x3a68, 0x3227, 0x29e6, 0x21a5, 0x2164, 0x1923, 0x10e2, 0x8a1, 0x861, 0xff83, 0xeee3, 0xde42, 0xcda2, 0xbd22, 0xaca1, 0x9c01, 0x8b81, 0x7b01, 0x6aa0, 0x5a40, 0x49c0, 0x3960, 0x2900, 0x1880, 0x840, 0x1f, 0x87d, 0x10bb, 0x18f9, 0x2137, 0x2975, 0x3193, 0x3191, 0x318f, 0x318d, 0x318c, 0x296a, 0x2128, 0x18e6, 0x10a4, 0x862, 0x2800, 0x3800, 0x4840, 0x6040, 0x6880, 0x78c1, 0x9101, 0xa141, 0xb1a2, 0xc263, 0xcb05, 0xdbe7, 0xe4aa, 0xe54c, 0xedee, 0xf691, 0xa3c7, 0xb4c7, 0xc607, 0xe70b, 0x7dff, 0xaf3f, 0xd7ff, 0x6800, 0x8800, 0xb000, 0xd000, 0xf800, 0xff92, 0xffb8, 0xffff, 0x9aca"];
+static const palette_t palette[256] = {0x0, 0x1082, 0x2104, 0x3186, 0x4208, 0x4a69, 0x5acb, 0x6b4d, 0x7bcf, 0x8c51, 0x9cd3, 0xad55, 0xbdd7, 0xce59, 0xdedb, 0xef5d, 0x1061, 0x1881, 0x20c1, 0x28e2, 0x3122, 0x3963, 0x4183, 0x49c3, 0x51e3, 0x5a24, 0x6264, 0x6aa4, 0x72a4, 0x7ae4, 0x8324, 0x8b64, 0x862, 0x10a3, 0x18e5, 0x2946, 0x3188, 0x39c9, 0x420b, 0x4a4d, 0x528e, 0x5acf, 0x6311, 0x6b52, 0x7394, 0x7bd5, 0x8417, 0x8c59, 0x0, 0x840, 0x860, 0x10a0, 0x18e0, 0x2120, 0x2961, 0x3181, 0x39c1, 0x4201, 0x4a41, 0x4a61, 0x52a1, 0x5ac1, 0x6301, 0x6b42, 0x800, 0x1000, 0x1800, 0x2000, 0x2800, 0x3000, 0x3800, 0x4000, 0x4800, 0x5000, 0x5800, 0x6000, 0x6800, 0x6800, 0x7000, 0x7800, 0x10a0, 0x18e0, 0x2120, 0x3160, 0x3980, 0x41c0, 0x49e1, 0x5a21, 0x6241, 0x6a61, 0x72a2, 0x82a2, 0x8ac2, 0x92e3, 0xa304, 0xab24, 0x20a1, 0x30c1, 0x3902, 0x4922, 0x5963, 0x6184, 0x71c4, 0x79e5, 0x8a26, 0x9a86, 0xab06, 0xbba6, 0xcc65, 0xdd45, 0xee44, 0xff83, 0x840, 0x18a0, 0x2922, 0x3962, 0x49a3, 0x51c4, 0x6205, 0x6a46, 0x7aa8, 0x8ae9, 0x9b4a, 0xa3cc, 0xb42d, 0xc48f, 0xd511, 0xe592, 0xac54, 0x9bf2, 0x9390, 0x8b2f, 0x7acd, 0x72ac, 0x6a6b, 0x6209, 0x59c8, 0x4987, 0x4146, 0x3904, 0x28c3, 0x20a2, 0x1861, 0x1041, 0xbb93, 0xab51, 0xa2f0, 0x92ae, 0x8a8d, 0x7a6c, 0x722a, 0x69e9, 0x61a8, 0x5167, 0x4925, 0x3904, 0x30c3, 0x20a2, 0x1861, 0x1041, 0xde17, 0xcd94, 0xbd13, 0xacb1, 0xa42f, 0x93cd, 0x836c, 0x7b0a, 0x6aa9, 0x6267, 0x5206, 0x41a5, 0x3964, 0x2903, 0x18a2, 0x1061, 0x6c0f, 0x6bcd, 0x638d, 0x5b4c, 0x530b, 0x4aca, 0x42a9, 0x3a68, 0x3227, 0x29e6, 0x21a5, 0x2164, 0x1923, 0x10e2, 0x8a1, 0x861, 0xff83, 0xeee3, 0xde42, 0xcda2, 0xbd22, 0xaca1, 0x9c01, 0x8b81, 0x7b01, 0x6aa0, 0x5a40, 0x49c0, 0x3960, 0x2900, 0x1880, 0x840, 0x1f, 0x87d, 0x10bb, 0x18f9, 0x2137, 0x2975, 0x3193, 0x3191, 0x318f, 0x318d, 0x318c, 0x296a, 0x2128, 0x18e6, 0x10a4, 0x862, 0x2800, 0x3800, 0x4840, 0x6040, 0x6880, 0x78c1, 0x9101, 0xa141, 0xb1a2, 0xc263, 0xcb05, 0xdbe7, 0xe4aa, 0xe54c, 0xedee, 0xf691, 0xa3c7, 0xb4c7, 0xc607, 0xe70b, 0x7dff, 0xaf3f, 0xd7ff, 0x6800, 0x8800, 0xb000, 0xd000, 0xf800, 0xff92, 0xffb8, 0xffff, 0x9aca};
 
-#endif
\ No newline at end of file
+#endif
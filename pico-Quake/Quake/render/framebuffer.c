@@ -0,0 +1,306 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// framebuffer.c -- banded framebuffer and scanout
+
+#include "quakedef.h"
+
+cvar_t		vid_bandheight = {"vid_bandheight", "0", CVAR_ARCHIVE};	// 0 = whole frames
+
+fbscanout_t	fb_scanout;
+
+static fbstrip_t	fb_strips[FB_NUM_STRIPS];
+static int			fb_stripwidth, fb_stripheight;	// size the strips were allocated for
+
+static fbpixel_t	*fb_line;			// one converted row on its way to the panel
+static qboolean		fb_fullupdate;		// every band has to be sent next frame
+
+// the gl renderer draws into its own framebuffer, so the host reads each band
+// back in the panel's format and maps it onto the palette to get what the
+// strip would have held. the map is by the top 4 bits of each channel, and
+// is filled in as colors turn up.
+#define	FB_NOINDEX		255		// transparent, never the nearest color
+
+static fbpixel_t	*fb_readback;		// one band
+static byte			fb_12to8[4096];
+
+#if defined(COLOR_MODE) && COLOR_MODE == 565
+#define	FB_READFORMAT	GL_RGB
+#define	FB_READTYPE		GL_UNSIGNED_SHORT_5_6_5
+#define	FB_PIXELKEY(p)	((((p) >> 12) << 8) | ((((p) >> 7) & 15) << 4) | (((p) >> 1) & 15))
+#elif defined(COLOR_MODE) && COLOR_MODE == 555
+#define	FB_READFORMAT	GL_BGRA
+#define	FB_READTYPE		GL_UNSIGNED_SHORT_1_5_5_5_REV
+#define	FB_PIXELKEY(p)	(((((p) >> 11) & 15) << 8) | ((((p) >> 6) & 15) << 4) | (((p) >> 1) & 15))
+#else
+#define	FB_READFORMAT	GL_BGRA
+#define	FB_READTYPE		GL_UNSIGNED_INT_8_8_8_8_REV
+#define	FB_PIXELKEY(p)	(((((p) >> 20) & 15) << 8) | ((((p) >> 12) & 15) << 4) | (((p) >> 4) & 15))
+#endif
+
+static int				fb_bandssent, fb_bandsskipped;
+static unsigned short	fb_crc, fb_lastcrc;
+
+/*
+=============
+FB_SetPalette
+
+rgba is d_8to24table. called whenever the palette is (re)loaded.
+=============
+*/
+void FB_SetPalette (const unsigned int *rgba)
+{
+	memset (fb_12to8, FB_NOINDEX, sizeof(fb_12to8));
+	fb_fullupdate = true;
+}
+
+/*
+=============
+FB_NearestIndex
+
+nearest opaque palette entry to the middle of a 12 bit color's cell
+=============
+*/
+static byte FB_NearestIndex (int key)
+{
+	const byte	*pal;
+	int		j, r, g, b, dr, dg, db, dist, bestdist, best;
+
+	r = ((key >> 8) << 4) | 8;
+	g = (((key >> 4) & 15) << 4) | 8;
+	b = ((key & 15) << 4) | 8;
+
+	best = 0;
+	bestdist = INT_MAX;
+	for (j = 0; j < FB_NOINDEX; j++)
+	{
+		pal = (const byte *)&d_8to24table[j];
+		dr = pal[0] - r;
+		dg = pal[1] - g;
+		db = pal[2] - b;
+		dist = dr*dr + dg*dg + db*db;
+		if (dist < bestdist)
+		{
+			bestdist = dist;
+			best = j;
+		}
+	}
+
+	return fb_12to8[key] = best;
+}
+
+/*
+=============
+FB_AllocStrips
+=============
+*/
+static void FB_AllocStrips (int width, int height)
+{
+	int		i;
+
+	for (i = 0; i < FB_NUM_STRIPS; i++)
+	{
+		free (fb_strips[i].pixels);
+		fb_strips[i].pixels = (pixel_t *) malloc (width * height * sizeof(pixel_t));
+		if (!fb_strips[i].pixels)
+			Sys_Error ("FB_AllocStrips: couldn't allocate %i bytes", width * height);
+	}
+
+	free (fb_line);
+	free (fb_readback);
+	fb_line = (fbpixel_t *) malloc (width * sizeof(fbpixel_t));
+	fb_readback = (fbpixel_t *) malloc (width * height * sizeof(fbpixel_t));
+	if (!fb_line || !fb_readback)
+		Sys_Error ("FB_AllocStrips: couldn't allocate scanout buffers");
+
+	fb_stripwidth = width;
+	fb_stripheight = height;
+	fb_fullupdate = true;
+}
+
+/*
+=============
+FB_ReadBand
+
+fills the strip with rows y .. y+height-1 of the finished frame
+=============
+*/
+static void FB_ReadBand (fbstrip_t *strip, int y, int height)
+{
+	const fbpixel_t	*src;
+	pixel_t		*dst;
+	int		row, x, key;
+
+	strip->y = y;
+	strip->height = height;
+
+	glPixelStorei (GL_PACK_ALIGNMENT, 1);
+	glReadPixels (glx, gly + glheight - y - height, fb_stripwidth, height, FB_READFORMAT, FB_READTYPE, fb_readback);
+
+	// gl rows are bottom-up
+	for (row = 0; row < height; row++)
+	{
+		src = fb_readback + (height - 1 - row) * fb_stripwidth;
+		dst = strip->pixels + row * fb_stripwidth;
+		for (x = 0; x < fb_stripwidth; x++)
+		{
+			key = FB_PIXELKEY (src[x]);
+			*dst++ = (fb_12to8[key] != FB_NOINDEX) ? fb_12to8[key] : FB_NearestIndex (key);
+		}
+	}
+}
+
+/*
+=============
+FB_ScanoutStrip
+
+palette conversion stage, one row at a time so only a single converted row
+is ever held
+=============
+*/
+static void FB_ScanoutStrip (fbstrip_t *strip)
+{
+	const pixel_t	*src;
+	int		row, x;
+
+	for (row = 0; row < strip->height; row++)
+	{
+		src = strip->pixels + row * fb_stripwidth;
+		for (x = 0; x < fb_stripwidth; x++)
+			fb_line[x] = palette[src[x]];
+		fb_scanout (strip->y + row, fb_stripwidth, fb_line);
+	}
+}
+
+/*
+=============
+FB_ChecksumRow -- default scanout sink
+=============
+*/
+static void FB_ChecksumRow (int y, int width, const fbpixel_t *row)
+{
+	const byte	*data = (const byte *)row;
+	int		i, count;
+
+	count = width * sizeof(fbpixel_t);
+	for (i = 0; i < count; i++)
+		CRC_ProcessByte (&fb_crc, data[i]);
+}
+
+/*
+=============
+FB_EndFrame
+
+takes the place of presenting a whole frame. each band that any of the dirty
+rectangles touch is produced into the next free strip, and the band before
+it is scanned out behind it, so at most FB_NUM_STRIPS strips are ever live.
+=============
+*/
+void FB_EndFrame (vrect_t *dirty)
+{
+	fbstrip_t	*strip, *pending;
+	vrect_t		*rect;
+	int		bandheight, y, height, next;
+
+	if (vid_bandheight.value <= 0 || scr_skipupdate)
+		return;
+
+	bandheight = CLAMP ((glheight + FB_MAX_BANDS - 1) / FB_MAX_BANDS, (int)vid_bandheight.value, glheight);
+	if (glwidth != fb_stripwidth || bandheight != fb_stripheight)
+		FB_AllocStrips (glwidth, bandheight);
+
+	CRC_Init (&fb_crc);
+	fb_bandssent = fb_bandsskipped = 0;
+
+	pending = NULL;
+	next = 0;
+	for (y = 0; y < glheight; y += bandheight)
+	{
+		height = q_min (bandheight, glheight - y);
+
+		if (!fb_fullupdate)
+		{
+			for (rect = dirty; rect; rect = rect->pnext)
+				if (rect->y < y + height && rect->y + rect->height > y)
+					break;
+			if (!rect)
+			{
+				fb_bandsskipped++;	// the panel still has it from an earlier frame
+				continue;
+			}
+		}
+
+		strip = &fb_strips[next];
+		next = (next + 1) % FB_NUM_STRIPS;
+		FB_ReadBand (strip, y, height);
+
+		if (pending)
+			FB_ScanoutStrip (pending);
+		pending = strip;
+		fb_bandssent++;
+	}
+
+	if (pending)
+		FB_ScanoutStrip (pending);
+
+	fb_fullupdate = false;
+	fb_lastcrc = CRC_Value (fb_crc);
+}
+
+/*
+=============
+FB_Info_f
+=============
+*/
+static void FB_Info_f (void)
+{
+	if (vid_bandheight.value <= 0 || !fb_stripwidth)
+	{
+		Con_Printf ("banded scanout is off, set vid_bandheight\n");
+		return;
+	}
+
+	Con_Printf ("%i strips of %ix%i: %i bytes (whole frame %i)\n", FB_NUM_STRIPS,
+				fb_stripwidth, fb_stripheight,
+				(int)(FB_NUM_STRIPS * fb_stripwidth * fb_stripheight * sizeof(pixel_t)),
+				(int)(glwidth * glheight * sizeof(pixel_t)));
+	Con_Printf ("readback band %i bytes, row %i bytes, color map %i bytes\n",
+				(int)(fb_stripwidth * fb_stripheight * sizeof(fbpixel_t)),
+				(int)(fb_stripwidth * sizeof(fbpixel_t)), (int)sizeof(fb_12to8));
+	Con_Printf ("last frame: %i bands sent, %i skipped, scanout crc %04x\n",
+				fb_bandssent, fb_bandsskipped, fb_lastcrc);
+}
+
+/*
+=============
+FB_Init
+=============
+*/
+void FB_Init (void)
+{
+	Cvar_RegisterVariable (&vid_bandheight);
+	Cmd_AddCommand ("fb_info", FB_Info_f);
+
+	memset (fb_12to8, FB_NOINDEX, sizeof(fb_12to8));
+
+	if (!fb_scanout)
+		fb_scanout = FB_ChecksumRow;
+}
@@ -1,2 +1,58 @@
-#include "palette.h"
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
 
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef _QUAKE_FRAMEBUFFER_H
+#define _QUAKE_FRAMEBUFFER_H
+
+// framebuffer.h -- banded framebuffer and scanout
+
+// there is no room for two full frames, so the finished frame is cut into
+// horizontal bands of vid_bandheight rows. each band is produced into one of
+// FB_NUM_STRIPS small strips of palette indices, and the scanout converts a
+// finished strip to the panel's COLOR_MODE while the next band is produced
+// into the other strip. bands that nothing was drawn into are not sent again.
+
+#include "palette.h"	// the COLOR_MODE table from color_modes.py
+
+#define	FB_NUM_STRIPS		2	// one being produced, one being scanned out
+#define	FB_MAX_BANDS		64
+
+typedef palette_t	fbpixel_t;	// a pixel in the panel's COLOR_MODE
+
+typedef struct
+{
+	int			y, height;	// rows of the frame held by this strip
+	pixel_t		*pixels;	// height * width palette indices
+} fbstrip_t;
+
+// hands one converted row to the panel. the default sink only checksums the
+// rows, which is all the host needs to check the output is deterministic.
+typedef void (*fbscanout_t) (int y, int width, const fbpixel_t *row);
+
+extern	cvar_t		vid_bandheight;
+extern	fbscanout_t	fb_scanout;
+
+void FB_Init (void);
+void FB_SetPalette (const unsigned int *rgba);
+void FB_EndFrame (vrect_t *dirty);
+
+#endif	/* _QUAKE_FRAMEBUFFER_H */
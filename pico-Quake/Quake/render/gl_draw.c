@@ -525,6 +525,42 @@ void Draw_Pic (int x, int y, qpic_t *pic)
 	glEnd ();
 }
 
+/*
+=============
+Draw_SubPic
+
+draws the given sub-rectangle of a pic at x,y. used to restore a background
+pic underneath a single hud element without redrawing the whole pic.
+=============
+*/
+void Draw_SubPic (int x, int y, qpic_t *pic, int srcx, int srcy, int width, int height)
+{
+	glpic_t			*gl;
+	float			sl, tl, sh, th, ds, dt;
+
+	if (scrap_dirty)
+		Scrap_Upload ();
+	gl = (glpic_t *)pic->data;
+	ds = (gl->sh - gl->sl) / pic->width;
+	dt = (gl->th - gl->tl) / pic->height;
+	sl = gl->sl + srcx * ds;
+	sh = gl->sl + (srcx + width) * ds;
+	tl = gl->tl + srcy * dt;
+	th = gl->tl + (srcy + height) * dt;
+
+	GL_Bind (gl->gltexture);
+	glBegin (GL_QUADS);
+	glTexCoord2f (sl, tl);
+	glVertex2f (x, y);
+	glTexCoord2f (sh, tl);
+	glVertex2f (x+width, y);
+	glTexCoord2f (sh, th);
+	glVertex2f (x+width, y+height);
+	glTexCoord2f (sl, th);
+	glVertex2f (x, y+height);
+	glEnd ();
+}
+
 /*
 =============
 Draw_TransPicTranslate -- johnfitz -- rewritten to use texmgr to do translation
@@ -673,6 +709,57 @@ void Draw_FadeScreen (void)
 	glDisable (GL_BLEND);
 
 	Sbar_Changed();
+	SCR_AddDirtyRect (0, 0, glwidth, glheight);
+}
+
+/*
+================
+GL_CanvasOrtho
+
+sets up the projection for a canvas, and remembers how canvas units map to
+screen pixels so 2d drawing can report the regions it touches
+================
+*/
+static float	canvas_left, canvas_top, canvas_xscale, canvas_yscale;
+static float	canvas_vx, canvas_vy;
+
+static void GL_CanvasOrtho (float left, float right, float bottom, float top, int vx, int vy, int vw, int vh)
+{
+	glOrtho (left, right, bottom, top, -99999, 99999);
+	glViewport (vx, vy, vw, vh);
+
+	canvas_left = left;
+	canvas_top = top;
+	canvas_xscale = vw / (right - left);
+	canvas_yscale = vh / (bottom - top);
+	canvas_vx = vx - glx;
+	canvas_vy = glheight - (vy - gly) - vh;	// gl viewports are bottom-up
+}
+
+/*
+================
+GL_CanvasRect
+
+converts a rectangle in the current canvas to screen pixels, clipped to the
+screen. returns false if nothing is left.
+================
+*/
+qboolean GL_CanvasRect (int *x, int *y, int *w, int *h)
+{
+	float	x0, y0, x1, y1, t;
+
+	x0 = canvas_vx + (*x - canvas_left) * canvas_xscale;
+	x1 = canvas_vx + (*x + *w - canvas_left) * canvas_xscale;
+	y0 = canvas_vy + (*y - canvas_top) * canvas_yscale;
+	y1 = canvas_vy + (*y + *h - canvas_top) * canvas_yscale;
+	if (x1 < x0) { t = x0; x0 = x1; x1 = t; }
+	if (y1 < y0) { t = y0; y0 = y1; y1 = t; }
+
+	*x = q_max ((int)x0, 0);
+	*y = q_max ((int)y0, 0);
+	*w = q_min ((int)ceil(x1), glwidth) - *x;
+	*h = q_min ((int)ceil(y1), glheight) - *y;
+	return (*w > 0 && *h > 0);
 }
 
 /*
@@ -697,57 +784,47 @@ void GL_SetCanvas (canvastype newcanvas)
 	switch(newcanvas)
 	{
 	case CANVAS_DEFAULT:
-		glOrtho (0, glwidth, glheight, 0, -99999, 99999);
-		glViewport (glx, gly, glwidth, glheight);
+		GL_CanvasOrtho (0, glwidth, glheight, 0, glx, gly, glwidth, glheight);
 		break;
 	case CANVAS_CONSOLE:
 		lines = vid.conheight - (scr_con_current * vid.conheight / glheight);
-		glOrtho (0, vid.conwidth, vid.conheight + lines, lines, -99999, 99999);
-		glViewport (glx, gly, glwidth, glheight);
+		GL_CanvasOrtho (0, vid.conwidth, vid.conheight + lines, lines, glx, gly, glwidth, glheight);
 		break;
 	case CANVAS_MENU:
 		s = q_min((float)glwidth / 320.0f, (float)glheight / 200.0f);
 		s = CLAMP (1.0f, scr_menuscale.value, s);
 		// ericw -- doubled width to 640 to accommodate long keybindings
-		glOrtho (0, 640, 200, 0, -99999, 99999);
-		glViewport (glx + (glwidth - 320*s) / 2, gly + (glheight - 200*s) / 2, 640*s, 200*s);
+		GL_CanvasOrtho (0, 640, 200, 0, glx + (glwidth - 320*s) / 2, gly + (glheight - 200*s) / 2, 640*s, 200*s);
 		break;
 	case CANVAS_SBAR:
 		s = CLAMP (1.0f, scr_sbarscale.value, (float)glwidth / 320.0f);
 		if (cl.gametype == GAME_DEATHMATCH)
 		{
-			glOrtho (0, glwidth / s, 48, 0, -99999, 99999);
-			glViewport (glx, gly, glwidth, 48*s);
+			GL_CanvasOrtho (0, glwidth / s, 48, 0, glx, gly, glwidth, 48*s);
 		}
 		else
 		{
-			glOrtho (0, 320, 48, 0, -99999, 99999);
-			glViewport (glx + (glwidth - 320*s) / 2, gly, 320*s, 48*s);
+			GL_CanvasOrtho (0, 320, 48, 0, glx + (glwidth - 320*s) / 2, gly, 320*s, 48*s);
 		}
 		break;
 	case CANVAS_WARPIMAGE:
-		glOrtho (0, 128, 0, 128, -99999, 99999);
-		glViewport (glx, gly+glheight-gl_warpimagesize, gl_warpimagesize, gl_warpimagesize);
+		GL_CanvasOrtho (0, 128, 0, 128, glx, gly+glheight-gl_warpimagesize, gl_warpimagesize, gl_warpimagesize);
 		break;
 	case CANVAS_CROSSHAIR: //0,0 is center of viewport
 		s = CLAMP (1.0f, scr_crosshairscale.value, 10.0f);
-		glOrtho (scr_vrect.width/-2/s, scr_vrect.width/2/s, scr_vrect.height/2/s, scr_vrect.height/-2/s, -99999, 99999);
-		glViewport (scr_vrect.x, glheight - scr_vrect.y - scr_vrect.height, scr_vrect.width & ~1, scr_vrect.height & ~1);
+		GL_CanvasOrtho (scr_vrect.width/-2/s, scr_vrect.width/2/s, scr_vrect.height/2/s, scr_vrect.height/-2/s, scr_vrect.x, glheight - scr_vrect.y - scr_vrect.height, scr_vrect.width & ~1, scr_vrect.height & ~1);
 		break;
 	case CANVAS_BOTTOMLEFT: //used by devstats
 		s = (float)glwidth/vid.conwidth; //use console scale
-		glOrtho (0, 320, 200, 0, -99999, 99999);
-		glViewport (glx, gly, 320*s, 200*s);
+		GL_CanvasOrtho (0, 320, 200, 0, glx, gly, 320*s, 200*s);
 		break;
 	case CANVAS_BOTTOMRIGHT: //used by fps/clock
 		s = (float)glwidth/vid.conwidth; //use console scale
-		glOrtho (0, 320, 200, 0, -99999, 99999);
-		glViewport (glx+glwidth-320*s, gly, 320*s, 200*s);
+		GL_CanvasOrtho (0, 320, 200, 0, glx+glwidth-320*s, gly, 320*s, 200*s);
 		break;
 	case CANVAS_TOPRIGHT: //used by disc
 		s = 1;
-		glOrtho (0, 320, 200, 0, -99999, 99999);
-		glViewport (glx+glwidth-320*s, gly+glheight-200*s, 320*s, 200*s);
+		GL_CanvasOrtho (0, 320, 200, 0, glx+glwidth-320*s, gly+glheight-200*s, 320*s, 200*s);
 		break;
 	default:
 		Sys_Error ("GL_SetCanvas: bad canvas type");
@@ -42,9 +42,6 @@ static cvar_t	external_vis = {"external_vis", "1", CVAR_ARCHIVE};
 static byte	*mod_novis;
 static int	mod_novis_capacity;
 
-static byte	*mod_decompressed;
-static int	mod_decompressed_capacity;
-
 #define	MAX_MOD_KNOWN	2048 /*johnfitz -- was 512 */
 static qmodel_t	mod_known[MAX_MOD_KNOWN];
 static int		mod_numknown;
@@ -132,34 +129,26 @@ mleaf_t *Mod_PointInLeaf (vec3_t p, qmodel_t *model)
 /*
 ===================
 Mod_DecompressVis
+
+into out, which holds a row of (numleafs+7)>>3 bytes. the caller owns it, so
+the renderer and a pipelined server frame can both decompress at once.
 ===================
 */
-static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
+static byte *Mod_DecompressVis (byte *in, qmodel_t *model, byte *out)
 {
 	int		c;
-	byte	*out;
+	byte	*row;
 	byte	*outend;
-	int		row;
+	int		rowbytes;
 
-	row = (model->numleafs+7)>>3;
-	if (mod_decompressed == NULL || row > mod_decompressed_capacity)
-	{
-		mod_decompressed_capacity = row;
-		mod_decompressed = (byte *) realloc (mod_decompressed, mod_decompressed_capacity);
-		if (!mod_decompressed)
-			Sys_Error ("Mod_DecompressVis: realloc() failed on %d bytes", mod_decompressed_capacity);
-	}
-	out = mod_decompressed;
-	outend = mod_decompressed + row;
+	rowbytes = (model->numleafs+7)>>3;
+	row = out;
+	outend = out + rowbytes;
 
 	if (!in)
 	{	// no vis info, so make all visible
-		while (row)
-		{
-			*out++ = 0xff;
-			row--;
-		}
-		return mod_decompressed;
+		memset (row, 0xff, rowbytes);
+		return row;
 	}
 
 	do
@@ -180,21 +169,28 @@ static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
 					model->viswarn = true;
 					Con_Warning("Mod_DecompressVis: output overrun on model \"%s\"\n", model->name);
 				}
-				return mod_decompressed;
+				return row;
 			}
 			*out++ = 0;
 			c--;
 		}
-	} while (out - mod_decompressed < row);
+	} while (out < outend);
 
-	return mod_decompressed;
+	return row;
 }
 
-byte *Mod_LeafPVS (mleaf_t *leaf, qmodel_t *model)
+/*
+===================
+Mod_LeafPVS
+
+the leaf's row of the pvs, decompressed into out
+===================
+*/
+byte *Mod_LeafPVS (mleaf_t *leaf, qmodel_t *model, byte *out)
 {
 	if (leaf == model->leafs)
-		return Mod_NoVisPVS (model);
-	return Mod_DecompressVis (leaf->compressed_vis, model);
+		return Mod_DecompressVis (NULL, model, out);
+	return Mod_DecompressVis (leaf->compressed_vis, model, out);
 }
 
 byte *Mod_NoVisPVS (qmodel_t *model)
@@ -1706,6 +1702,20 @@ static void Mod_LoadLeafs (lump_t *l, int bsp2)
 		Mod_ProcessLeafs_S  ((dsleaf_t *) in, l->filelen);
 }
 
+/*
+=================
+Mod_SetClipnodePlane
+
+copies the plane into the clipnode for the hull tracing code
+=================
+*/
+static void Mod_SetClipnodePlane (mclipnode_t *out, mplane_t *plane)
+{
+	VectorCopy (plane->normal, out->normal);
+	out->dist = plane->dist;
+	out->type = plane->type;
+}
+
 /*
 =================
 Mod_LoadClipnodes
@@ -1717,7 +1727,7 @@ static void Mod_LoadClipnodes (lump_t *l, qboolean bsp2)
 	dlclipnode_t *inl;
 
 	mclipnode_t *out; //johnfitz -- was dclipnode_t
-	int			i, count;
+	int			i, count, planenum;
 	hull_t		*hull;
 
 	if (bsp2)
@@ -1752,7 +1762,6 @@ static void Mod_LoadClipnodes (lump_t *l, qboolean bsp2)
 	hull->clipnodes = out;
 	hull->firstclipnode = 0;
 	hull->lastclipnode = count-1;
-	hull->planes = loadmodel->planes;
 	hull->clip_mins[0] = -16;
 	hull->clip_mins[1] = -16;
 	hull->clip_mins[2] = -24;
@@ -1764,7 +1773,6 @@ static void Mod_LoadClipnodes (lump_t *l, qboolean bsp2)
 	hull->clipnodes = out;
 	hull->firstclipnode = 0;
 	hull->lastclipnode = count-1;
-	hull->planes = loadmodel->planes;
 	hull->clip_mins[0] = -32;
 	hull->clip_mins[1] = -32;
 	hull->clip_mins[2] = -24;
@@ -1776,13 +1784,15 @@ static void Mod_LoadClipnodes (lump_t *l, qboolean bsp2)
 	{
 		for (i=0 ; i<count ; i++, out++, inl++)
 		{
-			out->planenum = LittleLong(inl->planenum);
+			planenum = LittleLong(inl->planenum);
 
 			//johnfitz -- bounds check
-			if (out->planenum < 0 || out->planenum >= loadmodel->numplanes)
+			if (planenum < 0 || planenum >= loadmodel->numplanes)
 				Host_Error ("Mod_LoadClipnodes: planenum out of bounds");
 			//johnfitz
 
+			Mod_SetClipnodePlane (out, loadmodel->planes + planenum);
+
 			out->children[0] = LittleLong(inl->children[0]);
 			out->children[1] = LittleLong(inl->children[1]);
 			//Spike: FIXME: bounds check
@@ -1792,13 +1802,15 @@ static void Mod_LoadClipnodes (lump_t *l, qboolean bsp2)
 	{
 		for (i=0 ; i<count ; i++, out++, ins++)
 		{
-			out->planenum = LittleLong(ins->planenum);
+			planenum = LittleLong(ins->planenum);
 
 			//johnfitz -- bounds check
-			if (out->planenum < 0 || out->planenum >= loadmodel->numplanes)
+			if (planenum < 0 || planenum >= loadmodel->numplanes)
 				Host_Error ("Mod_LoadClipnodes: planenum out of bounds");
 			//johnfitz
 
+			Mod_SetClipnodePlane (out, loadmodel->planes + planenum);
+
 			//johnfitz -- support clipnodes > 32k
 			out->children[0] = (unsigned short)LittleShort(ins->children[0]);
 			out->children[1] = (unsigned short)LittleShort(ins->children[1]);
@@ -1835,11 +1847,10 @@ static void Mod_MakeHull0 (void)
 	hull->clipnodes = out;
 	hull->firstclipnode = 0;
 	hull->lastclipnode = count-1;
-	hull->planes = loadmodel->planes;
 
 	for (i=0 ; i<count ; i++, out++, in++)
 	{
-		out->planenum = in->plane - loadmodel->planes;
+		Mod_SetClipnodePlane (out, in->plane);
 		for (j=0 ; j<2 ; j++)
 		{
 			child = in->children[j];
@@ -2047,34 +2058,32 @@ from axial planes found in the clipnodes for that hull.
 #if 0 /* disabled for now -- see in Mod_SetupSubmodels()  */
 static void Mod_BoundsFromClipNode (qmodel_t *mod, int hull, int nodenum)
 {
-	mplane_t	*plane;
 	mclipnode_t	*node;
 
 	if (nodenum < 0)
 		return; //hit a leafnode
 
 	node = &mod->clipnodes[nodenum];
-	plane = mod->hulls[hull].planes + node->planenum;
-	switch (plane->type)
+	switch (node->type)
 	{
 
 	case PLANE_X:
-		if (plane->signbits == 1)
-			mod->clipmins[0] = q_min(mod->clipmins[0], -plane->dist - mod->hulls[hull].clip_mins[0]);
+		if (node->normal[0] < 0)
+			mod->clipmins[0] = q_min(mod->clipmins[0], -node->dist - mod->hulls[hull].clip_mins[0]);
 		else
-			mod->clipmaxs[0] = q_max(mod->clipmaxs[0], plane->dist - mod->hulls[hull].clip_maxs[0]);
+			mod->clipmaxs[0] = q_max(mod->clipmaxs[0], node->dist - mod->hulls[hull].clip_maxs[0]);
 		break;
 	case PLANE_Y:
-		if (plane->signbits == 2)
-			mod->clipmins[1] = q_min(mod->clipmins[1], -plane->dist - mod->hulls[hull].clip_mins[1]);
+		if (node->normal[1] < 0)
+			mod->clipmins[1] = q_min(mod->clipmins[1], -node->dist - mod->hulls[hull].clip_mins[1]);
 		else
-			mod->clipmaxs[1] = q_max(mod->clipmaxs[1], plane->dist - mod->hulls[hull].clip_maxs[1]);
+			mod->clipmaxs[1] = q_max(mod->clipmaxs[1], node->dist - mod->hulls[hull].clip_maxs[1]);
 		break;
 	case PLANE_Z:
-		if (plane->signbits == 4)
-			mod->clipmins[2] = q_min(mod->clipmins[2], -plane->dist - mod->hulls[hull].clip_mins[2]);
+		if (node->normal[2] < 0)
+			mod->clipmins[2] = q_min(mod->clipmins[2], -node->dist - mod->hulls[hull].clip_mins[2]);
 		else
-			mod->clipmaxs[2] = q_max(mod->clipmaxs[2], plane->dist - mod->hulls[hull].clip_maxs[2]);
+			mod->clipmaxs[2] = q_max(mod->clipmaxs[2], node->dist - mod->hulls[hull].clip_maxs[2]);
 		break;
 	default:
 		//skip nonaxial planes; don't need them
@@ -172,7 +172,9 @@ typedef struct msurface_s
 	int			lightmaptexturenum;
 	byte		styles[MAXLIGHTMAPS];
 	int			cached_light[MAXLIGHTMAPS];	// values currently used in lightmap
+	qboolean	stylechanged;				// a style it uses has changed since the lightmap was built
 	qboolean	cached_dlight;				// true if dynamic light in cache
+	short		dlightrect[4];				// texels the cached dynamic light covers, s0 t0 s1 t1
 	byte		*samples;		// [numstyles*surfsize]
 } msurface_t;
 
@@ -217,10 +219,15 @@ typedef struct mleaf_s
 } mleaf_t;
 
 //johnfitz -- for clipnodes>32k
+// the plane is copied into the clipnode, so tracing touches one 32 byte
+// record per level instead of a clipnode and a plane
 typedef struct mclipnode_s
 {
-	int			planenum;
+	vec3_t		normal;
+	float		dist;
+	int			type;
 	int			children[2]; // negative numbers are contents
+	int			pad;
 } mclipnode_t;
 //johnfitz
 
@@ -228,7 +235,6 @@ typedef struct mclipnode_s
 typedef struct
 {
 	mclipnode_t	*clipnodes; //johnfitz -- was dclipnode_t
-	mplane_t	*planes;
 	int			firstclipnode;
 	int			lastclipnode;
 	vec3_t		clip_mins;
@@ -512,7 +518,7 @@ void	*Mod_Extradata (qmodel_t *mod);	// handles caching
 void	Mod_TouchModel (const char *name);
 
 mleaf_t *Mod_PointInLeaf (vec3_t p, qmodel_t *model);
-byte	*Mod_LeafPVS (mleaf_t *leaf, qmodel_t *model);
+byte	*Mod_LeafPVS (mleaf_t *leaf, qmodel_t *model, byte *out);
 byte	*Mod_NoVisPVS (qmodel_t *model);
 
 void Mod_SetExtraFlags (qmodel_t *mod);
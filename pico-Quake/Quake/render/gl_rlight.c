@@ -34,7 +34,7 @@ R_AnimateLight
 */
 void R_AnimateLight (void)
 {
-	int			i,j,k;
+	int			i,j,k,value;
 
 //
 // light animations
@@ -43,22 +43,25 @@ void R_AnimateLight (void)
 	for (j=0 ; j<MAX_LIGHTSTYLES ; j++)
 	{
 		if (!cl_lightstyle[j].length)
-		{
-			d_lightstylevalue[j] = 256;
-			continue;
-		}
+			value = 256;
 		//johnfitz -- r_flatlightstyles
-		if (r_flatlightstyles.value == 2)
-			k = cl_lightstyle[j].peak - 'a';
+		else if (r_flatlightstyles.value == 2)
+			value = (cl_lightstyle[j].peak - 'a') * 22;
 		else if (r_flatlightstyles.value == 1)
-			k = cl_lightstyle[j].average - 'a';
+			value = (cl_lightstyle[j].average - 'a') * 22;
 		else
 		{
 			k = i % cl_lightstyle[j].length;
-			k = cl_lightstyle[j].map[k] - 'a';
+			value = (cl_lightstyle[j].map[k] - 'a') * 22;
 		}
-		d_lightstylevalue[j] = k*22;
 		//johnfitz
+
+		// only the surfaces using a style that changed need new lightmaps
+		if (value != d_lightstylevalue[j])
+		{
+			d_lightstylevalue[j] = value;
+			R_MarkLightStyle (j);
+		}
 	}
 }
 
@@ -116,6 +119,44 @@ void R_RenderDlight (dlight_t *light)
 	glEnd ();
 }
 
+/*
+=============
+R_FlashBlendLight
+
+lights that are far away or only lit for a moment aren't worth rebuilding
+lightmaps for, so they get the cheaper gl_flashblend glow instead.  they are
+told apart by the life they were given, not the life they have left, so a
+long light stays lightmapped to its end.  a keyed light that is renewed
+every frame is only ever given a frame, so it is told from a flash by its
+key persisting
+=============
+*/
+qboolean R_FlashBlendLight (dlight_t *light)
+{
+	vec3_t	v;
+	float	life;
+
+	if (gl_flashblend.value)
+		return true;
+
+	life = light->die - light->lit;
+	if (r_dlightshort.value && !light->persist && life < r_dlightshort.value)
+	{
+		// a keyed light that won't last to the next frame is there to be renewed
+		if (!light->key || life >= cl.time - cl.oldtime)
+			return true;
+	}
+
+	if (r_dlightfar.value)
+	{
+		VectorSubtract (light->origin, r_refdef.vieworg, v);
+		if (VectorLength (v) - light->radius > r_dlightfar.value)
+			return true;
+	}
+
+	return false;
+}
+
 /*
 =============
 R_RenderDlights
@@ -125,25 +166,28 @@ void R_RenderDlights (void)
 {
 	int		i;
 	dlight_t	*l;
-
-	if (!gl_flashblend.value)
-		return;
-
-	r_dlightframecount = r_framecount + 1;	// because the count hasn't advanced yet for this frame
-	glDepthMask (0);
-	glDisable (GL_TEXTURE_2D);
-	glShadeModel (GL_SMOOTH);
-	glEnable (GL_BLEND);
-	glBlendFunc (GL_ONE, GL_ONE);
+	qboolean	blending = false;
 
 	l = cl_dlights;
 	for (i=0 ; i<MAX_DLIGHTS ; i++, l++)
 	{
-		if (l->die < cl.time || !l->radius)
+		if (l->die < cl.time || !l->radius || !R_FlashBlendLight (l))
 			continue;
+		if (!blending)
+		{
+			glDepthMask (0);
+			glDisable (GL_TEXTURE_2D);
+			glShadeModel (GL_SMOOTH);
+			glEnable (GL_BLEND);
+			glBlendFunc (GL_ONE, GL_ONE);
+			blending = true;
+		}
 		R_RenderDlight (l);
 	}
 
+	if (!blending)
+		return;
+
 	glColor3f (1,1,1);
 	glDisable (GL_BLEND);
 	glEnable (GL_TEXTURE_2D);
@@ -245,7 +289,7 @@ void R_PushDlights (void)
 
 	for (i=0 ; i<MAX_DLIGHTS ; i++, l++)
 	{
-		if (l->die < cl.time || !l->radius)
+		if (l->die < cl.time || !l->radius || R_FlashBlendLight (l))
 			continue;
 		R_MarkLights (l, i, cl.worldmodel->nodes);
 	}
@@ -66,6 +66,8 @@ cvar_t	r_shadows = {"r_shadows","0",CVAR_ARCHIVE};
 cvar_t	r_wateralpha = {"r_wateralpha","1",CVAR_ARCHIVE};
 cvar_t	r_litwater = {"r_litwater","1",CVAR_NONE};
 cvar_t	r_dynamic = {"r_dynamic","1",CVAR_ARCHIVE};
+cvar_t	r_dlightfar = {"r_dlightfar","1536",CVAR_ARCHIVE};		// lights further than this are flash blended
+cvar_t	r_dlightshort = {"r_dlightshort","0.2",CVAR_ARCHIVE};	// and so are lights that live less than this
 cvar_t	r_novis = {"r_novis","0",CVAR_ARCHIVE};
 
 cvar_t	gl_finish = {"gl_finish","0",CVAR_NONE};
@@ -733,7 +735,7 @@ void R_ShowBoundingBoxes (void)
 
 	for (i=1, ed=NEXT_EDICT(sv.edicts) ; i<sv.num_edicts ; i++, ed=NEXT_EDICT(ed))
 	{
-		if (ed == sv_player || ed->free)
+		if (ed == sv_player || ed->hot->free)
 			continue; //don't draw player's own bbox or freed edicts
 
 //		if (r_showbboxes.value != 2)
@@ -743,13 +745,13 @@ void R_ShowBoundingBoxes (void)
 		if (ed->v.mins[0] == ed->v.maxs[0] && ed->v.mins[1] == ed->v.maxs[1] && ed->v.mins[2] == ed->v.maxs[2])
 		{
 			//point entity
-			R_EmitWirePoint (ed->v.origin);
+			R_EmitWirePoint (ed->hot->origin);
 		}
 		else
 		{
 			//box entity
-			VectorAdd (ed->v.mins, ed->v.origin, mins);
-			VectorAdd (ed->v.maxs, ed->v.origin, maxs);
+			VectorAdd (ed->v.mins, ed->hot->origin, mins);
+			VectorAdd (ed->v.maxs, ed->hot->origin, maxs);
 			R_EmitWireBox (mins, maxs);
 		}
 	}
@@ -124,6 +124,167 @@ void SCR_ScreenShot_f (void);
 /*
 ===============================================================================
 
+DIRTY RECTANGLES
+
+===============================================================================
+*/
+
+typedef struct
+{
+	unsigned int	signature;	// state the element was last drawn from
+	int			updates;	// if >= vid.numpages, no update needed
+} hudstate_t;
+
+static hudstate_t	scr_hud[NUM_HUD_ELEMENTS];
+static qboolean		scr_hud_fullredraw;	// nothing survives between frames, draw it all
+
+static vrect_t		scr_dirty[MAX_DIRTY_RECTS];
+static int			scr_numdirty;
+
+/*
+==============
+SCR_HudHash
+
+folds one more value into an element signature
+==============
+*/
+unsigned int SCR_HudHash (unsigned int hash, int value)
+{
+	return (hash ^ (unsigned int)value) * 16777619u;
+}
+
+/*
+==============
+SCR_InvalidateHud
+
+forces every tracked element to be redrawn for the next vid.numpages frames
+==============
+*/
+void SCR_InvalidateHud (void)
+{
+	int		i;
+
+	for (i = 0; i < NUM_HUD_ELEMENTS; i++)
+		scr_hud[i].updates = 0;
+}
+
+/*
+==============
+SCR_HudElementDirty
+
+returns true if the element has to be drawn this frame, either because its
+signature changed or because not every page has seen the latest version yet.
+x, y, w, h are in the current canvas, and are added to the dirty list.
+==============
+*/
+qboolean SCR_HudElementDirty (hudelement_t elem, unsigned int signature, int x, int y, int w, int h)
+{
+	hudstate_t	*hud = &scr_hud[elem];
+
+	if (hud->signature != signature)
+	{
+		hud->signature = signature;
+		hud->updates = 0;
+	}
+
+	if (hud->updates >= vid.numpages && !scr_hud_fullredraw)
+		return false;
+	if (hud->updates < vid.numpages)
+		hud->updates++;
+
+	if (GL_CanvasRect (&x, &y, &w, &h))
+		SCR_AddDirtyRect (x, y, w, h);
+	return true;
+}
+
+/*
+==============
+SCR_AddDirtyRect
+
+adds a region of the screen, in pixels, that changed this frame. overlapping
+regions are merged, and if the list fills up everything collapses into one
+bounding rectangle.
+==============
+*/
+void SCR_AddDirtyRect (int x, int y, int w, int h)
+{
+	vrect_t	*r;
+	int		i, x1, y1;
+
+	if (w <= 0 || h <= 0)
+		return;
+
+	for (i = 0, r = scr_dirty; i < scr_numdirty; i++, r++)
+	{
+		if (x > r->x + r->width || x + w < r->x || y > r->y + r->height || y + h < r->y)
+			continue;
+		x1 = q_max (x + w, r->x + r->width);
+		y1 = q_max (y + h, r->y + r->height);
+		r->x = q_min (x, r->x);
+		r->y = q_min (y, r->y);
+		r->width = x1 - r->x;
+		r->height = y1 - r->y;
+		return;
+	}
+
+	if (scr_numdirty == MAX_DIRTY_RECTS)
+	{
+		x1 = x + w;
+		y1 = y + h;
+		for (i = 0, r = scr_dirty; i < scr_numdirty; i++, r++)
+		{
+			x = q_min (x, r->x);
+			y = q_min (y, r->y);
+			x1 = q_max (x1, r->x + r->width);
+			y1 = q_max (y1, r->y + r->height);
+		}
+		scr_numdirty = 0;
+		SCR_AddDirtyRect (x, y, x1 - x, y1 - y);
+		return;
+	}
+
+	r = &scr_dirty[scr_numdirty++];
+	r->x = x;
+	r->y = y;
+	r->width = w;
+	r->height = h;
+}
+
+/*
+==============
+SCR_DirtyRects
+
+returns the regions touched this frame as a linked list, or NULL if the
+screen did not change at all
+==============
+*/
+vrect_t *SCR_DirtyRects (void)
+{
+	int		i;
+
+	if (!scr_numdirty)
+		return NULL;
+	for (i = 0; i < scr_numdirty - 1; i++)
+		scr_dirty[i].pnext = &scr_dirty[i + 1];
+	scr_dirty[i].pnext = NULL;
+	return scr_dirty;
+}
+
+/*
+==============
+SCR_BeginDirtyRects
+==============
+*/
+static void SCR_BeginDirtyRects (void)
+{
+	scr_numdirty = 0;
+	//ericw -- glsl gamma rewrites the whole frame
+	scr_hud_fullredraw = gl_clear.value || (gl_glsl_gamma_able && vid_gamma.value != 1);
+}
+
+/*
+===============================================================================
+
 CENTER PRINTING
 
 ===============================================================================
@@ -286,6 +447,7 @@ static void SCR_CalcRefdef (void)
 
 // force the status bar to redraw
 	Sbar_Changed ();
+	SCR_InvalidateHud ();
 
 	scr_tileclear_updates = 0; //johnfitz
 
@@ -429,6 +591,8 @@ void SCR_Init (void)
 
 	SCR_LoadPics (); //johnfitz
 
+	FB_Init ();
+
 	scr_initialized = true;
 }
 
@@ -713,6 +877,27 @@ void SCR_SetUpToDrawConsole (void)
 		scr_tileclear_updates = 0; //johnfitz
 }
 
+/*
+==================
+SCR_ConsoleChanged
+
+with no world behind it, a full screen console only needs to be redrawn when
+its text, input line or cursor changes. an open menu is drawn on top of it
+every frame, so never trust it then.
+==================
+*/
+static qboolean SCR_ConsoleChanged (void)
+{
+	unsigned int	signature;
+
+	signature = SCR_HudHash (Con_Signature (), (int)scr_con_current);
+	if (key_dest == key_menu)
+		signature = SCR_HudHash (signature, host_framecount);
+
+	GL_SetCanvas (CANVAS_DEFAULT);
+	return SCR_HudElementDirty (HUD_CONSOLE, signature, 0, 0, glwidth, glheight);
+}
+
 /*
 ==================
 SCR_DrawConsole
@@ -988,8 +1173,13 @@ void SCR_TileClear (void)
 	//ericw -- added check for glsl gamma. TODO: remove this ugly optimization?
 	if (scr_tileclear_updates >= vid.numpages && !gl_clear.value && !(gl_glsl_gamma_able && vid_gamma.value != 1))
 		return;
+	if (con_forcedup)
+		return; //hidden under the console, and may be drawn over a skipped one
 	scr_tileclear_updates++;
 
+	// the tiles surround the view, which is dirty every frame anyway
+	SCR_AddDirtyRect (0, 0, glwidth, glheight - sb_lines);
+
 	if (r_refdef.vrect.x > 0)
 	{
 		// left
@@ -1050,6 +1240,7 @@ void SCR_UpdateScreen (void)
 
 
 	GL_BeginRendering (&glx, &gly, &glwidth, &glheight);
+	SCR_BeginDirtyRects ();
 
 	//
 	// determine size of refresh window
@@ -1063,6 +1254,8 @@ void SCR_UpdateScreen (void)
 	SCR_SetUpToDrawConsole ();
 
 	V_RenderView ();
+	if (!con_forcedup)
+		SCR_AddDirtyRect (scr_vrect.x, scr_vrect.y, scr_vrect.width, scr_vrect.height);
 
 	GL_Set2D ();
 
@@ -1092,6 +1285,10 @@ void SCR_UpdateScreen (void)
 		Sbar_FinaleOverlay ();
 		SCR_CheckDrawCenterString ();
 	}
+	else if (con_forcedup && !SCR_ConsoleChanged ())
+	{
+		clearconsole = 0; //nothing on screen changed
+	}
 	else
 	{
 		SCR_DrawCrosshair (); //johnfitz
@@ -1111,6 +1308,8 @@ void SCR_UpdateScreen (void)
 
 	GLSLGamma_GammaCorrect ();
 
+	FB_EndFrame (SCR_DirtyRects ());
+
 	GL_EndRendering ();
 }
 
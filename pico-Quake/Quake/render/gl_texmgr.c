@@ -528,6 +528,8 @@ void TexMgr_LoadPalette (void)
 	memcpy(d_8to24table_conchars, d_8to24table, 256*4);
 	((byte *) &d_8to24table_conchars[0]) [3] = 0;
 
+	FB_SetPalette (d_8to24table);
+
 	Hunk_FreeToLowMark (mark);
 }
 
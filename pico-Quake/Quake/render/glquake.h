@@ -142,6 +142,8 @@ extern	cvar_t	r_telealpha;
 extern	cvar_t	r_slimealpha;
 extern	cvar_t	r_litwater;
 extern	cvar_t	r_dynamic;
+extern	cvar_t	r_dlightfar;
+extern	cvar_t	r_dlightshort;
 extern	cvar_t	r_novis;
 extern	cvar_t	r_scale;
 
@@ -292,6 +294,7 @@ typedef struct {
 	int		dlights;
 } devstats_t;
 extern devstats_t dev_stats, dev_peakstats;
+extern devstats_t sv_devstats, sv_devpeakstats;	// the server frame's packetsize and edicts, copied into dev_stats after it
 
 //ohnfitz -- reduce overflow warning spam
 typedef struct {
@@ -362,6 +365,7 @@ void R_StoreEfrags (efrag_t **ppefrag);
 qboolean R_CullModelForEntity (entity_t *e);
 void R_RotateForEntity (vec3_t origin, vec3_t angles, unsigned char scale);
 void R_MarkLights (dlight_t *light, int num, mnode_t *node);
+qboolean R_FlashBlendLight (dlight_t *light);
 
 void R_InitParticles (void);
 void R_DrawParticles (void);
@@ -381,6 +385,7 @@ void R_DrawTextureChains_Water (qmodel_t *model, entity_t *ent, texchain_t chain
 
 void R_RenderDlights (void);
 void GL_BuildLightmaps (void);
+void R_MarkLightStyle (int style);
 void GL_DeleteBModelVertexBuffer (void);
 void GL_BuildBModelVertexBuffer (void);
 void GLMesh_LoadVertexBuffers (void);
@@ -391,6 +396,7 @@ int R_LightPoint (vec3_t p);
 
 void GL_SubdivideSurface (msurface_t *fa);
 void R_BuildLightMap (msurface_t *surf, byte *dest, int stride);
+void R_BuildLightMapRect (msurface_t *surf, byte *dest, int stride, const int *rect);
 void R_RenderDynamicLightmaps (msurface_t *fa);
 void R_UploadLightmaps (void);
 
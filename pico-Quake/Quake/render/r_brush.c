@@ -39,6 +39,11 @@ static int	last_lightmap_allocated;
 
 static unsigned	blocklights[LMBLOCK_WIDTH*LMBLOCK_HEIGHT*3]; //johnfitz -- was 18*18, added lit support (*3) and loosened surface extents maximum (LMBLOCK_WIDTH*LMBLOCK_HEIGHT)
 
+static qboolean R_DynamicLightRect (msurface_t *surf, int *rect);
+
+// every lightmapped surface, grouped by the lightstyles it uses
+static int			r_stylefirst[257];	// surfaces of style i are r_stylesurfs[r_stylefirst[i] .. r_stylefirst[i+1]-1]
+static msurface_t	**r_stylesurfs;
 
 /*
 ===============
@@ -162,7 +167,8 @@ void R_DrawBrushModel (entity_t *e)
 		for (k=0 ; k<MAX_DLIGHTS ; k++)
 		{
 			if ((cl_dlights[k].die < cl.time) ||
-				(!cl_dlights[k].radius))
+				(!cl_dlights[k].radius) ||
+				R_FlashBlendLight (&cl_dlights[k]))
 				continue;
 
 			R_MarkLights (&cl_dlights[k], k,
@@ -276,6 +282,44 @@ void R_DrawBrushModel_ShowTris (entity_t *e)
 =============================================================
 */
 
+/*
+================
+R_UpdateLightmap
+
+rebuilds the texels of fa inside rect (s0, t0, s1, t1) and marks them for upload
+================
+*/
+static void R_UpdateLightmap (msurface_t *fa, const int *rect)
+{
+	struct lightmap_s *lm = &lightmaps[fa->lightmaptexturenum];
+	glRect_t	*theRect;
+	byte		*base;
+	int			l, t, r, b;
+
+	l = fa->light_s + rect[0];
+	t = fa->light_t + rect[1];
+	r = fa->light_s + rect[2];
+	b = fa->light_t + rect[3];
+
+	lm->modified = true;
+	theRect = &lm->rectchange;
+	if (theRect->w && theRect->h)
+	{
+		r = q_max (r, theRect->l + theRect->w);
+		b = q_max (b, theRect->t + theRect->h);
+		l = q_min (l, theRect->l);
+		t = q_min (t, theRect->t);
+	}
+	theRect->l = l;
+	theRect->t = t;
+	theRect->w = r - l;
+	theRect->h = b - t;
+
+	base = lm->data;
+	base += fa->light_t * LMBLOCK_WIDTH * lightmap_bytes + fa->light_s * lightmap_bytes;
+	R_BuildLightMapRect (fa, base, LMBLOCK_WIDTH*lightmap_bytes, rect);
+}
+
 /*
 ================
 R_RenderDynamicLightmaps
@@ -284,10 +328,7 @@ called during rendering
 */
 void R_RenderDynamicLightmaps (msurface_t *fa)
 {
-	byte		*base;
-	int			maps;
-	glRect_t    *theRect;
-	int smax, tmax;
+	int			rect[4], lit[4];
 
 	if (fa->flags & SURF_DRAWTILED) //johnfitz -- not a lightmapped surface
 		return;
@@ -296,40 +337,46 @@ void R_RenderDynamicLightmaps (msurface_t *fa)
 	fa->polys->chain = lightmaps[fa->lightmaptexturenum].polys;
 	lightmaps[fa->lightmaptexturenum].polys = fa->polys;
 
-	// check for lightmap modification
-	for (maps=0; maps < MAXLIGHTMAPS && fa->styles[maps] != 255; maps++)
-		if (d_lightstylevalue[fa->styles[maps]] != fa->cached_light[maps])
-			goto dynamic;
+	if (!r_dynamic.value)
+		return;
 
+	// check for lightmap modification, R_MarkLightStyle flags the surfaces
+	// of every style that changed value
+	if (fa->stylechanged)
+	{
+		rect[0] = rect[1] = 0;
+		rect[2] = (fa->extents[0]>>4)+1;
+		rect[3] = (fa->extents[1]>>4)+1;
+		R_UpdateLightmap (fa, rect);
+		return;
+	}
+
+	// the static lighting outside the texels a dlight reaches is still in the
+	// lightmap, so only what the lights covered last frame or cover now is redone
 	if (fa->dlightframe == r_framecount	// dynamic this frame
 		|| fa->cached_dlight)			// dynamic previously
 	{
-dynamic:
-		if (r_dynamic.value)
+		rect[0] = fa->dlightrect[0];
+		rect[1] = fa->dlightrect[1];
+		rect[2] = fa->dlightrect[2];
+		rect[3] = fa->dlightrect[3];
+		if (fa->dlightframe == r_framecount && R_DynamicLightRect (fa, lit))
 		{
-			struct lightmap_s *lm = &lightmaps[fa->lightmaptexturenum];
-			lm->modified = true;
-			theRect = &lm->rectchange;
-			if (fa->light_t < theRect->t) {
-				if (theRect->h)
-					theRect->h += theRect->t - fa->light_t;
-				theRect->t = fa->light_t;
-			}
-			if (fa->light_s < theRect->l) {
-				if (theRect->w)
-					theRect->w += theRect->l - fa->light_s;
-				theRect->l = fa->light_s;
+			if (rect[0] < rect[2] && rect[1] < rect[3])
+			{
+				rect[0] = q_min (rect[0], lit[0]);
+				rect[1] = q_min (rect[1], lit[1]);
+				rect[2] = q_max (rect[2], lit[2]);
+				rect[3] = q_max (rect[3], lit[3]);
 			}
-			smax = (fa->extents[0]>>4)+1;
-			tmax = (fa->extents[1]>>4)+1;
-			if ((theRect->w + theRect->l) < (fa->light_s + smax))
-				theRect->w = (fa->light_s-theRect->l)+smax;
-			if ((theRect->h + theRect->t) < (fa->light_t + tmax))
-				theRect->h = (fa->light_t-theRect->t)+tmax;
-			base = lm->data;
-			base += fa->light_t * LMBLOCK_WIDTH * lightmap_bytes + fa->light_s * lightmap_bytes;
-			R_BuildLightMap (fa, base, LMBLOCK_WIDTH*lightmap_bytes);
+			else
+				memcpy (rect, lit, sizeof(rect));
 		}
+
+		if (rect[0] < rect[2] && rect[1] < rect[3])
+			R_UpdateLightmap (fa, rect);
+		else
+			fa->cached_dlight = false;	// marked, but too dim to change anything
 	}
 }
 
@@ -521,6 +568,77 @@ void BuildSurfaceDisplayList (msurface_t *fa)
 		GL_SubdivideSurface (fa);
 }
 
+/*
+==================
+GL_BuildLightStyleIndex
+
+so that a lightstyle changing only has to look at the surfaces that use it
+==================
+*/
+static void GL_BuildLightStyleIndex (void)
+{
+	int			count[256];
+	int			i, j, maps, style;
+	qmodel_t	*m;
+	msurface_t	*surf;
+
+	memset (count, 0, sizeof(count));
+	for (j=1 ; j<MAX_MODELS ; j++)
+	{
+		if (!(m = cl.model_precache[j]))
+			break;
+		if (m->name[0] == '*')
+			continue;
+		for (i=0, surf=m->surfaces ; i<m->numsurfaces ; i++, surf++)
+		{
+			if (surf->flags & SURF_DRAWTILED)
+				continue;
+			for (maps=0 ; maps < MAXLIGHTMAPS && surf->styles[maps] != 255 ; maps++)
+				count[surf->styles[maps]]++;
+		}
+	}
+
+	r_stylefirst[0] = 0;
+	for (i=0 ; i<256 ; i++)
+		r_stylefirst[i+1] = r_stylefirst[i] + count[i];
+
+	free (r_stylesurfs);
+	r_stylesurfs = (msurface_t **) malloc (q_max(r_stylefirst[256], 1) * sizeof(msurface_t *));
+	if (!r_stylesurfs)
+		Sys_Error ("GL_BuildLightStyleIndex: out of memory");
+
+	memcpy (count, r_stylefirst, sizeof(count));
+	for (j=1 ; j<MAX_MODELS ; j++)
+	{
+		if (!(m = cl.model_precache[j]))
+			break;
+		if (m->name[0] == '*')
+			continue;
+		for (i=0, surf=m->surfaces ; i<m->numsurfaces ; i++, surf++)
+		{
+			if (surf->flags & SURF_DRAWTILED)
+				continue;
+			for (maps=0 ; maps < MAXLIGHTMAPS && (style = surf->styles[maps]) != 255 ; maps++)
+				r_stylesurfs[count[style]++] = surf;
+		}
+	}
+}
+
+/*
+==================
+R_MarkLightStyle
+
+called when lightstyle style changes value
+==================
+*/
+void R_MarkLightStyle (int style)
+{
+	int		i;
+
+	for (i = r_stylefirst[style]; i < r_stylefirst[style+1]; i++)
+		r_stylesurfs[i]->stylechanged = true;
+}
+
 /*
 ==================
 GL_BuildLightmaps -- called at level load time
@@ -580,6 +698,8 @@ void GL_BuildLightmaps (void)
 		}
 	}
 
+	GL_BuildLightStyleIndex ();
+
 	//
 	// upload all lightmaps that were filled
 	//
@@ -694,68 +814,144 @@ void GL_BuildBModelVertexBuffer (void)
 	GL_ClearBufferBindings ();
 }
 
+/*
+===============
+R_DlightTexels
+
+finds the texels of surf that dynamic light lnum can reach, as (s0, t0, s1, t1)
+in rect. returns false if it doesn't reach the surface.
+===============
+*/
+static qboolean R_DlightTexels (msurface_t *surf, int lnum, float *local, float *rad, float *minlight, int *rect)
+{
+	dlight_t	*dl = &cl_dlights[lnum];
+	mtexinfo_t	*tex = surf->texinfo;
+	vec3_t		impact;
+	float		dist;
+	int			i, smax, tmax;
+
+	dist = DotProduct (dl->origin, surf->plane->normal) - surf->plane->dist;
+	*rad = dl->radius - fabs(dist);
+	if (*rad < dl->minlight)
+		return false;
+	*minlight = *rad - dl->minlight;
+
+	for (i=0 ; i<3 ; i++)
+		impact[i] = dl->origin[i] - surf->plane->normal[i]*dist;
+
+	local[0] = DotProduct (impact, tex->vecs[0]) + tex->vecs[0][3] - surf->texturemins[0];
+	local[1] = DotProduct (impact, tex->vecs[1]) + tex->vecs[1][3] - surf->texturemins[1];
+
+	// a texel is only lit when both its s and t distance are under minlight
+	smax = (surf->extents[0]>>4)+1;
+	tmax = (surf->extents[1]>>4)+1;
+	rect[0] = CLAMP (0, (int)floor((local[0] - *minlight) / 16), smax);
+	rect[1] = CLAMP (0, (int)floor((local[1] - *minlight) / 16), tmax);
+	rect[2] = CLAMP (0, (int)ceil((local[0] + *minlight) / 16) + 1, smax);
+	rect[3] = CLAMP (0, (int)ceil((local[1] + *minlight) / 16) + 1, tmax);
+
+	return rect[0] < rect[2] && rect[1] < rect[3];
+}
+
+/*
+===============
+R_DynamicLightRect
+
+the texels of surf that any of this frame's dynamic lights reach
+===============
+*/
+static qboolean R_DynamicLightRect (msurface_t *surf, int *rect)
+{
+	int			lnum, texels[4];
+	float		local[2], rad, minlight;
+	qboolean	lit = false;
+
+	for (lnum=0 ; lnum<MAX_DLIGHTS ; lnum++)
+	{
+		if (! (surf->dlightbits[lnum >> 5] & (1U << (lnum & 31))))
+			continue;		// not lit by this light
+		if (!R_DlightTexels (surf, lnum, local, &rad, &minlight, texels))
+			continue;
+
+		if (!lit)
+		{
+			memcpy (rect, texels, sizeof(texels));
+			lit = true;
+			continue;
+		}
+		rect[0] = q_min (rect[0], texels[0]);
+		rect[1] = q_min (rect[1], texels[1]);
+		rect[2] = q_max (rect[2], texels[2]);
+		rect[3] = q_max (rect[3], texels[3]);
+	}
+
+	return lit;
+}
+
 /*
 ===============
 R_AddDynamicLights
+
+adds the dynamic lights to the texels of blocklights inside rect, and records
+the texels they reach in surf->dlightrect
 ===============
 */
-void R_AddDynamicLights (msurface_t *surf)
+void R_AddDynamicLights (msurface_t *surf, const int *rect)
 {
 	int			lnum;
 	int			sd, td;
 	float		dist, rad, minlight;
-	vec3_t		impact, local;
+	float		local[2];
 	int			s, t;
-	int			i;
-	int			smax, tmax;
-	mtexinfo_t	*tex;
+	int			smax;
+	int			texels[4], s0, t0, s1, t1;
 	//johnfitz -- lit support via lordhavoc
 	float		cred, cgreen, cblue, brightness;
 	unsigned	*bl;
 	//johnfitz
 
 	smax = (surf->extents[0]>>4)+1;
-	tmax = (surf->extents[1]>>4)+1;
-	tex = surf->texinfo;
 
 	for (lnum=0 ; lnum<MAX_DLIGHTS ; lnum++)
 	{
 		if (! (surf->dlightbits[lnum >> 5] & (1U << (lnum & 31))))
 			continue;		// not lit by this light
 
-		rad = cl_dlights[lnum].radius;
-		dist = DotProduct (cl_dlights[lnum].origin, surf->plane->normal) -
-				surf->plane->dist;
-		rad -= fabs(dist);
-		minlight = cl_dlights[lnum].minlight;
-		if (rad < minlight)
+		if (!R_DlightTexels (surf, lnum, local, &rad, &minlight, texels))
 			continue;
-		minlight = rad - minlight;
 
-		for (i=0 ; i<3 ; i++)
+		if (surf->dlightrect[0] < surf->dlightrect[2])
 		{
-			impact[i] = cl_dlights[lnum].origin[i] -
-					surf->plane->normal[i]*dist;
+			surf->dlightrect[0] = q_min (surf->dlightrect[0], texels[0]);
+			surf->dlightrect[1] = q_min (surf->dlightrect[1], texels[1]);
+			surf->dlightrect[2] = q_max (surf->dlightrect[2], texels[2]);
+			surf->dlightrect[3] = q_max (surf->dlightrect[3], texels[3]);
+		}
+		else
+		{
+			surf->dlightrect[0] = texels[0];
+			surf->dlightrect[1] = texels[1];
+			surf->dlightrect[2] = texels[2];
+			surf->dlightrect[3] = texels[3];
 		}
 
-		local[0] = DotProduct (impact, tex->vecs[0]) + tex->vecs[0][3];
-		local[1] = DotProduct (impact, tex->vecs[1]) + tex->vecs[1][3];
-
-		local[0] -= surf->texturemins[0];
-		local[1] -= surf->texturemins[1];
+		s0 = q_max (texels[0], rect[0]);
+		t0 = q_max (texels[1], rect[1]);
+		s1 = q_min (texels[2], rect[2]);
+		t1 = q_min (texels[3], rect[3]);
 
 		//johnfitz -- lit support via lordhavoc
-		bl = blocklights;
 		cred = cl_dlights[lnum].color[0] * 256.0f;
 		cgreen = cl_dlights[lnum].color[1] * 256.0f;
 		cblue = cl_dlights[lnum].color[2] * 256.0f;
 		//johnfitz
-		for (t = 0 ; t<tmax ; t++)
+		for (t = t0 ; t<t1 ; t++)
 		{
 			td = local[1] - t*16;
 			if (td < 0)
 				td = -td;
-			for (s=0 ; s<smax ; s++)
+			bl = blocklights + (t*smax + s0)*3;
+			for (s=s0 ; s<s1 ; s++)
 			{
 				sd = local[0] - s*16;
 				if (sd < 0)
@@ -782,12 +978,13 @@ void R_AddDynamicLights (msurface_t *surf)
 
 /*
 ===============
-R_BuildLightMap -- johnfitz -- revised for lit support via lordhavoc
+R_BuildLightMapRect -- johnfitz -- revised for lit support via lordhavoc
 
-Combine and scale multiple lightmaps into the 8.8 format in blocklights
+Combine and scale multiple lightmaps into the 8.8 format in blocklights.
+Only the texels inside rect (s0, t0, s1, t1) are rebuilt and stored.
 ===============
 */
-void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
+void R_BuildLightMapRect (msurface_t *surf, byte *dest, int stride, const int *rect)
 {
 	const int overbright = !!gl_overbright.value;
 	const int wide10bits = !!r_lightmapwide.value;
@@ -795,25 +992,32 @@ void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 	int			smax, tmax;
 	unsigned		r, g, b;
 	int			i, j, size;
+	int			s0, t0, w;
 	byte		*lightmap;
 	unsigned	scale;
 	int			maps;
 	unsigned	*bl;
 
-	surf->cached_dlight = (surf->dlightframe == r_framecount);
+	surf->dlightrect[0] = surf->dlightrect[1] = surf->dlightrect[2] = surf->dlightrect[3] = 0;
 
 	smax = (surf->extents[0]>>4)+1;
 	tmax = (surf->extents[1]>>4)+1;
 	size = smax*tmax;
-	lightmap = surf->samples;
+	s0 = rect[0];
+	t0 = rect[1];
+	w = rect[2] - rect[0];
+
+	if (!s0 && !t0 && w == smax && rect[3] == tmax)
+		surf->stylechanged = false;	// a whole rebuild picks up the current style values
 
 	if (cl.worldmodel->lightdata)
 	{
 	// clear to no light
-		memset (&blocklights[0], 0, size * 3 * sizeof (unsigned int)); //johnfitz -- lit support via lordhavoc
+		for (i=t0 ; i<rect[3] ; i++)
+			memset (&blocklights[(i*smax + s0)*3], 0, w * 3 * sizeof (unsigned int)); //johnfitz -- lit support via lordhavoc
 
 	// add all the lightmaps
-		if (lightmap)
+		if (surf->samples)
 		{
 			for (maps = 0 ; maps < MAXLIGHTMAPS && surf->styles[maps] != 255 ;
 				 maps++)
@@ -821,12 +1025,16 @@ void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 				scale = d_lightstylevalue[surf->styles[maps]];
 				surf->cached_light[maps] = scale;	// 8.8 fraction
 				//johnfitz -- lit support via lordhavoc
-				bl = blocklights;
-				for (i=0 ; i<size ; i++)
+				for (i=t0 ; i<rect[3] ; i++)
 				{
-					*bl++ += *lightmap++ * scale;
-					*bl++ += *lightmap++ * scale;
-					*bl++ += *lightmap++ * scale;
+					bl = blocklights + (i*smax + s0)*3;
+					lightmap = surf->samples + (maps*size + i*smax + s0)*3;
+					for (j=0 ; j<w ; j++)
+					{
+						*bl++ += *lightmap++ * scale;
+						*bl++ += *lightmap++ * scale;
+						*bl++ += *lightmap++ * scale;
+					}
 				}
 				//johnfitz
 			}
@@ -834,24 +1042,28 @@ void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 
 	// add all the dynamic lights
 		if (surf->dlightframe == r_framecount)
-			R_AddDynamicLights (surf);
+			R_AddDynamicLights (surf, rect);
 	}
 	else
 	{
 	// set to full bright if no light data
-		memset (&blocklights[0], 255, size * 3 * sizeof (unsigned int)); //johnfitz -- lit support via lordhavoc
+		for (i=t0 ; i<rect[3] ; i++)
+			memset (&blocklights[(i*smax + s0)*3], 255, w * 3 * sizeof (unsigned int)); //johnfitz -- lit support via lordhavoc
 	}
 
+	surf->cached_dlight = (surf->dlightrect[0] < surf->dlightrect[2]);
+
 // bound, invert, and shift
 // store:
+	dest += t0 * stride + s0 * 4;
 	switch (gl_lightmap_format)
 	{
 	case GL_RGBA:
-		stride -= smax * 4;
-		bl = blocklights;
-		for (i=0 ; i<tmax ; i++, dest += stride)
+		stride -= w * 4;
+		for (i=t0 ; i<rect[3] ; i++, dest += stride)
 		{
-			for (j=0 ; j<smax ; j++)
+			bl = blocklights + (i*smax + s0)*3;
+			for (j=0 ; j<w ; j++)
 			{
 				if (overbright)
 				{
@@ -892,11 +1104,11 @@ void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 		}
 		break;
 	case GL_BGRA:
-		stride -= smax * 4;
-		bl = blocklights;
-		for (i=0 ; i<tmax ; i++, dest += stride)
+		stride -= w * 4;
+		for (i=t0 ; i<rect[3] ; i++, dest += stride)
 		{
-			for (j=0 ; j<smax ; j++)
+			bl = blocklights + (i*smax + s0)*3;
+			for (j=0 ; j<w ; j++)
 			{
 				if (overbright)
 				{
@@ -941,6 +1153,23 @@ void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 	}
 }
 
+/*
+===============
+R_BuildLightMap
+
+rebuilds the whole lightmap of surf
+===============
+*/
+void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
+{
+	int		rect[4];
+
+	rect[0] = rect[1] = 0;
+	rect[2] = (surf->extents[0]>>4)+1;
+	rect[3] = (surf->extents[1]>>4)+1;
+	R_BuildLightMapRect (surf, dest, stride, rect);
+}
+
 /*
 ===============
 R_UploadLightmap -- johnfitz -- uploads the modified lightmap to opengl if necessary
@@ -960,8 +1189,11 @@ static void R_UploadLightmap(int lmap)
 
 	lm->modified = false;
 
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, lm->rectchange.t, LMBLOCK_WIDTH, lm->rectchange.h, gl_lightmap_format,
-			type, lm->data + lm->rectchange.t*LMBLOCK_WIDTH*lightmap_bytes);
+	// send only the columns that changed
+	glPixelStorei (GL_UNPACK_ROW_LENGTH, LMBLOCK_WIDTH);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, lm->rectchange.l, lm->rectchange.t, lm->rectchange.w, lm->rectchange.h, gl_lightmap_format,
+			type, lm->data + (lm->rectchange.t*LMBLOCK_WIDTH + lm->rectchange.l)*lightmap_bytes);
+	glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
 	lm->rectchange.l = LMBLOCK_WIDTH;
 	lm->rectchange.t = LMBLOCK_HEIGHT;
 	lm->rectchange.h = 0;
@@ -26,7 +26,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 extern cvar_t gl_fullbrights, r_drawflat, gl_overbright, r_oldwater, r_oldskyleaf, r_showtris; //johnfitz
 
-byte *SV_FatPVS (vec3_t org, qmodel_t *worldmodel);
+byte *SV_FatPVSNoCache (vec3_t org, qmodel_t *worldmodel, byte *dest, byte *row);
+
+static byte	*r_vis;		// two pvs rows, the renderer's own
+static int	r_vis_capacity;
 
 //==============================================================================
 //
@@ -112,12 +115,20 @@ void R_MarkSurfaces (void)
 			nearwaterportal = true;
 
 	// choose vis data
+	i = (cl.worldmodel->numleafs+7)>>3;
+	if (r_vis == NULL || 2*i > r_vis_capacity)
+	{
+		r_vis_capacity = 2*i;
+		r_vis = (byte *) realloc (r_vis, r_vis_capacity);
+		if (!r_vis)
+			Sys_Error ("R_MarkSurfaces: realloc() failed on %d bytes", r_vis_capacity);
+	}
 	if (r_novis.value || r_viewleaf->contents == CONTENTS_SOLID || r_viewleaf->contents == CONTENTS_SKY)
 		vis = Mod_NoVisPVS (cl.worldmodel);
 	else if (nearwaterportal)
-		vis = SV_FatPVS (r_origin, cl.worldmodel);
+		vis = SV_FatPVSNoCache (r_origin, cl.worldmodel, r_vis, r_vis + i);
 	else
-		vis = Mod_LeafPVS (r_viewleaf, cl.worldmodel);
+		vis = Mod_LeafPVS (r_viewleaf, cl.worldmodel, r_vis);
 
 	r_visframecount++;
 
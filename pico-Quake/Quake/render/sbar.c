@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 
 static int		sb_updates;		// if >= vid.numpages, no update needed
+static qboolean	sb_full;		// whole bar is being redrawn this frame
 
 #define STAT_MINUS		10	// num frame for '-' stats digit
 
@@ -557,9 +558,6 @@ void Sbar_DrawInventory (void)
 				flashon = (flashon%5) + 2;
 
 			Sbar_DrawPic (i*24, -16, sb_weapons[flashon][i]);
-
-			if (flashon > 1)
-				sb_updates = 0;		// force update to remove flash
 		}
 	}
 
@@ -614,9 +612,6 @@ void Sbar_DrawInventory (void)
 				}
 				else
 					Sbar_DrawPic (176 + (i*24), -16, hsb_weapons[flashon][i]);
-
-				if (flashon > 1)
-					sb_updates = 0;	// force update to remove flash
 			}
 		}
 	}
@@ -669,8 +664,6 @@ void Sbar_DrawInventory (void)
 					Sbar_DrawPic (192 + i*16, -16, sb_items[i]);
 				}
 			}
-			if (time && time > cl.time - 2)
-				sb_updates = 0;
 		}
 	}
 	//MED 01/04/97 added hipnotic items
@@ -690,8 +683,6 @@ void Sbar_DrawInventory (void)
 				{
 					Sbar_DrawPic (288 + i*16, -16, hsb_items[i]);
 				}
-				if (time && time > cl.time - 2)
-					sb_updates = 0;
 			}
 		}
 	}
@@ -712,8 +703,6 @@ void Sbar_DrawInventory (void)
 				{
 					Sbar_DrawPic (288 + i*16, -16, rsb_items[i]);
 				}
-				if (time && time > cl.time - 2)
-					sb_updates = 0;
 			}
 		}
 	}
@@ -731,8 +720,6 @@ void Sbar_DrawInventory (void)
 				}
 				else
 					Sbar_DrawPic (320-32 + i*8, -16, sb_sigil[i]);
-				if (time && time > cl.time - 2)
-					sb_updates = 0;
 			}
 		}
 	}
@@ -878,18 +865,186 @@ void Sbar_DrawFace (void)
 		f = 0;
 
 	if (cl.time <= cl.faceanimtime)
-	{
 		anim = 1;
-		sb_updates = 0;		// make sure the anim gets drawn over
-	}
 	else
 		anim = 0;
 	Sbar_DrawPic (112, 0, sb_faces[f][anim]);
 }
 
+/*
+===============
+Sbar_ElementDirty
+
+per-element half of the sbar update logic. while the whole bar is being
+redrawn every element is drawn, otherwise only the ones whose signature
+changed are, after restoring the piece of sb_sbar underneath them.
+===============
+*/
+static qboolean Sbar_ElementDirty (hudelement_t elem, unsigned int signature, int x, int y, int w, int h)
+{
+	if (!SCR_HudElementDirty (elem, signature, x, y + 24, w, h) && !sb_full)
+		return false;
+
+	if (!sb_full && y >= 0)
+		Draw_SubPic (x, y + 24, sb_sbar, x, y, w, h);
+	return true;
+}
+
+/*
+===============
+Sbar_InventorySignature
+===============
+*/
+static unsigned int Sbar_InventorySignature (void)
+{
+	unsigned int	signature;
+	int		i;
+
+	signature = SCR_HudHash (cl.items, cl.stats[STAT_ACTIVEWEAPON]);
+	for (i = 0; i < 4; i++)
+		signature = SCR_HudHash (signature, cl.stats[STAT_SHELLS+i]);
+
+	// anything picked up in the last two seconds may be flashing, so keep
+	// the signature ticking at the flash rate until it settles
+	for (i = 0; i < 32; i++)
+	{
+		if (cl.item_gettime[i] && cl.item_gettime[i] > cl.time - 2)
+		{
+			signature = SCR_HudHash (signature, (int)(cl.time*10));
+			break;
+		}
+	}
+
+	if (cl.maxclients != 1)
+	{
+		for (i = 0; i < cl.maxclients; i++)
+		{
+			signature = SCR_HudHash (signature, cl.scores[i].frags);
+			signature = SCR_HudHash (signature, cl.scores[i].colors);
+		}
+	}
+
+	return signature;
+}
+
+/*
+===============
+Sbar_FaceSignature
+===============
+*/
+static unsigned int Sbar_FaceSignature (void)
+{
+	unsigned int	signature;
+
+	signature = SCR_HudHash (cl.items & (IT_INVISIBILITY | IT_INVULNERABILITY | IT_QUAD), cl.stats[STAT_HEALTH] / 20);
+	signature = SCR_HudHash (signature, cl.time <= cl.faceanimtime);
+	if (rogue && cl.maxclients != 1) // team color swatch
+	{
+		signature = SCR_HudHash (signature, cl.scores[cl.viewentity - 1].frags);
+		signature = SCR_HudHash (signature, cl.scores[cl.viewentity - 1].colors);
+	}
+
+	return signature;
+}
+
+/*
+===============
+Sbar_DrawArmor
+===============
+*/
+static void Sbar_DrawArmor (void)
+{
+	if (cl.items & IT_INVULNERABILITY)
+	{
+		Sbar_DrawNum (24, 0, 666, 3, 1);
+		Sbar_DrawPic (0, 0, draw_disc);
+	}
+	else
+	{
+		if (rogue)
+		{
+			Sbar_DrawNum (24, 0, cl.stats[STAT_ARMOR], 3,
+							cl.stats[STAT_ARMOR] <= 25);
+			if (cl.items & RIT_ARMOR3)
+				Sbar_DrawPic (0, 0, sb_armor[2]);
+			else if (cl.items & RIT_ARMOR2)
+				Sbar_DrawPic (0, 0, sb_armor[1]);
+			else if (cl.items & RIT_ARMOR1)
+				Sbar_DrawPic (0, 0, sb_armor[0]);
+		}
+		else
+		{
+			Sbar_DrawNum (24, 0, cl.stats[STAT_ARMOR], 3
+			, cl.stats[STAT_ARMOR] <= 25);
+			if (cl.items & IT_ARMOR3)
+				Sbar_DrawPic (0, 0, sb_armor[2]);
+			else if (cl.items & IT_ARMOR2)
+				Sbar_DrawPic (0, 0, sb_armor[1]);
+			else if (cl.items & IT_ARMOR1)
+				Sbar_DrawPic (0, 0, sb_armor[0]);
+		}
+	}
+}
+
+/*
+===============
+Sbar_DrawAmmo
+===============
+*/
+static void Sbar_DrawAmmo (void)
+{
+// keys (hipnotic only)
+	//MED 01/04/97 moved keys here so they would not be overwritten
+	if (hipnotic)
+	{
+		if (cl.items & IT_KEY1)
+			Sbar_DrawPic (209, 3, sb_items[0]);
+		if (cl.items & IT_KEY2)
+			Sbar_DrawPic (209, 12, sb_items[1]);
+	}
+
+// ammo icon
+	if (rogue)
+	{
+		if (cl.items & RIT_SHELLS)
+			Sbar_DrawPic (224, 0, sb_ammo[0]);
+		else if (cl.items & RIT_NAILS)
+			Sbar_DrawPic (224, 0, sb_ammo[1]);
+		else if (cl.items & RIT_ROCKETS)
+			Sbar_DrawPic (224, 0, sb_ammo[2]);
+		else if (cl.items & RIT_CELLS)
+			Sbar_DrawPic (224, 0, sb_ammo[3]);
+		else if (cl.items & RIT_LAVA_NAILS)
+			Sbar_DrawPic (224, 0, rsb_ammo[0]);
+		else if (cl.items & RIT_PLASMA_AMMO)
+			Sbar_DrawPic (224, 0, rsb_ammo[1]);
+		else if (cl.items & RIT_MULTI_ROCKETS)
+			Sbar_DrawPic (224, 0, rsb_ammo[2]);
+	}
+	else
+	{
+		if (cl.items & IT_SHELLS)
+			Sbar_DrawPic (224, 0, sb_ammo[0]);
+		else if (cl.items & IT_NAILS)
+			Sbar_DrawPic (224, 0, sb_ammo[1]);
+		else if (cl.items & IT_ROCKETS)
+			Sbar_DrawPic (224, 0, sb_ammo[2]);
+		else if (cl.items & IT_CELLS)
+			Sbar_DrawPic (224, 0, sb_ammo[3]);
+	}
+
+	Sbar_DrawNum (248, 0, cl.stats[STAT_AMMO], 3,
+				  cl.stats[STAT_AMMO] <= 10);
+}
+
 /*
 ===============
 Sbar_Draw
+
+the whole bar is redrawn for vid.numpages frames after Sbar_Changed, or every
+frame if nothing survives between frames. the rest of the time only the
+elements whose stats changed are redrawn, so an idle bar costs a handful of
+compares.
 ===============
 */
 void Sbar_Draw (void)
@@ -902,37 +1057,43 @@ void Sbar_Draw (void)
 	if (cl.intermission)
 		return; //johnfitz -- never draw sbar during intermission
 
-	if (sb_updates >= vid.numpages && !gl_clear.value && scr_sbaralpha.value >= 1 //johnfitz -- gl_clear, scr_sbaralpha
-        && !(gl_glsl_gamma_able && vid_gamma.value != 1))                         //ericw -- must draw sbar every frame if doing glsl gamma
-		return;
+	sb_full = sb_updates < vid.numpages || gl_clear.value || scr_sbaralpha.value < 1 //johnfitz -- gl_clear, scr_sbaralpha
+		|| (gl_glsl_gamma_able && vid_gamma.value != 1);                          //ericw -- must draw sbar every frame if doing glsl gamma
 
-	sb_updates++;
+	if (sb_full)
+	{
+		sb_updates++;
 
-	GL_SetCanvas (CANVAS_DEFAULT); //johnfitz
+		GL_SetCanvas (CANVAS_DEFAULT); //johnfitz
+		SCR_AddDirtyRect (0, glheight - sb_lines, glwidth, sb_lines);
 
-	//johnfitz -- don't waste fillrate by clearing the area behind the sbar
-	w = CLAMP (320.0f, scr_sbarscale.value * 320.0f, (float)glwidth);
-	if (sb_lines && glwidth > w)
-	{
-		if (scr_sbaralpha.value < 1)
-			Draw_TileClear (0, glheight - sb_lines, glwidth, sb_lines);
-		if (cl.gametype == GAME_DEATHMATCH)
-			Draw_TileClear (w, glheight - sb_lines, glwidth - w, sb_lines);
-		else
+		//johnfitz -- don't waste fillrate by clearing the area behind the sbar
+		w = CLAMP (320.0f, scr_sbarscale.value * 320.0f, (float)glwidth);
+		if (sb_lines && glwidth > w)
 		{
-			Draw_TileClear (0, glheight - sb_lines, (glwidth - w) / 2.0f, sb_lines);
-			Draw_TileClear ((glwidth - w) / 2.0f + w, glheight - sb_lines, (glwidth - w) / 2.0f, sb_lines);
+			if (scr_sbaralpha.value < 1)
+				Draw_TileClear (0, glheight - sb_lines, glwidth, sb_lines);
+			if (cl.gametype == GAME_DEATHMATCH)
+				Draw_TileClear (w, glheight - sb_lines, glwidth - w, sb_lines);
+			else
+			{
+				Draw_TileClear (0, glheight - sb_lines, (glwidth - w) / 2.0f, sb_lines);
+				Draw_TileClear ((glwidth - w) / 2.0f + w, glheight - sb_lines, (glwidth - w) / 2.0f, sb_lines);
+			}
 		}
+		//johnfitz
 	}
-	//johnfitz
 
 	GL_SetCanvas (CANVAS_SBAR); //johnfitz
 
 	if (scr_viewsize.value < 110) //johnfitz -- check viewsize instead of sb_lines
 	{
-		Sbar_DrawInventory ();
-		if (cl.maxclients != 1)
-			Sbar_DrawFrags ();
+		if (Sbar_ElementDirty (HUD_INVENTORY, Sbar_InventorySignature (), 0, -24, 320, 24))
+		{
+			Sbar_DrawInventory ();
+			if (cl.maxclients != 1)
+				Sbar_DrawFrags ();
+		}
 	}
 
 	if (sb_showscores || cl.stats[STAT_HEALTH] <= 0)
@@ -943,92 +1104,29 @@ void Sbar_Draw (void)
 	}
 	else if (scr_viewsize.value < 120) //johnfitz -- check viewsize instead of sb_lines
 	{
-		Sbar_DrawPicAlpha (0, 0, sb_sbar, scr_sbaralpha.value); //johnfitz -- scr_sbaralpha
+		if (sb_full)
+			Sbar_DrawPicAlpha (0, 0, sb_sbar, scr_sbaralpha.value); //johnfitz -- scr_sbaralpha
 
-   // keys (hipnotic only)
-		//MED 01/04/97 moved keys here so they would not be overwritten
-		if (hipnotic)
-		{
-			if (cl.items & IT_KEY1)
-				Sbar_DrawPic (209, 3, sb_items[0]);
-			if (cl.items & IT_KEY2)
-				Sbar_DrawPic (209, 12, sb_items[1]);
-		}
 	// armor
-		if (cl.items & IT_INVULNERABILITY)
-		{
-			Sbar_DrawNum (24, 0, 666, 3, 1);
-			Sbar_DrawPic (0, 0, draw_disc);
-		}
-		else
-		{
-			if (rogue)
-			{
-				Sbar_DrawNum (24, 0, cl.stats[STAT_ARMOR], 3,
-								cl.stats[STAT_ARMOR] <= 25);
-				if (cl.items & RIT_ARMOR3)
-					Sbar_DrawPic (0, 0, sb_armor[2]);
-				else if (cl.items & RIT_ARMOR2)
-					Sbar_DrawPic (0, 0, sb_armor[1]);
-				else if (cl.items & RIT_ARMOR1)
-					Sbar_DrawPic (0, 0, sb_armor[0]);
-			}
-			else
-			{
-				Sbar_DrawNum (24, 0, cl.stats[STAT_ARMOR], 3
-				, cl.stats[STAT_ARMOR] <= 25);
-				if (cl.items & IT_ARMOR3)
-					Sbar_DrawPic (0, 0, sb_armor[2]);
-				else if (cl.items & IT_ARMOR2)
-					Sbar_DrawPic (0, 0, sb_armor[1]);
-				else if (cl.items & IT_ARMOR1)
-					Sbar_DrawPic (0, 0, sb_armor[0]);
-			}
-		}
+		if (Sbar_ElementDirty (HUD_ARMOR, SCR_HudHash (cl.items, cl.stats[STAT_ARMOR]), 0, 0, 96, 24))
+			Sbar_DrawArmor ();
 
 	// face
-		Sbar_DrawFace ();
+		if (Sbar_ElementDirty (HUD_FACE, Sbar_FaceSignature (), 112, 0, 24, 24))
+			Sbar_DrawFace ();
 
 	// health
-		Sbar_DrawNum (136, 0, cl.stats[STAT_HEALTH], 3
-		, cl.stats[STAT_HEALTH] <= 25);
-
-	// ammo icon
-		if (rogue)
-		{
-			if (cl.items & RIT_SHELLS)
-				Sbar_DrawPic (224, 0, sb_ammo[0]);
-			else if (cl.items & RIT_NAILS)
-				Sbar_DrawPic (224, 0, sb_ammo[1]);
-			else if (cl.items & RIT_ROCKETS)
-				Sbar_DrawPic (224, 0, sb_ammo[2]);
-			else if (cl.items & RIT_CELLS)
-				Sbar_DrawPic (224, 0, sb_ammo[3]);
-			else if (cl.items & RIT_LAVA_NAILS)
-				Sbar_DrawPic (224, 0, rsb_ammo[0]);
-			else if (cl.items & RIT_PLASMA_AMMO)
-				Sbar_DrawPic (224, 0, rsb_ammo[1]);
-			else if (cl.items & RIT_MULTI_ROCKETS)
-				Sbar_DrawPic (224, 0, rsb_ammo[2]);
-		}
-		else
-		{
-			if (cl.items & IT_SHELLS)
-				Sbar_DrawPic (224, 0, sb_ammo[0]);
-			else if (cl.items & IT_NAILS)
-				Sbar_DrawPic (224, 0, sb_ammo[1]);
-			else if (cl.items & IT_ROCKETS)
-				Sbar_DrawPic (224, 0, sb_ammo[2]);
-			else if (cl.items & IT_CELLS)
-				Sbar_DrawPic (224, 0, sb_ammo[3]);
-		}
+		if (Sbar_ElementDirty (HUD_HEALTH, SCR_HudHash (0, cl.stats[STAT_HEALTH]), 136, 0, 72, 24))
+			Sbar_DrawNum (136, 0, cl.stats[STAT_HEALTH], 3
+			, cl.stats[STAT_HEALTH] <= 25);
 
-		Sbar_DrawNum (248, 0, cl.stats[STAT_AMMO], 3,
-					  cl.stats[STAT_AMMO] <= 10);
+	// keys, ammo icon and count
+		if (Sbar_ElementDirty (HUD_AMMO, SCR_HudHash (cl.items, cl.stats[STAT_AMMO]), 208, 0, 112, 24))
+			Sbar_DrawAmmo ();
 	}
 
 	//johnfitz -- removed the vid.width > 320 check here
-	if (cl.gametype == GAME_DEATHMATCH)
+	if (cl.gametype == GAME_DEATHMATCH && sb_full)
 			Sbar_MiniDeathmatchOverlay ();
 }
 
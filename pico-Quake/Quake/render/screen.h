@@ -81,5 +81,31 @@ extern	cvar_t		scr_crosshairscale;
 
 extern int scr_tileclear_updates; //johnfitz
 
+//
+// dirty rectangles for the 2d overlay
+//
+// each hud element remembers a signature of the state it was last drawn
+// from, and is only redrawn (for the next vid.numpages frames) once that
+// signature changes. every region drawn during a frame is added to the
+// frame's dirty list, in screen pixels, for the video layer to flush.
+//
+typedef enum {
+	HUD_INVENTORY,
+	HUD_ARMOR,
+	HUD_FACE,
+	HUD_HEALTH,
+	HUD_AMMO,
+	HUD_CONSOLE,
+	NUM_HUD_ELEMENTS
+} hudelement_t;
+
+#define	MAX_DIRTY_RECTS	32
+
+unsigned int SCR_HudHash (unsigned int hash, int value);
+qboolean SCR_HudElementDirty (hudelement_t elem, unsigned int signature, int x, int y, int w, int h);
+void SCR_InvalidateHud (void);
+void SCR_AddDirtyRect (int x, int y, int w, int h);
+vrect_t *SCR_DirtyRects (void);
+
 #endif	/* _QUAKE_SCREEN_H */
 
@@ -38,6 +38,16 @@ typedef struct
 
 #define MAX_SIGNON_BUFFERS 256
 
+#define	THINKWHEEL_SLOTS	128		// must be a power of two
+#define	THINKWHEEL_RATE		20		// slots per second
+
+typedef struct
+{
+	qboolean	waiting;			// linked into sv.thinkwheel[slot]
+	int			slot;
+	int			prev, next;			// edict numbers, 0 ends the list
+} edictthink_t;
+
 typedef enum {ss_loading, ss_active} server_state_t;
 
 typedef struct
@@ -64,13 +74,23 @@ typedef struct
 	edict_t		*edicts;			// can NOT be array indexed, because
 									// edict_t is variable sized, but can
 									// be used to reference the world ent
+	edicthot_t	*edicthot;		// max_edicts, by edict number, after the edicts
+	edictleafs_t	*edictleafs;	// max_edicts, by edict number
+	entity_state_t	*baselines;		// max_edicts, by edict number
+
+	unsigned int	*physwake;		// a bit for each edict SV_Physics has to run
+	unsigned int	*netedicts;		// a bit for each edict last linked with a model
+	unsigned int	*baselineedicts;	// a bit for each edict SV_CreateBaseline gave a baseline
+	edictthink_t	*edictthink;	// max_edicts, by edict number
+	int			thinkwheel[THINKWHEEL_SLOTS];	// idle edicts by nextthink
+	int			thinkwheelkey;		// first slot not yet emptied into physwake
 	server_state_t	state;			// some actions are only valid during load
 
-	sizebuf_t	datagram;
-	byte		datagram_buf[MAX_DATAGRAM];
+	sizebuf_t	datagram;			// PROTOCOL_DATAGRAM, from the message pool
 
 	sizebuf_t	reliable_datagram;	// copied to all clients at end of frame
-	byte		reliable_datagram_buf[MAX_DATAGRAM];
+
+	sizebuf_t	clientdatagram;		// where SV_SendClientDatagram builds each one
 
 	sizebuf_t	*signon;
 	int			num_signon_buffers;
@@ -80,6 +100,16 @@ typedef struct
 	unsigned	protocolflags;
 } server_t;
 
+// anything that changes an edict behind QuakeC's back has to wake it, or an
+// idle one won't notice until its nextthink comes
+#define	SV_WakeEdict(n)		(sv.physwake[(n) >> 5] |= 1u << ((n) & 31))
+
+// only these are looked at when the entities are sent to the clients.
+// SV_LinkEdict keeps them up to date: an edict linked without a model gets
+// no pvs leafs, so it can't be seen until it's linked again.
+#define	SV_SetNetEdict(n)	(sv.netedicts[(n) >> 5] |= 1u << ((n) & 31))
+#define	SV_ClearNetEdict(n)	(sv.netedicts[(n) >> 5] &= ~(1u << ((n) & 31)))
+
 
 #define	NUM_PING_TIMES		16
 #define	NUM_SPAWN_PARMS		16
@@ -89,6 +119,7 @@ enum sendsignon_e
 	PRESPAWN_DONE,
 	PRESPAWN_FLUSH=1,
 	PRESPAWN_SIGNONBUFS,
+	PRESPAWN_BASELINES,		// signonidx is the next edict
 	PRESPAWN_SIGNONMSG,
 };
 
@@ -110,7 +141,7 @@ typedef struct client_s
 
 	sizebuf_t		message;			// can be added to at any time,
 										// copied and clear once per frame
-	byte			msgbuf[MAX_MSGLEN];
+										// PROTOCOL_MSGLEN, from the message pool
 	edict_t			*edict;				// EDICT_NUM(clientnum+1)
 	char			name[32];			// for printing to other people
 	int				colors;
@@ -123,9 +154,44 @@ typedef struct client_s
 
 // client known data for deltas
 	int				old_frags;
+
+// PRFL_DELTAENTS
+	qboolean		deltaents;			// has acked, so gets svc_deltaentities
+	int				deltasequence;		// of the last snapshot sent
+	int				deltaack;			// the last one the client has
+	struct deltaframe_s	*deltaframes;	// DELTA_BACKUP, kept when the slot is reused
 } client_t;
 
 
+//=============================================================================
+
+// the entities of the last datagram sent to the local client, which has an
+// svc_localsnapshot where they would have been written. the client applies
+// them from here instead of parsing them out of the message.
+typedef struct
+{
+	qboolean		pending;		// sent and not yet read by the client
+	int				sequence;
+	int				offset;			// of the svc_localsnapshot in the datagram
+	int				numupdates;
+	int				maxupdates;
+	entityupdate_t	*updates;
+} localsnapshot_t;
+
+// the entities of a snapshot sent with svc_deltaentities. the server keeps
+// the last few for each client and the client keeps the ones it got, both
+// by sequence, so a later snapshot can be sent as the changes from one
+// the client acked.
+#define	DELTA_BACKUP	32			// a power of two
+
+typedef struct deltaframe_s
+{
+	int				sequence;		// 0 when empty
+	int				numupdates;		// sorted by entity number
+	int				maxupdates;
+	entityupdate_t	*updates;
+} deltaframe_t;
+
 //=============================================================================
 
 // edict->movetype values
@@ -202,6 +268,9 @@ extern	client_t	*host_client;
 
 extern	edict_t		*sv_player;
 
+extern	localsnapshot_t	sv_snapshot;
+extern	cvar_t			sv_localsnapshot;
+
 //===========================================================
 
 void SV_Init (void);
@@ -221,6 +290,11 @@ int SV_ModelIndex (const char *name);
 
 void SV_SetIdealPitch (void);
 
+// sv_workers.c
+int SV_Workers (void);
+void SV_RunJobs (void (*job) (int index, int worker), int count);
+void SV_ShutdownWorkers (void);
+
 void SV_AddUpdates (void);
 
 void SV_ClientThink (void);
@@ -230,11 +304,14 @@ void SV_ClientPrintf (const char *fmt, ...) FUNC_PRINTF(1,2);
 void SV_BroadcastPrintf (const char *fmt, ...) FUNC_PRINTF(1,2);
 
 void SV_Physics (void);
+void SV_WakeAllEdicts (void);
 
 qboolean SV_CheckBottom (edict_t *ent);
 qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink);
 
 void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg);
+void SV_GrowDeltaFrame (deltaframe_t *frame, int numupdates);
+void SV_ClearDeltaFrames (client_t *client);
 
 void SV_MoveToGoal (void);
 
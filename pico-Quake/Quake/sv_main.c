@@ -30,6 +30,11 @@ static char	localmodels[MAX_MODELS][8];	// inline model names for precache
 
 int		sv_protocol = PROTOCOL_FITZQUAKE; //johnfitz
 
+localsnapshot_t	sv_snapshot;
+
+// hand the local client its entities in sv_snapshot instead of in the message
+cvar_t	sv_localsnapshot = {"sv_localsnapshot", "1", CVAR_NONE};
+
 extern qboolean	pr_alpha_supported; //johnfitz
 extern int pr_effects_mask;
 
@@ -79,6 +84,12 @@ void SV_Init (void)
 	extern	cvar_t	sv_gravity;
 	extern	cvar_t	sv_nostep;
 	extern	cvar_t	sv_freezenonclients;
+	extern	cvar_t	sv_thinkwheel;
+	extern	cvar_t	sv_areasplit;
+	extern	cvar_t	sv_tracecache;
+	extern	cvar_t	sv_fatpvscache;
+	extern	cvar_t	sv_deltaents;
+	extern	cvar_t	sv_threads;
 	extern	cvar_t	sv_friction;
 	extern	cvar_t	sv_edgefriction;
 	extern	cvar_t	sv_stopspeed;
@@ -104,9 +115,18 @@ void SV_Init (void)
 	Cvar_RegisterVariable 	(&sv_aim);
 	Cvar_RegisterVariable 	(&sv_nostep);
 	Cvar_RegisterVariable 	(&sv_freezenonclients);
+	Cvar_RegisterVariable 	(&sv_thinkwheel);
+	Cvar_RegisterVariable 	(&sv_areasplit);
+	Cvar_RegisterVariable 	(&sv_tracecache);
+	Cvar_RegisterVariable 	(&sv_fatpvscache);
+	Cvar_RegisterVariable 	(&sv_deltaents);
+	Cvar_RegisterVariable 	(&sv_threads);
+	Cvar_RegisterVariable 	(&sv_localsnapshot);
 	Cvar_RegisterVariable 	(&sv_altnoclip); //johnfitz
 
 	Cmd_AddCommand ("sv_protocol", &SV_Protocol_f); //johnfitz
+	Cmd_AddCommand ("sv_areastats", SV_AreaStats_f);
+	Cmd_AddCommand ("sv_tracebench", SV_TraceBench_f);
 
 	for (i=0 ; i<MAX_MODELS ; i++)
 		sprintf (localmodels[i], "*%i", i);
@@ -152,7 +172,7 @@ void SV_StartParticle (vec3_t org, vec3_t dir, int color, int count)
 {
 	int		i, v;
 
-	if (sv.datagram.cursize > MAX_DATAGRAM-18)
+	if (sv.datagram.cursize > sv.datagram.maxsize-18)
 		return;
 	MSG_WriteByte 	(&sv.datagram, svc_particle);
 	MSG_WriteCoord 	(&sv.datagram, org[0], sv.protocolflags);
@@ -200,7 +220,7 @@ void SV_StartSound (edict_t *entity, int channel, const char *sample, int volume
 	if (channel < 0 || channel > 7)
 		Host_Error ("SV_StartSound: channel = %i", channel);
 
-	if (sv.datagram.cursize > MAX_DATAGRAM-21)
+	if (sv.datagram.cursize > sv.datagram.maxsize-21)
 		return;
 
 // find precache number for sound
@@ -239,7 +259,7 @@ void SV_StartSound (edict_t *entity, int channel, const char *sample, int volume
 	}
 	//johnfitz
 
-	if (sv.datagram.cursize > MAX_DATAGRAM-21)
+	if (sv.datagram.cursize > sv.datagram.maxsize-21)
 		return;
 
 // directed messages go only to the entity the are targeted on
@@ -265,7 +285,7 @@ void SV_StartSound (edict_t *entity, int channel, const char *sample, int volume
 	//johnfitz
 
 	for (i = 0; i < 3; i++)
-		MSG_WriteCoord (&sv.datagram, entity->v.origin[i]+0.5*(entity->v.mins[i]+entity->v.maxs[i]), sv.protocolflags);
+		MSG_WriteCoord (&sv.datagram, entity->hot->origin[i]+0.5*(entity->v.mins[i]+entity->v.maxs[i]), sv.protocolflags);
 #endif
 }
 
@@ -336,6 +356,13 @@ void SV_SendServerinfo (client_t *client)
 	char			message[2048];
 	int				i; //johnfitz
 
+// size the connection for the protocol, which can change with the level
+	SZ_Resize (&client->message, PROTOCOL_MSGLEN (sv.protocol));
+	NET_SetMessageSize (client->netconnection, NET_MESSAGESIZE (sv.protocol));
+
+// the entity numbers of the last level's snapshots mean nothing now
+	SV_ClearDeltaFrames (client);
+
 	MSG_WriteByte (&client->message, svc_print);
 	sprintf (message, "%c\nFITZQUAKE %1.2f SERVER (%i CRC)\n", 2, FITZQUAKE_VERSION, pr_crc); //johnfitz -- include fitzquake version
 	MSG_WriteString (&client->message,message);
@@ -400,6 +427,8 @@ void SV_ConnectClient (int clientnum)
 	client_t		*client;
 	int				edictnum;
 	qsocket_t	 	*netconnection;
+	sizebuf_t		message;
+	deltaframe_t	*deltaframes;
 	int				i;
 	float			spawn_parms[NUM_SPAWN_PARMS];
 
@@ -413,6 +442,8 @@ void SV_ConnectClient (int clientnum)
 
 // set up the client_t
 	netconnection = client->netconnection;
+	message = client->message;			// keep its buffer
+	deltaframes = client->deltaframes;	// and its snapshots
 
 	if (sv.loadgame)
 		Q_memcpy (spawn_parms, client->spawn_parms, sizeof(spawn_parms));
@@ -423,10 +454,14 @@ void SV_ConnectClient (int clientnum)
 	client->active = true;
 	client->spawned = false;
 	client->edict = ent;
-	client->message.data = client->msgbuf;
-	client->message.maxsize = sizeof(client->msgbuf);
+	client->message = message;
+	SZ_Clear (&client->message);
+	client->deltaframes = deltaframes;
 	client->message.allowoverflow = true;		// we can catch it
 
+	if (SV_IsLocalClient (client))
+		sv_snapshot.pending = false;
+
 	if (sv.loadgame)
 		Q_memcpy (client->spawn_parms, spawn_parms, sizeof(spawn_parms));
 	else
@@ -504,14 +539,36 @@ or other small motion on the client side.  Otherwise, a bob might cause an
 entity that should be visible to not show up, especially when the bob
 crosses a waterline.
 
+The fat PVS only changes when the set of leafs within 8 pixels does, so the
+server keeps the ones it has built for the last few leaf sets, shared by
+every client that stands in the same spot.
+
 =============================================================================
 */
 
-static int	fatbytes;
-static byte	*fatpvs;
-static int	fatpvs_capacity;
+#define	FATPVS_CACHESIZE	64
+#define	FATPVS_MAXLEAFS		16		// more than this near the eye isn't cached
 
-void SV_AddToFatPVS (vec3_t org, mnode_t *node, qmodel_t *worldmodel) //johnfitz -- added worldmodel as a parameter
+typedef struct
+{
+	int		numleafs;				// -1 for an entry that can't be found again
+	int		leafs[FATPVS_MAXLEAFS];	// sorted
+	int		lastused;
+	byte	*pvs;
+} fatpvscache_t;
+
+cvar_t	sv_fatpvscache = {"sv_fatpvscache", "1", CVAR_NONE};
+
+static byte	*fatpvs_row;	// the server's leaf rows are decompressed in here
+static int	fatpvs_row_capacity;
+
+static fatpvscache_t	fatpvscache[FATPVS_CACHESIZE];
+static qmodel_t	*fatpvscache_model;
+static byte		*fatpvscache_data;
+static int		fatpvscache_bytes;
+static int		fatpvscache_sequence;
+
+static void SV_AddToFatPVS (vec3_t org, mnode_t *node, qmodel_t *worldmodel, byte *dest, byte *row, int fatbytes) //johnfitz -- added worldmodel as a parameter
 {
 	int		i;
 	byte	*pvs;
@@ -525,9 +582,9 @@ void SV_AddToFatPVS (vec3_t org, mnode_t *node, qmodel_t *worldmodel) //johnfitz
 		{
 			if (node->contents != CONTENTS_SOLID)
 			{
-				pvs = Mod_LeafPVS ( (mleaf_t *)node, worldmodel); //johnfitz -- worldmodel as a parameter
+				pvs = Mod_LeafPVS ( (mleaf_t *)node, worldmodel, row); //johnfitz -- worldmodel as a parameter
 				for (i=0 ; i<fatbytes ; i++)
-					fatpvs[i] |= pvs[i];
+					dest[i] |= pvs[i];
 			}
 			return;
 		}
@@ -540,34 +597,240 @@ void SV_AddToFatPVS (vec3_t org, mnode_t *node, qmodel_t *worldmodel) //johnfitz
 			node = node->children[1];
 		else
 		{	// go down both
-			SV_AddToFatPVS (org, node->children[0], worldmodel); //johnfitz -- worldmodel as a parameter
+			SV_AddToFatPVS (org, node->children[0], worldmodel, dest, row, fatbytes); //johnfitz -- worldmodel as a parameter
 			node = node->children[1];
 		}
 	}
 }
 
+/*
+=============
+SV_FatPVSLeafs
+
+the leafs SV_AddToFatPVS would take the pvs of. numleafs counts past
+FATPVS_MAXLEAFS, but only that many are kept.
+=============
+*/
+static void SV_FatPVSLeafs (vec3_t org, mnode_t *node, qmodel_t *worldmodel, int *leafs, int *numleafs)
+{
+	mplane_t	*plane;
+	float	d;
+
+	while (1)
+	{
+		if (node->contents < 0)
+		{
+			if (node->contents != CONTENTS_SOLID)
+			{
+				if (*numleafs < FATPVS_MAXLEAFS)
+					leafs[*numleafs] = (mleaf_t *)node - worldmodel->leafs;
+				(*numleafs)++;
+			}
+			return;
+		}
+
+		plane = node->plane;
+		d = DotProduct (org, plane->normal) - plane->dist;
+		if (d > 8)
+			node = node->children[0];
+		else if (d < -8)
+			node = node->children[1];
+		else
+		{	// go down both
+			SV_FatPVSLeafs (org, node->children[0], worldmodel, leafs, numleafs);
+			node = node->children[1];
+		}
+	}
+}
+
+/*
+=============
+SV_ClearFatPVSCache
+
+the cached rows belong to the map they were built from
+=============
+*/
+static void SV_ClearFatPVSCache (void)
+{
+	int		i;
+
+	for (i=0 ; i<FATPVS_CACHESIZE ; i++)
+	{
+		fatpvscache[i].numleafs = -1;
+		fatpvscache[i].lastused = 0;
+	}
+	fatpvscache_model = NULL;
+}
+
+/*
+=============
+SV_FatPVSEntry
+
+the cached fat pvs for the leafs, or the least recently used entry emptied
+for it to be built in. numleafs < 0 is never looked up, it only takes an
+entry, and empty entries have it too.
+=============
+*/
+static fatpvscache_t *SV_FatPVSEntry (qmodel_t *worldmodel, int fatbytes, int *leafs, int numleafs, qboolean *found)
+{
+	fatpvscache_t	*c, *oldest;
+	int		i;
+
+	if (worldmodel != fatpvscache_model || fatbytes > fatpvscache_bytes)
+	{
+		SV_ClearFatPVSCache ();
+		if (fatbytes > fatpvscache_bytes)
+		{
+			fatpvscache_bytes = fatbytes;
+			fatpvscache_data = (byte *) realloc (fatpvscache_data, FATPVS_CACHESIZE * fatpvscache_bytes);
+			if (!fatpvscache_data)
+				Sys_Error ("SV_FatPVS: realloc() failed on %d bytes", FATPVS_CACHESIZE * fatpvscache_bytes);
+		}
+		for (i=0 ; i<FATPVS_CACHESIZE ; i++)
+			fatpvscache[i].pvs = fatpvscache_data + i * fatpvscache_bytes;
+		fatpvscache_model = worldmodel;
+	}
+
+	fatpvscache_sequence++;
+	oldest = fatpvscache;
+	for (i=0, c=fatpvscache ; i<FATPVS_CACHESIZE ; i++, c++)
+	{
+		if (numleafs >= 0 && c->numleafs == numleafs && !memcmp (c->leafs, leafs, numleafs * sizeof(int)))
+		{
+			c->lastused = fatpvscache_sequence;
+			*found = true;
+			return c;
+		}
+		if (c->lastused < oldest->lastused)
+			oldest = c;
+	}
+
+	oldest->numleafs = numleafs;
+	memcpy (oldest->leafs, leafs, q_max (numleafs, 0) * sizeof(int));
+	oldest->lastused = fatpvscache_sequence;
+	*found = false;
+	return oldest;
+}
+
 /*
 =============
 SV_FatPVS
 
 Calculates a PVS that is the inclusive or of all leafs within 8 pixels of the
 given point.
+
+The result is the server's, and stays good until its next call. It comes
+from the cache when the same leafs have been near an eye recently, so it
+must not be written to.
 =============
 */
 byte *SV_FatPVS (vec3_t org, qmodel_t *worldmodel) //johnfitz -- added worldmodel as a parameter
 {
+	int		leafs[FATPVS_MAXLEAFS];
+	int		fatbytes, numleafs, i, j, leaf;
+	byte	*pvs, *row;
+	qboolean	found;
+	fatpvscache_t	*c;
+
 	fatbytes = (worldmodel->numleafs+7)>>3; // ericw -- was +31, assumed to be a bug/typo
-	if (fatpvs == NULL || fatbytes > fatpvs_capacity)
+
+	numleafs = 0;
+	if (sv_fatpvscache.value)
+		SV_FatPVSLeafs (org, worldmodel->nodes, worldmodel, leafs, &numleafs);
+
+	// the order they were found in depends on where in them the eye is
+	if (sv_fatpvscache.value && numleafs <= FATPVS_MAXLEAFS)
 	{
-		fatpvs_capacity = fatbytes;
-		fatpvs = (byte *) realloc (fatpvs, fatpvs_capacity);
-		if (!fatpvs)
-			Sys_Error ("SV_FatPVS: realloc() failed on %d bytes", fatpvs_capacity);
+		for (i=1 ; i<numleafs ; i++)
+		{
+			leaf = leafs[i];
+			for (j=i ; j>0 && leafs[j-1] > leaf ; j--)
+				leafs[j] = leafs[j-1];
+			leafs[j] = leaf;
+		}
 	}
-	
-	Q_memset (fatpvs, 0, fatbytes);
-	SV_AddToFatPVS (org, worldmodel->nodes, worldmodel); //johnfitz -- worldmodel as a parameter
-	return fatpvs;
+	else
+		numleafs = -1;	// takes an entry, but is never found again
+
+	c = SV_FatPVSEntry (worldmodel, fatbytes, leafs, numleafs, &found);
+	if (found)
+		return c->pvs;
+
+	if (fatpvs_row == NULL || fatbytes > fatpvs_row_capacity)
+	{
+		fatpvs_row_capacity = fatbytes;
+		fatpvs_row = (byte *) realloc (fatpvs_row, fatpvs_row_capacity);
+		if (!fatpvs_row)
+			Sys_Error ("SV_FatPVS: realloc() failed on %d bytes", fatpvs_row_capacity);
+	}
+
+	Q_memset (c->pvs, 0, fatpvscache_bytes);
+	if (numleafs < 0)
+	{
+		SV_AddToFatPVS (org, worldmodel->nodes, worldmodel, c->pvs, fatpvs_row, fatbytes);
+		return c->pvs;
+	}
+	for (i=0 ; i<numleafs ; i++)
+	{
+		row = Mod_LeafPVS (worldmodel->leafs + leafs[i], worldmodel, fatpvs_row);
+		pvs = c->pvs;
+		for (j=0 ; j<fatbytes ; j++)
+			pvs[j] |= row[j];
+	}
+	return c->pvs;
+}
+
+/*
+=============
+SV_FatPVSNoCache
+
+built every time into dest, with the leaf rows decompressed into row, both
+(numleafs+7)>>3 bytes and the caller's. touches nothing of the server's, so
+the renderer can call it while a pipelined server frame runs.
+=============
+*/
+byte *SV_FatPVSNoCache (vec3_t org, qmodel_t *worldmodel, byte *dest, byte *row)
+{
+	int		bytes;
+
+	bytes = (worldmodel->numleafs+7)>>3;
+	Q_memset (dest, 0, bytes);
+	SV_AddToFatPVS (org, worldmodel->nodes, worldmodel, dest, row, bytes); //johnfitz -- worldmodel as a parameter
+	return dest;
+}
+
+/*
+=============
+SV_LeafsInPVS
+
+pvs is a packed row, (numleafs+7)>>3 bytes. the words of an edict in many
+leafs are read from it unaligned, and none runs past its end.
+=============
+*/
+static qboolean SV_LeafsInPVS (edictleafs_t *leafs, byte *pvs)
+{
+	int		i, leafnum;
+	unsigned int	bits;
+
+	if (leafs->num_pvswords)
+	{
+		for (i=0 ; i < leafs->num_pvswords ; i++)
+		{
+			memcpy (&bits, pvs + leafs->u.pvswords[i].ofs, sizeof(bits));
+			if (bits & leafs->u.pvswords[i].mask)
+				return true;
+		}
+		return false;
+	}
+
+	for (i=0 ; i < leafs->num_leafs ; i++)
+	{
+		leafnum = leafs->u.leafnums[i];
+		if (pvs[leafnum >> 3] & (1 << (leafnum & 7)))
+			return true;
+	}
+
+	return false;
 }
 
 /*
@@ -581,225 +844,505 @@ qboolean SV_VisibleToClient (edict_t *client, edict_t *test, qmodel_t *worldmode
 {
 	byte	*pvs;
 	vec3_t	org;
-	int		i;
 
-	VectorAdd (client->v.origin, client->v.view_ofs, org);
+	VectorAdd (client->hot->origin, client->v.view_ofs, org);
 	pvs = SV_FatPVS (org, worldmodel);
 
-	for (i=0 ; i < test->num_leafs ; i++)
-		if (pvs[test->leafnums[i] >> 3] & (1 << (test->leafnums[i]&7) ))
-			return true;
-
-	return false;
+	return SV_LeafsInPVS (&sv.edictleafs[NUM_FOR_EDICT(test)], pvs);
 }
 
 //=============================================================================
 
 /*
 =============
-SV_WriteEntitiesToClient
+SV_GrowUpdates
+
+room in updates for an update for every edict in use, grown geometrically
+as sv.num_edicts rises
 =============
 */
-void SV_WriteEntitiesToClient (edict_t	*clent, sizebuf_t *msg)
+static void SV_GrowUpdates (entityupdate_t **updates, int *maxupdates)
+{
+	if (*updates && *maxupdates >= sv.num_edicts)
+		return;
+
+	*maxupdates = q_max (sv.num_edicts, *maxupdates * 2);
+	*updates = (entityupdate_t *) realloc (*updates, *maxupdates * sizeof(entityupdate_t));
+	if (!*updates)
+		Sys_Error ("SV_GrowUpdates: realloc() failed on %d updates", *maxupdates);
+}
+
+/*
+=============
+SV_ClientPVS
+=============
+*/
+static byte *SV_ClientPVS (edict_t *clent)
 {
-	int		e, i;
-	int		bits;
-	byte	*pvs;
 	vec3_t	org;
-	float	miss;
+
+	VectorAdd (clent->hot->origin, clent->v.view_ofs, org);
+	return SV_FatPVS (org, sv.worldmodel);
+}
+
+/*
+=============
+SV_PrepareEntities
+
+Works out the fields SV_BuildEntityUpdates reads that the progs don't set
+directly. That's once a frame rather than once for every client that sees
+the entity, and leaves the edicts read only while the clients' datagrams
+are built.
+=============
+*/
+static void SV_PrepareEntities (void)
+{
+	int		e, word, numwords;
+	unsigned int	netbits;
 	edict_t	*ent;
 	eval_t	*val;
 
-// find the client's PVS
-	VectorAdd (clent->v.origin, clent->v.view_ofs, org);
-	pvs = SV_FatPVS (org, sv.worldmodel);
-
-// send over all entities (excpet the client) that touch the pvs
-	ent = NEXT_EDICT(sv.edicts);
-	for (e=1 ; e<sv.num_edicts ; e++, ent = NEXT_EDICT(ent))
+	numwords = (sv.num_edicts + 31) >> 5;
+	for (word=0 ; word<numwords ; word++)
 	{
+		netbits = sv.netedicts[word];
+		if (!word)	// the clients are sent even without a model. MAX_SCOREBOARD is under 32
+			netbits |= (2u << svs.maxclients) - 2;
+		for (e = word << 5 ; netbits && e < sv.num_edicts ; e++, netbits >>= 1)
+		{
+			if (!(netbits & 1))
+				continue;
+			ent = EDICT_NUM(e);
 
-		if (ent != clent)	// clent is ALLWAYS sent
+			//johnfitz -- alpha
+			if (pr_alpha_supported)
+			{
+				// TODO: find a cleaner place to put this code
+				val = GetEdictFieldOfs(ent, pr_extfields.alpha);
+				if (val)
+					ent->alpha = ENTALPHA_ENCODE(val->_float);
+			}
+			//johnfitz
+
+			val = GetEdictFieldOfs(ent, pr_extfields.scale);
+			if (val)
+				ent->scale = ENTSCALE_ENCODE(val->_float);
+			else
+				ent->scale = ENTSCALE_DEFAULT;
+		}
+	}
+}
+
+/*
+=============
+SV_BuildEntityUpdates
+
+the updates the client gets for every entity it can see in pvs, returning
+how many there are. only reads the edicts, so it can run on a worker.
+=============
+*/
+static int SV_BuildEntityUpdates (edict_t *clent, byte *pvs, entityupdate_t *updates)
+{
+	int		e, i;
+	int		bits;
+	int		clentnum, word, numwords;
+	unsigned int	netbits;
+	float	miss;
+	edict_t	*ent;
+	edictleafs_t	*leafs;
+	entity_state_t	*baseline;
+	entityupdate_t	*u;
+
+// send over all entities (excpet the client) that touch the pvs. only the
+// edicts linked with a model can, so the rest are skipped a word at a time
+// without being touched
+	u = updates;
+	clentnum = NUM_FOR_EDICT(clent);
+	numwords = (sv.num_edicts + 31) >> 5;
+	for (word=0 ; word<numwords ; word++)
+	{
+		netbits = sv.netedicts[word];
+		if (word == clentnum >> 5)
+			netbits |= 1u << (clentnum & 31);
+		if (!word)
+			netbits &= ~1u;		// not the world
+		for (e = word << 5 ; netbits ; e++, netbits >>= 1)
 		{
-			// ignore ents without visible models
-			if (!ent->v.modelindex || !PR_GetString(ent->v.model)[0])
+			if (!(netbits & 1))
 				continue;
+			if (e >= sv.num_edicts)
+				break;
+			ent = EDICT_NUM(e);
+
+			if (ent != clent)	// clent is ALLWAYS sent
+			{
+				// ignore if not touching a PV leaf. this comes first because
+				// it only reads sv.edictleafs, so the edicts that fail it
+				// (most of them) are never touched
+				leafs = &sv.edictleafs[e];
+
+				// ericw -- added ent->num_leafs < MAX_ENT_LEAFS condition.
+				//
+				// if ent->num_leafs == MAX_ENT_LEAFS, the ent is visible from too many leafs
+				// for us to say whether it's in the PVS, so don't try to vis cull it.
+				// this commonly happens with rotators, because they often have huge bboxes
+				// spanning the entire map, or really tall lifts, etc.
+				if (leafs->num_leafs < MAX_ENT_LEAFS && !SV_LeafsInPVS (leafs, pvs))
+					continue;		// not visible
+
+				// ignore ents without visible models
+				if (!ent->v.modelindex || !PR_GetString(ent->v.model)[0])
+					continue;
+
+				//johnfitz -- don't send model>255 entities if protocol is 15
+				if (sv.protocol == PROTOCOL_NETQUAKE && (int)ent->v.modelindex & 0xFF00)
+					continue;
+			}
 
-			//johnfitz -- don't send model>255 entities if protocol is 15
-			if (sv.protocol == PROTOCOL_NETQUAKE && (int)ent->v.modelindex & 0xFF00)
+		// send an update
+			bits = 0;
+			baseline = &sv.baselines[e];
+
+			for (i=0 ; i<3 ; i++)
+			{
+				miss = ent->hot->origin[i] - baseline->origin[i];
+				if ( miss < -0.1 || miss > 0.1 )
+					bits |= U_ORIGIN1<<i;
+			}
+
+			if ( ent->v.angles[0] != baseline->angles[0] )
+				bits |= U_ANGLE1;
+
+			if ( ent->v.angles[1] != baseline->angles[1] )
+				bits |= U_ANGLE2;
+
+			if ( ent->v.angles[2] != baseline->angles[2] )
+				bits |= U_ANGLE3;
+
+			if (ent->hot->movetype == MOVETYPE_STEP)
+				bits |= U_STEP;	// don't mess up the step animation
+
+			if (baseline->colormap != ent->v.colormap)
+				bits |= U_COLORMAP;
+
+			if (baseline->skin != ent->v.skin)
+				bits |= U_SKIN;
+
+			if (baseline->frame != ent->v.frame)
+				bits |= U_FRAME;
+
+			if ((baseline->effects ^ (int)ent->v.effects) & pr_effects_mask)
+				bits |= U_EFFECTS;
+
+			if (baseline->modelindex != ent->v.modelindex)
+				bits |= U_MODEL;
+
+			//johnfitz -- don't send invisible entities unless they have effects
+			if (ent->alpha == ENTALPHA_ZERO && !((int)ent->v.effects & pr_effects_mask))
 				continue;
+			//johnfitz
 
-			// ignore if not touching a PV leaf
-			for (i=0 ; i < ent->num_leafs ; i++)
-				if (pvs[ent->leafnums[i] >> 3] & (1 << (ent->leafnums[i]&7) ))
-					break;
-			
-			// ericw -- added ent->num_leafs < MAX_ENT_LEAFS condition.
-			//
-			// if ent->num_leafs == MAX_ENT_LEAFS, the ent is visible from too many leafs
-			// for us to say whether it's in the PVS, so don't try to vis cull it.
-			// this commonly happens with rotators, because they often have huge bboxes
-			// spanning the entire map, or really tall lifts, etc.
-			if (i == ent->num_leafs && ent->num_leafs < MAX_ENT_LEAFS)
-				continue;		// not visible
+			//johnfitz -- PROTOCOL_FITZQUAKE
+			if (sv.protocol != PROTOCOL_NETQUAKE)
+			{
+				if (baseline->alpha != ent->alpha) bits |= U_ALPHA;
+				if (baseline->scale != ent->scale) bits |= U_SCALE;
+				if (bits & U_FRAME && (int)ent->v.frame & 0xFF00) bits |= U_FRAME2;
+				if (bits & U_MODEL && (int)ent->v.modelindex & 0xFF00) bits |= U_MODEL2;
+				if (ent->sendinterval) bits |= U_LERPFINISH;
+				if (bits >= 65536) bits |= U_EXTEND1;
+				if (bits >= 16777216) bits |= U_EXTEND2;
+			}
+			//johnfitz
+
+			if (e >= 256)
+				bits |= U_LONGENTITY;
+
+			if (bits >= 256)
+				bits |= U_MOREBITS;
+
+			u->num = e;
+			u->bits = bits;
+			u->modelindex = ent->v.modelindex;
+			u->frame = ent->v.frame;
+			u->colormap = (int)ent->v.colormap;
+			u->skin = (int)ent->v.skin;
+			u->effects = (int)ent->v.effects & pr_effects_mask;
+			u->alpha = ent->alpha;
+			u->scale = ent->scale;
+			if (bits & U_LERPFINISH)
+				u->lerpfinish = Q_rint((ent->hot->nextthink-sv.time)*255);
+			VectorCopy (ent->hot->origin, u->origin);
+			VectorCopy (ent->v.angles, u->angles);
+			u++;
 		}
+	}
+
+	return u - updates;
+}
 
+/*
+=============
+SV_WriteEntitiesToClient
+=============
+*/
+typedef struct
+{
+	sizebuf_t	msg;
+	int			msgsize;			// allocated, past the header room
+	byte		*pvs;				// the client's fat pvs
+	qboolean	overflowed;			// some of the entities didn't fit
+	qboolean	built;				// by a worker, for SV_SendClientDatagram
+} clientbuild_t;
+
+static void SV_WriteEntitiesToClient (clientbuild_t *b, edict_t *clent, entityupdate_t *updates)
+{
+	sizebuf_t	*msg = &b->msg;
+	int		i, numupdates;
+
+	numupdates = SV_BuildEntityUpdates (clent, b->pvs, updates);
+
+	for (i=0 ; i<numupdates ; i++)
+	{
 		// johnfitz -- max size for protocol 15 is 18 bytes, not 16 as originally
 		// assumed here.  And, for protocol 85 the max size is actually 24 bytes.
 		// For float coords and angles the limit is 40.
 		// FIXME: Use tighter limit according to protocol flags and send bits.
 		if (msg->cursize + 40 > msg->maxsize)
 		{
-			//johnfitz -- less spammy overflow message
-			if (!dev_overflows.packetsize || dev_overflows.packetsize + CONSOLE_RESPAM_TIME < realtime )
-			{
-				Con_Printf ("Packet overflow!\n");
-				dev_overflows.packetsize = realtime;
-			}
-			goto stats;
-			//johnfitz
+			b->overflowed = true;
+			break;
 		}
 
-// send an update
-		bits = 0;
+		MSG_WriteEntityUpdate (msg, &updates[i], sv.protocolflags);
+	}
+}
+
+/*
+=============
+SV_WriteEntitiesToSnapshot
+
+for the local client, whose updates are left in sv_snapshot and never
+written to the message
+=============
+*/
+static void SV_WriteEntitiesToSnapshot (edict_t *clent, sizebuf_t *msg)
+{
+	SV_GrowUpdates (&sv_snapshot.updates, &sv_snapshot.maxupdates);
+	sv_snapshot.numupdates = SV_BuildEntityUpdates (clent, SV_ClientPVS (clent), sv_snapshot.updates);
+	sv_snapshot.sequence++;
+	sv_snapshot.offset = msg->cursize;
+	sv_snapshot.pending = true;
+
+	MSG_WriteByte (msg, svc_localsnapshot);
+	MSG_WriteLong (msg, sv_snapshot.sequence);
+}
+
+/*
+=============================================================================
+
+DELTA SNAPSHOTS
+
+A client that acks them gets its entities as the changes from the last
+snapshot it acked: the ones that have gone, then an update for each one
+that is new or has changed, from the acked snapshot's state of it or from
+its baseline if it's new. Nothing is sent for the ones that haven't
+changed, so standing entities cost nothing.
+
+=============================================================================
+*/
+
+cvar_t	sv_deltaents = {"sv_deltaents", "0", CVAR_NONE};	// PRFL_DELTAENTS is ours alone, so opt in
+
+/*
+=============
+SV_GrowDeltaFrame
+
+also used by the client for the snapshots it keeps
+=============
+*/
+void SV_GrowDeltaFrame (deltaframe_t *frame, int numupdates)
+{
+	if (frame->updates && frame->maxupdates >= numupdates)
+		return;
+
+	frame->maxupdates = q_max (numupdates, frame->maxupdates * 2);
+	frame->updates = (entityupdate_t *) realloc (frame->updates, frame->maxupdates * sizeof(entityupdate_t));
+	if (!frame->updates)
+		Sys_Error ("SV_GrowDeltaFrame: realloc() failed on %d updates", frame->maxupdates);
+}
+
+/*
+=============
+SV_ClearDeltaFrames
+
+the client starts over without a base, when it connects or the level changes
+=============
+*/
+void SV_ClearDeltaFrames (client_t *client)
+{
+	int		i;
+
+	client->deltaents = false;
+	client->deltaack = 0;
+	if (!client->deltaframes)
+		return;
+	for (i=0 ; i<DELTA_BACKUP ; i++)
+		client->deltaframes[i].sequence = 0;
+}
+
+/*
+=============
+SV_DeltaBits
+
+the bits an update from the entity as it was in from needs, or -1 when
+nothing has changed. U_STEP and U_LERPFINISH are sent as they are now,
+since they say how the client lerps rather than what it has.
+=============
+*/
+static int SV_DeltaBits (entityupdate_t *u, entityupdate_t *from)
+{
+	int		bits, i;
 
-		for (i=0 ; i<3 ; i++)
-		{
-			miss = ent->v.origin[i] - ent->baseline.origin[i];
-			if ( miss < -0.1 || miss > 0.1 )
-				bits |= U_ORIGIN1<<i;
-		}
+	bits = 0;
+	for (i=0 ; i<3 ; i++)
+		if (u->origin[i] != from->origin[i])
+			bits |= U_ORIGIN1<<i;
+	if (u->angles[0] != from->angles[0])
+		bits |= U_ANGLE1;
+	if (u->angles[1] != from->angles[1])
+		bits |= U_ANGLE2;
+	if (u->angles[2] != from->angles[2])
+		bits |= U_ANGLE3;
+	if (u->modelindex != from->modelindex)
+		bits |= (u->modelindex & 0xFF00) ? U_MODEL|U_MODEL2 : U_MODEL;
+	if (u->frame != from->frame)
+		bits |= (u->frame & 0xFF00) ? U_FRAME|U_FRAME2 : U_FRAME;
+	if (u->colormap != from->colormap)
+		bits |= U_COLORMAP;
+	if (u->skin != from->skin)
+		bits |= U_SKIN;
+	if (u->effects != from->effects)
+		bits |= U_EFFECTS;
+	if (u->alpha != from->alpha)
+		bits |= U_ALPHA;
+	if (u->scale != from->scale)
+		bits |= U_SCALE;
+
+	if (!bits && !((u->bits ^ from->bits) & (U_STEP|U_LERPFINISH))
+	&& !((u->bits & U_LERPFINISH) && u->lerpfinish != from->lerpfinish))
+		return -1;
+
+	bits |= u->bits & (U_STEP|U_LERPFINISH);
+	if (bits >= 65536)
+		bits |= U_EXTEND1;
+	if (bits >= 16777216)
+		bits |= U_EXTEND2;
+	if (u->num >= 256)
+		bits |= U_LONGENTITY;
+	if (bits >= 256)
+		bits |= U_MOREBITS;
+
+	return bits;
+}
 
-		if ( ent->v.angles[0] != ent->baseline.angles[0] )
-			bits |= U_ANGLE1;
+/*
+=============
+SV_WriteDeltaEntitiesToClient
 
-		if ( ent->v.angles[1] != ent->baseline.angles[1] )
-			bits |= U_ANGLE2;
+The snapshot is kept as the client will have it if this datagram gets
+there, which is not quite what was built when it doesn't all fit: an
+entity whose update is left out stays as it was in the base, or isn't
+there at all if it's new.
+=============
+*/
+static void SV_WriteDeltaEntitiesToClient (clientbuild_t *build, client_t *client, entityupdate_t *updates)
+{
+	sizebuf_t	*msg = &build->msg;
+	deltaframe_t	*frame, *base;
+	entityupdate_t	*u, *b, delta;
+	int		i, j, numupdates, numremoved, sequence, bits;
 
-		if ( ent->v.angles[2] != ent->baseline.angles[2] )
-			bits |= U_ANGLE3;
+	if (!client->deltaframes)
+	{
+		client->deltaframes = (deltaframe_t *) calloc (DELTA_BACKUP, sizeof(deltaframe_t));
+		if (!client->deltaframes)
+			Sys_Error ("SV_WriteDeltaEntitiesToClient: couldn't allocate snapshots");
+	}
 
-		if (ent->v.movetype == MOVETYPE_STEP)
-			bits |= U_STEP;	// don't mess up the step animation
+	numupdates = SV_BuildEntityUpdates (client->edict, build->pvs, updates);
 
-		if (ent->baseline.colormap != ent->v.colormap)
-			bits |= U_COLORMAP;
+	sequence = ++client->deltasequence;
+	base = &client->deltaframes[client->deltaack & (DELTA_BACKUP-1)];
+	if (!client->deltaack || base->sequence != client->deltaack || sequence - client->deltaack >= DELTA_BACKUP)
+		base = NULL;
 
-		if (ent->baseline.skin != ent->v.skin)
-			bits |= U_SKIN;
+// the ones that have gone. if they won't all fit, the whole snapshot
+// is sent from the baselines instead
+	numremoved = 0;
+	for (i=j=0 ; base && i<base->numupdates ; i++)
+	{
+		while (j < numupdates && updates[j].num < base->updates[i].num)
+			j++;
+		if (j == numupdates || updates[j].num != base->updates[i].num)
+			numremoved++;
+	}
+	if (msg->cursize + 9 + 2*(numremoved + 1) + 1 > msg->maxsize)
+		base = NULL;
 
-		if (ent->baseline.frame != ent->v.frame)
-			bits |= U_FRAME;
+	frame = &client->deltaframes[sequence & (DELTA_BACKUP-1)];
+	SV_GrowDeltaFrame (frame, numupdates + (base ? base->numupdates : 0));
+	frame->sequence = sequence;
+	frame->numupdates = 0;
 
-		if ((ent->baseline.effects ^ (int)ent->v.effects) & pr_effects_mask)
-			bits |= U_EFFECTS;
+	MSG_WriteByte (msg, svc_deltaentities);
+	MSG_WriteLong (msg, sequence);
+	MSG_WriteLong (msg, base ? base->sequence : 0);
 
-		if (ent->baseline.modelindex != ent->v.modelindex)
-			bits |= U_MODEL;
+	for (i=j=0 ; base && i<base->numupdates ; i++)
+	{
+		while (j < numupdates && updates[j].num < base->updates[i].num)
+			j++;
+		if (j == numupdates || updates[j].num != base->updates[i].num)
+			MSG_WriteShort (msg, base->updates[i].num);
+	}
+	MSG_WriteShort (msg, 0);
 
-		//johnfitz -- alpha
-		if (pr_alpha_supported)
+// the ones that are new or have changed
+	for (i=j=0 ; i<numupdates ; i++)
+	{
+		u = &updates[i];
+		b = NULL;
+		if (base)
 		{
-			// TODO: find a cleaner place to put this code
-			val = GetEdictFieldValue(ent, "alpha");
-			if (val)
-				ent->alpha = ENTALPHA_ENCODE(val->_float);
+			while (j < base->numupdates && base->updates[j].num < u->num)
+				j++;
+			if (j < base->numupdates && base->updates[j].num == u->num)
+				b = &base->updates[j];
 		}
 
-		//don't send invisible entities unless they have effects
-		if (ent->alpha == ENTALPHA_ZERO && !((int)ent->v.effects & pr_effects_mask))
+		bits = b ? SV_DeltaBits (u, b) : u->bits;
+		if (bits == -1)
+		{
+			frame->updates[frame->numupdates++] = *u;
 			continue;
-		//johnfitz
-
-		val = GetEdictFieldValue(ent, "scale");
-		if (val)
-			ent->scale = ENTSCALE_ENCODE(val->_float);
-		else
-			ent->scale = ENTSCALE_DEFAULT;
+		}
 
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (sv.protocol != PROTOCOL_NETQUAKE)
+		// one byte is kept for the end
+		if (msg->cursize + 40 + 1 > msg->maxsize)
 		{
-			if (ent->baseline.alpha != ent->alpha) bits |= U_ALPHA;
-			if (ent->baseline.scale != ent->scale) bits |= U_SCALE;
-			if (bits & U_FRAME && (int)ent->v.frame & 0xFF00) bits |= U_FRAME2;
-			if (bits & U_MODEL && (int)ent->v.modelindex & 0xFF00) bits |= U_MODEL2;
-			if (ent->sendinterval) bits |= U_LERPFINISH;
-			if (bits >= 65536) bits |= U_EXTEND1;
-			if (bits >= 16777216) bits |= U_EXTEND2;
+			build->overflowed = true;
+			if (b)
+				frame->updates[frame->numupdates++] = *b;
+			continue;
 		}
-		//johnfitz
-
-		if (e >= 256)
-			bits |= U_LONGENTITY;
-
-		if (bits >= 256)
-			bits |= U_MOREBITS;
-
-	//
-	// write the message
-	//
-		MSG_WriteByte (msg, bits | U_SIGNAL);
-
-		if (bits & U_MOREBITS)
-			MSG_WriteByte (msg, bits>>8);
-
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits & U_EXTEND1)
-			MSG_WriteByte(msg, bits>>16);
-		if (bits & U_EXTEND2)
-			MSG_WriteByte(msg, bits>>24);
-		//johnfitz
-
-		if (bits & U_LONGENTITY)
-			MSG_WriteShort (msg,e);
-		else
-			MSG_WriteByte (msg,e);
-
-		if (bits & U_MODEL)
-			MSG_WriteByte (msg,	ent->v.modelindex);
-		if (bits & U_FRAME)
-			MSG_WriteByte (msg, ent->v.frame);
-		if (bits & U_COLORMAP)
-			MSG_WriteByte (msg, ent->v.colormap);
-		if (bits & U_SKIN)
-			MSG_WriteByte (msg, ent->v.skin);
-		if (bits & U_EFFECTS)
-			MSG_WriteByte (msg, (int)ent->v.effects & pr_effects_mask);
-		if (bits & U_ORIGIN1)
-			MSG_WriteCoord (msg, ent->v.origin[0], sv.protocolflags);
-		if (bits & U_ANGLE1)
-			MSG_WriteAngle(msg, ent->v.angles[0], sv.protocolflags);
-		if (bits & U_ORIGIN2)
-			MSG_WriteCoord (msg, ent->v.origin[1], sv.protocolflags);
-		if (bits & U_ANGLE2)
-			MSG_WriteAngle(msg, ent->v.angles[1], sv.protocolflags);
-		if (bits & U_ORIGIN3)
-			MSG_WriteCoord (msg, ent->v.origin[2], sv.protocolflags);
-		if (bits & U_ANGLE3)
-			MSG_WriteAngle(msg, ent->v.angles[2], sv.protocolflags);
 
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits & U_ALPHA)
-			MSG_WriteByte(msg, ent->alpha);
-		if (bits & U_SCALE)
-			MSG_WriteByte(msg, ent->scale);
-		if (bits & U_FRAME2)
-			MSG_WriteByte(msg, (int)ent->v.frame >> 8);
-		if (bits & U_MODEL2)
-			MSG_WriteByte(msg, (int)ent->v.modelindex >> 8);
-		if (bits & U_LERPFINISH)
-			MSG_WriteByte(msg, (byte)(Q_rint((ent->v.nextthink-sv.time)*255)));
-		//johnfitz
+		delta = *u;
+		delta.bits = bits;
+		MSG_WriteEntityUpdate (msg, &delta, sv.protocolflags);
+		frame->updates[frame->numupdates++] = *u;
 	}
-
-	//johnfitz -- devstats
-stats:
-	if (msg->cursize > 1024 && dev_peakstats.packetsize <= 1024)
-		Con_DWarning ("%i byte packet exceeds standard limit of 1024 (max = %d).\n", msg->cursize, msg->maxsize);
-	dev_stats.packetsize = msg->cursize;
-	dev_peakstats.packetsize = q_max(msg->cursize, dev_peakstats.packetsize);
-	//johnfitz
+	MSG_WriteByte (msg, 0);
 }
 
 /*
@@ -821,10 +1364,13 @@ void SV_CleanupEnts (void)
 
 /*
 ==================
-SV_WriteClientdataToMessage
+SV_WriteClientdata
+
+all of SV_WriteClientdataToMessage but the ideal pitch, which traces, so
+it can run on a worker
 ==================
 */
-void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
+static void SV_WriteClientdata (edict_t *ent, sizebuf_t *msg)
 {
 	int		bits;
 	int		i;
@@ -842,17 +1388,12 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 		MSG_WriteByte (msg, ent->v.dmg_save);
 		MSG_WriteByte (msg, ent->v.dmg_take);
 		for (i=0 ; i<3 ; i++)
-			MSG_WriteCoord (msg, other->v.origin[i] + 0.5*(other->v.mins[i] + other->v.maxs[i]), sv.protocolflags );
+			MSG_WriteCoord (msg, other->hot->origin[i] + 0.5*(other->v.mins[i] + other->v.maxs[i]), sv.protocolflags );
 
 		ent->v.dmg_take = 0;
 		ent->v.dmg_save = 0;
 	}
 
-//
-// send the current viewpos offset from the view entity
-//
-	SV_SetIdealPitch ();		// how much to look up / down ideally
-
 // a fixangle might get lost in a dropped packet.  Oh well.
 	if ( ent->v.fixangle )
 	{
@@ -872,7 +1413,7 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 
 // stuff the sigil bits into the high bits of items for sbar, or else
 // mix in items2
-	val = GetEdictFieldValue(ent, "items2");
+	val = GetEdictFieldOfs(ent, pr_extfields.items2);
 
 	if (val)
 		items = (int)ent->v.items | ((int)val->_float << 23);
@@ -881,7 +1422,7 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 
 	bits |= SU_ITEMS;
 
-	if ( (int)ent->v.flags & FL_ONGROUND)
+	if ( (int)ent->hot->flags & FL_ONGROUND)
 		bits |= SU_ONGROUND;
 
 	if ( ent->v.waterlevel >= 2)
@@ -891,7 +1432,7 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 	{
 		if (ent->v.punchangle[i])
 			bits |= (SU_PUNCH1<<i);
-		if (ent->v.velocity[i])
+		if (ent->hot->velocity[i])
 			bits |= (SU_VELOCITY1<<i);
 	}
 
@@ -942,7 +1483,7 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 		if (bits & (SU_PUNCH1<<i))
 			MSG_WriteChar (msg, ent->v.punchangle[i]);
 		if (bits & (SU_VELOCITY1<<i))
-			MSG_WriteChar (msg, ent->v.velocity[i]/16);
+			MSG_WriteChar (msg, ent->hot->velocity[i]/16);
 	}
 
 // [always sent]	if (bits & SU_ITEMS)
@@ -1000,6 +1541,189 @@ void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
 	//johnfitz
 }
 
+void SV_WriteClientdataToMessage (edict_t *ent, sizebuf_t *msg)
+{
+//
+// send the current viewpos offset from the view entity
+//
+	SV_SetIdealPitch ();		// how much to look up / down ideally
+
+	SV_WriteClientdata (ent, msg);
+}
+
+/*
+=======================
+SV_BuildClientDatagram
+
+everything but the server datagram, into b, with updates as scratch for
+the entities. only reads what's shared, so it can run on a worker.
+=======================
+*/
+static void SV_BuildClientDatagram (client_t *client, clientbuild_t *b, entityupdate_t *updates)
+{
+	b->msg.cursize = 0;
+	b->overflowed = false;
+
+	MSG_WriteByte (&b->msg, svc_time);
+	MSG_WriteFloat (&b->msg, sv.time);
+
+// add the client specific data to the datagram
+	SV_WriteClientdata (client->edict, &b->msg);
+
+	if (client->deltaents && (sv.protocolflags & PRFL_DELTAENTS))
+		SV_WriteDeltaEntitiesToClient (b, client, updates);
+	else
+		SV_WriteEntitiesToClient (b, client->edict, updates);
+}
+
+/*
+=============================================================================
+
+THREADED DATAGRAMS
+
+With sv_threads set, the datagrams of the clients on the network are built
+on the workers of sv_workers.c before any is sent. What has to happen on
+this thread, the ideal pitch and the fat pvs from the shared cache, is done
+for each of them first, and the sending is left to SV_SendClientDatagram
+as before. Each client has its own message buffer, as they all have to be
+kept until the sending, but the entity updates are only scratch, so there
+is one set for each worker.
+
+=============================================================================
+*/
+
+static clientbuild_t	sv_build;			// for building on this thread
+static clientbuild_t	*sv_clientbuilds;	// svs.maxclientslimit
+static int		sv_numclientbuilds;
+static int		sv_clientbuildjobs[MAX_SCOREBOARD];	// client numbers
+
+typedef struct
+{
+	entityupdate_t	*updates;
+	int			maxupdates;
+} updatescratch_t;
+
+static updatescratch_t	*sv_scratch;		// by worker, 0 for this thread
+static int		sv_numscratch;
+
+/*
+=======================
+SV_UpdateScratch
+
+the worker's scratch for SV_BuildEntityUpdates, made big enough on this
+thread before any job needs it
+=======================
+*/
+static entityupdate_t *SV_UpdateScratch (int worker)
+{
+	if (worker >= sv_numscratch)
+	{
+		sv_scratch = (updatescratch_t *) realloc (sv_scratch, (worker + 1) * sizeof(updatescratch_t));
+		if (!sv_scratch)
+			Sys_Error ("SV_UpdateScratch: out of memory");
+		memset (sv_scratch + sv_numscratch, 0, (worker + 1 - sv_numscratch) * sizeof(updatescratch_t));
+		sv_numscratch = worker + 1;
+	}
+	SV_GrowUpdates (&sv_scratch[worker].updates, &sv_scratch[worker].maxupdates);
+	return sv_scratch[worker].updates;
+}
+
+/*
+=======================
+SV_SizeClientBuild
+
+b's buffer for a datagram of up to maxsize, with room in front for the
+header, so that NET_SendUnreliableMessage sends it from where it's built
+=======================
+*/
+static void SV_SizeClientBuild (clientbuild_t *b, int maxsize)
+{
+	byte	*buf;
+
+	maxsize = q_min (maxsize, sv.clientdatagram.maxsize);
+	if (b->msgsize < maxsize)
+	{
+		buf = b->msg.data ? b->msg.data - NET_HEADERSIZE : NULL;
+		buf = (byte *) realloc (buf, NET_HEADERSIZE + maxsize);
+		if (!buf)
+			Sys_Error ("SV_SizeClientBuild: out of memory");
+		b->msgsize = maxsize;
+		b->msg.data = buf + NET_HEADERSIZE;
+	}
+	b->msg.headroom = NET_HEADERSIZE;
+	b->msg.allowoverflow = sv.clientdatagram.allowoverflow;
+	b->msg.overflowed = false;
+	b->msg.maxsize = maxsize;
+	b->msg.cursize = 0;
+}
+
+/*
+=======================
+SV_BuildClientJob
+=======================
+*/
+static void SV_BuildClientJob (int index, int worker)
+{
+	clientbuild_t	*b = &sv_clientbuilds[sv_clientbuildjobs[index]];
+
+	SV_BuildClientDatagram (svs.clients + sv_clientbuildjobs[index], b, sv_scratch[worker].updates);
+	b->built = true;
+}
+
+/*
+=======================
+SV_BuildClientDatagrams
+=======================
+*/
+static void SV_BuildClientDatagrams (void)
+{
+	extern	cvar_t	sv_threads;
+	client_t	*client;
+	clientbuild_t	*b;
+	int		i, numjobs, numworkers, pvsbytes;
+
+	for (i=0 ; i<sv_numclientbuilds ; i++)
+		sv_clientbuilds[i].built = false;	// any a dropped client didn't send
+
+	if (!sv_threads.value)
+		return;
+
+	if (sv_numclientbuilds < svs.maxclientslimit)
+	{
+		sv_clientbuilds = (clientbuild_t *) realloc (sv_clientbuilds, svs.maxclientslimit * sizeof(clientbuild_t));
+		if (!sv_clientbuilds)
+			Sys_Error ("SV_BuildClientDatagrams: out of memory");
+		memset (sv_clientbuilds + sv_numclientbuilds, 0, (svs.maxclientslimit - sv_numclientbuilds) * sizeof(clientbuild_t));
+		sv_numclientbuilds = svs.maxclientslimit;
+	}
+
+	pvsbytes = (sv.worldmodel->numleafs + 7) >> 3;
+	numjobs = 0;
+	for (i=0, client = svs.clients ; i<svs.maxclients ; i++, client++)
+	{
+		if (!client->active || !client->spawned || SV_IsLocalClient (client))
+			continue;	// the local client's can be a snapshot, which is the server's
+
+		b = &sv_clientbuilds[i];
+		SV_SizeClientBuild (b, DATAGRAM_MTU);
+		b->pvs = (byte *) realloc (b->pvs, pvsbytes);
+		if (!b->pvs)
+			Sys_Error ("SV_BuildClientDatagrams: out of memory");
+
+		SV_SetIdealPitch ();
+		SV_ModelIndex (PR_GetString (client->edict->v.weaponmodel));	// any error is raised here, not on a worker
+		memcpy (b->pvs, SV_ClientPVS (client->edict), pvsbytes);
+
+		sv_clientbuildjobs[numjobs++] = i;
+	}
+
+	numworkers = SV_Workers ();
+	for (i=0 ; i<numworkers ; i++)
+		SV_UpdateScratch (i);
+
+	SV_RunJobs (SV_BuildClientJob, numjobs);
+}
+
 /*
 =======================
 SV_SendClientDatagram
@@ -1007,36 +1731,77 @@ SV_SendClientDatagram
 */
 qboolean SV_SendClientDatagram (client_t *client)
 {
-	byte		buf[MAX_DATAGRAM];
-	sizebuf_t	msg;
+	clientbuild_t	*b;
+	sizebuf_t	*msg;
+	qboolean	local, snapshot;
+	int			r;
+
+	snapshot = false;
+	b = sv_clientbuilds ? &sv_clientbuilds[client - svs.clients] : NULL;
+	if (b && b->built)
+		b->built = false;
+	else
+	{
+		b = &sv_build;
 
-	msg.data = buf;
-	msg.maxsize = sizeof(buf);
-	msg.cursize = 0;
+		//johnfitz -- if client is nonlocal, use smaller max size so packets aren't fragmented
+		local = SV_IsLocalClient (client);
+		SV_SizeClientBuild (b, local ? sv.clientdatagram.maxsize : DATAGRAM_MTU);
+		//johnfitz
 
-	//johnfitz -- if client is nonlocal, use smaller max size so packets aren't fragmented
-	if (Q_strcmp(NET_QSocketGetAddressString(client->netconnection), "LOCAL") != 0)
-		msg.maxsize = DATAGRAM_MTU;
-	//johnfitz
+		SV_SetIdealPitch ();
 
-	MSG_WriteByte (&msg, svc_time);
-	MSG_WriteFloat (&msg, sv.time);
+	// the local client reads the entities straight from the snapshot, unless it
+	// hasn't got to the last one yet
+		snapshot = local && sv_localsnapshot.value && !sv_snapshot.pending;
+		if (snapshot)
+		{
+			b->msg.cursize = 0;
+			b->overflowed = false;
+			MSG_WriteByte (&b->msg, svc_time);
+			MSG_WriteFloat (&b->msg, sv.time);
+			SV_WriteClientdata (client->edict, &b->msg);
+			SV_WriteEntitiesToSnapshot (client->edict, &b->msg);
+		}
+		else
+		{
+			b->pvs = SV_ClientPVS (client->edict);
+			SV_BuildClientDatagram (client, b, SV_UpdateScratch (0));
+		}
+	}
+	msg = &b->msg;
 
-// add the client specific data to the datagram
-	SV_WriteClientdataToMessage (client->edict, &msg);
+	//johnfitz -- less spammy overflow message
+	if (b->overflowed && (!dev_overflows.packetsize || dev_overflows.packetsize + CONSOLE_RESPAM_TIME < realtime))
+	{
+		Con_Printf ("Packet overflow!\n");
+		dev_overflows.packetsize = realtime;
+	}
+	//johnfitz
 
-	SV_WriteEntitiesToClient (client->edict, &msg);
+	//johnfitz -- devstats
+	if (!snapshot)
+	{
+		if (msg->cursize > 1024 && sv_devpeakstats.packetsize <= 1024)
+			Con_DWarning ("%i byte packet exceeds standard limit of 1024 (max = %d).\n", msg->cursize, msg->maxsize);
+		sv_devstats.packetsize = msg->cursize;
+		sv_devpeakstats.packetsize = q_max(msg->cursize, sv_devpeakstats.packetsize);
+	}
+	//johnfitz
 
 // copy the server datagram if there is space
-	if (msg.cursize + sv.datagram.cursize < msg.maxsize)
-		SZ_Write (&msg, sv.datagram.data, sv.datagram.cursize);
+	if (msg->cursize + sv.datagram.cursize < msg->maxsize)
+		SZ_Write (msg, sv.datagram.data, sv.datagram.cursize);
 
 // send the datagram
-	if (NET_SendUnreliableMessage (client->netconnection, &msg) == -1)
+	r = NET_SendUnreliableMessage (client->netconnection, msg);
+	if (r == -1)
 	{
 		SV_DropClient (true);// if the message couldn't send, kick off
 		return false;
 	}
+	if (!r && snapshot)
+		sv_snapshot.pending = false;	// dropped, so nothing will read it
 
 	return true;
 }
@@ -1091,11 +1856,12 @@ message buffer
 void SV_SendNop (client_t *client)
 {
 	sizebuf_t	msg;
-	byte		buf[4];
+	byte		buf[NET_HEADERSIZE + 4];
 
-	msg.data = buf;
-	msg.maxsize = sizeof(buf);
+	msg.data = buf + NET_HEADERSIZE;
+	msg.maxsize = 4;
 	msg.cursize = 0;
+	msg.headroom = NET_HEADERSIZE;
 
 	MSG_WriteChar (&msg, svc_nop);
 
@@ -1104,6 +1870,8 @@ void SV_SendNop (client_t *client)
 	client->last_message = realtime;
 }
 
+static void SV_StreamSignon (client_t *client);
+
 /*
 =======================
 SV_SendClientMessages
@@ -1116,6 +1884,10 @@ void SV_SendClientMessages (void)
 // update frags, names, etc
 	SV_UpdateToReliableMessages ();
 
+// build the datagrams on the workers, if there are any
+	SV_PrepareEntities ();
+	SV_BuildClientDatagrams ();
+
 // build individual updates
 	for (i=0, host_client = svs.clients ; i<svs.maxclients ; i++, host_client++)
 	{
@@ -1140,25 +1912,8 @@ void SV_SendClientMessages (void)
 					SV_SendNop (host_client);
 				continue;	// don't send out non-signon messages
 			}
-			if (host_client->sendsignon == PRESPAWN_SIGNONBUFS)
-			{
-				qboolean local = SV_IsLocalClient (host_client);
-				while (host_client->signonidx < sv.num_signon_buffers)
-				{
-					sizebuf_t *signon = sv.signon_buffers[host_client->signonidx];
-					if (host_client->message.cursize + signon->cursize > host_client->message.maxsize)
-						break;
-					SZ_Write (&host_client->message, signon->data, signon->cursize);
-					host_client->signonidx++;
-					// only send multiple buffers at once when playing locally,
-					// otherwise we send one signon at a time to avoid overflowing
-					// the datagram buffer for clients using a lower limit (e.g. 32000 in QS)
-					if (!local)
-						break;
-				}
-				if (host_client->signonidx == sv.num_signon_buffers)
-					host_client->sendsignon = PRESPAWN_SIGNONMSG;
-			}
+			if (host_client->sendsignon == PRESPAWN_SIGNONBUFS || host_client->sendsignon == PRESPAWN_BASELINES)
+				SV_StreamSignon (host_client);
 			if (host_client->sendsignon == PRESPAWN_SIGNONMSG)
 			{
 				if (host_client->message.cursize + 2 < host_client->message.maxsize)
@@ -1219,9 +1974,15 @@ SERVER SPAWNING
 
 #define SIGNON_SIZE		31500 // QS has a MAX_DATAGRAM of 32000, try to play nice
 
+// a signon buffer has to fit in a client message, with room to spare
+#define	SV_SignonSize()	q_min (SIGNON_SIZE, PROTOCOL_MSGLEN (sv.protocol) - 512)
+
 /*
 ================
 SV_AddSignonBuffer
+
+malloc'd, as QuakeC can fill one after the map has loaded, when the server
+frame may be pipelined and the hunk isn't its own
 ================
 */
 static void SV_AddSignonBuffer (void)
@@ -1230,9 +1991,11 @@ static void SV_AddSignonBuffer (void)
 	if (sv.num_signon_buffers >= MAX_SIGNON_BUFFERS)
 		Host_Error ("SV_AddSignonBuffer overflow\n");
 
-	sb = (sizebuf_t *) Hunk_AllocName (sizeof (sizebuf_t) + SIGNON_SIZE, "signon");
+	sb = (sizebuf_t *) calloc (1, sizeof (sizebuf_t) + SV_SignonSize ());
+	if (!sb)
+		Sys_Error ("SV_AddSignonBuffer: out of memory");
 	sb->data = (byte *)(sb + 1);
-	sb->maxsize = SIGNON_SIZE;
+	sb->maxsize = SV_SignonSize ();
 	sv.signon_buffers[sv.num_signon_buffers++] = sb;
 	sv.signon = sb;
 }
@@ -1276,118 +2039,231 @@ SV_CreateBaseline
 */
 void SV_CreateBaseline (void)
 {
-	int			i;
 	edict_t		*svent;
 	int			entnum;
-	int			bits; //johnfitz -- PROTOCOL_FITZQUAKE
+	entity_state_t	*baseline;
 
 	for (entnum = 0; entnum < sv.num_edicts ; entnum++)
 	{
 	// get the current server version
 		svent = EDICT_NUM(entnum);
-		if (svent->free)
+		if (svent->hot->free)
 			continue;
+		baseline = &sv.baselines[entnum];
 		if (entnum > svs.maxclients && !svent->v.modelindex)
 			continue;
 
 	//
 	// create entity baseline
 	//
-		VectorCopy (svent->v.origin, svent->baseline.origin);
-		VectorCopy (svent->v.angles, svent->baseline.angles);
-		svent->baseline.frame = svent->v.frame;
-		svent->baseline.skin = svent->v.skin;
+		VectorCopy (svent->hot->origin, baseline->origin);
+		VectorCopy (svent->v.angles, baseline->angles);
+		baseline->frame = svent->v.frame;
+		baseline->skin = svent->v.skin;
 		if (entnum > 0 && entnum <= svs.maxclients)
 		{
-			svent->baseline.colormap = entnum;
-			svent->baseline.modelindex = SV_ModelIndex("progs/player.mdl");
-			svent->baseline.alpha = ENTALPHA_DEFAULT; //johnfitz -- alpha support
-			svent->baseline.scale = ENTSCALE_DEFAULT;
+			baseline->colormap = entnum;
+			baseline->modelindex = SV_ModelIndex("progs/player.mdl");
+			baseline->alpha = ENTALPHA_DEFAULT; //johnfitz -- alpha support
+			baseline->scale = ENTSCALE_DEFAULT;
 		}
 		else
 		{
-			svent->baseline.colormap = 0;
-			svent->baseline.modelindex = SV_ModelIndex(PR_GetString(svent->v.model));
-			svent->baseline.alpha = svent->alpha; //johnfitz -- alpha support
-			svent->baseline.scale = ENTSCALE_DEFAULT;
+			baseline->colormap = 0;
+			baseline->modelindex = SV_ModelIndex(PR_GetString(svent->v.model));
+			baseline->alpha = svent->alpha; //johnfitz -- alpha support
+			baseline->scale = ENTSCALE_DEFAULT;
 			if (sv.protocol == PROTOCOL_RMQ)
 			{
 				eval_t* val;
-				val = GetEdictFieldValue(svent, "scale");
+				val = GetEdictFieldOfs(svent, pr_extfields.scale);
 				if (val)
-					svent->baseline.scale = ENTSCALE_ENCODE(val->_float);
+					baseline->scale = ENTSCALE_ENCODE(val->_float);
 			}
 		}
 
 		//johnfitz -- PROTOCOL_FITZQUAKE
-		bits = 0;
 		if (sv.protocol == PROTOCOL_NETQUAKE) //still want to send baseline in PROTOCOL_NETQUAKE, so reset these values
 		{
-			if (svent->baseline.modelindex & 0xFF00)
-				svent->baseline.modelindex = 0;
-			if (svent->baseline.frame & 0xFF00)
-				svent->baseline.frame = 0;
-			svent->baseline.alpha = ENTALPHA_DEFAULT;
-			svent->baseline.scale = ENTSCALE_DEFAULT;
-		}
-		else //decide which extra data needs to be sent
-		{
-			if (svent->baseline.modelindex & 0xFF00)
-				bits |= B_LARGEMODEL;
-			if (svent->baseline.frame & 0xFF00)
-				bits |= B_LARGEFRAME;
-			if (svent->baseline.alpha != ENTALPHA_DEFAULT)
-				bits |= B_ALPHA;
-			if (svent->baseline.scale != ENTSCALE_DEFAULT)
-				bits |= B_SCALE;
+			if (baseline->modelindex & 0xFF00)
+				baseline->modelindex = 0;
+			if (baseline->frame & 0xFF00)
+				baseline->frame = 0;
+			baseline->alpha = ENTALPHA_DEFAULT;
+			baseline->scale = ENTSCALE_DEFAULT;
 		}
 		//johnfitz
 
-	//
-	// add to the message
-	//
-		SV_ReserveSignonSpace (35);
+	// SV_StreamSignon writes it out for each client that signs on
+		sv.baselineedicts[entnum >> 5] |= 1u << (entnum & 31);
+	}
+}
 
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits)
-			MSG_WriteByte (sv.signon, svc_spawnbaseline2);
-		else
-			MSG_WriteByte (sv.signon, svc_spawnbaseline);
-		//johnfitz
+/*
+================
+SV_BaselineBits
 
-		MSG_WriteShort (sv.signon,entnum);
+the extra data the baseline needs sent with svc_spawnbaseline2
+================
+*/
+static int SV_BaselineBits (entity_state_t *baseline)
+{
+	int		bits;
 
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits)
-			MSG_WriteByte (sv.signon, bits);
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	bits = 0;
+	if (sv.protocol != PROTOCOL_NETQUAKE) //decide which extra data needs to be sent
+	{
+		if (baseline->modelindex & 0xFF00)
+			bits |= B_LARGEMODEL;
+		if (baseline->frame & 0xFF00)
+			bits |= B_LARGEFRAME;
+		if (baseline->alpha != ENTALPHA_DEFAULT)
+			bits |= B_ALPHA;
+		if (baseline->scale != ENTSCALE_DEFAULT)
+			bits |= B_SCALE;
+	}
+	//johnfitz
 
-		if (bits & B_LARGEMODEL)
-			MSG_WriteShort (sv.signon, svent->baseline.modelindex);
-		else
-			MSG_WriteByte (sv.signon, svent->baseline.modelindex);
+	return bits;
+}
 
-		if (bits & B_LARGEFRAME)
-			MSG_WriteShort (sv.signon, svent->baseline.frame);
-		else
-			MSG_WriteByte (sv.signon, svent->baseline.frame);
-		//johnfitz
+/*
+================
+SV_BaselineSize
 
-		MSG_WriteByte (sv.signon, svent->baseline.colormap);
-		MSG_WriteByte (sv.signon, svent->baseline.skin);
-		for (i=0 ; i<3 ; i++)
+the bytes SV_WriteBaseline will take for entnum, from the bits and the
+protocol flags, without writing it
+================
+*/
+static int SV_BaselineSize (int entnum)
+{
+	int		bits, coord, angle;
+
+	bits = SV_BaselineBits (&sv.baselines[entnum]);
+
+	if (sv.protocolflags & (PRFL_FLOATCOORD | PRFL_INT32COORD))
+		coord = 4;
+	else if (sv.protocolflags & PRFL_24BITCOORD)
+		coord = 3;
+	else
+		coord = 2;
+
+	if (sv.protocolflags & PRFL_FLOATANGLE)
+		angle = 4;
+	else if (sv.protocolflags & PRFL_SHORTANGLE)
+		angle = 2;
+	else
+		angle = 1;
+
+	return 3 + (bits ? 1 : 0)				// svc, entnum and bits
+		+ ((bits & B_LARGEMODEL) ? 2 : 1)
+		+ ((bits & B_LARGEFRAME) ? 2 : 1)
+		+ 2									// colormap and skin
+		+ 3 * (coord + angle)
+		+ ((bits & B_ALPHA) ? 1 : 0)
+		+ ((bits & B_SCALE) ? 1 : 0);
+}
+
+/*
+================
+SV_WriteBaseline
+================
+*/
+static void SV_WriteBaseline (sizebuf_t *msg, int entnum)
+{
+	int		i, bits;
+	entity_state_t	*baseline = &sv.baselines[entnum];
+
+	bits = SV_BaselineBits (baseline);
+
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	if (bits)
+		MSG_WriteByte (msg, svc_spawnbaseline2);
+	else
+		MSG_WriteByte (msg, svc_spawnbaseline);
+	//johnfitz
+
+	MSG_WriteShort (msg,entnum);
+
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	if (bits)
+		MSG_WriteByte (msg, bits);
+
+	if (bits & B_LARGEMODEL)
+		MSG_WriteShort (msg, baseline->modelindex);
+	else
+		MSG_WriteByte (msg, baseline->modelindex);
+
+	if (bits & B_LARGEFRAME)
+		MSG_WriteShort (msg, baseline->frame);
+	else
+		MSG_WriteByte (msg, baseline->frame);
+	//johnfitz
+
+	MSG_WriteByte (msg, baseline->colormap);
+	MSG_WriteByte (msg, baseline->skin);
+	for (i=0 ; i<3 ; i++)
+	{
+		MSG_WriteCoord(msg, baseline->origin[i], sv.protocolflags);
+		MSG_WriteAngle(msg, baseline->angles[i], sv.protocolflags);
+	}
+
+	//johnfitz -- PROTOCOL_FITZQUAKE
+	if (bits & B_ALPHA)
+		MSG_WriteByte (msg, baseline->alpha);
+	//johnfitz
+
+	if (bits & B_SCALE)
+		MSG_WriteByte (msg, baseline->scale);
+}
+
+/*
+================
+SV_StreamSignon
+
+Adds the next part of the signon to the client's message: first what was
+written to the signon buffers, the static entities and sounds and anything
+the progs sent to MSG_INIT, then a baseline for every entity that has one.
+The baselines aren't kept as messages but written from sv.baselines as the
+client gets to them, as many as fit. A client on the network gets no more
+than SV_SignonSize of it in a message.
+================
+*/
+static void SV_StreamSignon (client_t *client)
+{
+	sizebuf_t	*signon;
+	int		limit;
+
+	limit = client->message.maxsize;
+	if (!SV_IsLocalClient (client))
+		limit = q_min (limit, client->message.cursize + SV_SignonSize ());
+
+	while (client->sendsignon == PRESPAWN_SIGNONBUFS)
+	{
+		if (client->signonidx == sv.num_signon_buffers)
 		{
-			MSG_WriteCoord(sv.signon, svent->baseline.origin[i], sv.protocolflags);
-			MSG_WriteAngle(sv.signon, svent->baseline.angles[i], sv.protocolflags);
+			client->sendsignon = PRESPAWN_BASELINES;
+			client->signonidx = 0;
+			break;
 		}
+		signon = sv.signon_buffers[client->signonidx];
+		if (client->message.cursize + signon->cursize > limit)
+			return;
+		SZ_Write (&client->message, signon->data, signon->cursize);
+		client->signonidx++;
+	}
 
-		//johnfitz -- PROTOCOL_FITZQUAKE
-		if (bits & B_ALPHA)
-			MSG_WriteByte (sv.signon, svent->baseline.alpha);
-		//johnfitz
-
-		if (bits & B_SCALE)
-			MSG_WriteByte (sv.signon, svent->baseline.scale);
+	for ( ; client->signonidx < sv.num_edicts ; client->signonidx++)
+	{
+		if (!(sv.baselineedicts[client->signonidx >> 5] & (1u << (client->signonidx & 31))))
+			continue;
+		if (client->message.cursize + SV_BaselineSize (client->signonidx) > limit)
+			return;
+		SV_WriteBaseline (&client->message, client->signonidx);
 	}
+
+	client->sendsignon = PRESPAWN_SIGNONMSG;
 }
 
 
@@ -1502,6 +2378,8 @@ void SV_SpawnServer (const char *server)
 		// set up the protocol flags used by this server
 		// (note - these could be cvar-ised so that server admins could choose the protocol features used by their servers)
 		sv.protocolflags = PRFL_INT32COORD | PRFL_SHORTANGLE;
+		if (sv_deltaents.value)
+			sv.protocolflags |= PRFL_DELTAENTS;
 	}
 	else sv.protocolflags = 0;
 
@@ -1511,21 +2389,32 @@ void SV_SpawnServer (const char *server)
 // allocate server memory
 	/* Host_ClearMemory() called above already cleared the whole sv structure */
 	sv.max_edicts = CLAMP (MIN_EDICTS,(int)max_edicts.value,MAX_EDICTS); //johnfitz -- max_edicts cvar
-	sv.edicts = (edict_t *) malloc (sv.max_edicts*pr_edict_size); // ericw -- sv.edicts switched to use malloc()
-
-	sv.datagram.maxsize = sizeof(sv.datagram_buf);
-	sv.datagram.cursize = 0;
-	sv.datagram.data = sv.datagram_buf;
-
-	sv.reliable_datagram.maxsize = sizeof(sv.reliable_datagram_buf);
-	sv.reliable_datagram.cursize = 0;
-	sv.reliable_datagram.data = sv.reliable_datagram_buf;
+	// the hot fields go in the same block, so progs' pointers to them, which
+	// are offsets from sv.edicts, fit in an int
+	sv.edicts = (edict_t *) malloc (sv.max_edicts*(pr_edict_size + sizeof(edicthot_t))); // ericw -- sv.edicts switched to use malloc()
+	sv.edicthot = (edicthot_t *) ((byte *)sv.edicts + sv.max_edicts*pr_edict_size);
+	sv.edictleafs = (edictleafs_t *) calloc (sv.max_edicts, sizeof(edictleafs_t));
+	sv.baselines = (entity_state_t *) calloc (sv.max_edicts, sizeof(entity_state_t));
+	sv.physwake = (unsigned int *) malloc (((sv.max_edicts + 31) >> 5) * sizeof(unsigned int));
+	sv.netedicts = (unsigned int *) calloc ((sv.max_edicts + 31) >> 5, sizeof(unsigned int));
+	sv.baselineedicts = (unsigned int *) calloc ((sv.max_edicts + 31) >> 5, sizeof(unsigned int));
+	sv.edictthink = (edictthink_t *) calloc (sv.max_edicts, sizeof(edictthink_t));
+	if (!sv.edicts || !sv.edictleafs || !sv.baselines || !sv.physwake || !sv.netedicts || !sv.baselineedicts || !sv.edictthink)
+		Sys_Error ("SV_SpawnServer: couldn't allocate %i edicts", sv.max_edicts);
+	SV_WakeAllEdicts ();
+
+	SZ_Resize (&sv.datagram, PROTOCOL_DATAGRAM (sv.protocol));
+	SZ_Resize (&sv.reliable_datagram, PROTOCOL_DATAGRAM (sv.protocol));
+	SZ_Resize (&sv.clientdatagram, PROTOCOL_DATAGRAM (sv.protocol));
+
+	sv_snapshot.pending = false;	// the last level's, which nothing will read now
 
 	SV_AddSignonBuffer ();
 
 // leave slots at start for clients only
 	sv.num_edicts = svs.maxclients+1;
-	Q_memset(sv.edicts, 0, sv.num_edicts*pr_edict_size); // ericw -- sv.edicts switched to use malloc()
+	for (i=0 ; i<sv.num_edicts ; i++)
+		ED_ZeroEdict (i); // ericw -- sv.edicts switched to use malloc()
 	for (i=0 ; i<svs.maxclients ; i++)
 	{
 		ent = EDICT_NUM(i+1);
@@ -1552,6 +2441,7 @@ void SV_SpawnServer (const char *server)
 // clear world interaction links
 //
 	SV_ClearWorld ();
+	SV_ClearFatPVSCache ();
 
 	sv.sound_precache[0] = dummy;
 	sv.model_precache[0] = dummy;
@@ -1566,12 +2456,12 @@ void SV_SpawnServer (const char *server)
 // load the rest of the entities
 //
 	ent = EDICT_NUM(0);
-	Q_memset (&ent->v, 0, progs->entityfields * 4);
-	ent->free = false;
+	ED_ClearFields (ent);
+	ent->hot->free = false;
 	ent->v.model = PR_SetEngineString(sv.worldmodel->name);
 	ent->v.modelindex = 1;		// world model
-	ent->v.solid = SOLID_BSP;
-	ent->v.movetype = MOVETYPE_PUSH;
+	ent->hot->solid = SOLID_BSP;
+	ent->hot->movetype = MOVETYPE_PUSH;
 
 	if (coop.value)
 		pr_global_struct->coop = coop.value;
@@ -1599,12 +2489,20 @@ void SV_SpawnServer (const char *server)
 	SV_CreateBaseline ();
 
 	//johnfitz -- warn if signon buffer larger than standard server can handle
-	for (i = 0, signonsize = 0; i < sv.num_signon_buffers; i++)
-		signonsize += sv.signon_buffers[i]->cursize;
-	if (signonsize > 64000-2)
-		Con_DWarning ("%i byte signon buffer exceeds QS limit of 63998.\n", signonsize);
-	else if (signonsize > 8000-2) //max size that will fit into 8000-sized client->message buffer with 2 extra bytes on the end
-		Con_DWarning ("%i byte signon buffer exceeds standard limit of 7998.\n", signonsize);
+	if (developer.value)
+	{
+		for (i = 0, signonsize = 0; i < sv.num_signon_buffers; i++)
+			signonsize += sv.signon_buffers[i]->cursize;
+		for (i = 0; i < sv.num_edicts; i++)
+		{
+			if (sv.baselineedicts[i >> 5] & (1u << (i & 31)))
+				signonsize += SV_BaselineSize (i);
+		}
+		if (signonsize > 64000-2)
+			Con_DWarning ("%i byte signon buffer exceeds QS limit of 63998.\n", signonsize);
+		else if (signonsize > 8000-2) //max size that will fit into 8000-sized client->message buffer with 2 extra bytes on the end
+			Con_DWarning ("%i byte signon buffer exceeds standard limit of 7998.\n", signonsize);
+	}
 	//johnfitz
 
 // send serverinfo to all connected clients
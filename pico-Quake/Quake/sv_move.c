@@ -38,13 +38,14 @@ int c_yes, c_no;
 
 qboolean SV_CheckBottom (edict_t *ent)
 {
-	vec3_t	mins, maxs, start, stop;
-	trace_t	trace;
-	int		x, y;
+	vec3_t	mins, maxs, start;
+	vec3_t	starts[5], stops[5];
+	trace_t	traces[5];
+	int		i, x, y;
 	float	mid, bottom;
 
-	VectorAdd (ent->v.origin, ent->v.mins, mins);
-	VectorAdd (ent->v.origin, ent->v.maxs, maxs);
+	VectorAdd (ent->hot->origin, ent->v.mins, mins);
+	VectorAdd (ent->hot->origin, ent->v.maxs, maxs);
 
 // if all of the points under the corners are solid world, don't bother
 // with the tougher checks
@@ -66,33 +67,39 @@ realcheck:
 	c_no++;
 //
 // check it for real...
+// the midpoint and the four corners are traced down together
 //
-	start[2] = mins[2];
-
-// the midpoint must be within 16 of the bottom
-	start[0] = stop[0] = (mins[0] + maxs[0])*0.5;
-	start[1] = stop[1] = (mins[1] + maxs[1])*0.5;
-	stop[2] = start[2] - 2*STEPSIZE;
-	trace = SV_Move (start, vec3_origin, vec3_origin, stop, true, ent);
-
-	if (trace.fraction == 1.0)
-		return false;
-	mid = bottom = trace.endpos[2];
+	for (i=0 ; i<5 ; i++)
+	{
+		starts[i][2] = mins[2];
+		stops[i][2] = mins[2] - 2*STEPSIZE;
+	}
 
-// the corners must be within 16 of the midpoint
+	starts[0][0] = stops[0][0] = (mins[0] + maxs[0])*0.5;
+	starts[0][1] = stops[0][1] = (mins[1] + maxs[1])*0.5;
 	for	(x=0 ; x<=1 ; x++)
 		for	(y=0 ; y<=1 ; y++)
 		{
-			start[0] = stop[0] = x ? maxs[0] : mins[0];
-			start[1] = stop[1] = y ? maxs[1] : mins[1];
+			i = 1 + x*2 + y;
+			starts[i][0] = stops[i][0] = x ? maxs[0] : mins[0];
+			starts[i][1] = stops[i][1] = y ? maxs[1] : mins[1];
+		}
 
-			trace = SV_Move (start, vec3_origin, vec3_origin, stop, true, ent);
+	SV_MoveBatch (5, starts, vec3_origin, vec3_origin, stops, true, ent, traces);
 
-			if (trace.fraction != 1.0 && trace.endpos[2] > bottom)
-				bottom = trace.endpos[2];
-			if (trace.fraction == 1.0 || mid - trace.endpos[2] > STEPSIZE)
-				return false;
-		}
+// the midpoint must be within 16 of the bottom
+	if (traces[0].fraction == 1.0)
+		return false;
+	mid = bottom = traces[0].endpos[2];
+
+// the corners must be within 16 of the midpoint
+	for (i=1 ; i<5 ; i++)
+	{
+		if (traces[i].fraction != 1.0 && traces[i].endpos[2] > bottom)
+			bottom = traces[i].endpos[2];
+		if (traces[i].fraction == 1.0 || mid - traces[i].endpos[2] > STEPSIZE)
+			return false;
+	}
 
 	c_yes++;
 	return true;
@@ -118,33 +125,33 @@ qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink)
 	edict_t		*enemy;
 
 // try the move
-	VectorCopy (ent->v.origin, oldorg);
-	VectorAdd (ent->v.origin, move, neworg);
+	VectorCopy (ent->hot->origin, oldorg);
+	VectorAdd (ent->hot->origin, move, neworg);
 
 // flying monsters don't step up
-	if ( (int)ent->v.flags & (FL_SWIM | FL_FLY) )
+	if ( (int)ent->hot->flags & (FL_SWIM | FL_FLY) )
 	{
 	// try one move with vertical motion, then one without
 		for (i=0 ; i<2 ; i++)
 		{
-			VectorAdd (ent->v.origin, move, neworg);
+			VectorAdd (ent->hot->origin, move, neworg);
 			enemy = PROG_TO_EDICT(ent->v.enemy);
 			if (i == 0 && enemy != sv.edicts)
 			{
-				dz = ent->v.origin[2] - PROG_TO_EDICT(ent->v.enemy)->v.origin[2];
+				dz = ent->hot->origin[2] - PROG_TO_EDICT(ent->v.enemy)->hot->origin[2];
 				if (dz > 40)
 					neworg[2] -= 8;
 				if (dz < 30)
 					neworg[2] += 8;
 			}
-			trace = SV_Move (ent->v.origin, ent->v.mins, ent->v.maxs, neworg, false, ent);
+			trace = SV_MoveCached (ent->hot->origin, ent->v.mins, ent->v.maxs, neworg, false, ent);
 
 			if (trace.fraction == 1)
 			{
-				if ( ((int)ent->v.flags & FL_SWIM) && SV_PointContents(trace.endpos) == CONTENTS_EMPTY )
+				if ( ((int)ent->hot->flags & FL_SWIM) && SV_PointContents(trace.endpos) == CONTENTS_EMPTY )
 					return false;	// swim monster left water
 
-				VectorCopy (trace.endpos, ent->v.origin);
+				VectorCopy (trace.endpos, ent->hot->origin);
 				if (relink)
 					SV_LinkEdict (ent, true);
 				return true;
@@ -162,7 +169,7 @@ qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink)
 	VectorCopy (neworg, end);
 	end[2] -= STEPSIZE*2;
 
-	trace = SV_Move (neworg, ent->v.mins, ent->v.maxs, end, false, ent);
+	trace = SV_MoveCached (neworg, ent->v.mins, ent->v.maxs, end, false, ent);
 
 	if (trace.allsolid)
 		return false;
@@ -170,19 +177,20 @@ qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink)
 	if (trace.startsolid)
 	{
 		neworg[2] -= STEPSIZE;
-		trace = SV_Move (neworg, ent->v.mins, ent->v.maxs, end, false, ent);
+		trace = SV_MoveCached (neworg, ent->v.mins, ent->v.maxs, end, false, ent);
 		if (trace.allsolid || trace.startsolid)
 			return false;
 	}
 	if (trace.fraction == 1)
 	{
 	// if monster had the ground pulled out, go ahead and fall
-		if ( (int)ent->v.flags & FL_PARTIALGROUND )
+		if ( (int)ent->hot->flags & FL_PARTIALGROUND )
 		{
-			VectorAdd (ent->v.origin, move, ent->v.origin);
+			VectorAdd (ent->hot->origin, move, ent->hot->origin);
 			if (relink)
 				SV_LinkEdict (ent, true);
-			ent->v.flags = (int)ent->v.flags & ~FL_ONGROUND;
+			ent->hot->flags = (int)ent->hot->flags & ~FL_ONGROUND;
+			SV_WakeEdict (NUM_FOR_EDICT(ent));
 		//	Con_Printf ("fall down\n");
 			return true;
 		}
@@ -191,25 +199,25 @@ qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink)
 	}
 
 // check point traces down for dangling corners
-	VectorCopy (trace.endpos, ent->v.origin);
+	VectorCopy (trace.endpos, ent->hot->origin);
 
 	if (!SV_CheckBottom (ent))
 	{
-		if ( (int)ent->v.flags & FL_PARTIALGROUND )
+		if ( (int)ent->hot->flags & FL_PARTIALGROUND )
 		{	// entity had floor mostly pulled out from underneath it
 			// and is trying to correct
 			if (relink)
 				SV_LinkEdict (ent, true);
 			return true;
 		}
-		VectorCopy (oldorg, ent->v.origin);
+		VectorCopy (oldorg, ent->hot->origin);
 		return false;
 	}
 
-	if ( (int)ent->v.flags & FL_PARTIALGROUND )
+	if ( (int)ent->hot->flags & FL_PARTIALGROUND )
 	{
 	//	Con_Printf ("back on ground\n");
-		ent->v.flags = (int)ent->v.flags & ~FL_PARTIALGROUND;
+		ent->hot->flags = (int)ent->hot->flags & ~FL_PARTIALGROUND;
 	}
 	ent->v.groundentity = EDICT_TO_PROG(trace.ent);
 
@@ -245,13 +253,13 @@ qboolean SV_StepDirection (edict_t *ent, float yaw, float dist)
 	move[1] = sin(yaw)*dist;
 	move[2] = 0;
 
-	VectorCopy (ent->v.origin, oldorigin);
+	VectorCopy (ent->hot->origin, oldorigin);
 	if (SV_movestep (ent, move, false))
 	{
 		delta = ent->v.angles[YAW] - ent->v.ideal_yaw;
 		if (delta > 45 && delta < 315)
 		{		// not turned far enough, so don't take the step
-			VectorCopy (oldorigin, ent->v.origin);
+			VectorCopy (oldorigin, ent->hot->origin);
 		}
 		SV_LinkEdict (ent, true);
 		return true;
@@ -270,7 +278,7 @@ SV_FixCheckBottom
 void SV_FixCheckBottom (edict_t *ent)
 {
 //	Con_Printf ("SV_FixCheckBottom\n");
-	ent->v.flags = (int)ent->v.flags | FL_PARTIALGROUND;
+	ent->hot->flags = (int)ent->hot->flags | FL_PARTIALGROUND;
 }
 
 
@@ -290,8 +298,8 @@ void SV_NewChaseDir (edict_t *actor, edict_t *enemy, float dist)
 	olddir = anglemod( (int)(actor->v.ideal_yaw/45)*45 );
 	turnaround = anglemod(olddir - 180);
 
-	deltax = enemy->v.origin[0] - actor->v.origin[0];
-	deltay = enemy->v.origin[1] - actor->v.origin[1];
+	deltax = enemy->hot->origin[0] - actor->hot->origin[0];
+	deltay = enemy->hot->origin[1] - actor->hot->origin[1];
 	if (deltax>10)
 		d[1]= 0;
 	else if (deltax<-10)
@@ -399,7 +407,7 @@ void SV_MoveToGoal (void)
 	goal = PROG_TO_EDICT(ent->v.goalentity);
 	dist = G_FLOAT(OFS_PARM0);
 
-	if ( !( (int)ent->v.flags & (FL_ONGROUND|FL_FLY|FL_SWIM) ) )
+	if ( !( (int)ent->hot->flags & (FL_ONGROUND|FL_FLY|FL_SWIM) ) )
 	{
 		G_FLOAT(OFS_RETURN) = 0;
 		return;
@@ -47,6 +47,7 @@ cvar_t	sv_gravity = 			{"sv_gravity","800",CVAR_NOTIFY|CVAR_SERVERINFO};
 cvar_t	sv_maxvelocity = 		{"sv_maxvelocity","2000",CVAR_NONE};
 cvar_t	sv_nostep = 			{"sv_nostep","0",CVAR_NONE};
 cvar_t	sv_freezenonclients = 	{"sv_freezenonclients","0",CVAR_NONE};
+cvar_t	sv_thinkwheel = 		{"sv_thinkwheel","1",CVAR_NONE};
 
 
 #define	MOVE_EPSILON	0.01
@@ -67,11 +68,11 @@ void SV_CheckAllEnts (void)
 	check = NEXT_EDICT(sv.edicts);
 	for (e=1 ; e<sv.num_edicts ; e++, check = NEXT_EDICT(check))
 	{
-		if (check->free)
+		if (check->hot->free)
 			continue;
-		if (check->v.movetype == MOVETYPE_PUSH
-		|| check->v.movetype == MOVETYPE_NONE
-		|| check->v.movetype == MOVETYPE_NOCLIP)
+		if (check->hot->movetype == MOVETYPE_PUSH
+		|| check->hot->movetype == MOVETYPE_NONE
+		|| check->hot->movetype == MOVETYPE_NOCLIP)
 			continue;
 
 		if (SV_TestEntityPosition (check))
@@ -93,20 +94,20 @@ void SV_CheckVelocity (edict_t *ent)
 //
 	for (i=0 ; i<3 ; i++)
 	{
-		if (IS_NAN(ent->v.velocity[i]))
+		if (IS_NAN(ent->hot->velocity[i]))
 		{
 			Con_Printf ("Got a NaN velocity on %s\n", PR_GetString(ent->v.classname));
-			ent->v.velocity[i] = 0;
+			ent->hot->velocity[i] = 0;
 		}
-		if (IS_NAN(ent->v.origin[i]))
+		if (IS_NAN(ent->hot->origin[i]))
 		{
 			Con_Printf ("Got a NaN origin on %s\n", PR_GetString(ent->v.classname));
-			ent->v.origin[i] = 0;
+			ent->hot->origin[i] = 0;
 		}
-		if (ent->v.velocity[i] > sv_maxvelocity.value)
-			ent->v.velocity[i] = sv_maxvelocity.value;
-		else if (ent->v.velocity[i] < -sv_maxvelocity.value)
-			ent->v.velocity[i] = -sv_maxvelocity.value;
+		if (ent->hot->velocity[i] > sv_maxvelocity.value)
+			ent->hot->velocity[i] = sv_maxvelocity.value;
+		else if (ent->hot->velocity[i] < -sv_maxvelocity.value)
+			ent->hot->velocity[i] = -sv_maxvelocity.value;
 	}
 }
 
@@ -124,7 +125,7 @@ qboolean SV_RunThink (edict_t *ent)
 {
 	float	thinktime;
 
-	thinktime = ent->v.nextthink;
+	thinktime = ent->hot->nextthink;
 	if (thinktime <= 0 || thinktime > sv.time + host_frametime)
 		return true;
 
@@ -136,13 +137,13 @@ qboolean SV_RunThink (edict_t *ent)
 	ent->oldthinktime = thinktime;
 	ent->oldframe = ent->v.frame; //johnfitz
 
-	ent->v.nextthink = 0;
+	ent->hot->nextthink = 0;
 	pr_global_struct->time = thinktime;
 	pr_global_struct->self = EDICT_TO_PROG(ent);
 	pr_global_struct->other = EDICT_TO_PROG(sv.edicts);
 	PR_ExecuteProgram (ent->v.think);
 
-	return !ent->free;
+	return !ent->hot->free;
 }
 
 /*
@@ -160,14 +161,14 @@ void SV_Impact (edict_t *e1, edict_t *e2)
 	old_other = pr_global_struct->other;
 
 	pr_global_struct->time = sv.time;
-	if (e1->v.touch && e1->v.solid != SOLID_NOT)
+	if (e1->v.touch && e1->hot->solid != SOLID_NOT)
 	{
 		pr_global_struct->self = EDICT_TO_PROG(e1);
 		pr_global_struct->other = EDICT_TO_PROG(e2);
 		PR_ExecuteProgram (e1->v.touch);
 	}
 
-	if (e2->v.touch && e2->v.solid != SOLID_NOT)
+	if (e2->v.touch && e2->hot->solid != SOLID_NOT)
 	{
 		pr_global_struct->self = EDICT_TO_PROG(e2);
 		pr_global_struct->other = EDICT_TO_PROG(e1);
@@ -245,32 +246,32 @@ int SV_FlyMove (edict_t *ent, float time, trace_t *steptrace)
 	numbumps = 4;
 
 	blocked = 0;
-	VectorCopy (ent->v.velocity, original_velocity);
-	VectorCopy (ent->v.velocity, primal_velocity);
+	VectorCopy (ent->hot->velocity, original_velocity);
+	VectorCopy (ent->hot->velocity, primal_velocity);
 	numplanes = 0;
 
 	time_left = time;
 
 	for (bumpcount=0 ; bumpcount<numbumps ; bumpcount++)
 	{
-		if (!ent->v.velocity[0] && !ent->v.velocity[1] && !ent->v.velocity[2])
+		if (!ent->hot->velocity[0] && !ent->hot->velocity[1] && !ent->hot->velocity[2])
 			break;
 
 		for (i=0 ; i<3 ; i++)
-			end[i] = ent->v.origin[i] + time_left * ent->v.velocity[i];
+			end[i] = ent->hot->origin[i] + time_left * ent->hot->velocity[i];
 
-		trace = SV_Move (ent->v.origin, ent->v.mins, ent->v.maxs, end, false, ent);
+		trace = SV_Move (ent->hot->origin, ent->v.mins, ent->v.maxs, end, false, ent);
 
 		if (trace.allsolid)
 		{	// entity is trapped in another solid
-			VectorCopy (vec3_origin, ent->v.velocity);
+			VectorCopy (vec3_origin, ent->hot->velocity);
 			return 3;
 		}
 
 		if (trace.fraction > 0)
 		{	// actually covered some distance
-			VectorCopy (trace.endpos, ent->v.origin);
-			VectorCopy (ent->v.velocity, original_velocity);
+			VectorCopy (trace.endpos, ent->hot->origin);
+			VectorCopy (ent->hot->velocity, original_velocity);
 			numplanes = 0;
 		}
 
@@ -283,9 +284,9 @@ int SV_FlyMove (edict_t *ent, float time, trace_t *steptrace)
 		if (trace.plane.normal[2] > 0.7)
 		{
 			blocked |= 1;		// floor
-			if (trace.ent->v.solid == SOLID_BSP)
+			if (trace.ent->hot->solid == SOLID_BSP)
 			{
-				ent->v.flags =	(int)ent->v.flags | FL_ONGROUND;
+				ent->hot->flags =	(int)ent->hot->flags | FL_ONGROUND;
 				ent->v.groundentity = EDICT_TO_PROG(trace.ent);
 			}
 		}
@@ -300,7 +301,7 @@ int SV_FlyMove (edict_t *ent, float time, trace_t *steptrace)
 // run the impact function
 //
 		SV_Impact (ent, trace.ent);
-		if (ent->free)
+		if (ent->hot->free)
 			break;		// removed by the impact function
 
 
@@ -309,7 +310,7 @@ int SV_FlyMove (edict_t *ent, float time, trace_t *steptrace)
 	// cliped to another plane
 		if (numplanes >= MAX_CLIP_PLANES)
 		{	// this shouldn't really happen
-			VectorCopy (vec3_origin, ent->v.velocity);
+			VectorCopy (vec3_origin, ent->hot->velocity);
 			return 3;
 		}
 
@@ -334,28 +335,28 @@ int SV_FlyMove (edict_t *ent, float time, trace_t *steptrace)
 
 		if (i != numplanes)
 		{	// go along this plane
-			VectorCopy (new_velocity, ent->v.velocity);
+			VectorCopy (new_velocity, ent->hot->velocity);
 		}
 		else
 		{	// go along the crease
 			if (numplanes != 2)
 			{
 //				Con_Printf ("clip velocity, numplanes == %i\n",numplanes);
-				VectorCopy (vec3_origin, ent->v.velocity);
+				VectorCopy (vec3_origin, ent->hot->velocity);
 				return 7;
 			}
 			CrossProduct (planes[0], planes[1], dir);
-			d = DotProduct (dir, ent->v.velocity);
-			VectorScale (dir, d, ent->v.velocity);
+			d = DotProduct (dir, ent->hot->velocity);
+			VectorScale (dir, d, ent->hot->velocity);
 		}
 
 //
 // if original velocity is against the original velocity, stop dead
 // to avoid tiny occilations in sloping corners
 //
-		if (DotProduct (ent->v.velocity, primal_velocity) <= 0)
+		if (DotProduct (ent->hot->velocity, primal_velocity) <= 0)
 		{
-			VectorCopy (vec3_origin, ent->v.velocity);
+			VectorCopy (vec3_origin, ent->hot->velocity);
 			return blocked;
 		}
 	}
@@ -375,13 +376,13 @@ void SV_AddGravity (edict_t *ent)
 	float	ent_gravity;
 	eval_t	*val;
 
-	val = GetEdictFieldValue(ent, "gravity");
+	val = GetEdictFieldOfs(ent, pr_extfields.gravity);
 	if (val && val->_float)
 		ent_gravity = val->_float;
 	else
 		ent_gravity = 1.0;
 
-	ent->v.velocity[2] -= ent_gravity * sv_gravity.value * host_frametime;
+	ent->hot->velocity[2] -= ent_gravity * sv_gravity.value * host_frametime;
 }
 
 
@@ -405,17 +406,17 @@ trace_t SV_PushEntity (edict_t *ent, vec3_t push)
 	trace_t	trace;
 	vec3_t	end;
 
-	VectorAdd (ent->v.origin, push, end);
+	VectorAdd (ent->hot->origin, push, end);
 
-	if (ent->v.movetype == MOVETYPE_FLYMISSILE)
-		trace = SV_Move (ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_MISSILE, ent);
-	else if (ent->v.solid == SOLID_TRIGGER || ent->v.solid == SOLID_NOT)
+	if (ent->hot->movetype == MOVETYPE_FLYMISSILE)
+		trace = SV_Move (ent->hot->origin, ent->v.mins, ent->v.maxs, end, MOVE_MISSILE, ent);
+	else if (ent->hot->solid == SOLID_TRIGGER || ent->hot->solid == SOLID_NOT)
 	// only clip against bmodels
-		trace = SV_Move (ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_NOMONSTERS, ent);
+		trace = SV_Move (ent->hot->origin, ent->v.mins, ent->v.maxs, end, MOVE_NOMONSTERS, ent);
 	else
-		trace = SV_Move (ent->v.origin, ent->v.mins, ent->v.maxs, end, MOVE_NORMAL, ent);
+		trace = SV_Move (ent->hot->origin, ent->v.mins, ent->v.maxs, end, MOVE_NORMAL, ent);
 
-	VectorCopy (trace.endpos, ent->v.origin);
+	VectorCopy (trace.endpos, ent->hot->origin);
 	SV_LinkEdict (ent, true);
 
 	if (trace.ent)
@@ -437,11 +438,11 @@ void SV_PushMove (edict_t *pusher, float movetime)
 	vec3_t		mins, maxs, move;
 	vec3_t		entorig, pushorig;
 	int			num_moved;
-	edict_t		**moved_edict; //johnfitz -- dynamically allocate
-	vec3_t		*moved_from; //johnfitz -- dynamically allocate
-	int			mark; //johnfitz
+	static edict_t	**moved_edict; //johnfitz -- dynamically allocate
+	static vec3_t	*moved_from; //johnfitz -- dynamically allocate
+	static int		maxmoved;	// malloc'd, see SV_TouchLinks
 
-	if (!pusher->v.velocity[0] && !pusher->v.velocity[1] && !pusher->v.velocity[2])
+	if (!pusher->hot->velocity[0] && !pusher->hot->velocity[1] && !pusher->hot->velocity[2])
 	{
 		pusher->v.ltime += movetime;
 		return;
@@ -449,23 +450,28 @@ void SV_PushMove (edict_t *pusher, float movetime)
 
 	for (i=0 ; i<3 ; i++)
 	{
-		move[i] = pusher->v.velocity[i] * movetime;
+		move[i] = pusher->hot->velocity[i] * movetime;
 		mins[i] = pusher->v.absmin[i] + move[i];
 		maxs[i] = pusher->v.absmax[i] + move[i];
 	}
 
-	VectorCopy (pusher->v.origin, pushorig);
+	VectorCopy (pusher->hot->origin, pushorig);
 
 // move the pusher to it's final position
 
-	VectorAdd (pusher->v.origin, move, pusher->v.origin);
+	VectorAdd (pusher->hot->origin, move, pusher->hot->origin);
 	pusher->v.ltime += movetime;
 	SV_LinkEdict (pusher, false);
 
 	//johnfitz -- dynamically allocate
-	mark = Hunk_LowMark ();
-	moved_edict = (edict_t **) Hunk_Alloc (sv.num_edicts*sizeof(edict_t *));
-	moved_from = (vec3_t *) Hunk_Alloc (sv.num_edicts*sizeof(vec3_t));
+	if (maxmoved < sv.num_edicts)
+	{
+		maxmoved = q_max (sv.num_edicts, maxmoved * 2);
+		moved_edict = (edict_t **) realloc (moved_edict, maxmoved*sizeof(edict_t *));
+		moved_from = (vec3_t *) realloc (moved_from, maxmoved*sizeof(vec3_t));
+		if (!moved_edict || !moved_from)
+			Sys_Error ("SV_PushMove: out of memory");
+	}
 	//johnfitz
 
 // see if any solid entities are inside the final position
@@ -473,15 +479,15 @@ void SV_PushMove (edict_t *pusher, float movetime)
 	check = NEXT_EDICT(sv.edicts);
 	for (e=1 ; e<sv.num_edicts ; e++, check = NEXT_EDICT(check))
 	{
-		if (check->free)
+		if (check->hot->free)
 			continue;
-		if (check->v.movetype == MOVETYPE_PUSH
-		|| check->v.movetype == MOVETYPE_NONE
-		|| check->v.movetype == MOVETYPE_NOCLIP)
+		if (check->hot->movetype == MOVETYPE_PUSH
+		|| check->hot->movetype == MOVETYPE_NONE
+		|| check->hot->movetype == MOVETYPE_NOCLIP)
 			continue;
 
 	// if the entity is standing on the pusher, it will definately be moved
-		if ( ! ( ((int)check->v.flags & FL_ONGROUND)
+		if ( ! ( ((int)check->hot->flags & FL_ONGROUND)
 		&& PROG_TO_EDICT(check->v.groundentity) == pusher) )
 		{
 			if ( check->v.absmin[0] >= maxs[0]
@@ -498,18 +504,19 @@ void SV_PushMove (edict_t *pusher, float movetime)
 		}
 
 	// remove the onground flag for non-players
-		if (check->v.movetype != MOVETYPE_WALK)
-			check->v.flags = (int)check->v.flags & ~FL_ONGROUND;
+		if (check->hot->movetype != MOVETYPE_WALK)
+			check->hot->flags = (int)check->hot->flags & ~FL_ONGROUND;
+		SV_WakeEdict (e);
 
-		VectorCopy (check->v.origin, entorig);
-		VectorCopy (check->v.origin, moved_from[num_moved]);
+		VectorCopy (check->hot->origin, entorig);
+		VectorCopy (check->hot->origin, moved_from[num_moved]);
 		moved_edict[num_moved] = check;
 		num_moved++;
 
 		// try moving the contacted entity
-		pusher->v.solid = SOLID_NOT;
+		pusher->hot->solid = SOLID_NOT;
 		SV_PushEntity (check, move);
-		pusher->v.solid = SOLID_BSP;
+		pusher->hot->solid = SOLID_BSP;
 
 	// if it is still inside the pusher, block
 		block = SV_TestEntityPosition (check);
@@ -517,17 +524,17 @@ void SV_PushMove (edict_t *pusher, float movetime)
 		{	// fail the move
 			if (check->v.mins[0] == check->v.maxs[0])
 				continue;
-			if (check->v.solid == SOLID_NOT || check->v.solid == SOLID_TRIGGER)
+			if (check->hot->solid == SOLID_NOT || check->hot->solid == SOLID_TRIGGER)
 			{	// corpse
 				check->v.mins[0] = check->v.mins[1] = 0;
 				VectorCopy (check->v.mins, check->v.maxs);
 				continue;
 			}
 
-			VectorCopy (entorig, check->v.origin);
+			VectorCopy (entorig, check->hot->origin);
 			SV_LinkEdict (check, true);
 
-			VectorCopy (pushorig, pusher->v.origin);
+			VectorCopy (pushorig, pusher->hot->origin);
 			SV_LinkEdict (pusher, false);
 			pusher->v.ltime -= movetime;
 
@@ -543,15 +550,13 @@ void SV_PushMove (edict_t *pusher, float movetime)
 		// move back any entities we already moved
 			for (i=0 ; i<num_moved ; i++)
 			{
-				VectorCopy (moved_from[i], moved_edict[i]->v.origin);
+				VectorCopy (moved_from[i], moved_edict[i]->hot->origin);
 				SV_LinkEdict (moved_edict[i], false);
 			}
-			Hunk_FreeToLowMark (mark); //johnfitz
 			return;
 		}
 	}
 
-	Hunk_FreeToLowMark (mark); //johnfitz
 
 }
 
@@ -569,7 +574,7 @@ void SV_Physics_Pusher (edict_t *ent)
 
 	oldltime = ent->v.ltime;
 
-	thinktime = ent->v.nextthink;
+	thinktime = ent->hot->nextthink;
 	if (thinktime < ent->v.ltime + host_frametime)
 	{
 		movetime = thinktime - ent->v.ltime;
@@ -586,12 +591,12 @@ void SV_Physics_Pusher (edict_t *ent)
 
 	if (thinktime > oldltime && thinktime <= ent->v.ltime)
 	{
-		ent->v.nextthink = 0;
+		ent->hot->nextthink = 0;
 		pr_global_struct->time = sv.time;
 		pr_global_struct->self = EDICT_TO_PROG(ent);
 		pr_global_struct->other = EDICT_TO_PROG(sv.edicts);
 		PR_ExecuteProgram (ent->v.think);
-		if (ent->free)
+		if (ent->hot->free)
 			return;
 	}
 
@@ -622,12 +627,12 @@ void SV_CheckStuck (edict_t *ent)
 
 	if (!SV_TestEntityPosition(ent))
 	{
-		VectorCopy (ent->v.origin, ent->v.oldorigin);
+		VectorCopy (ent->hot->origin, ent->v.oldorigin);
 		return;
 	}
 
-	VectorCopy (ent->v.origin, org);
-	VectorCopy (ent->v.oldorigin, ent->v.origin);
+	VectorCopy (ent->hot->origin, org);
+	VectorCopy (ent->v.oldorigin, ent->hot->origin);
 	if (!SV_TestEntityPosition(ent))
 	{
 		Con_DPrintf ("Unstuck.\n");
@@ -639,9 +644,9 @@ void SV_CheckStuck (edict_t *ent)
 		for (i=-1 ; i <= 1 ; i++)
 			for (j=-1 ; j <= 1 ; j++)
 			{
-				ent->v.origin[0] = org[0] + i;
-				ent->v.origin[1] = org[1] + j;
-				ent->v.origin[2] = org[2] + z;
+				ent->hot->origin[0] = org[0] + i;
+				ent->hot->origin[1] = org[1] + j;
+				ent->hot->origin[2] = org[2] + z;
 				if (!SV_TestEntityPosition(ent))
 				{
 					Con_DPrintf ("Unstuck.\n");
@@ -650,7 +655,7 @@ void SV_CheckStuck (edict_t *ent)
 				}
 			}
 
-	VectorCopy (org, ent->v.origin);
+	VectorCopy (org, ent->hot->origin);
 	Con_DPrintf ("player is stuck.\n");
 }
 
@@ -665,9 +670,9 @@ qboolean SV_CheckWater (edict_t *ent)
 	vec3_t	point;
 	int		cont;
 
-	point[0] = ent->v.origin[0];
-	point[1] = ent->v.origin[1];
-	point[2] = ent->v.origin[2] + ent->v.mins[2] + 1;
+	point[0] = ent->hot->origin[0];
+	point[1] = ent->hot->origin[1];
+	point[2] = ent->hot->origin[2] + ent->v.mins[2] + 1;
 
 	ent->v.waterlevel = 0;
 	ent->v.watertype = CONTENTS_EMPTY;
@@ -676,12 +681,12 @@ qboolean SV_CheckWater (edict_t *ent)
 	{
 		ent->v.watertype = cont;
 		ent->v.waterlevel = 1;
-		point[2] = ent->v.origin[2] + (ent->v.mins[2] + ent->v.maxs[2])*0.5;
+		point[2] = ent->hot->origin[2] + (ent->v.mins[2] + ent->v.maxs[2])*0.5;
 		cont = SV_PointContents (point);
 		if (cont <= CONTENTS_WATER)
 		{
 			ent->v.waterlevel = 2;
-			point[2] = ent->v.origin[2] + ent->v.view_ofs[2];
+			point[2] = ent->hot->origin[2] + ent->v.view_ofs[2];
 			cont = SV_PointContents (point);
 			if (cont <= CONTENTS_WATER)
 				ent->v.waterlevel = 3;
@@ -711,12 +716,12 @@ void SV_WallFriction (edict_t *ent, trace_t *trace)
 		return;
 
 // cut the tangential velocity
-	i = DotProduct (trace->plane.normal, ent->v.velocity);
+	i = DotProduct (trace->plane.normal, ent->hot->velocity);
 	VectorScale (trace->plane.normal, i, into);
-	VectorSubtract (ent->v.velocity, into, side);
+	VectorSubtract (ent->hot->velocity, into, side);
 
-	ent->v.velocity[0] = side[0] * (1 + d);
-	ent->v.velocity[1] = side[1] * (1 + d);
+	ent->hot->velocity[0] = side[0] * (1 + d);
+	ent->hot->velocity[1] = side[1] * (1 + d);
 }
 
 /*
@@ -739,7 +744,7 @@ int SV_TryUnstick (edict_t *ent, vec3_t oldvel)
 	int		clip;
 	trace_t	steptrace;
 
-	VectorCopy (ent->v.origin, oldorg);
+	VectorCopy (ent->hot->origin, oldorg);
 	VectorCopy (vec3_origin, dir);
 
 	for (i=0 ; i<8 ; i++)
@@ -760,23 +765,23 @@ int SV_TryUnstick (edict_t *ent, vec3_t oldvel)
 		SV_PushEntity (ent, dir);
 
 // retry the original move
-		ent->v.velocity[0] = oldvel[0];
+		ent->hot->velocity[0] = oldvel[0];
 		ent->v. velocity[1] = oldvel[1];
 		ent->v. velocity[2] = 0;
 		clip = SV_FlyMove (ent, 0.1, &steptrace);
 
-		if ( fabs(oldorg[1] - ent->v.origin[1]) > 4
-			|| fabs(oldorg[0] - ent->v.origin[0]) > 4 )
+		if ( fabs(oldorg[1] - ent->hot->origin[1]) > 4
+			|| fabs(oldorg[0] - ent->hot->origin[0]) > 4 )
 		{
 		//	Con_DPrintf ("unstuck!\n");
 			return clip;
 		}
 
 // go back to the original pos and try again
-		VectorCopy (oldorg, ent->v.origin);
+		VectorCopy (oldorg, ent->hot->origin);
 	}
 
-	VectorCopy (vec3_origin, ent->v.velocity);
+	VectorCopy (vec3_origin, ent->hot->velocity);
 	return 7;		// still not moving
 }
 
@@ -800,11 +805,11 @@ void SV_WalkMove (edict_t *ent)
 //
 // do a regular slide move unless it looks like you ran into a step
 //
-	oldonground = (int)ent->v.flags & FL_ONGROUND;
-	ent->v.flags = (int)ent->v.flags & ~FL_ONGROUND;
+	oldonground = (int)ent->hot->flags & FL_ONGROUND;
+	ent->hot->flags = (int)ent->hot->flags & ~FL_ONGROUND;
 
-	VectorCopy (ent->v.origin, oldorg);
-	VectorCopy (ent->v.velocity, oldvel);
+	VectorCopy (ent->hot->origin, oldorg);
+	VectorCopy (ent->hot->velocity, oldvel);
 
 	clip = SV_FlyMove (ent, host_frametime, &steptrace);
 
@@ -814,22 +819,22 @@ void SV_WalkMove (edict_t *ent)
 	if (!oldonground && ent->v.waterlevel == 0)
 		return;		// don't stair up while jumping
 
-	if (ent->v.movetype != MOVETYPE_WALK)
+	if (ent->hot->movetype != MOVETYPE_WALK)
 		return;		// gibbed by a trigger
 
 	if (sv_nostep.value)
 		return;
 
-	if ( (int)sv_player->v.flags & FL_WATERJUMP )
+	if ( (int)sv_player->hot->flags & FL_WATERJUMP )
 		return;
 
-	VectorCopy (ent->v.origin, nosteporg);
-	VectorCopy (ent->v.velocity, nostepvel);
+	VectorCopy (ent->hot->origin, nosteporg);
+	VectorCopy (ent->hot->velocity, nostepvel);
 
 //
 // try moving up and forward to go up a step
 //
-	VectorCopy (oldorg, ent->v.origin);	// back to start pos
+	VectorCopy (oldorg, ent->hot->origin);	// back to start pos
 
 	VectorCopy (vec3_origin, upmove);
 	VectorCopy (vec3_origin, downmove);
@@ -840,7 +845,7 @@ void SV_WalkMove (edict_t *ent)
 	SV_PushEntity (ent, upmove);	// FIXME: don't link?
 
 // move forward
-	ent->v.velocity[0] = oldvel[0];
+	ent->hot->velocity[0] = oldvel[0];
 	ent->v. velocity[1] = oldvel[1];
 	ent->v. velocity[2] = 0;
 	clip = SV_FlyMove (ent, host_frametime, &steptrace);
@@ -849,8 +854,8 @@ void SV_WalkMove (edict_t *ent)
 // in the clipping hulls
 	if (clip)
 	{
-		if ( fabs(oldorg[1] - ent->v.origin[1]) < 0.03125
-		&& fabs(oldorg[0] - ent->v.origin[0]) < 0.03125 )
+		if ( fabs(oldorg[1] - ent->hot->origin[1]) < 0.03125
+		&& fabs(oldorg[0] - ent->hot->origin[0]) < 0.03125 )
 		{	// stepping up didn't make any progress
 			clip = SV_TryUnstick (ent, oldvel);
 		}
@@ -865,9 +870,9 @@ void SV_WalkMove (edict_t *ent)
 
 	if (downtrace.plane.normal[2] > 0.7)
 	{
-		if (ent->v.solid == SOLID_BSP)
+		if (ent->hot->solid == SOLID_BSP)
 		{
-			ent->v.flags =	(int)ent->v.flags | FL_ONGROUND;
+			ent->hot->flags =	(int)ent->hot->flags | FL_ONGROUND;
 			ent->v.groundentity = EDICT_TO_PROG(downtrace.ent);
 		}
 	}
@@ -876,8 +881,8 @@ void SV_WalkMove (edict_t *ent)
 // if the push down didn't end up on good ground, use the move without
 // the step up.  This happens near wall / slope combinations, and can
 // cause the player to hop up higher on a slope too steep to climb
-		VectorCopy (nosteporg, ent->v.origin);
-		VectorCopy (nostepvel, ent->v.velocity);
+		VectorCopy (nosteporg, ent->hot->origin);
+		VectorCopy (nostepvel, ent->hot->velocity);
 	}
 }
 
@@ -909,7 +914,7 @@ void SV_Physics_Client (edict_t	*ent, int num)
 //
 // decide which move function to call
 //
-	switch ((int)ent->v.movetype)
+	switch ((int)ent->hot->movetype)
 	{
 	case MOVETYPE_NONE:
 		if (!SV_RunThink (ent))
@@ -919,7 +924,7 @@ void SV_Physics_Client (edict_t	*ent, int num)
 	case MOVETYPE_WALK:
 		if (!SV_RunThink (ent))
 			return;
-		if (!SV_CheckWater (ent) && ! ((int)ent->v.flags & FL_WATERJUMP) )
+		if (!SV_CheckWater (ent) && ! ((int)ent->hot->flags & FL_WATERJUMP) )
 			SV_AddGravity (ent);
 		SV_CheckStuck (ent);
 		SV_WalkMove (ent);
@@ -940,11 +945,11 @@ void SV_Physics_Client (edict_t	*ent, int num)
 	case MOVETYPE_NOCLIP:
 		if (!SV_RunThink (ent))
 			return;
-		VectorMA (ent->v.origin, host_frametime, ent->v.velocity, ent->v.origin);
+		VectorMA (ent->hot->origin, host_frametime, ent->hot->velocity, ent->hot->origin);
 		break;
 
 	default:
-		Sys_Error ("SV_Physics_client: bad movetype %i", (int)ent->v.movetype);
+		Sys_Error ("SV_Physics_client: bad movetype %i", (int)ent->hot->movetype);
 	}
 
 //
@@ -986,7 +991,7 @@ void SV_Physics_Noclip (edict_t *ent)
 		return;
 
 	VectorMA (ent->v.angles, host_frametime, ent->v.avelocity, ent->v.angles);
-	VectorMA (ent->v.origin, host_frametime, ent->v.velocity, ent->v.origin);
+	VectorMA (ent->hot->origin, host_frametime, ent->hot->velocity, ent->hot->origin);
 
 	SV_LinkEdict (ent, false);
 }
@@ -1009,7 +1014,7 @@ void SV_CheckWaterTransition (edict_t *ent)
 {
 	int		cont;
 
-	cont = SV_PointContents (ent->v.origin);
+	cont = SV_PointContents (ent->hot->origin);
 
 	if (!ent->v.watertype)
 	{	// just spawned here
@@ -1056,42 +1061,42 @@ void SV_Physics_Toss (edict_t *ent)
 		return;
 
 // if onground, return without moving
-	if ( ((int)ent->v.flags & FL_ONGROUND) )
+	if ( ((int)ent->hot->flags & FL_ONGROUND) )
 		return;
 
 	SV_CheckVelocity (ent);
 
 // add gravity
-	if (ent->v.movetype != MOVETYPE_FLY
-	&& ent->v.movetype != MOVETYPE_FLYMISSILE)
+	if (ent->hot->movetype != MOVETYPE_FLY
+	&& ent->hot->movetype != MOVETYPE_FLYMISSILE)
 		SV_AddGravity (ent);
 
 // move angles
 	VectorMA (ent->v.angles, host_frametime, ent->v.avelocity, ent->v.angles);
 
 // move origin
-	VectorScale (ent->v.velocity, host_frametime, move);
+	VectorScale (ent->hot->velocity, host_frametime, move);
 	trace = SV_PushEntity (ent, move);
 	if (trace.fraction == 1)
 		return;
-	if (ent->free)
+	if (ent->hot->free)
 		return;
 
-	if (ent->v.movetype == MOVETYPE_BOUNCE)
+	if (ent->hot->movetype == MOVETYPE_BOUNCE)
 		backoff = 1.5;
 	else
 		backoff = 1;
 
-	ClipVelocity (ent->v.velocity, trace.plane.normal, ent->v.velocity, backoff);
+	ClipVelocity (ent->hot->velocity, trace.plane.normal, ent->hot->velocity, backoff);
 
 // stop if on ground
 	if (trace.plane.normal[2] > 0.7)
 	{
-		if (ent->v.velocity[2] < 60 || ent->v.movetype != MOVETYPE_BOUNCE)
+		if (ent->hot->velocity[2] < 60 || ent->hot->movetype != MOVETYPE_BOUNCE)
 		{
-			ent->v.flags = (int)ent->v.flags | FL_ONGROUND;
+			ent->hot->flags = (int)ent->hot->flags | FL_ONGROUND;
 			ent->v.groundentity = EDICT_TO_PROG(trace.ent);
-			VectorCopy (vec3_origin, ent->v.velocity);
+			VectorCopy (vec3_origin, ent->hot->velocity);
 			VectorCopy (vec3_origin, ent->v.avelocity);
 		}
 	}
@@ -1124,9 +1129,9 @@ void SV_Physics_Step (edict_t *ent)
 	qboolean	hitsound;
 
 // freefall if not onground
-	if ( ! ((int)ent->v.flags & (FL_ONGROUND | FL_FLY | FL_SWIM) ) )
+	if ( ! ((int)ent->hot->flags & (FL_ONGROUND | FL_FLY | FL_SWIM) ) )
 	{
-		if (ent->v.velocity[2] < sv_gravity.value*-0.1)
+		if (ent->hot->velocity[2] < sv_gravity.value*-0.1)
 			hitsound = true;
 		else
 			hitsound = false;
@@ -1136,7 +1141,7 @@ void SV_Physics_Step (edict_t *ent)
 		SV_FlyMove (ent, host_frametime, NULL);
 		SV_LinkEdict (ent, true);
 
-		if ( (int)ent->v.flags & FL_ONGROUND )	// just hit ground
+		if ( (int)ent->hot->flags & FL_ONGROUND )	// just hit ground
 		{
 			if (hitsound)
 				SV_StartSound (ent, 0, "demon/dland2.wav", 255, 1);
@@ -1150,6 +1155,151 @@ void SV_Physics_Step (edict_t *ent)
 }
 
 
+/*
+===============================================================================
+
+IDLE EDICTS
+
+Most edicts in a map are lights, triggers and items that do nothing until
+their nextthink comes. Once one is found idle it waits in sv.thinkwheel,
+hashed by nextthink, and SV_Physics only runs the edicts with a bit set in
+sv.physwake. The bits are walked in edict order, so whatever does run still
+runs in the same order as before. QuakeC wakes an edict whenever it takes
+the address of one of its fields.
+
+===============================================================================
+*/
+
+/*
+================
+SV_ThinkKey
+================
+*/
+static int SV_ThinkKey (float time)
+{
+	return (int)floor (time * THINKWHEEL_RATE);
+}
+
+/*
+================
+SV_WakeAllEdicts
+================
+*/
+void SV_WakeAllEdicts (void)
+{
+	memset (sv.physwake, 0xff, ((sv.max_edicts + 31) >> 5) * sizeof(unsigned int));
+}
+
+/*
+================
+SV_UnparkEdict
+================
+*/
+static void SV_UnparkEdict (int e)
+{
+	edictthink_t	*t = &sv.edictthink[e];
+
+	if (!t->waiting)
+		return;
+
+	if (t->prev)
+		sv.edictthink[t->prev].next = t->next;
+	else
+		sv.thinkwheel[t->slot] = t->next;
+	if (t->next)
+		sv.edictthink[t->next].prev = t->prev;
+	t->waiting = false;
+}
+
+/*
+================
+SV_ParkEdict
+
+puts an edict that has nothing to do until its nextthink to sleep
+================
+*/
+static void SV_ParkEdict (edict_t *ent, int e)
+{
+	edictthink_t	*t = &sv.edictthink[e];
+	int		key;
+
+	sv.physwake[e >> 5] &= ~(1u << (e & 31));
+
+	if (ent->hot->nextthink <= 0)
+		return;		// until something wakes it
+
+	key = SV_ThinkKey (ent->hot->nextthink);
+	if (key < sv.thinkwheelkey)
+	{
+		SV_WakeEdict (e);	// its slot has already been emptied
+		return;
+	}
+
+	t->slot = key & (THINKWHEEL_SLOTS - 1);
+	t->prev = 0;
+	t->next = sv.thinkwheel[t->slot];
+	if (t->next)
+		sv.edictthink[t->next].prev = e;
+	sv.thinkwheel[t->slot] = e;
+	t->waiting = true;
+}
+
+/*
+================
+SV_WakeThinkers
+
+wakes every edict whose nextthink may come this frame. a slot also holds
+edicts a whole turn of the wheel later, they just go back to sleep.
+================
+*/
+static void SV_WakeThinkers (void)
+{
+	int		key, last, e, next;
+	int		*slot;
+
+	last = SV_ThinkKey (sv.time + host_frametime);
+	if (last - sv.thinkwheelkey >= THINKWHEEL_SLOTS)
+		sv.thinkwheelkey = last - THINKWHEEL_SLOTS + 1;
+
+	for (key = sv.thinkwheelkey; key <= last; key++)
+	{
+		slot = &sv.thinkwheel[key & (THINKWHEEL_SLOTS - 1)];
+		for (e = *slot; e; e = next)
+		{
+			next = sv.edictthink[e].next;
+			sv.edictthink[e].waiting = false;
+			SV_WakeEdict (e);
+		}
+		*slot = 0;
+	}
+
+	if (sv.thinkwheelkey <= last)
+		sv.thinkwheelkey = last + 1;
+}
+
+/*
+================
+SV_EdictIdle
+
+true if running the edict's physics would do nothing until its nextthink.
+a toss that is on the ground stays put until something moves it.
+================
+*/
+static qboolean SV_EdictIdle (edict_t *ent)
+{
+	if (ent->hot->nextthink > 0 && ent->hot->nextthink <= sv.time + host_frametime)
+		return false;
+	if (ent->hot->movetype == MOVETYPE_NONE)
+		return true;
+	if (ent->hot->movetype == MOVETYPE_TOSS
+	|| ent->hot->movetype == MOVETYPE_GIB
+	|| ent->hot->movetype == MOVETYPE_BOUNCE
+	|| ent->hot->movetype == MOVETYPE_FLY
+	|| ent->hot->movetype == MOVETYPE_FLYMISSILE)
+		return ((int)ent->hot->flags & FL_ONGROUND) != 0;
+	return false;
+}
+
 //============================================================================
 
 /*
@@ -1163,6 +1313,8 @@ void SV_Physics (void)
 	int	i;
 	int	entity_cap; // For sv_freezenonclients 
 	edict_t	*ent;
+	edicthot_t	*hot;
+	unsigned int	bits;
 
 // let the progs know that a new frame has started
 	pr_global_struct->self = EDICT_TO_PROG(sv.edicts);
@@ -1172,22 +1324,42 @@ void SV_Physics (void)
 
 //SV_CheckAllEnts ();
 
+	if (!sv_thinkwheel.value || pr_global_struct->force_retouch)
+		SV_WakeAllEdicts ();
+	else
+		SV_WakeThinkers ();
+
 //
 // treat each object in turn
 //
-	ent = sv.edicts;
-
 	if (sv_freezenonclients.value)
 	  entity_cap = svs.maxclients + 1; // Only run physics on clients and the world
 	else
 	  entity_cap = sv.num_edicts;
 
 	//for (i=0 ; i<sv.num_edicts ; i++, ent = NEXT_EDICT(ent))
-	for (i=0 ; i<entity_cap ; i++, ent = NEXT_EDICT(ent))
+	for (i=0 ; i<entity_cap ; i++)
 	{
-		if (ent->free)
+		// reread each time, running one edict can wake the ones after it
+		bits = sv.physwake[i >> 5];
+		if (!(bits & (1u << (i & 31))))
+		{
+			if (!(bits >> (i & 31)))
+				i |= 31;	// nothing else awake in this word
+			continue;
+		}
+
+		// free and the movetype come from sv.edicthot, so the edict records
+		// are only read for the edicts that run
+		hot = &sv.edicthot[i];
+		SV_UnparkEdict (i);
+		if (hot->free)
+		{
+			sv.physwake[i >> 5] &= ~(1u << (i & 31));
 			continue;
+		}
 
+		ent = (edict_t *)((byte *)sv.edicts + i*pr_edict_size);
 		if (pr_global_struct->force_retouch)
 		{
 			SV_LinkEdict (ent, true);	// force retouch even for stationary
@@ -1195,34 +1367,37 @@ void SV_Physics (void)
 
 		if (i > 0 && i <= svs.maxclients)
 			SV_Physics_Client (ent, i);
-		else if (ent->v.movetype == MOVETYPE_PUSH)
+		else if (hot->movetype == MOVETYPE_PUSH)
 			SV_Physics_Pusher (ent);
-		else if (ent->v.movetype == MOVETYPE_NONE)
+		else if (hot->movetype == MOVETYPE_NONE)
 			SV_Physics_None (ent);
-		else if (ent->v.movetype == MOVETYPE_NOCLIP)
+		else if (hot->movetype == MOVETYPE_NOCLIP)
 			SV_Physics_Noclip (ent);
-		else if (ent->v.movetype == MOVETYPE_STEP)
+		else if (hot->movetype == MOVETYPE_STEP)
 			SV_Physics_Step (ent);
-		else if (ent->v.movetype == MOVETYPE_TOSS
-		|| ent->v.movetype == MOVETYPE_GIB
-		|| ent->v.movetype == MOVETYPE_BOUNCE
-		|| ent->v.movetype == MOVETYPE_FLY
-		|| ent->v.movetype == MOVETYPE_FLYMISSILE)
+		else if (hot->movetype == MOVETYPE_TOSS
+		|| hot->movetype == MOVETYPE_GIB
+		|| hot->movetype == MOVETYPE_BOUNCE
+		|| hot->movetype == MOVETYPE_FLY
+		|| hot->movetype == MOVETYPE_FLYMISSILE)
 			SV_Physics_Toss (ent);
 		else
-			Sys_Error ("SV_Physics: bad movetype %i", (int)ent->v.movetype);
+			Sys_Error ("SV_Physics: bad movetype %i", (int)hot->movetype);
 
 	//johnfitz -- PROTOCOL_FITZQUAKE
 	//capture interval to nextthink here and send it to client for better
 	//lerp timing, but only if interval is not 0.1 (which client assumes)
 		ent->sendinterval = false;
-		if (!ent->free && ent->v.nextthink > sv.time && (ent->v.movetype == MOVETYPE_STEP || ent->v.movetype == MOVETYPE_WALK || ent->v.frame != ent->oldframe))
+		if (!hot->free && hot->nextthink > sv.time && (hot->movetype == MOVETYPE_STEP || hot->movetype == MOVETYPE_WALK || ent->v.frame != ent->oldframe))
 		{
-			int j = Q_rint((ent->v.nextthink-ent->oldthinktime)*255);
+			int j = Q_rint((hot->nextthink-ent->oldthinktime)*255);
 			if (j >= 0 && j < 256 && j != 25 && j != 26) //25 and 26 are close enough to 0.1 to not send
 				ent->sendinterval = true;
 		}
 	//johnfitz
+
+		if (i > svs.maxclients && sv_thinkwheel.value && !hot->free && SV_EdictIdle (ent))
+			SV_ParkEdict (ent, i);
 	}
 
 	if (pr_global_struct->force_retouch)
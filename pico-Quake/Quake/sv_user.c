@@ -58,7 +58,7 @@ void SV_SetIdealPitch (void)
 	int		i, j;
 	int		step, dir, steps;
 
-	if (!((int)sv_player->v.flags & FL_ONGROUND))
+	if (!((int)sv_player->hot->flags & FL_ONGROUND))
 		return;
 
 	angleval = sv_player->v.angles[YAW] * M_PI*2 / 360;
@@ -67,9 +67,9 @@ void SV_SetIdealPitch (void)
 
 	for (i=0 ; i<MAX_FORWARD ; i++)
 	{
-		top[0] = sv_player->v.origin[0] + cosval*(i+3)*12;
-		top[1] = sv_player->v.origin[1] + sinval*(i+3)*12;
-		top[2] = sv_player->v.origin[2] + sv_player->v.view_ofs[2];
+		top[0] = sv_player->hot->origin[0] + cosval*(i+3)*12;
+		top[1] = sv_player->hot->origin[1] + sinval*(i+3)*12;
+		top[2] = sv_player->hot->origin[2] + sv_player->v.view_ofs[2];
 
 		bottom[0] = top[0];
 		bottom[1] = top[1];
@@ -287,11 +287,11 @@ void SV_WaterJump (void)
 	if (sv.time > sv_player->v.teleport_time
 	|| !sv_player->v.waterlevel)
 	{
-		sv_player->v.flags = (int)sv_player->v.flags & ~FL_WATERJUMP;
+		sv_player->hot->flags = (int)sv_player->hot->flags & ~FL_WATERJUMP;
 		sv_player->v.teleport_time = 0;
 	}
-	sv_player->v.velocity[0] = sv_player->v.movedir[0];
-	sv_player->v.velocity[1] = sv_player->v.movedir[1];
+	sv_player->hot->velocity[0] = sv_player->v.movedir[0];
+	sv_player->hot->velocity[1] = sv_player->v.movedir[1];
 }
 
 /*
@@ -341,7 +341,7 @@ void SV_AirMove (void)
 	for (i=0 ; i<3 ; i++)
 		wishvel[i] = forward[i]*fmove + right[i]*smove;
 
-	if ( (int)sv_player->v.movetype != MOVETYPE_WALK)
+	if ( (int)sv_player->hot->movetype != MOVETYPE_WALK)
 		wishvel[2] = cmd.upmove;
 	else
 		wishvel[2] = 0;
@@ -354,7 +354,7 @@ void SV_AirMove (void)
 		wishspeed = sv_maxspeed.value;
 	}
 
-	if ( sv_player->v.movetype == MOVETYPE_NOCLIP)
+	if ( sv_player->hot->movetype == MOVETYPE_NOCLIP)
 	{	// noclip
 		VectorCopy (wishvel, velocity);
 	}
@@ -381,13 +381,13 @@ void SV_ClientThink (void)
 {
 	vec3_t		v_angle;
 
-	if (sv_player->v.movetype == MOVETYPE_NONE)
+	if (sv_player->hot->movetype == MOVETYPE_NONE)
 		return;
 
-	onground = (int)sv_player->v.flags & FL_ONGROUND;
+	onground = (int)sv_player->hot->flags & FL_ONGROUND;
 
-	origin = sv_player->v.origin;
-	velocity = sv_player->v.velocity;
+	origin = sv_player->hot->origin;
+	velocity = sv_player->hot->velocity;
 
 	DropPunchAngle ();
 
@@ -404,14 +404,14 @@ void SV_ClientThink (void)
 	angles = sv_player->v.angles;
 
 	VectorAdd (sv_player->v.v_angle, sv_player->v.punchangle, v_angle);
-	angles[ROLL] = V_CalcRoll (sv_player->v.angles, sv_player->v.velocity)*4;
+	angles[ROLL] = V_CalcRoll (sv_player->v.angles, sv_player->hot->velocity)*4;
 	if (!sv_player->v.fixangle)
 	{
 		angles[PITCH] = -v_angle[PITCH]/3;
 		angles[YAW] = v_angle[YAW];
 	}
 
-	if ( (int)sv_player->v.flags & FL_WATERJUMP )
+	if ( (int)sv_player->hot->flags & FL_WATERJUMP )
 	{
 		SV_WaterJump ();
 		return;
@@ -420,9 +420,9 @@ void SV_ClientThink (void)
 // walk
 //
 	//johnfitz -- alternate noclip
-	if (sv_player->v.movetype == MOVETYPE_NOCLIP && sv_altnoclip.value)
+	if (sv_player->hot->movetype == MOVETYPE_NOCLIP && sv_altnoclip.value)
 		SV_NoclipMove ();
-	else if (sv_player->v.waterlevel >= 2 && sv_player->v.movetype != MOVETYPE_NOCLIP)
+	else if (sv_player->v.waterlevel >= 2 && sv_player->hot->movetype != MOVETYPE_NOCLIP)
 		SV_WaterMove ();
 	else
 		SV_AirMove ();
@@ -483,6 +483,7 @@ qboolean SV_ReadClientMessage (void)
 {
 	int		ret;
 	int		ccmd;
+	int		ack;
 	const char	*s;
 
 	do
@@ -582,6 +583,13 @@ nextmsg:
 			case clc_move:
 				SV_ReadClientMove (&host_client->cmd);
 				break;
+
+			case clc_deltaack:
+				ack = MSG_ReadLong ();
+				if (ack > host_client->deltaack)
+					host_client->deltaack = ack;	// they can come out of order
+				host_client->deltaents = true;
+				break;
 			}
 		}
 	} while (ret == 1);
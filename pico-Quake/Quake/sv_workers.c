@@ -0,0 +1,217 @@
+/*
+Copyright (C) 1996-2001 Id Software, Inc.
+Copyright (C) 2002-2009 John Fitzgibbons and others
+Copyright (C) 2010-2014 QuakeSpasm developers
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sv_workers.c -- threads the server spreads independent jobs over
+
+#include "quakedef.h"
+
+/*
+
+SV_RunJobs calls a job once for each index, spread over sv_threads worker
+threads and the calling one, and returns when they have all finished. The
+jobs may only read the server's shared state and write what belongs to
+their own index or worker: they can't print, raise errors or allocate from
+the hunk. The calling thread is worker 0, the threads 1 and up.
+
+*/
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WORKER_THREADS	1
+#include <pthread.h>
+#else
+#define WORKER_THREADS	0	// every job runs on the calling thread
+#endif
+
+#define	MAX_WORKERS		16
+
+cvar_t	sv_threads = {"sv_threads", "0", CVAR_ARCHIVE};
+
+static void		(*worker_job) (int index, int worker);
+static int		worker_numjobs;
+static int		worker_nextjob;		// taken with an atomic add
+
+#if WORKER_THREADS
+static pthread_t		worker_threads[MAX_WORKERS];
+static int				worker_count;		// started
+static pthread_mutex_t	worker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	worker_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	worker_done = PTHREAD_COND_INITIALIZER;
+static int				worker_generation;	// bumped for each SV_RunJobs
+static int				worker_startgeneration;	// the one the threads were started in
+static int				worker_finished;	// workers through with this generation
+static qboolean			worker_quit;
+#endif
+
+/*
+==================
+SV_DoJobs
+
+takes jobs until there are none left
+==================
+*/
+static void SV_DoJobs (int worker)
+{
+	int		i;
+
+	while ((i = __atomic_fetch_add (&worker_nextjob, 1, __ATOMIC_RELAXED)) < worker_numjobs)
+		worker_job (i, worker);
+}
+
+#if WORKER_THREADS
+/*
+==================
+SV_WorkerMain
+==================
+*/
+static void *SV_WorkerMain (void *arg)
+{
+	int		worker = (int)(intptr_t)arg;
+	int		generation = worker_startgeneration;
+
+	for (;;)
+	{
+		pthread_mutex_lock (&worker_lock);
+		while (!worker_quit && worker_generation == generation)
+			pthread_cond_wait (&worker_wake, &worker_lock);
+		generation = worker_generation;
+		pthread_mutex_unlock (&worker_lock);
+
+		if (worker_quit)
+			break;
+
+		SV_DoJobs (worker);
+
+		// the next SV_RunJobs waits for everyone, so nobody can still be
+		// taking from this one's counter when it's reset
+		pthread_mutex_lock (&worker_lock);
+		if (++worker_finished == worker_count)
+			pthread_cond_signal (&worker_done);
+		pthread_mutex_unlock (&worker_lock);
+	}
+
+	return NULL;
+}
+
+/*
+==================
+SV_StartWorkers
+==================
+*/
+static void SV_StartWorkers (int count)
+{
+	worker_quit = false;
+	worker_startgeneration = worker_generation;
+	for (worker_count = 0; worker_count < count; worker_count++)
+	{
+		if (pthread_create (&worker_threads[worker_count], NULL, SV_WorkerMain, (void *)(intptr_t)(worker_count + 1)) != 0)
+		{
+			Con_Warning ("couldn't start more than %i server threads\n", worker_count);
+			Cvar_SetValueQuick (&sv_threads, worker_count);
+			break;
+		}
+	}
+}
+#endif
+
+/*
+==================
+SV_Workers
+
+starts or stops threads to match sv_threads, and returns how many workers
+there are, counting the calling thread. the jobs are given numbers below it.
+==================
+*/
+int SV_Workers (void)
+{
+#if WORKER_THREADS
+	int		wanted;
+
+	wanted = CLAMP (0, (int)sv_threads.value, MAX_WORKERS);
+	if (wanted != worker_count)
+	{
+		SV_ShutdownWorkers ();
+		SV_StartWorkers (wanted);
+	}
+	return worker_count + 1;
+#else
+	return 1;
+#endif
+}
+
+/*
+==================
+SV_RunJobs
+==================
+*/
+void SV_RunJobs (void (*job) (int index, int worker), int count)
+{
+	SV_Workers ();
+
+	worker_job = job;
+	worker_numjobs = count;
+	worker_nextjob = 0;
+
+#if WORKER_THREADS
+	if (worker_count && count > 1)
+	{
+		pthread_mutex_lock (&worker_lock);
+		worker_finished = 0;
+		worker_generation++;
+		pthread_cond_broadcast (&worker_wake);
+		pthread_mutex_unlock (&worker_lock);
+
+		SV_DoJobs (0);
+
+		pthread_mutex_lock (&worker_lock);
+		while (worker_finished < worker_count)
+			pthread_cond_wait (&worker_done, &worker_lock);
+		pthread_mutex_unlock (&worker_lock);
+		return;
+	}
+#endif
+
+	SV_DoJobs (0);
+}
+
+/*
+==================
+SV_ShutdownWorkers
+==================
+*/
+void SV_ShutdownWorkers (void)
+{
+#if WORKER_THREADS
+	int		i;
+
+	if (!worker_count)
+		return;
+
+	pthread_mutex_lock (&worker_lock);
+	worker_quit = true;
+	pthread_cond_broadcast (&worker_wake);
+	pthread_mutex_unlock (&worker_lock);
+
+	for (i = 0; i < worker_count; i++)
+		pthread_join (worker_threads[i], NULL);
+	worker_count = 0;
+	worker_quit = false;
+#endif
+}
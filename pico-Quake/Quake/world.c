@@ -44,6 +44,33 @@ typedef struct
 	edict_t		*passedict;
 } moveclip_t;
 
+/*
+the results of recent monster moves, which an idle monster asks for again
+every think. a result is only given back while the edicts its box touches
+are all still where and what they were when it was traced.
+*/
+#define	TRACECACHE_SIZE	256		// must be a power of two
+
+typedef struct
+{
+	vec3_t		start, end, mins, maxs;
+	int			type;
+	edict_t		*passedict;
+} tracekey_t;
+
+typedef struct
+{
+	tracekey_t	key;
+	uint64_t	state;		// SV_MoveState when it was traced
+	qboolean	valid;
+	trace_t		trace;
+} tracecache_t;
+
+static	tracecache_t	sv_traces[TRACECACHE_SIZE];
+static	int			sv_tracecachehits, sv_tracecachemisses;
+
+cvar_t	sv_tracecache = {"sv_tracecache", "1", CVAR_NONE};
+
 
 int SV_HullPointContents (hull_t *hull, int num, vec3_t p);
 
@@ -58,13 +85,12 @@ HULL BOXES
 
 static	hull_t		box_hull;
 static	mclipnode_t	box_clipnodes[6]; //johnfitz -- was dclipnode_t
-static	mplane_t	box_planes[6];
 
 /*
 ===================
 SV_InitBoxHull
 
-Set up the planes and clipnodes so that the six floats of a bounding box
+Set up the clipnodes so that the six floats of a bounding box
 can just be stored out and get a proper hull_t structure.
 ===================
 */
@@ -74,14 +100,11 @@ void SV_InitBoxHull (void)
 	int		side;
 
 	box_hull.clipnodes = box_clipnodes;
-	box_hull.planes = box_planes;
 	box_hull.firstclipnode = 0;
 	box_hull.lastclipnode = 5;
 
 	for (i=0 ; i<6 ; i++)
 	{
-		box_clipnodes[i].planenum = i;
-
 		side = i&1;
 
 		box_clipnodes[i].children[side] = CONTENTS_EMPTY;
@@ -90,8 +113,8 @@ void SV_InitBoxHull (void)
 		else
 			box_clipnodes[i].children[side^1] = CONTENTS_SOLID;
 
-		box_planes[i].type = i>>1;
-		box_planes[i].normal[i>>1] = 1;
+		box_clipnodes[i].type = i>>1;
+		box_clipnodes[i].normal[i>>1] = 1;
 	}
 
 }
@@ -107,12 +130,12 @@ BSP trees instead of being compared directly.
 */
 hull_t	*SV_HullForBox (vec3_t mins, vec3_t maxs)
 {
-	box_planes[0].dist = maxs[0];
-	box_planes[1].dist = mins[0];
-	box_planes[2].dist = maxs[1];
-	box_planes[3].dist = mins[1];
-	box_planes[4].dist = maxs[2];
-	box_planes[5].dist = mins[2];
+	box_clipnodes[0].dist = maxs[0];
+	box_clipnodes[1].dist = mins[0];
+	box_clipnodes[2].dist = maxs[1];
+	box_clipnodes[3].dist = mins[1];
+	box_clipnodes[4].dist = maxs[2];
+	box_clipnodes[5].dist = mins[2];
 
 	return &box_hull;
 }
@@ -137,17 +160,17 @@ hull_t *SV_HullForEntity (edict_t *ent, vec3_t mins, vec3_t maxs, vec3_t offset)
 	hull_t		*hull;
 
 // decide which clipping hull to use, based on the size
-	if (ent->v.solid == SOLID_BSP)
+	if (ent->hot->solid == SOLID_BSP)
 	{	// explicit hulls in the BSP model
-		if (ent->v.movetype != MOVETYPE_PUSH)
+		if (ent->hot->movetype != MOVETYPE_PUSH)
 			Host_Error ("SOLID_BSP without MOVETYPE_PUSH (%s at %f %f %f)",
-				    PR_GetString(ent->v.classname), ent->v.origin[0], ent->v.origin[1], ent->v.origin[2]);
+				    PR_GetString(ent->v.classname), ent->hot->origin[0], ent->hot->origin[1], ent->hot->origin[2]);
 
 		model = sv.models[ (int)ent->v.modelindex ];
 
 		if (!model || model->type != mod_brush)
 			Host_Error ("SOLID_BSP with a non bsp model (%s at %f %f %f)",
-				    PR_GetString(ent->v.classname), ent->v.origin[0], ent->v.origin[1], ent->v.origin[2]);
+				    PR_GetString(ent->v.classname), ent->hot->origin[0], ent->hot->origin[1], ent->hot->origin[2]);
 
 		VectorSubtract (maxs, mins, size);
 		if (size[0] < 3)
@@ -159,7 +182,7 @@ hull_t *SV_HullForEntity (edict_t *ent, vec3_t mins, vec3_t maxs, vec3_t offset)
 
 // calculate an offset value to center the origin
 		VectorSubtract (hull->clip_mins, mins, offset);
-		VectorAdd (offset, ent->v.origin, offset);
+		VectorAdd (offset, ent->hot->origin, offset);
 	}
 	else
 	{	// create a temp hull from bounding box sizes
@@ -168,7 +191,7 @@ hull_t *SV_HullForEntity (edict_t *ent, vec3_t mins, vec3_t maxs, vec3_t offset)
 		VectorSubtract (ent->v.maxs, mins, hullmaxs);
 		hull = SV_HullForBox (hullmins, hullmaxs);
 
-		VectorCopy (ent->v.origin, offset);
+		VectorCopy (ent->hot->origin, offset);
 	}
 
 
@@ -190,38 +213,70 @@ typedef struct areanode_s
 	struct areanode_s	*children[2];
 	link_t	trigger_edicts;
 	link_t	solid_edicts;
+
+	vec3_t	mins, maxs;
+	int		depth;
+	int		numlinks;	// edicts linked here, in either list
+	int		splitat;	// numlinks at which to try splitting again
 } areanode_t;
 
-#define	AREA_DEPTH	4
-#define	AREA_NODES	32
+#define	AREA_DEPTH		4		// the tree every map starts with
+#define	AREA_MAXDEPTH	10
+#define	AREA_NODES		256
+#define	AREA_SAMPLES	64		// edicts looked at to place a split
 
 static	areanode_t	sv_areanodes[AREA_NODES];
 static	int			sv_numareanodes;
 
+#define	TOUCH_DEPTH		16		// touch functions linking edicts that touch more
+
+static	edict_t		**sv_touchlists;	// TOUCH_DEPTH lists of sv.max_edicts
+static	int			sv_touchlistsize;
+static	int			sv_touchdepth;
+
+// a leaf with more edicts than this is split again, on the median of the
+// edicts in it rather than the middle of its bounds
+cvar_t	sv_areasplit = {"sv_areasplit", "12", CVAR_NONE};
+
 /*
 ===============
-SV_CreateAreaNode
-
+SV_NewAreaNode
 ===============
 */
-areanode_t *SV_CreateAreaNode (int depth, vec3_t mins, vec3_t maxs)
+static areanode_t *SV_NewAreaNode (int depth, vec3_t mins, vec3_t maxs)
 {
 	areanode_t	*anode;
-	vec3_t		size;
-	vec3_t		mins1, maxs1, mins2, maxs2;
 
 	anode = &sv_areanodes[sv_numareanodes];
 	sv_numareanodes++;
 
 	ClearLink (&anode->trigger_edicts);
 	ClearLink (&anode->solid_edicts);
+	VectorCopy (mins, anode->mins);
+	VectorCopy (maxs, anode->maxs);
+	anode->depth = depth;
+	anode->axis = -1;
+	anode->children[0] = anode->children[1] = NULL;
+
+	return anode;
+}
+
+/*
+===============
+SV_CreateAreaNode
+
+===============
+*/
+areanode_t *SV_CreateAreaNode (int depth, vec3_t mins, vec3_t maxs)
+{
+	areanode_t	*anode;
+	vec3_t		size;
+	vec3_t		mins1, maxs1, mins2, maxs2;
+
+	anode = SV_NewAreaNode (depth, mins, maxs);
 
 	if (depth == AREA_DEPTH)
-	{
-		anode->axis = -1;
-		anode->children[0] = anode->children[1] = NULL;
 		return anode;
-	}
 
 	VectorSubtract (maxs, mins, size);
 	if (size[0] > size[1])
@@ -243,6 +298,192 @@ areanode_t *SV_CreateAreaNode (int depth, vec3_t mins, vec3_t maxs)
 	return anode;
 }
 
+static int SV_CompareFloats (const void *a, const void *b)
+{
+	float	fa = *(const float *)a, fb = *(const float *)b;
+
+	return (fa > fb) - (fa < fb);
+}
+
+/*
+===============
+SV_SplitAreaNode
+
+A leaf holding too many edicts is split on the axis its edicts are most
+spread along, at their median, and the edicts that end up wholly on one
+side move down. Nothing is split if most of them would straddle the plane;
+it is tried again once the leaf has doubled.
+===============
+*/
+static void SV_SplitAreaNode (areanode_t *anode)
+{
+	static float	centers[3][AREA_SAMPLES];
+	vec3_t		mins1, maxs1, mins2, maxs2;
+	link_t		*lists[2], *l, *next;
+	edict_t		*ent;
+	areanode_t	*child;
+	int			i, j, num, axis, straddle;
+	float		dist, spread, best;
+
+	anode->splitat = anode->numlinks * 2;
+	if (anode->depth == AREA_MAXDEPTH || sv_numareanodes + 2 > AREA_NODES)
+		return;
+
+	lists[0] = &anode->solid_edicts;
+	lists[1] = &anode->trigger_edicts;
+
+	num = 0;
+	for (i = 0; i < 2; i++)
+	{
+		for (l = lists[i]->next; l != lists[i] && num < AREA_SAMPLES; l = l->next)
+		{
+			ent = EDICT_FROM_AREA(l);
+			for (j = 0; j < 3; j++)
+				centers[j][num] = 0.5 * (ent->v.absmin[j] + ent->v.absmax[j]);
+			num++;
+		}
+	}
+
+	axis = 0;
+	best = -1;
+	for (j = 0; j < 3; j++)
+	{
+		qsort (centers[j], num, sizeof(float), SV_CompareFloats);
+		spread = centers[j][num-1] - centers[j][0];
+		if (spread > best)
+		{
+			best = spread;
+			axis = j;
+		}
+	}
+	dist = centers[axis][num/2];
+	if (dist <= anode->mins[axis] || dist >= anode->maxs[axis])
+		return;
+
+	straddle = 0;
+	for (i = 0; i < 2; i++)
+	{
+		for (l = lists[i]->next; l != lists[i]; l = l->next)
+		{
+			ent = EDICT_FROM_AREA(l);
+			if (ent->v.absmin[axis] <= dist && ent->v.absmax[axis] >= dist)
+				straddle++;
+		}
+	}
+	if (straddle * 2 > anode->numlinks)
+		return;
+
+	VectorCopy (anode->mins, mins1);
+	VectorCopy (anode->mins, mins2);
+	VectorCopy (anode->maxs, maxs1);
+	VectorCopy (anode->maxs, maxs2);
+	maxs1[axis] = mins2[axis] = dist;
+
+	anode->axis = axis;
+	anode->dist = dist;
+	anode->children[0] = SV_NewAreaNode (anode->depth+1, mins2, maxs2);
+	anode->children[1] = SV_NewAreaNode (anode->depth+1, mins1, maxs1);
+
+	// the same tests SV_LinkEdict uses to pick a node
+	for (i = 0; i < 2; i++)
+	{
+		for (l = lists[i]->next; l != lists[i]; l = next)
+		{
+			next = l->next;
+			ent = EDICT_FROM_AREA(l);
+			if (ent->v.absmin[axis] > dist)
+				child = anode->children[0];
+			else if (ent->v.absmax[axis] < dist)
+				child = anode->children[1];
+			else
+				continue;
+
+			RemoveLink (l);
+			InsertLinkBefore (l, i ? &child->trigger_edicts : &child->solid_edicts);
+			ent->areanode = child;
+			anode->numlinks--;
+			child->numlinks++;
+		}
+	}
+}
+
+/*
+===============
+SV_AreaNodeStats
+
+walks the tree for SV_AreaStats_f. cost is how many solid edicts a move
+that ends up in a leaf has looked at on the way down to it.
+===============
+*/
+static void SV_AreaNodeStats (areanode_t *node, int cost, int *numleafs, int *maxdepth, int *maxlinks, int *maxcost, areanode_t **worst)
+{
+	link_t	*l;
+
+	for (l = node->solid_edicts.next; l != &node->solid_edicts; l = l->next)
+		cost++;
+	*maxlinks = q_max (*maxlinks, node->numlinks);
+
+	if (node->axis != -1)
+	{
+		SV_AreaNodeStats (node->children[0], cost, numleafs, maxdepth, maxlinks, maxcost, worst);
+		SV_AreaNodeStats (node->children[1], cost, numleafs, maxdepth, maxlinks, maxcost, worst);
+		return;
+	}
+
+	(*numleafs)++;
+	*maxdepth = q_max (*maxdepth, node->depth);
+	if (cost > *maxcost)
+	{
+		*maxcost = cost;
+		*worst = node;
+	}
+}
+
+/*
+===============
+SV_AreaStats_f
+===============
+*/
+void SV_AreaStats_f (void)
+{
+	areanode_t	*node, *worst;
+	link_t		*l;
+	int			i, numleafs, maxdepth, maxlinks, maxcost, solids, triggers;
+
+	if (!sv.active || !sv_numareanodes)
+	{
+		Con_Printf ("no map running\n");
+		return;
+	}
+
+	numleafs = maxdepth = maxlinks = maxcost = 0;
+	worst = sv_areanodes;
+	SV_AreaNodeStats (sv_areanodes, 0, &numleafs, &maxdepth, &maxlinks, &maxcost, &worst);
+
+	Con_Printf ("%i of %i area nodes, %i leafs, depth %i\n", sv_numareanodes, AREA_NODES, numleafs, maxdepth);
+	Con_Printf ("most edicts in a node: %i\n", maxlinks);
+	Con_Printf ("most solid edicts on the way to a leaf: %i, in (%.0f %.0f %.0f) - (%.0f %.0f %.0f)\n", maxcost,
+				worst->mins[0], worst->mins[1], worst->mins[2], worst->maxs[0], worst->maxs[1], worst->maxs[2]);
+	Con_Printf ("trace cache: %i hits, %i misses\n", sv_tracecachehits, sv_tracecachemisses);
+
+	if (Cmd_Argc() < 2)
+		return;
+
+	// sv_areastats all -- every node with anything in it
+	for (i = 0, node = sv_areanodes; i < sv_numareanodes; i++, node++)
+	{
+		if (!node->numlinks)
+			continue;
+		solids = triggers = 0;
+		for (l = node->solid_edicts.next; l != &node->solid_edicts; l = l->next)
+			solids++;
+		for (l = node->trigger_edicts.next; l != &node->trigger_edicts; l = l->next)
+			triggers++;
+		Con_Printf ("%3i: depth %2i %s %3i solid %3i trigger\n", i, node->depth,
+					node->axis == -1 ? "leaf" : "node", solids, triggers);
+	}
+}
+
 /*
 ===============
 SV_ClearWorld
@@ -256,8 +497,19 @@ void SV_ClearWorld (void)
 	Q_memset (sv_areanodes, 0, sizeof(sv_areanodes));
 	sv_numareanodes = 0;
 	SV_CreateAreaNode (0, sv.worldmodel->mins, sv.worldmodel->maxs);
-}
 
+	Q_memset (sv_traces, 0, sizeof(sv_traces));
+	sv_tracecachehits = sv_tracecachemisses = 0;
+
+	if (sv_touchlistsize != sv.max_edicts)
+	{
+		sv_touchlistsize = sv.max_edicts;
+		sv_touchlists = (edict_t **) realloc (sv_touchlists, TOUCH_DEPTH * sv_touchlistsize * sizeof(edict_t *));
+		if (!sv_touchlists)
+			Sys_Error ("SV_ClearWorld: couldn't allocate touch lists");
+	}
+	sv_touchdepth = 0;	// a progs error can leave SV_TouchLinks without unwinding
+}
 
 /*
 ===============
@@ -271,6 +523,7 @@ void SV_UnlinkEdict (edict_t *ent)
 		return;		// not linked in anywhere
 	RemoveLink (&ent->area);
 	ent->area.prev = ent->area.next = NULL;
+	ent->areanode->numlinks--;
 }
 
 
@@ -295,7 +548,7 @@ SV_AreaTriggerEdicts ( edict_t *ent, areanode_t *node, edict_t **list, int *list
 		touch = EDICT_FROM_AREA(l);
 		if (touch == ent)
 			continue;
-		if (!touch->v.touch || touch->v.solid != SOLID_TRIGGER)
+		if (!touch->v.touch || touch->hot->solid != SOLID_TRIGGER)
 			continue;
 		if (ent->v.absmin[0] > touch->v.absmax[0]
 		|| ent->v.absmin[1] > touch->v.absmax[1]
@@ -326,10 +579,13 @@ SV_AreaTriggerEdicts ( edict_t *ent, areanode_t *node, edict_t **list, int *list
 ====================
 SV_TouchLinks
 
-ericw -- copy the touching edicts to an array (on the hunk) so we can avoid
+ericw -- copy the touching edicts to an array so we can avoid
 iteating the trigger_edicts linked list while calling PR_ExecuteProgram
 which could potentially corrupt the list while it's being iterated.
 Based on code from Spike.
+The arrays are allocated with the map rather than on the hunk, which the
+main thread may be using while the server frame is pipelined, one for each
+level the touch functions recurse to.
 ====================
 */
 void SV_TouchLinks (edict_t *ent)
@@ -338,14 +594,16 @@ void SV_TouchLinks (edict_t *ent)
 	edict_t		*touch;
 	int		old_self, old_other;
 	int		i, listcount;
-	int		mark;
 	
-	mark = Hunk_LowMark ();
-	list = (edict_t **) Hunk_Alloc (sv.num_edicts*sizeof(edict_t *));
+	if (sv_touchdepth == TOUCH_DEPTH)
+		PR_RunError ("SV_TouchLinks: touch functions nested too deep");
+	list = sv_touchlists + sv_touchdepth * sv_touchlistsize;
 	
 	listcount = 0;
 	SV_AreaTriggerEdicts (ent, sv_areanodes, list, &listcount, sv.num_edicts);
 
+	sv_touchdepth++;
+
 	for (i = 0; i < listcount; i++)
 	{
 		touch = list[i];
@@ -353,7 +611,7 @@ void SV_TouchLinks (edict_t *ent)
 	// edicts later in the list no longer touch
 		if (touch == ent)
 			continue;
-		if (!touch->v.touch || touch->v.solid != SOLID_TRIGGER)
+		if (!touch->v.touch || touch->hot->solid != SOLID_TRIGGER)
 			continue;
 		if (ent->v.absmin[0] > touch->v.absmax[0]
 		|| ent->v.absmin[1] > touch->v.absmax[1]
@@ -374,8 +632,7 @@ void SV_TouchLinks (edict_t *ent)
 		pr_global_struct->other = old_other;
 	}
 
-// free hunk-allocated edicts array
-	Hunk_FreeToLowMark (mark);
+	sv_touchdepth--;
 }
 
 
@@ -385,7 +642,7 @@ SV_FindTouchedLeafs
 
 ===============
 */
-void SV_FindTouchedLeafs (edict_t *ent, mnode_t *node)
+static void SV_FindTouchedLeafs (edict_t *ent, edictleafs_t *leafs, mnode_t *node)
 {
 	mplane_t	*splitplane;
 	mleaf_t		*leaf;
@@ -395,7 +652,7 @@ void SV_FindTouchedLeafs (edict_t *ent, mnode_t *node)
 	if (node->contents == CONTENTS_SOLID)
 		return;
 
-	if (ent->num_leafs == MAX_ENT_LEAFS)
+	if (leafs->num_leafs == MAX_ENT_LEAFS)
 		return;
 
 // add an efrag if the node is a leaf
@@ -405,8 +662,8 @@ void SV_FindTouchedLeafs (edict_t *ent, mnode_t *node)
 		leaf = (mleaf_t *)node;
 		leafnum = leaf - sv.worldmodel->leafs - 1;
 
-		ent->leafnums[ent->num_leafs] = leafnum;
-		ent->num_leafs++;
+		leafs->u.leafnums[leafs->num_leafs] = leafnum;
+		leafs->num_leafs++;
 		return;
 	}
 
@@ -417,10 +674,63 @@ void SV_FindTouchedLeafs (edict_t *ent, mnode_t *node)
 
 // recurse down the contacted sides
 	if (sides & 1)
-		SV_FindTouchedLeafs (ent, node->children[0]);
+		SV_FindTouchedLeafs (ent, leafs, node->children[0]);
 
 	if (sides & 2)
-		SV_FindTouchedLeafs (ent, node->children[1]);
+		SV_FindTouchedLeafs (ent, leafs, node->children[1]);
+}
+
+/*
+===============
+SV_PackLeafWords
+
+for an edict in enough leafs, groups them by the four bytes of the pvs row
+they're in, so a pvs test is an and of a few words instead of a bit test per
+leaf. the words are placed so none runs past the end of a packed row, and the
+masks are built a byte at a time so they match the row in memory on any byte
+order. leaves the leaf numbers alone if the words wouldn't fit over them.
+===============
+*/
+#define	PVSWORDS_MINLEAFS	8
+
+static void SV_PackLeafWords (edictleafs_t *leafs)
+{
+	pvsword_t	words[MAX_ENT_LEAFS/2];
+	int		i, j, num, ofs, leafnum, rowbytes;
+	union
+	{
+		unsigned int	mask;
+		byte			bytes[4];
+	} bits;
+
+	rowbytes = (sv.worldmodel->numleafs+7)>>3;
+	if (leafs->num_leafs < PVSWORDS_MINLEAFS || leafs->num_leafs == MAX_ENT_LEAFS || rowbytes < 4)
+		return;	// a full list is never tested, it's always sent
+
+	num = 0;
+	for (i = 0; i < leafs->num_leafs; i++)
+	{
+		leafnum = leafs->u.leafnums[i];
+		ofs = q_min ((leafnum >> 3) & ~3, rowbytes - 4);
+		for (j = 0; j < num; j++)
+			if (words[j].ofs == ofs)
+				break;
+		if (j == num)
+		{
+			if (num == MAX_ENT_LEAFS/2)
+				return;
+			words[j].ofs = ofs;
+			words[j].mask = 0;
+			num++;
+		}
+
+		bits.mask = 0;
+		bits.bytes[(leafnum >> 3) - ofs] = 1 << (leafnum & 7);
+		words[j].mask |= bits.mask;
+	}
+
+	memcpy (leafs->u.pvswords, words, num * sizeof(pvsword_t));
+	leafs->num_pvswords = num;
 }
 
 /*
@@ -432,6 +742,8 @@ SV_LinkEdict
 void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 {
 	areanode_t	*node;
+	edictleafs_t	*leafs;
+	int			num;
 
 	if (ent->area.prev)
 		SV_UnlinkEdict (ent);	// unlink from old position
@@ -439,18 +751,18 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 	if (ent == sv.edicts)
 		return;		// don't add the world
 
-	if (ent->free)
+	if (ent->hot->free)
 		return;
 
 // set the abs box
-	VectorAdd (ent->v.origin, ent->v.mins, ent->v.absmin);
-	VectorAdd (ent->v.origin, ent->v.maxs, ent->v.absmax);
+	VectorAdd (ent->hot->origin, ent->v.mins, ent->v.absmin);
+	VectorAdd (ent->hot->origin, ent->v.maxs, ent->v.absmax);
 
 //
 // to make items easier to pick up and allow them to be grabbed off
 // of shelves, the abs sizes are expanded
 //
-	if ((int)ent->v.flags & FL_ITEM)
+	if ((int)ent->hot->flags & FL_ITEM)
 	{
 		ent->v.absmin[0] -= 15;
 		ent->v.absmin[1] -= 15;
@@ -469,11 +781,20 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 	}
 
 // link to PVS leafs
-	ent->num_leafs = 0;
+	num = NUM_FOR_EDICT(ent);
+	leafs = &sv.edictleafs[num];
+	leafs->num_leafs = 0;
+	leafs->num_pvswords = 0;
 	if (ent->v.modelindex)
-		SV_FindTouchedLeafs (ent, sv.worldmodel->nodes);
+	{
+		SV_FindTouchedLeafs (ent, leafs, sv.worldmodel->nodes);
+		SV_PackLeafWords (leafs);
+		SV_SetNetEdict (num);
+	}
+	else
+		SV_ClearNetEdict (num);
 
-	if (ent->v.solid == SOLID_NOT)
+	if (ent->hot->solid == SOLID_NOT)
 		return;
 
 // find the first node that the ent's box crosses
@@ -492,10 +813,16 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 
 // link it in
 
-	if (ent->v.solid == SOLID_TRIGGER)
+	if (ent->hot->solid == SOLID_TRIGGER)
 		InsertLinkBefore (&ent->area, &node->trigger_edicts);
 	else
 		InsertLinkBefore (&ent->area, &node->solid_edicts);
+	ent->areanode = node;
+	node->numlinks++;
+
+	if (node->axis == -1 && sv_areasplit.value > 0
+	&& node->numlinks > q_max ((int)sv_areasplit.value, node->splitat))
+		SV_SplitAreaNode (node);
 
 // if touch_triggers, touch all entities at this node and decend for more
 	if (touch_triggers)
@@ -522,7 +849,6 @@ int SV_HullPointContents (hull_t *hull, int num, vec3_t p)
 {
 	float		d;
 	mclipnode_t	*node; //johnfitz -- was dclipnode_t
-	mplane_t	*plane;
 
 	while (num >= 0)
 	{
@@ -530,12 +856,11 @@ int SV_HullPointContents (hull_t *hull, int num, vec3_t p)
 			Sys_Error ("SV_HullPointContents: bad node number");
 
 		node = hull->clipnodes + num;
-		plane = hull->planes + node->planenum;
 
-		if (plane->type < 3)
-			d = p[plane->type] - plane->dist;
+		if (node->type < 3)
+			d = p[node->type] - node->dist;
 		else
-			d = DoublePrecisionDotProduct (plane->normal, p) - plane->dist;
+			d = DoublePrecisionDotProduct (node->normal, p) - node->dist;
 		if (d < 0)
 			num = node->children[1];
 		else
@@ -580,7 +905,7 @@ edict_t	*SV_TestEntityPosition (edict_t *ent)
 {
 	trace_t	trace;
 
-	trace = SV_Move (ent->v.origin, ent->v.mins, ent->v.maxs, ent->v.origin, 0, ent);
+	trace = SV_Move (ent->hot->origin, ent->v.mins, ent->v.maxs, ent->hot->origin, 0, ent);
 
 	if (trace.startsolid)
 		return sv.edicts;
@@ -599,14 +924,15 @@ LINE TESTING IN HULLS
 
 /*
 ==================
-SV_RecursiveHullCheck
+SV_HullCheckRecursive
 
+the original tracer, kept for sv_tracebench to compare against and for
+SV_RecursiveHullCheck to fall back on when its stack is full
 ==================
 */
-qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace)
+static qboolean SV_HullCheckRecursive (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace)
 {
 	mclipnode_t	*node; //johnfitz -- was dclipnode_t
-	mplane_t	*plane;
 	float		t1, t2;
 	float		frac;
 	int			i;
@@ -631,29 +957,28 @@ qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec
 	}
 
 	if (num < hull->firstclipnode || num > hull->lastclipnode)
-		Sys_Error ("SV_RecursiveHullCheck: bad node number");
+		Sys_Error ("SV_HullCheckRecursive: bad node number");
 
 //
 // find the point distances
 //
 	node = hull->clipnodes + num;
-	plane = hull->planes + node->planenum;
 
-	if (plane->type < 3)
+	if (node->type < 3)
 	{
-		t1 = p1[plane->type] - plane->dist;
-		t2 = p2[plane->type] - plane->dist;
+		t1 = p1[node->type] - node->dist;
+		t2 = p2[node->type] - node->dist;
 	}
 	else
 	{
-		t1 = DoublePrecisionDotProduct (plane->normal, p1) - plane->dist;
-		t2 = DoublePrecisionDotProduct (plane->normal, p2) - plane->dist;
+		t1 = DoublePrecisionDotProduct (node->normal, p1) - node->dist;
+		t2 = DoublePrecisionDotProduct (node->normal, p2) - node->dist;
 	}
 
 	if (t1 >= 0 && t2 >= 0)
-		return SV_RecursiveHullCheck (hull, node->children[0], p1f, p2f, p1, p2, trace);
+		return SV_HullCheckRecursive (hull, node->children[0], p1f, p2f, p1, p2, trace);
 	if (t1 < 0 && t2 < 0)
-		return SV_RecursiveHullCheck (hull, node->children[1], p1f, p2f, p1, p2, trace);
+		return SV_HullCheckRecursive (hull, node->children[1], p1f, p2f, p1, p2, trace);
 
 // put the crosspoint DIST_EPSILON pixels on the near side
 	if (t1 < 0)
@@ -672,13 +997,13 @@ qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec
 	side = (t1 < 0);
 
 // move up to the node
-	if (!SV_RecursiveHullCheck (hull, node->children[side], p1f, midf, p1, mid, trace) )
+	if (!SV_HullCheckRecursive (hull, node->children[side], p1f, midf, p1, mid, trace) )
 		return false;
 
 	if (SV_HullPointContents (hull, node->children[side^1], mid)
 	!= CONTENTS_SOLID)
 // go past the node
-		return SV_RecursiveHullCheck (hull, node->children[side^1], midf, p2f, mid, p2, trace);
+		return SV_HullCheckRecursive (hull, node->children[side^1], midf, p2f, mid, p2, trace);
 
 	if (trace->allsolid)
 		return false;		// never got out of the solid area
@@ -688,13 +1013,13 @@ qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec
 //==================
 	if (!side)
 	{
-		VectorCopy (plane->normal, trace->plane.normal);
-		trace->plane.dist = plane->dist;
+		VectorCopy (node->normal, trace->plane.normal);
+		trace->plane.dist = node->dist;
 	}
 	else
 	{
-		VectorSubtract (vec3_origin, plane->normal, trace->plane.normal);
-		trace->plane.dist = -plane->dist;
+		VectorSubtract (vec3_origin, node->normal, trace->plane.normal);
+		trace->plane.dist = -node->dist;
 	}
 
 	while (SV_HullPointContents (hull, hull->firstclipnode, mid)
@@ -720,6 +1045,177 @@ qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec
 }
 
 
+/*
+==================
+SV_RecursiveHullCheck
+
+Walks the hull with a stack of the nodes the line crosses instead of
+recursing. The line is followed down to the leaf its near end is in; each
+crossed node then gets the far half of its line tried once everything
+below it on the near side has let the line through, which is the order
+the recursive version took, so the results are the same to the bit.
+==================
+*/
+#define	HULLCHECK_STACK	64
+
+typedef struct
+{
+	mclipnode_t	*node;
+	int			side;
+	float		p1f, p2f, midf, frac;
+	vec3_t		p1, p2, mid;
+} hullcheck_t;
+
+qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace)
+{
+	hullcheck_t	stack[HULLCHECK_STACK], *f;
+	mclipnode_t	*node;
+	vec3_t		start, end;
+	float		t1, t2, frac;
+	int			i, sp;
+
+	VectorCopy (p1, start);
+	VectorCopy (p2, end);
+	sp = 0;
+
+	while (1)
+	{
+	// go down to the leaf, stacking every node the line crosses on the way
+		while (num >= 0)
+		{
+			if (num < hull->firstclipnode || num > hull->lastclipnode)
+				Sys_Error ("SV_RecursiveHullCheck: bad node number");
+
+			node = hull->clipnodes + num;
+			if (node->type < 3)
+			{
+				t1 = start[node->type] - node->dist;
+				t2 = end[node->type] - node->dist;
+			}
+			else
+			{
+				t1 = DoublePrecisionDotProduct (node->normal, start) - node->dist;
+				t2 = DoublePrecisionDotProduct (node->normal, end) - node->dist;
+			}
+
+			if (t1 >= 0 && t2 >= 0)
+			{
+				num = node->children[0];
+				continue;
+			}
+			if (t1 < 0 && t2 < 0)
+			{
+				num = node->children[1];
+				continue;
+			}
+
+			if (sp == HULLCHECK_STACK)
+			{
+				if (!SV_HullCheckRecursive (hull, num, p1f, p2f, start, end, trace))
+					return false;
+				goto through;
+			}
+
+		// put the crosspoint DIST_EPSILON pixels on the near side
+			if (t1 < 0)
+				frac = (t1 + DIST_EPSILON)/(t1-t2);
+			else
+				frac = (t1 - DIST_EPSILON)/(t1-t2);
+			if (frac < 0)
+				frac = 0;
+			if (frac > 1)
+				frac = 1;
+
+			f = &stack[sp++];
+			f->node = node;
+			f->side = (t1 < 0);
+			f->frac = frac;
+			f->p1f = p1f;
+			f->p2f = p2f;
+			f->midf = p1f + (p2f - p1f)*frac;
+			for (i=0 ; i<3 ; i++)
+				f->mid[i] = start[i] + frac*(end[i] - start[i]);
+			VectorCopy (start, f->p1);
+			VectorCopy (end, f->p2);
+
+		// move up to the node
+			num = node->children[f->side];
+			p2f = f->midf;
+			VectorCopy (f->mid, end);
+		}
+
+	// check for empty
+		if (num != CONTENTS_SOLID)
+		{
+			trace->allsolid = false;
+			if (num == CONTENTS_EMPTY)
+				trace->inopen = true;
+			else
+				trace->inwater = true;
+		}
+		else
+			trace->startsolid = true;
+
+through:
+	// the near side of the last crossed node let the line through
+		if (!sp)
+			return true;
+		f = &stack[--sp];
+		node = f->node;
+
+		if (SV_HullPointContents (hull, node->children[f->side^1], f->mid)
+		!= CONTENTS_SOLID)
+		{
+		// go past the node
+			num = node->children[f->side^1];
+			p1f = f->midf;
+			p2f = f->p2f;
+			VectorCopy (f->mid, start);
+			VectorCopy (f->p2, end);
+			continue;
+		}
+
+		if (trace->allsolid)
+			return false;		// never got out of the solid area
+
+	//==================
+	// the other side of the node is solid, this is the impact point
+	//==================
+		if (!f->side)
+		{
+			VectorCopy (node->normal, trace->plane.normal);
+			trace->plane.dist = node->dist;
+		}
+		else
+		{
+			VectorSubtract (vec3_origin, node->normal, trace->plane.normal);
+			trace->plane.dist = -node->dist;
+		}
+
+		frac = f->frac;
+		while (SV_HullPointContents (hull, hull->firstclipnode, f->mid)
+		== CONTENTS_SOLID)
+		{ // shouldn't really happen, but does occasionally
+			frac -= 0.1;
+			if (frac < 0)
+			{
+				trace->fraction = f->midf;
+				VectorCopy (f->mid, trace->endpos);
+				Con_DPrintf ("backup past 0\n");
+				return false;
+			}
+			f->midf = f->p1f + (f->p2f - f->p1f)*frac;
+			for (i=0 ; i<3 ; i++)
+				f->mid[i] = f->p1[i] + frac*(f->p2[i] - f->p1[i]);
+		}
+
+		trace->fraction = f->midf;
+		VectorCopy (f->mid, trace->endpos);
+
+		return false;
+	}
+}
+
 /*
 ==================
 SV_ClipMoveToEntity
@@ -763,6 +1259,71 @@ trace_t SV_ClipMoveToEntity (edict_t *ent, vec3_t start, vec3_t mins, vec3_t max
 
 //===========================================================================
 
+/*
+====================
+SV_ClipToEdict
+
+false once the move is all solid, when nothing else can change it
+====================
+*/
+static qboolean SV_ClipToEdict (edict_t *touch, moveclip_t *clip)
+{
+	trace_t		trace;
+
+	if (touch->hot->solid == SOLID_NOT)
+		return true;
+	if (touch == clip->passedict)
+		return true;
+	if (touch->hot->solid == SOLID_TRIGGER)
+		Sys_Error ("Trigger in clipping list");
+
+	if (clip->type == MOVE_NOMONSTERS && touch->hot->solid != SOLID_BSP)
+		return true;
+
+	if (clip->boxmins[0] > touch->v.absmax[0]
+	|| clip->boxmins[1] > touch->v.absmax[1]
+	|| clip->boxmins[2] > touch->v.absmax[2]
+	|| clip->boxmaxs[0] < touch->v.absmin[0]
+	|| clip->boxmaxs[1] < touch->v.absmin[1]
+	|| clip->boxmaxs[2] < touch->v.absmin[2] )
+		return true;
+
+	if (clip->passedict && clip->passedict->v.size[0] && !touch->v.size[0])
+		return true;	// points never interact
+
+// might intersect, so do an exact clip
+	if (clip->trace.allsolid)
+		return false;
+	if (clip->passedict)
+	{
+	 	if (PROG_TO_EDICT(touch->v.owner) == clip->passedict)
+			return true;	// don't clip against own missiles
+		if (PROG_TO_EDICT(clip->passedict->v.owner) == touch)
+			return true;	// don't clip against owner
+	}
+
+	if ((int)touch->hot->flags & FL_MONSTER)
+		trace = SV_ClipMoveToEntity (touch, clip->start, clip->mins2, clip->maxs2, clip->end);
+	else
+		trace = SV_ClipMoveToEntity (touch, clip->start, clip->mins, clip->maxs, clip->end);
+	if (trace.allsolid || trace.startsolid ||
+	trace.fraction < clip->trace.fraction)
+	{
+		trace.ent = touch;
+	 	if (clip->trace.startsolid)
+		{
+			clip->trace = trace;
+			clip->trace.startsolid = true;
+		}
+		else
+			clip->trace = trace;
+	}
+	else if (trace.startsolid)
+		clip->trace.startsolid = true;
+
+	return true;
+}
+
 /*
 ====================
 SV_ClipToLinks
@@ -773,64 +1334,13 @@ Mins and maxs enclose the entire area swept by the move
 void SV_ClipToLinks ( areanode_t *node, moveclip_t *clip )
 {
 	link_t		*l, *next;
-	edict_t		*touch;
-	trace_t		trace;
 
 // touch linked edicts
 	for (l = node->solid_edicts.next ; l != &node->solid_edicts ; l = next)
 	{
 		next = l->next;
-		touch = EDICT_FROM_AREA(l);
-		if (touch->v.solid == SOLID_NOT)
-			continue;
-		if (touch == clip->passedict)
-			continue;
-		if (touch->v.solid == SOLID_TRIGGER)
-			Sys_Error ("Trigger in clipping list");
-
-		if (clip->type == MOVE_NOMONSTERS && touch->v.solid != SOLID_BSP)
-			continue;
-
-		if (clip->boxmins[0] > touch->v.absmax[0]
-		|| clip->boxmins[1] > touch->v.absmax[1]
-		|| clip->boxmins[2] > touch->v.absmax[2]
-		|| clip->boxmaxs[0] < touch->v.absmin[0]
-		|| clip->boxmaxs[1] < touch->v.absmin[1]
-		|| clip->boxmaxs[2] < touch->v.absmin[2] )
-			continue;
-
-		if (clip->passedict && clip->passedict->v.size[0] && !touch->v.size[0])
-			continue;	// points never interact
-
-	// might intersect, so do an exact clip
-		if (clip->trace.allsolid)
+		if (!SV_ClipToEdict (EDICT_FROM_AREA(l), clip))
 			return;
-		if (clip->passedict)
-		{
-		 	if (PROG_TO_EDICT(touch->v.owner) == clip->passedict)
-				continue;	// don't clip against own missiles
-			if (PROG_TO_EDICT(clip->passedict->v.owner) == touch)
-				continue;	// don't clip against owner
-		}
-
-		if ((int)touch->v.flags & FL_MONSTER)
-			trace = SV_ClipMoveToEntity (touch, clip->start, clip->mins2, clip->maxs2, clip->end);
-		else
-			trace = SV_ClipMoveToEntity (touch, clip->start, clip->mins, clip->maxs, clip->end);
-		if (trace.allsolid || trace.startsolid ||
-		trace.fraction < clip->trace.fraction)
-		{
-			trace.ent = touch;
-		 	if (clip->trace.startsolid)
-			{
-				clip->trace = trace;
-				clip->trace.startsolid = true;
-			}
-			else
-				clip->trace = trace;
-		}
-		else if (trace.startsolid)
-			clip->trace.startsolid = true;
 	}
 
 // recurse down both sides
@@ -843,6 +1353,46 @@ void SV_ClipToLinks ( areanode_t *node, moveclip_t *clip )
 		SV_ClipToLinks ( node->children[1], clip );
 }
 
+/*
+====================
+SV_AreaSolidEdicts
+
+the solid edicts SV_ClipToLinks would look at for a move inside the box,
+in the same order
+====================
+*/
+static void SV_AreaSolidEdicts (areanode_t *node, vec3_t boxmins, vec3_t boxmaxs, edict_t **list, int *listcount, const int listspace)
+{
+	link_t		*l;
+	edict_t		*touch;
+
+	for (l = node->solid_edicts.next ; l != &node->solid_edicts ; l = l->next)
+	{
+		touch = EDICT_FROM_AREA(l);
+		if (boxmins[0] > touch->v.absmax[0]
+		|| boxmins[1] > touch->v.absmax[1]
+		|| boxmins[2] > touch->v.absmax[2]
+		|| boxmaxs[0] < touch->v.absmin[0]
+		|| boxmaxs[1] < touch->v.absmin[1]
+		|| boxmaxs[2] < touch->v.absmin[2] )
+			continue;
+
+		if (*listcount == listspace)
+			return; // should never happen
+
+		list[*listcount] = touch;
+		(*listcount)++;
+	}
+
+	if (node->axis == -1)
+		return;
+
+	if ( boxmaxs[node->axis] > node->dist )
+		SV_AreaSolidEdicts ( node->children[0], boxmins, boxmaxs, list, listcount, listspace );
+	if ( boxmins[node->axis] < node->dist )
+		SV_AreaSolidEdicts ( node->children[1], boxmins, boxmaxs, list, listcount, listspace );
+}
+
 
 /*
 ==================
@@ -913,3 +1463,431 @@ trace_t SV_Move (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, e
 	return clip.trace;
 }
 
+
+/*
+==================
+SV_MoveBatchTrace
+
+SV_Move for several moves of the same size at once. The world hull is
+looked up once and the area nodes are walked once, for the box around
+every move.
+==================
+*/
+static void SV_MoveBatchTrace (int count, vec3_t *starts, vec3_t mins, vec3_t maxs, vec3_t *ends, int type, edict_t *passedict, trace_t *traces)
+{
+	moveclip_t	clip;
+	vec3_t		starts_l[MAX_MOVEBATCH], ends_l[MAX_MOVEBATCH];
+	vec3_t		offset, boxmins, boxmaxs;
+	hull_t		*hull;
+	static edict_t	**list;		// not on the hunk, see SV_TouchLinks
+	static int		maxlist;
+	int			i, j, listcount;
+
+// clip to world
+	hull = SV_HullForEntity (sv.edicts, mins, maxs, offset);
+	for (i=0 ; i<count ; i++)
+	{
+		Q_memset (&traces[i], 0, sizeof(trace_t));
+		traces[i].fraction = 1;
+		traces[i].allsolid = true;
+		VectorCopy (ends[i], traces[i].endpos);
+		VectorSubtract (starts[i], offset, starts_l[i]);
+		VectorSubtract (ends[i], offset, ends_l[i]);
+	}
+
+	for (i=0 ; i<count ; i++)
+	{
+		SV_RecursiveHullCheck (hull, hull->firstclipnode, 0, 1, starts_l[i], ends_l[i], &traces[i]);
+		if (traces[i].fraction != 1)
+			VectorAdd (traces[i].endpos, offset, traces[i].endpos);
+		if (traces[i].fraction < 1 || traces[i].startsolid)
+			traces[i].ent = sv.edicts;
+	}
+
+// clip to entities, all found in one walk
+	Q_memset (&clip, 0, sizeof(clip));
+	clip.mins = mins;
+	clip.maxs = maxs;
+	clip.type = type;
+	clip.passedict = passedict;
+	if (type == MOVE_MISSILE)
+	{
+		for (i=0 ; i<3 ; i++)
+		{
+			clip.mins2[i] = -15;
+			clip.maxs2[i] = 15;
+		}
+	}
+	else
+	{
+		VectorCopy (mins, clip.mins2);
+		VectorCopy (maxs, clip.maxs2);
+	}
+
+	for (i=0 ; i<count ; i++)
+	{
+		SV_MoveBounds (starts[i], clip.mins2, clip.maxs2, ends[i], clip.boxmins, clip.boxmaxs);
+		for (j=0 ; j<3 ; j++)
+		{
+			boxmins[j] = i ? q_min (boxmins[j], clip.boxmins[j]) : clip.boxmins[j];
+			boxmaxs[j] = i ? q_max (boxmaxs[j], clip.boxmaxs[j]) : clip.boxmaxs[j];
+		}
+	}
+
+	if (maxlist < sv.num_edicts)
+	{
+		maxlist = q_max (sv.num_edicts, maxlist * 2);
+		list = (edict_t **) realloc (list, maxlist*sizeof(edict_t *));
+		if (!list)
+			Sys_Error ("SV_MoveBatchTrace: out of memory");
+	}
+	listcount = 0;
+	SV_AreaSolidEdicts (sv_areanodes, boxmins, boxmaxs, list, &listcount, sv.num_edicts);
+
+	for (i=0 ; i<count ; i++)
+	{
+		clip.start = starts[i];
+		clip.end = ends[i];
+		clip.trace = traces[i];
+		SV_MoveBounds (starts[i], clip.mins2, clip.maxs2, ends[i], clip.boxmins, clip.boxmaxs);
+
+		for (j=0 ; j<listcount ; j++)
+			if (!SV_ClipToEdict (list[j], &clip))
+				break;
+
+		traces[i] = clip.trace;
+	}
+}
+
+/*
+===============================================================================
+
+TRACE CACHE
+
+===============================================================================
+*/
+
+typedef struct
+{
+	edict_t		*ent;
+	float		solid, flags, modelindex, size;
+	int			owner;
+	vec3_t		origin, mins, maxs, absmin, absmax;
+} tracestate_t;
+
+/*
+==================
+SV_TraceHash
+
+64 bit FNV-1a
+==================
+*/
+#define	TRACEHASH_BASIS	0xcbf29ce484222325ull
+
+static uint64_t SV_TraceHash (uint64_t hash, const void *data, size_t len)
+{
+	const byte	*p = (const byte *) data;
+
+	while (len--)
+	{
+		hash ^= *p++;
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+/*
+==================
+SV_AreaState
+
+hashes everything SV_ClipToEdict reads from the solid edicts in the box,
+in the order SV_ClipToLinks would clip to them
+==================
+*/
+static uint64_t SV_AreaState (areanode_t *node, vec3_t boxmins, vec3_t boxmaxs, uint64_t hash)
+{
+	link_t			*l;
+	edict_t			*touch;
+	tracestate_t	state;
+
+	for (l = node->solid_edicts.next ; l != &node->solid_edicts ; l = l->next)
+	{
+		touch = EDICT_FROM_AREA(l);
+		if (boxmins[0] > touch->v.absmax[0]
+		|| boxmins[1] > touch->v.absmax[1]
+		|| boxmins[2] > touch->v.absmax[2]
+		|| boxmaxs[0] < touch->v.absmin[0]
+		|| boxmaxs[1] < touch->v.absmin[1]
+		|| boxmaxs[2] < touch->v.absmin[2] )
+			continue;
+
+		Q_memset (&state, 0, sizeof(state));
+		state.ent = touch;
+		state.solid = touch->hot->solid;
+		state.flags = touch->hot->flags;
+		state.modelindex = touch->v.modelindex;
+		state.size = touch->v.size[0];
+		state.owner = touch->v.owner;
+		VectorCopy (touch->hot->origin, state.origin);
+		VectorCopy (touch->v.mins, state.mins);
+		VectorCopy (touch->v.maxs, state.maxs);
+		VectorCopy (touch->v.absmin, state.absmin);
+		VectorCopy (touch->v.absmax, state.absmax);
+		hash = SV_TraceHash (hash, &state, sizeof(state));
+	}
+
+	if (node->axis == -1)
+		return hash;
+
+	if ( boxmaxs[node->axis] > node->dist )
+		hash = SV_AreaState ( node->children[0], boxmins, boxmaxs, hash );
+	if ( boxmins[node->axis] < node->dist )
+		hash = SV_AreaState ( node->children[1], boxmins, boxmaxs, hash );
+	return hash;
+}
+
+/*
+==================
+SV_MoveState
+
+what the result of the move depends on besides the world, which doesn't
+change while the map is up
+==================
+*/
+static uint64_t SV_MoveState (tracekey_t *key)
+{
+	vec3_t			mins2, maxs2, boxmins, boxmaxs;
+	tracestate_t	state;
+	uint64_t		hash;
+	int				i;
+
+	if (key->type == MOVE_MISSILE)
+	{
+		for (i=0 ; i<3 ; i++)
+		{
+			mins2[i] = -15;
+			maxs2[i] = 15;
+		}
+	}
+	else
+	{
+		VectorCopy (key->mins, mins2);
+		VectorCopy (key->maxs, maxs2);
+	}
+	SV_MoveBounds (key->start, mins2, maxs2, key->end, boxmins, boxmaxs);
+
+	hash = TRACEHASH_BASIS;
+	if (key->passedict)
+	{
+		Q_memset (&state, 0, sizeof(state));
+		state.size = key->passedict->v.size[0];
+		state.owner = key->passedict->v.owner;
+		hash = SV_TraceHash (hash, &state, sizeof(state));
+	}
+
+	return SV_AreaState (sv_areanodes, boxmins, boxmaxs, hash);
+}
+
+/*
+==================
+SV_TraceCacheSlot
+
+looks the move up, filling in its key and state for storing it if it
+isn't there
+==================
+*/
+static tracecache_t *SV_TraceCacheSlot (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, edict_t *passedict, tracekey_t *key, uint64_t *state)
+{
+	tracecache_t	*c;
+
+	Q_memset (key, 0, sizeof(*key));
+	VectorCopy (start, key->start);
+	VectorCopy (end, key->end);
+	VectorCopy (mins, key->mins);
+	VectorCopy (maxs, key->maxs);
+	key->type = type;
+	key->passedict = passedict;
+
+	c = &sv_traces[SV_TraceHash (TRACEHASH_BASIS, key, sizeof(*key)) & (TRACECACHE_SIZE-1)];
+	*state = SV_MoveState (key);
+
+	if (c->valid && c->state == *state && !memcmp (&c->key, key, sizeof(*key)))
+	{
+		sv_tracecachehits++;
+		return c;
+	}
+
+	sv_tracecachemisses++;
+	return NULL;
+}
+
+/*
+==================
+SV_TraceCacheStore
+==================
+*/
+static void SV_TraceCacheStore (tracekey_t *key, uint64_t state, trace_t *trace)
+{
+	tracecache_t	*c;
+
+	c = &sv_traces[SV_TraceHash (TRACEHASH_BASIS, key, sizeof(*key)) & (TRACECACHE_SIZE-1)];
+	c->key = *key;
+	c->state = state;
+	c->trace = *trace;
+	c->valid = true;
+}
+
+/*
+==================
+SV_MoveCached
+
+SV_Move, given back from the trace cache when nothing it could hit has
+changed since the same move was last traced
+==================
+*/
+trace_t SV_MoveCached (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, edict_t *passedict)
+{
+	tracecache_t	*c;
+	tracekey_t		key;
+	uint64_t		state;
+	trace_t			trace;
+
+	if (!sv_tracecache.value)
+		return SV_Move (start, mins, maxs, end, type, passedict);
+
+	c = SV_TraceCacheSlot (start, mins, maxs, end, type, passedict, &key, &state);
+	if (c)
+		return c->trace;
+
+	trace = SV_Move (start, mins, maxs, end, type, passedict);
+	SV_TraceCacheStore (&key, state, &trace);
+	return trace;
+}
+
+/*
+==================
+SV_MoveBatch
+
+SV_MoveBatchTrace for the moves that aren't in the trace cache
+==================
+*/
+void SV_MoveBatch (int count, vec3_t *starts, vec3_t mins, vec3_t maxs, vec3_t *ends, int type, edict_t *passedict, trace_t *traces)
+{
+	tracecache_t	*c;
+	tracekey_t		keys[MAX_MOVEBATCH];
+	uint64_t		states[MAX_MOVEBATCH];
+	vec3_t			missstarts[MAX_MOVEBATCH], missends[MAX_MOVEBATCH];
+	trace_t			misstraces[MAX_MOVEBATCH];
+	int				misses[MAX_MOVEBATCH];
+	int				i, nummisses;
+
+	if (count > MAX_MOVEBATCH)
+		Sys_Error ("SV_MoveBatch: %i moves", count);
+
+	if (!sv_tracecache.value)
+	{
+		SV_MoveBatchTrace (count, starts, mins, maxs, ends, type, passedict, traces);
+		return;
+	}
+
+	nummisses = 0;
+	for (i=0 ; i<count ; i++)
+	{
+		c = SV_TraceCacheSlot (starts[i], mins, maxs, ends[i], type, passedict, &keys[nummisses], &states[nummisses]);
+		if (c)
+		{
+			traces[i] = c->trace;
+			continue;
+		}
+		VectorCopy (starts[i], missstarts[nummisses]);
+		VectorCopy (ends[i], missends[nummisses]);
+		misses[nummisses++] = i;
+	}
+
+	if (!nummisses)
+		return;
+
+	SV_MoveBatchTrace (nummisses, missstarts, mins, maxs, missends, type, passedict, misstraces);
+	for (i=0 ; i<nummisses ; i++)
+	{
+		traces[misses[i]] = misstraces[i];
+		SV_TraceCacheStore (&keys[i], states[i], &misstraces[i]);
+	}
+}
+
+/*
+==================
+SV_TraceBench_f
+
+times the iterative hull tracer against the recursive one on random lines
+through the current map, and checks that they agree
+==================
+*/
+static unsigned int	tracebench_seed;
+
+static float SV_TraceBenchRandom (float lo, float hi)
+{
+	tracebench_seed = tracebench_seed * 1103515245 + 12345;
+	return lo + (hi - lo) * ((tracebench_seed >> 8) & 0xffff) / 65535.0f;
+}
+
+void SV_TraceBench_f (void)
+{
+	vec3_t		*starts, *ends;
+	trace_t		*traces, *ref;
+	hull_t		*hull;
+	double		time1, time2, time3;
+	int			count, h, i, j, mark, mismatches;
+
+	if (!sv.active)
+	{
+		Con_Printf ("no map running\n");
+		return;
+	}
+
+	count = (Cmd_Argc() > 1) ? atoi (Cmd_Argv(1)) : 10000;
+	count = CLAMP (1, count, 1000000);
+
+	mark = Hunk_LowMark ();
+	starts = (vec3_t *) Hunk_AllocName (count * sizeof(vec3_t), "tracebench");
+	ends = (vec3_t *) Hunk_AllocName (count * sizeof(vec3_t), "tracebench");
+	traces = (trace_t *) Hunk_AllocName (count * sizeof(trace_t), "tracebench");
+	ref = (trace_t *) Hunk_AllocName (count * sizeof(trace_t), "tracebench");
+
+	Con_Printf ("%i lines through %s\n", count, sv.worldmodel->name);
+	for (h = 0; h < 3; h++)
+	{
+		hull = &sv.worldmodel->hulls[h];
+
+		tracebench_seed = h + 1;
+		for (i = 0; i < count; i++)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				starts[i][j] = SV_TraceBenchRandom (sv.worldmodel->mins[j], sv.worldmodel->maxs[j]);
+				ends[i][j] = SV_TraceBenchRandom (sv.worldmodel->mins[j], sv.worldmodel->maxs[j]);
+			}
+		}
+
+		memset (ref, 0, count * sizeof(trace_t));
+		time1 = Sys_DoubleTime ();
+		for (i = 0; i < count; i++)
+			SV_HullCheckRecursive (hull, hull->firstclipnode, 0, 1, starts[i], ends[i], &ref[i]);
+
+		memset (traces, 0, count * sizeof(trace_t));
+		time2 = Sys_DoubleTime ();
+		for (i = 0; i < count; i++)
+			SV_RecursiveHullCheck (hull, hull->firstclipnode, 0, 1, starts[i], ends[i], &traces[i]);
+		time3 = Sys_DoubleTime ();
+
+		mismatches = 0;
+		for (i = 0; i < count; i++)
+			if (memcmp (&traces[i], &ref[i], sizeof(trace_t)))
+				mismatches++;
+
+		Con_Printf ("hull %i: recursive %.1f ns, iterative %.1f ns a line, %i mismatches\n", h,
+					(time2 - time1) * 1e9 / count, (time3 - time2) * 1e9 / count, mismatches);
+	}
+
+	Hunk_FreeToLowMark (mark);
+}
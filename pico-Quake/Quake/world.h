@@ -47,6 +47,9 @@ typedef struct
 void SV_ClearWorld (void);
 // called after the world model has been loaded, before linking any entities
 
+void SV_AreaStats_f (void);
+// prints how crowded the area nodes are
+
 void SV_UnlinkEdict (edict_t *ent);
 // call before removing an entity, and before trying to move one,
 // so it doesn't clip against itself
@@ -81,5 +84,16 @@ trace_t SV_Move (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, e
 
 qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace);
 
+#define	MAX_MOVEBATCH	8
+
+trace_t SV_MoveCached (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, edict_t *passedict);
+// SV_Move through the trace cache, for the probes monsters repeat every think
+
+void SV_MoveBatch (int count, vec3_t *starts, vec3_t mins, vec3_t maxs, vec3_t *ends, int type, edict_t *passedict, trace_t *traces);
+// SV_MoveCached for up to MAX_MOVEBATCH moves of the same size
+
+void SV_TraceBench_f (void);
+// times the hull tracers on the current map
+
 #endif	/* _QUAKE_WORLD_H */
 
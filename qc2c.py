@@ -0,0 +1,171 @@
+#Translates a progs.dat into C that the engine runs in place of interpreting it
+#usage: python3 qc2c.py <progs.dat> [pr_native_progs.c]
+#add the output to the build and define USE_NATIVE_PROGS. the engine only uses it
+#when the progs.dat it loads has the same crc, anything else is interpreted as before.
+import struct
+import sys
+
+PROG_VERSION = 6
+OFS_RETURN = 1
+RUNAWAY = 0x1000000
+
+(OP_DONE, OP_MUL_F, OP_MUL_V, OP_MUL_FV, OP_MUL_VF, OP_DIV_F, OP_ADD_F, OP_ADD_V, OP_SUB_F, OP_SUB_V,
+ OP_EQ_F, OP_EQ_V, OP_EQ_S, OP_EQ_E, OP_EQ_FNC, OP_NE_F, OP_NE_V, OP_NE_S, OP_NE_E, OP_NE_FNC,
+ OP_LE, OP_GE, OP_LT, OP_GT,
+ OP_LOAD_F, OP_LOAD_V, OP_LOAD_S, OP_LOAD_ENT, OP_LOAD_FLD, OP_LOAD_FNC, OP_ADDRESS,
+ OP_STORE_F, OP_STORE_V, OP_STORE_S, OP_STORE_ENT, OP_STORE_FLD, OP_STORE_FNC,
+ OP_STOREP_F, OP_STOREP_V, OP_STOREP_S, OP_STOREP_ENT, OP_STOREP_FLD, OP_STOREP_FNC,
+ OP_RETURN, OP_NOT_F, OP_NOT_V, OP_NOT_S, OP_NOT_ENT, OP_NOT_FNC, OP_IF, OP_IFNOT,
+ OP_CALL0, OP_CALL1, OP_CALL2, OP_CALL3, OP_CALL4, OP_CALL5, OP_CALL6, OP_CALL7, OP_CALL8,
+ OP_STATE, OP_GOTO, OP_AND, OP_OR, OP_BITAND, OP_BITOR) = range(66)
+
+BINARY = {
+	OP_ADD_F: "F({a}) + F({b})", OP_SUB_F: "F({a}) - F({b})",
+	OP_MUL_F: "F({a}) * F({b})", OP_DIV_F: "F({a}) / F({b})",
+	OP_BITAND: "(int)F({a}) & (int)F({b})", OP_BITOR: "(int)F({a}) | (int)F({b})",
+	OP_GE: "F({a}) >= F({b})", OP_LE: "F({a}) <= F({b})", OP_GT: "F({a}) > F({b})", OP_LT: "F({a}) < F({b})",
+	OP_AND: "F({a}) && F({b})", OP_OR: "F({a}) || F({b})",
+	OP_NOT_F: "!F({a})", OP_NOT_V: "!F({a}) && !F({a}+1) && !F({a}+2)",
+	OP_NOT_S: "!I({a}) || !*PR_GetString(I({a}))", OP_NOT_FNC: "!I({a})",
+	OP_NOT_ENT: "(PROG_TO_EDICT(I({a})) == sv.edicts)",
+	OP_EQ_F: "F({a}) == F({b})", OP_EQ_E: "I({a}) == I({b})", OP_EQ_FNC: "I({a}) == I({b})",
+	OP_EQ_V: "(F({a}) == F({b})) && (F({a}+1) == F({b}+1)) && (F({a}+2) == F({b}+2))",
+	OP_EQ_S: "!strcmp(PR_GetString(I({a})), PR_GetString(I({b})))",
+	OP_NE_F: "F({a}) != F({b})", OP_NE_E: "I({a}) != I({b})", OP_NE_FNC: "I({a}) != I({b})",
+	OP_NE_V: "(F({a}) != F({b})) || (F({a}+1) != F({b}+1)) || (F({a}+2) != F({b}+2))",
+	OP_NE_S: "strcmp(PR_GetString(I({a})), PR_GetString(I({b})))",
+}
+
+def crc16(data):
+	table = []
+	for i in range(256):
+		crc = i << 8
+		for _ in range(8):
+			crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+		table.append(crc & 0xffff)
+	crc = 0xffff
+	for byte in data:
+		crc = ((crc << 8) & 0xffff) ^ table[(crc >> 8) ^ byte]
+	return crc
+
+def cstring(data, ofs):
+	return data[ofs:data.index(b"\0", ofs)].decode("latin-1").replace("*/", "* /")
+
+#one statement as C, or None if it can't be translated
+def translate(s, st, first, end, labels):
+	op, a, b, c = st[s]
+	ua, ub, uc = a & 0xffff, b & 0xffff, c & 0xffff
+
+	def jump(ofs):
+		target = s + ofs
+		if target < first or target >= end:
+			return None
+		labels.add(target)
+		if ofs <= 0:
+			return "{ RUNAWAY(%d); goto s%d; }" % (s, target)
+		return "goto s%d;" % target
+
+	if op in BINARY:
+		return "F(%d) = %s;" % (uc, BINARY[op].format(a=ua, b=ub))
+	if op in (OP_ADD_V, OP_SUB_V):
+		sign = "+" if op == OP_ADD_V else "-"
+		return " ".join("F(%d) = F(%d) %s F(%d);" % (uc+k, ua+k, sign, ub+k) for k in range(3))
+	if op == OP_MUL_V:
+		return "F(%d) = F(%d) * F(%d) + F(%d) * F(%d) + F(%d) * F(%d);" % (uc, ua, ub, ua+1, ub+1, ua+2, ub+2)
+	if op == OP_MUL_FV:
+		return " ".join("F(%d) = F(%d) * F(%d);" % (uc+k, ua, ub+k) for k in range(3))
+	if op == OP_MUL_VF:
+		return " ".join("F(%d) = F(%d) * F(%d);" % (uc+k, ub, ua+k) for k in range(3))
+	if op in (OP_STORE_F, OP_STORE_S, OP_STORE_ENT, OP_STORE_FLD, OP_STORE_FNC):
+		return "I(%d) = I(%d);" % (ub, ua)
+	if op == OP_STORE_V:
+		return " ".join("F(%d) = F(%d);" % (ub+k, ua+k) for k in range(3))
+	if op in (OP_STOREP_F, OP_STOREP_S, OP_STOREP_ENT, OP_STOREP_FLD, OP_STOREP_FNC):
+		return "PTR(%d)->_int = I(%d);" % (ub, ua)
+	if op == OP_STOREP_V:
+		return "p = PTR(%d); " % ub + " ".join("p->vector[%d] = F(%d);" % (k, ua+k) for k in range(3))
+	if op == OP_ADDRESS:
+		return "I(%d) = PR_NativeAddress(%d, I(%d), I(%d));" % (uc, s, ua, ub)
+	if op in (OP_LOAD_F, OP_LOAD_S, OP_LOAD_ENT, OP_LOAD_FLD, OP_LOAD_FNC):
+		return "I(%d) = FLD(%d, %d)->_int;" % (uc, ua, ub)
+	if op == OP_LOAD_V:
+		return "p = FLD(%d, %d); " % (ua, ub) + " ".join("F(%d) = p->vector[%d];" % (uc+k, k) for k in range(3))
+	if op in (OP_IF, OP_IFNOT):
+		j = jump(b)
+		return j and ("if (%sI(%d)) %s" % ("" if op == OP_IF else "!", ua, j))
+	if op == OP_GOTO:
+		return jump(a)
+	if OP_CALL0 <= op <= OP_CALL8:
+		return "PR_NativeCall(%d, %d, I(%d));" % (s, op - OP_CALL0, ua)
+	if op in (OP_DONE, OP_RETURN):
+		return " ".join("I(%d) = I(%d);" % (OFS_RETURN+k, ua+k) for k in range(3)) + " return;"
+	if op == OP_STATE:
+		return "STATE(%d, %d);" % (ua, ub)
+	return None
+
+def main():
+	data = open(sys.argv[1], "rb").read()
+	out = open(sys.argv[2] if len(sys.argv) > 2 else "pr_native_progs.c", "w")
+
+	(version, _, ofs_statements, numstatements, _, _, _, _, ofs_functions, numfunctions,
+	 ofs_strings, _, _, _, _) = struct.unpack_from("<15i", data, 0)
+	assert version == PROG_VERSION, "not a version %d progs.dat" % PROG_VERSION
+
+	st = [struct.unpack_from("<Hhhh", data, ofs_statements + i*8) for i in range(numstatements)]
+	functions = [struct.unpack_from("<6i", data, ofs_functions + i*36) for i in range(numfunctions)]
+
+	#a function runs from its first statement up to the next function's
+	starts = sorted(f[0] for f in functions if f[0] > 0) + [numstatements]
+	ends = {starts[i]: starts[i+1] for i in range(len(starts) - 1)}
+
+	out.write(f"""//Generated with the "qc2c.py" script from {sys.argv[1].replace(chr(92), '/').split('/')[-1]}
+#include "quakedef.h"
+
+#define F(o)		(g[o])
+#define I(o)		(((int *)g)[o])
+#define PTR(o)		((eval_t *)((byte *)sv.edicts + I(o)))
+#define FLD(e,o)	((eval_t *)ED_Field(PROG_TO_EDICT(I(e)), I(o)))
+#define RUNAWAY(s)	do {{ if (++runaway > {RUNAWAY:#x}) PR_NativeRunaway(s); }} while (0)
+#define STATE(f,t)	do {{ edict_t *ed = PROG_TO_EDICT(pr_global_struct->self);	\\
+				SV_WakeEdict(pr_global_struct->self / pr_edict_size);	\\
+				ed->hot->nextthink = pr_global_struct->time + 0.1;	\\
+				ed->v.frame = F(f);	\\
+				ed->v.think = I(t); }} while (0)
+
+""")
+
+	names = [None] * numfunctions
+	translated = 0
+	for n, (first, _, _, _, s_name, _) in enumerate(functions):
+		if first <= 0:
+			continue
+		end = ends[first]
+		labels = set()
+		lines = [translate(s, st, first, end, labels) for s in range(first, end)]
+		#anything the interpreter would have to do differently stays with the interpreter
+		if None in lines or st[end-1][0] not in (OP_DONE, OP_RETURN, OP_GOTO):
+			continue
+
+		names[n] = "qc_%d" % n
+		translated += 1
+		out.write("// %s\nstatic void qc_%d (void)\n{\n" % (cstring(data, ofs_strings + s_name), n))
+		body = "".join("%s\t%s\n" % (("s%d:" % s) if s in labels else "", line) for s, line in zip(range(first, end), lines))
+		out.write("\tfloat *const g = pr_globals;\n")
+		if "p = " in body:
+			out.write("\teval_t *p;\n")
+		if "RUNAWAY" in body:
+			out.write("\tint runaway = 0;\n")
+		out.write("\n" + body)
+		out.write("}\n\n")
+
+	out.write("static const prnative_t qc_functions[%d] =\n{\n" % numfunctions)
+	for n in range(numfunctions):
+		out.write("\t%s,\n" % (names[n] or "NULL"))
+	out.write("};\n\n")
+	out.write("const prnativeprogs_t pr_nativeprogs =\n{\n")
+	out.write("\t%#06x, %d, %d,\n\tqc_functions\n};\n" % (crc16(data), numstatements, numfunctions))
+	out.close()
+
+	print("translated %d of %d functions" % (translated, numfunctions))
+
+main()